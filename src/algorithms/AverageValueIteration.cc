@@ -17,10 +17,28 @@
 #include "Random.h"
 #include <cmath>
 #include <cassert>
+#include <algorithm>
 
 #undef RECALCULATE_P_B
 
-AverageValueIteration::AverageValueIteration(const DiscreteMDP* mdp, bool relative, bool synchronous) : RELATIVE(relative), SYNCHRONOUS(synchronous), baseline(0)
+/// Number of transitions (plus actions) per block of states in parallel sweeps
+#define AVI_BLOCK_SIZE 4096
+
+/// Read a value that other threads may be writing
+static inline real RelaxedLoad(const real* x)
+{
+    real y;
+    __atomic_load(x, &y, __ATOMIC_RELAXED);
+    return y;
+}
+
+/// Write a value that other threads may be reading
+static inline void RelaxedStore(real* x, real y)
+{
+    __atomic_store(x, &y, __ATOMIC_RELAXED);
+}
+
+AverageValueIteration::AverageValueIteration(const DiscreteMDP* mdp, bool relative, bool synchronous) : model(mdp), pool(NULL), RELATIVE(relative), SYNCHRONOUS(synchronous), baseline(0)
 {
     assert (mdp);
     this->mdp = mdp;
@@ -66,6 +84,18 @@ AverageValueIteration::~AverageValueIteration()
 {
 }
 
+/// Process all blocks, in parallel if there is a thread pool
+void AverageValueIteration::RunBlocks(int n_blocks, const std::function<void (int)>& f)
+{
+    if (pool) {
+        pool->Run(n_blocks, f);
+    } else {
+        for (int k=0; k<n_blocks; ++k) {
+            f(k);
+        }
+    }
+}
+
 void AverageValueIteration::ComputeStateValues(real threshold, int max_iter)
 {
     std::vector<real> p_tmp(n_states);
@@ -76,30 +106,34 @@ void AverageValueIteration::ComputeStateValues(real threshold, int max_iter)
     real d2Delta = 0.0;
     Delta = 0.0;
     int stuck_count = 0;
-    do {
-        baseline = 0.0;
-        if (RELATIVE) {
-            for (int s=0; s<n_states; s++) {
-                baseline += p_b[s] * V[s];
-            }
-        }
-        //baseline = = real(n_states);
-        for (int s=0; s<n_states; s++) {
+    model.setMDP(mdp);
+    model.Update();
+    std::vector<int> block = model.PartitionStates(AVI_BLOCK_SIZE);
+    int n_blocks = block.size() - 1;
+    std::vector<int> block_policy_changes(n_blocks);
+    std::vector<real> block_dV_min(n_blocks);
+    std::vector<real> block_dV_max(n_blocks);
+
+    // Update the values of a block of states. In the asynchronous
+    // case, values of other blocks may be changing concurrently.
+    std::function<void (int)> sweep = [&] (int k) {
+        int changes = 0;
+        real dV_min = INF;
+        real dV_max = -INF;
+        for (int s=block[k]; s<block[k + 1]; s++) {
             real Q_a_max = -RAND_MAX;
             int c_a_max = 0;
             for (int a=0; a<n_actions; a++) {
                 real S = 0.0;
-                DiscreteStateSet next = mdp->getNextStates(s, a);
-                for (DiscreteStateSet::iterator i=next.begin();
-                     i!=next.end();
-                     ++i) {
-                    int s2 = *i;
-                    real P = mdp->getTransitionProbability(s, a, s2);
+                real R_sa = model.getExpectedReward(s, a);
+                for (int j=model.RowBegin(s, a); j<model.RowEnd(s, a); ++j) {
+                    int s2 = model.next_state[j];
+                    real P = model.probability[j];
                     real R;
                     if (SYNCHRONOUS) {
-                        R = mdp->getExpectedReward(s, a) + pV[s2] - baseline;
+                        R = R_sa + pV[s2] - baseline;
                     } else {
-                        R = mdp->getExpectedReward(s, a) + V[s2] - baseline;
+                        R = R_sa + RelaxedLoad(&V[s2]) - baseline;
                     }
                     S += P * R;
                 }
@@ -110,20 +144,41 @@ void AverageValueIteration::ComputeStateValues(real threshold, int max_iter)
             }
             if (c_a_max != a_max[s]) {
                 a_max[s] = c_a_max;
-                n_policy_changes++;
+                changes++;
             }
-            V[s] = Q_a_max;
-            dV[s] = pV[s] - V[s];
+            RelaxedStore(&V[s], Q_a_max);
+            dV[s] = pV[s] - Q_a_max;
+            dV_min = std::min(dV_min, dV[s]);
+            dV_max = std::max(dV_max, dV[s]);
             if (!SYNCHRONOUS) {
-                pV[s] = V[s];
+                pV[s] = Q_a_max;
             }
         }
+        block_policy_changes[k] = changes;
+        block_dV_min[k] = dV_min;
+        block_dV_max[k] = dV_max;
+    };
+    std::function<void (int)> copy = [&] (int k) {
+        for (int s=block[k]; s<block[k + 1]; s++) {
+            pV[s] = V[s];
+        }
+    };
 
-        if (SYNCHRONOUS) {
+    do {
+        baseline = 0.0;
+        if (RELATIVE) {
             for (int s=0; s<n_states; s++) {
-                pV[s] = V[s];
+                baseline += p_b[s] * V[s];
             }
         }
+        //baseline = = real(n_states);
+        RunBlocks(n_blocks, sweep);
+        if (SYNCHRONOUS) {
+            RunBlocks(n_blocks, copy);
+        }
+        for (int k=0; k<n_blocks; ++k) {
+            n_policy_changes += block_policy_changes[k];
+        }
 
 #ifdef RECALCULATE_P_B
         if (RELATIVE) { 
@@ -132,13 +187,8 @@ void AverageValueIteration::ComputeStateValues(real threshold, int max_iter)
             }
             for (int s=0; s<n_states; s++) {
                 // calculate new p_b
-                DiscreteStateSet next = mdp->getNextStates(s, a_max[s]);
-                for (DiscreteStateSet::iterator i=next.begin();
-                     i!=next.end();
-                     ++i) {
-                    int s2 = *i;
-                    real P = mdp->getTransitionProbability(s, a_max[s], s2);
-                    p_tmp[s2] += p_b[s] * P;
+                for (int k=model.RowBegin(s, a_max[s]); k<model.RowEnd(s, a_max[s]); ++k) {
+                    p_tmp[model.next_state[k]] += p_b[s] * model.probability[k];
                 }
             }
             for (int s=0; s<n_states; s++) {
@@ -147,7 +197,15 @@ void AverageValueIteration::ComputeStateValues(real threshold, int max_iter)
         }
 #endif
         pDelta = Delta;
-        Delta = Span(dV);
+        if (n_blocks > 0) {
+            real dV_min = block_dV_min[0];
+            real dV_max = block_dV_max[0];
+            for (int k=1; k<n_blocks; ++k) {
+                dV_min = std::min(dV_min, block_dV_min[k]);
+                dV_max = std::max(dV_max, block_dV_max[k]);
+            }
+            Delta = dV_max - dV_min;
+        }
         if (pDelta > 0) {
             d2Delta = Delta - pDelta;
             dDelta += d2Delta;
@@ -15,11 +15,24 @@
 
 #include "ValueIteration.h"
 #include "DiscreteMDP.h"
+#include "CompiledDiscreteMDP.h"
+#include "ThreadPool.h"
 #include "real.h"
+#include <functional>
 #include <vector>
 
+/** Value iteration for the average reward criterion.
+
+    If a thread pool is set, blocks of states are updated in parallel.
+    In the asynchronous case, each thread then sees the latest values
+    written by the others.
+*/
 class AverageValueIteration
 {
+protected:
+    CompiledDiscreteMDP model; ///< compiled snapshot of the MDP
+    ThreadPool* pool; ///< threads for parallel sweeps, NULL if serial
+    void RunBlocks(int n_blocks, const std::function<void (int)>& f);
 public:
     const bool RELATIVE;
     const bool SYNCHRONOUS;
@@ -43,6 +56,11 @@ public:
     ~AverageValueIteration();
     void Reset();
     void ComputeStateValues(real threshold, int max_iter=-1);
+    /// Use a thread pool for the sweeps; NULL for serial sweeps.
+    inline void setThreadPool(ThreadPool* pool_)
+    {
+        pool = pool_;
+    }
     inline real getValue (int state, int action)
     {
         assert(state>=0 && state < n_states);
@@ -13,4 +13,46 @@
 #include "BackwardsInduction.h"
 //#include <list>
 
-// No code, as we are using templates.
+// The graph version has no code, as we are using templates.
+
+DiscreteMDPBackwardsInduction::DiscreteMDPBackwardsInduction(const DiscreteMDP* mdp, real gamma_, int horizon_)
+    : model(mdp),
+      n_states(mdp->getNStates()),
+      n_actions(mdp->getNActions()),
+      gamma(gamma_),
+      horizon(horizon_),
+      V(horizon_ + 1, n_states),
+      policy(horizon_ * n_states)
+{
+    assert(gamma >= 0 && gamma <= 1);
+    assert(horizon >= 0);
+}
+
+/// Calculate the values and policy for all stages.
+void DiscreteMDPBackwardsInduction::Calculate()
+{
+    model.Update();
+    for (int s=0; s<n_states; ++s) {
+        V(horizon, s) = 0.0;
+    }
+    Vector V_next(n_states);
+    for (int t=horizon - 1; t>=0; --t) {
+        for (int s=0; s<n_states; ++s) {
+            V_next(s) = V(t + 1, s);
+        }
+        for (int s=0; s<n_states; ++s) {
+            int a_max = 0;
+            real Q_max = 0.0;
+            for (int a=0; a<n_actions; ++a) {
+                real Q_sa = model.getExpectedReward(s, a)
+                    + gamma * model.Expectation(s, a, V_next);
+                if (a == 0 || Q_sa > Q_max) {
+                    Q_max = Q_sa;
+                    a_max = a;
+                }
+            }
+            V(t, s) = Q_max;
+            policy[t * n_states + s] = a_max;
+        }
+    }
+}
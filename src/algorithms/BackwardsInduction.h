@@ -15,9 +15,12 @@
 
 
 #include "SparseGraph.h"
+#include "CompiledDiscreteMDP.h"
+#include "Matrix.h"
 #include "Vector.h"
 #include <stdexcept>
 #include <iostream>
+#include <vector>
 
 class InductionOperator
 {
@@ -91,6 +94,45 @@ public:
     void calculate_loopy(NodeList T, int max_iter, real end_accuracy);
 };
 
+/** Finite-horizon backwards induction on a discrete MDP.
+
+    Starting from \f$V_T(s) = 0\f$, it calculates
+    \f[
+    Q_t(s,a) = r(s,a) + \gamma \sum_{s'} P(s' | s, a) V_{t+1}(s'),
+    \qquad
+    V_t(s) = \max_a Q_t(s,a)
+    \f]
+    for \f$t = T - 1, \ldots, 0\f$, using a compiled snapshot of the MDP.
+*/
+class DiscreteMDPBackwardsInduction
+{
+protected:
+    CompiledDiscreteMDP model; ///< compiled snapshot of the MDP
+public:
+    int n_states; ///< number of states
+    int n_actions; ///< number of actions
+    real gamma; ///< discount factor
+    int horizon; ///< the horizon T
+    Matrix V; ///< V(t, s) is the value of s at stage t
+    std::vector<int> policy; ///< optimal action of state s at stage t
+    DiscreteMDPBackwardsInduction(const DiscreteMDP* mdp, real gamma_, int horizon_);
+    void setMDP(const DiscreteMDP* mdp)
+    {
+        model.setMDP(mdp);
+    }
+    void Calculate();
+    inline real getValue(int t, int s) const
+    {
+        return V(t, s);
+    }
+    inline int getAction(int t, int s) const
+    {
+        assert(t >= 0 && t < horizon);
+        assert(s >= 0 && s < n_states);
+        return policy[t * n_states + s];
+    }
+};
+
 
 
 #endif
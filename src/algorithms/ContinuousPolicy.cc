@@ -59,6 +59,20 @@ int FixedContinuousPolicy::SelectAction(const Vector& next_state)
 	return  MultinomialDistribution::generateInt(p);
 }
 
+/** Select an action for a state whose basis features are already known.
+
+	This behaves like SelectAction(state), with Phi the output of the
+	basis for the state, but does not change the current state.
+*/
+int FixedContinuousPolicy::SelectActionFromFeatures(const Vector& Phi)
+{
+	StatePolicy(Phi);
+    if (epsilon_greedy && urandom() < epsilon) {
+        return urandom(0, n_actions);
+    }
+	return  MultinomialDistribution::generateInt(p);
+}
+
 void FixedContinuousPolicy::Observe(const Vector& previous_state, const int& action, real r, const Vector& next_state)
 {
     state = next_state;
@@ -101,9 +115,14 @@ void FixedContinuousPolicy::Show()
 
 void FixedContinuousPolicy::StatePolicy()
 {
-	Vector Q(n_actions);
 	bfs->Evaluate(state);
-	Vector Phi = bfs->F();
+	StatePolicy(bfs->F());
+}
+
+/// Put all probability on the best action for features Phi
+void FixedContinuousPolicy::StatePolicy(const Vector& Phi)
+{
+	Vector Q(n_actions);
 	for(int i = 0; i< n_actions; ++i)
 	{
 		Q[i] = weights[(bfs->size() + 1)*i];
@@ -62,6 +62,7 @@ public:
 	virtual ~FixedContinuousPolicy();
 	virtual int SelectAction();
 	virtual int SelectAction(const Vector& next_state);
+	int SelectActionFromFeatures(const Vector& Phi);
 	virtual void Observe(const Vector& previous_state, const int& action, real r, const Vector& next_state);
 	virtual void Observe(real r, const Vector& next_state);
 	virtual void Reset()
@@ -83,6 +84,7 @@ public:
 		return weights;
 	}
 	inline void StatePolicy();
+	inline void StatePolicy(const Vector& Phi);
     virtual void setEpsilonGreedy(real epsilon_) 
     {
         epsilon_greedy = true;
@@ -98,10 +98,12 @@ public:
 		weights = Vector::Null(dim); 
 		Vector V(n_actions);
 		int n_iter = 0;
+		std::vector<Vector> Phi;
 		do {
 			AA = Matrix::Unity(dim,dim)*0;
 			b.Clear();
 			real steps = 0.0;
+			BasisConstruction(states, Phi);
 			for(int i=0; i<N; ++i)
 			{	
 				//Find best action - policy.
@@ -123,7 +125,7 @@ public:
 				environment->Reset();
 				environment->setState(states[i]);
 				
-				phi		= BasisConstruction(states[i]);
+				phi		= Phi[i];
 				final	= environment->Act(a);
 				r		= environment->getReward(); //Received Reward
 				
@@ -265,6 +267,33 @@ public:
 		return phi;
 	}
 	
+	/// Basis functions of many states; the cover trees find all paths in one batch.
+	void BasisConstruction(const std::vector<S>& samples, std::vector<Vector>& Phi)
+	{
+		int n_samples = samples.size();
+		Phi.resize(n_samples);
+		if(!strcmp(environment->Name(), "Bike") || tilings != 0 || RBFs != NULL) {
+			for(int i = 0; i<n_samples; ++i) {
+				Phi[i] = BasisConstruction(samples[i]);
+			}
+			return;
+		}
+		for(int i = 0; i<n_samples; ++i) {
+			Phi[i] = Vector(dim);
+		}
+		std::vector< std::vector< std::pair<int, real> > > paths;
+		int dim_current = 0;
+		for(int a = 0; a<n_actions; ++a) {
+			cover[a]->ExternalBasisCreation(samples, paths);
+			for(int i = 0; i<n_samples; ++i) {
+				for(uint j = 0; j < paths[i].size(); ++j) {
+					Phi[i](dim_current + (paths[i][j].first - 1)) = paths[i][j].second;
+				}
+			}
+			dim_current += cover[a]->GetNumBasisNodes();
+		}
+	}
+	
 	void Reset() {
 		if(RBFs==NULL) {
 			dim = 0;
@@ -14,6 +14,7 @@
 
 #include "BayesianMultivariateRegression.h"
 #include "BasisSet.h"
+#include "BlockVector.h"
 #include "Environment.h"
 #include "Matrix.h"
 #include "Random.h"
@@ -85,9 +86,8 @@ public:
 		int a;
 	    Matrix AA;
 		Vector b(dim);
-		Vector dif;
-		Vector phi_;
-		Vector phi;
+		BlockVector phi_;
+		BlockVector phi;
 		
 		real r;
 		bool final;
@@ -97,11 +97,17 @@ public:
 		weights = Vector::Unity(dim);
 		Vector V(n_actions);
 		int n_iter = 0;
+		std::vector< std::vector< std::vector< std::pair<int, real> > > > paths(n_actions);
 		do {
 			AA = Matrix::Null(dim,dim);
 			b.Clear();
 			distance = 0.1;
 			real steps = 0.0;
+			if(RBFs == NULL) {
+				for(a = 0; a < n_actions; a++) {
+					cover[a]->ExternalBasisCreation(states, paths[a]);
+				}
+			}
 			for(int i=0; i<N; ++i)
 			{	
 				//Find best action - policy.
@@ -109,11 +115,16 @@ public:
 					environment->Reset();
 					environment->setState(states[i]);
 				
-					phi = BasisConstruction(states[i],a);
+					if(RBFs == NULL) {
+						BasisConstruction(paths[a][i], a, phi);
+					} else {
+						BasisConstruction(states[i], a, phi);
+					}
 					//				phi.print(stdout);
 					final = environment->Act(a);
 					r = environment->getReward();
 				
+					AddOuterProduct(AA, 1.0, phi, phi);
 					if(final) {
 						int a_next;
 						Vector next_state = cover[a]->GenerateState(states[i]);
@@ -121,16 +132,11 @@ public:
 							V[a_next] = getValue(next_state,a_next);
 						}
 						a_next	 = ArgMax(V);
-						phi_ = BasisConstruction(next_state, a_next);
-						dif	 = phi - (phi_*gamma);
+						BasisConstruction(next_state, a_next, phi_);
+						AddOuterProduct(AA, -gamma, phi, phi_);
 					}
-					else {
-						dif = phi;
-					}	
 					steps++;
-					Matrix res = OuterProduct(phi,dif);
-					AA += res;					
-					b  += phi*r;
+					phi.AddTo(b, r);
 				}
 			}	
 			weights = ((1.0/steps)*AA + (lambda*steps)*Matrix::Unity(dim,dim)).Inverse_LU()*(b*(1/steps));
@@ -161,7 +167,8 @@ public:
 	
 	real getValue(const S& state, const A& action) 
 	{
-		Vector phi = BasisConstruction(state,action);
+		BlockVector phi;
+		BasisConstruction(state, action, phi);
 		return Product(weights,phi);
 	}
 	
@@ -192,35 +199,47 @@ public:
 	
 	/// Basis function construction based on the cover trees.
 	Vector BasisConstruction(const S& state, const A& action)
+	{
+		BlockVector phi;
+		BasisConstruction(state, action, phi);
+		return phi.getDense();
+	}
+	
+	/// Basis function construction, keeping only the non-zero block.
+	void BasisConstruction(const S& state, const A& action, BlockVector& phi)
 	{
 		assert(action >= 0);
-		Vector phi(dim);
 		if(RBFs == NULL) 
 		{
-			int dim_current = 0;
-			for(int i = 0; i < action; ++i) {
-				dim_current += cover[i]->GetNumBasisNodes();
-			}
-			
-			std::vector< std::pair<int, real> > path = cover[action]->ExternalBasisCreation(state);
-			for(uint j = 0; j < path.size(); ++j) {
-				int index	= dim_current + (path[j].first - 1);
-				phi[index]	= path[j].second; 
-			}
+			BasisConstruction(cover[action]->ExternalBasisCreation(state), action, phi);
 		}
 		else {
+			// each action block starts with its own constant term
+			int offset = (RBFs->size() + 1)*action;
+			phi.Resize(dim, offset, RBFs->size() + 1);
 			RBFs->Evaluate(state);
-			Vector Phi_state = RBFs->F();
-			phi[(RBFs->size() + 1)*action] = 1.0;
+			const Vector& Phi_state = RBFs->F();
+			phi.block[0] = 1.0;
 			
 			for(int i = 0; i<RBFs->size(); ++i)
 			{
-				phi[(RBFs->size() + 1)*action + i + 1] = Phi_state[i];
+				phi.block[i + 1] = Phi_state[i];
 			}
-			phi[dim-1] = 1.0; 
 		}
 		//		phi.print(stdout);
-		return phi;
+	}
+	
+	/// Basis function construction from a path found by the cover tree of the action.
+	void BasisConstruction(const std::vector< std::pair<int, real> >& path, const A& action, BlockVector& phi)
+	{
+		int dim_current = 0;
+		for(int i = 0; i < action; ++i) {
+			dim_current += cover[i]->GetNumBasisNodes();
+		}
+		phi.Resize(dim, dim_current, cover[action]->GetNumBasisNodes());
+		for(uint j = 0; j < path.size(); ++j) {
+			phi.block[path[j].first - 1] = path[j].second; 
+		}
 	}
 	
 	void Reset() {
@@ -49,14 +49,12 @@ DiscreteABCRL::DiscreteABCRL(int n_states_,
   
   real w_i = 1.0 / (real) max_samples;
   mdp_list.resize(max_samples);
-  value_iteration.resize(max_samples);
   printf("# Generating mean MDP\n");
   //mdp_list[0] = model->getMeanMDP();
   for (int i=0; i<max_samples; ++i) {
     printf("# Generating sampled MDP\n");
     mdp_list[i] = GenerateMDP();
     weights[i] = w_i;
-    value_iteration[i] = new ValueIteration(mdp_list[i], gamma);
   }
 
   printf ("# Setting up MultiMPDValueIteration\n");
@@ -69,7 +67,6 @@ DiscreteABCRL::~DiscreteABCRL()
 
   for (int i=0; i<max_samples; ++i) {
     delete mdp_list[i];
-    delete value_iteration[i];
   }
   delete multi_value_iteration;
 }
@@ -160,17 +157,15 @@ void DiscreteABCRL::Resample()
 
 void DiscreteABCRL::CalculateUpperBound(real accuracy, int iterations)
 {
-  for (int j=0; j<max_samples; ++j) {
-    value_iteration[j]->setMDP(mdp_list[j]);
-    value_iteration[j]->ComputeStateValuesStandard(accuracy, iterations);
-  }
+  multi_value_iteration->setMDPList(mdp_list);
+  multi_value_iteration->ComputeIndividualStateValues(accuracy, iterations);
     
   real Z = 1.0 / (real) max_samples;
   for (int s=0; s<n_states; ++s) {
     for (int a=0; a<n_actions; ++a) {
       QU(s,a) = 0;
       for (int i=0; i<max_samples; i++) {
-        QU(s, a) += value_iteration[i]->getValue(s, a);
+        QU(s, a) += multi_value_iteration->getValue(i, s, a);
       }
     }
   }
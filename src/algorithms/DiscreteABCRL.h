@@ -53,8 +53,7 @@ protected:
   EnvironmentGenerator<int, int>* generator; ///< generator
   Demonstrations<int, int> demonstrations; ///< demonstrations
   std::vector<DiscretePolicy*> policies;
-  std::vector<ValueIteration*> value_iteration; ///< value iteration on each separate model
-  MultiMDPValueIteration* multi_value_iteration; ///< multi-MDP value iteration
+  MultiMDPValueIteration* multi_value_iteration; ///< multi-MDP value iteration, for both bounds
   std::vector<real> tmpQ;
   Vector VU; ///< upper bound value
   Vector VL; ///< lower bound value
@@ -12,6 +12,7 @@
 
 #include "DiscreteBanditPolicy.h"
 #include "Random.h"
+#include <algorithm>
 
 /// Make e-greedy
 EpsilonGreedyPolicy::EpsilonGreedyPolicy(int n_actions, real epsilon, ActionValueEstimate* estimator)
@@ -240,6 +241,11 @@ PFVPIPolicy::~PFVPIPolicy()
 {
 }
 
+/** Select the action with the highest mean plus value of information.
+
+    The gain of each arm is a single sweep over its particles, written
+    so that the compiler can vectorise it.
+*/
 int PFVPIPolicy::SelectAction()
 {
     int j = estimator->GetMax();
@@ -250,17 +256,22 @@ int PFVPIPolicy::SelectAction()
     real U_max = -1;
     for (int i=0; i<n_actions; i++) {
         real V = estimator->GetMean(i);
-        real Gain = 0.0f;
         int N = estimator->q[i].N;
+        const real* q_i = &estimator->q[i].y[0];
+        const real* p_i = &estimator->q[i].w[0];
+        real Gain = 0.0f;
         real sum = 0.0;
-        for (int n=0; n<N; n++) {
-            real q_i = estimator->q[i].y[n];
-            real p_i = estimator->q[i].w[n];
-            sum += p_i;
-            if (i==j && q_j2 > q_i) {
-                Gain += (q_j2 - q_i)*p_i;
-            } else if (i!=j && q_i > q_j) {
-                Gain += (q_i - q_j)*p_i;
+        if (i==j) {
+            // the best arm gains if it is worse than the second best
+            for (int n=0; n<N; n++) {
+                Gain += std::max(q_j2 - q_i[n], (real) 0.0) * p_i[n];
+                sum += p_i[n];
+            }
+        } else {
+            // other arms gain if they are better than the best
+            for (int n=0; n<N; n++) {
+                Gain += std::max(q_i[n] - q_j, (real) 0.0) * p_i[n];
+                sum += p_i[n];
             }
         }
         real U = V + Gain/sum;
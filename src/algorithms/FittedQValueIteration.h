@@ -15,6 +15,7 @@
 
 #include "BayesianMultivariateRegression.h"
 #include "BasisSet.h"
+#include "BlockVector.h"
 #include "Environment.h"
 #include "Matrix.h"
 #include "Random.h"
@@ -156,16 +157,9 @@ public:
 	}
 	Vector BasisFunction(const S& state, const A& action)
 	{
-		RBFs->Evaluate(state);
-		Vector Phi_state = RBFs->F();
-		Vector Phi(dim);
-		Phi[(RBFs->size() + 1)*action] = 1.0;
-		
-		for(int i = 0; i<RBFs->size(); ++i)
-        {
-            Phi[(RBFs->size() + 1)*action + i + 1] = Phi_state[i];
-        }
-		return Phi;
+		BlockVector Phi;
+		BasisFunction(state, action, Phi);
+		return Phi.getDense();
 		
 	//	RBFs->Evaluate(state);
 //		Vector Phi = RBFs->F();
@@ -175,6 +169,11 @@ public:
 //		
 //		return Phi;
 	}
+	/// The state-action features, keeping only the block of the action.
+	void BasisFunction(const S& state, const A& action, BlockVector& Phi)
+	{
+		RBFs->Evaluate(state, action, n_actions, Phi);
+	}
 	real getValue(const S& state)
 	{
 		Vector Q(n_actions);
@@ -184,7 +183,8 @@ public:
 	}
 	real getValue(const S& state, const A& action)
 	{
-		Vector phi = BasisFunction(state,action);
+		BlockVector phi;
+		BasisFunction(state, action, phi);
 		return Product(weights,phi);
 	}
 	//void sampleSelection() {
@@ -159,12 +159,21 @@ public:
 		Vector S_L	= environment->StateLowerBound();
 		Vector S_U	= environment->StateUpperBound();
 		states.clear();
-		PHI = Matrix(dim,N);
+		Matrix X(N, S_L.Size());
 		for(int i=0; i<N; ++i) {
 			Vector state = urandom(S_L, S_U);
 			states.push_back(state);
-			Vector phi = BasisAPICreation(state);
-			PHI.setColumn(i,phi);
+			X.setRow(i, state);
+		}
+		// featurise all states at once; the last feature is constant
+		Matrix F;
+		RBFs->Evaluate(X, F);
+		PHI = Matrix(dim,N);
+		for(int i=0; i<N; ++i) {
+			for(int j=0; j<dim-1; ++j) {
+				PHI(j, i) = F(i, j);
+			}
+			PHI(dim-1, i) = 1.0;
 		}
 		pseudo_inv = (PHI*Transpose(PHI) + lambda*Matrix::Unity(dim,dim)).Inverse()*PHI;
 	}
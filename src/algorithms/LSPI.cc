@@ -10,6 +10,7 @@
  ***************************************************************************/
 
 #include "LSPI.h"
+#include "RecursiveLSTDQ.h"
 
 LSPI::LSPI(real gamma_, real Delta_, int n_dimension_, int n_actions_, int max_iteration_, RBFBasisSet* bfs_, Rollout<Vector,int,AbstractPolicy<Vector, int> >* Samples_)
  :gamma(gamma_),
@@ -68,6 +69,12 @@ Vector LSPI::BasisFunction(const Vector& state, int action)
 	return Phi;
 }
 
+/// Compute the features of a state-action pair, keeping only the block of the action.
+void LSPI::BasisFunction(const Vector& state, int action, BlockVector& Phi)
+{
+	bfs->Evaluate(state, action, n_actions, Phi);
+}
+
 //Vector LSPI::BasisFunction(const Vector& state, int action)
 //{
 //	Vector phi(n_basis);
@@ -96,26 +103,82 @@ Vector LSPI::BasisFunction(const Vector& state, int action)
 //	return phi;
 //}
 
+/** Compute the basis features of all sampled states and next states.
+
+	This is done with one batch call for each set of states. The
+	features are reused by every policy evaluation, and computed
+	again automatically if the number of samples changes. If the
+	samples are otherwise changed, this must be called again.
+*/
+void LSPI::FeaturiseSamples()
+{
+	int N = Samples->getNSamples();
+	Matrix X;
+	Matrix X_next;
+	int k = 0;
+	for(int i=0; i<Samples->getNRollouts(); ++i) {
+		for(int j=0; j<Samples->getNSamples(i); ++j, ++k) {
+			Vector s = Samples->getState(i,j);
+			Vector s2 = Samples->getNextState(i,j);
+			if (k == 0) {
+				X.Resize(N, s.Size());
+				X_next.Resize(N, s2.Size());
+			}
+			X.setRow(k, s);
+			X_next.setRow(k, s2);
+		}
+	}
+	if (N == 0) {
+		state_features.Resize(0, 0);
+		next_state_features.Resize(0, 0);
+		return;
+	}
+	bfs->Evaluate(X, state_features);
+	bfs->Evaluate(X_next, next_state_features);
+}
+
+/// The state-action features of sample k, from the cached features F
+void LSPI::CachedBasisFunction(const Matrix& F, int k, int action, BlockVector& Phi)
+{
+	int block_size = bfs->size() + 1;
+	Phi.Resize(n_basis, block_size * action, block_size);
+	Phi.block[0] = 1.0;
+	for (int i=0; i<bfs->size(); ++i) {
+		Phi.block[i + 1] = F(k, i);
+	}
+}
+
+/// The action of the policy at the next state of sample k
+int LSPI::CachedSelectAction(int k)
+{
+	scratch.Resize(bfs->size());
+	for (int i=0; i<bfs->size(); ++i) {
+		scratch[i] = next_state_features(k, i);
+	}
+	return policy.SelectActionFromFeatures(scratch);
+}
+
 void LSPI::LSTDQ()
 {
-	Vector Phi_;
-	Vector Phi;
-	Matrix res;
+	BlockVector Phi_;
+	BlockVector Phi;
 
     A = Matrix::Unity(n_basis,n_basis) * 1e-6;
     b.Clear();
+    if (state_features.Rows() != Samples->getNSamples()) {
+        FeaturiseSamples();
+    }
         
+    int k = 0;
     for(int i=0; i<Samples->getNRollouts(); ++i) {
-        for(int j=0; j<Samples->getNSamples(i); ++j) {
-            Phi_ = BasisFunction(Samples->getState(i,j), Samples->getAction(i,j));
-            if(Samples->getEndsim(i,j)){
-                res = OuterProduct(Phi_, Phi_);
-            } else{
-                Phi = BasisFunction(Samples->getNextState(i,j),policy.SelectAction(Samples->getNextState(i,j)));
-                res = OuterProduct(Phi_,(Phi_ - (Phi*gamma)));
+        for(int j=0; j<Samples->getNSamples(i); ++j, ++k) {
+            CachedBasisFunction(state_features, k, Samples->getAction(i,j), Phi_);
+            AddOuterProduct(A, 1.0, Phi_, Phi_);
+            if(!Samples->getEndsim(i,j)){
+                CachedBasisFunction(next_state_features, k, CachedSelectAction(k), Phi);
+                AddOuterProduct(A, -gamma, Phi_, Phi);
             }
-            A += res;
-            b += Phi_*Samples->getReward(i,j);
+            Phi_.AddTo(b, Samples->getReward(i,j));
         }
     }
     const Matrix w_ = A.Inverse_LU();
@@ -123,21 +186,17 @@ void LSPI::LSTDQ()
 }
 void LSPI::LSTDQ(const Vector& state, const int& action, const real& reward, const Vector& state_, const int& action_, const bool& endsim, const bool& update) 
 {
-	Vector Phi_;
-	Vector Phi;
-	Matrix res;
+	BlockVector Phi_;
+	BlockVector Phi;
 	
-	Phi_ = BasisFunction(state, action);
-	if(endsim) {
-		res = OuterProduct(Phi_, Phi_);
-	}
-	else {
-		Phi = BasisFunction(state_,action_);
-		res = OuterProduct(Phi_,(Phi_ - (Phi*gamma)));
+	BasisFunction(state, action, Phi_);
+	AddOuterProduct(A, 1.0, Phi_, Phi_);
+	if(!endsim) {
+		BasisFunction(state_, action_, Phi);
+		AddOuterProduct(A, -gamma, Phi_, Phi);
 	}
 	
-	A += res;
-	b += Phi_*reward;
+	Phi_.AddTo(b, reward);
 
 	
 	const Matrix w_ = A.Inverse_LU();
@@ -147,37 +206,32 @@ void LSPI::Update()
 {
 	policy.Update(w);
 }
+/// Calculate the weights recursively, without inverting A.
 void LSPI::LSTDQ_OPT()
 {
-	Vector Phi_;
-	Vector Phi;
-	Vector Phi_dif;
-	Matrix res;
-	real d = 0.000001;
-	A = Matrix::Unity(n_basis,n_basis) * (1/d);
-	b.Clear();
+	BlockVector Phi_;
+	BlockVector Phi;
+	RecursiveLSTDQ rls(n_basis, gamma);
+	if (state_features.Rows() != Samples->getNSamples()) {
+		FeaturiseSamples();
+	}
 	
+	int k = 0;
 	for(int i=0; i<Samples->getNRollouts(); ++i)
         {
-            for(int j=0; j<Samples->getNSamples(i); ++j)
+            for(int j=0; j<Samples->getNSamples(i); ++j, ++k)
                 {
-                    Phi_ = BasisFunction(Samples->getState(i,j), Samples->getAction(i,j));
+                    CachedBasisFunction(state_features, k, Samples->getAction(i,j), Phi_);
                     if(Samples->getEndsim(i,j)){
-                        Phi_dif = Phi_;
+                        rls.ObserveTerminal(Phi_.getDense(), Samples->getReward(i,j));
                     }
                     else{
-                        Phi = BasisFunction(Samples->getNextState(i,j),policy.SelectAction(Samples->getNextState(i,j)));
-                        Phi_dif = Phi_ - (Phi*gamma);
+                        CachedBasisFunction(next_state_features, k, CachedSelectAction(k), Phi);
+                        rls.Observe(Phi_.getDense(), Samples->getReward(i,j), Phi.getDense());
                     }
-                    res = OuterProduct(Phi_,Phi_dif);
-                    const Matrix p = A;
-                    real v = Product(p*Phi_,Phi_dif);
-                    A -= (((A*res)*A) / (v + 1));
-                    b += Phi_ * Samples->getReward(i,j);
                 }
         }
-	const Matrix w_ = A;
-	w = w_*b;
+	w = rls.getWeights();
 }
 
 void LSPI::PolicyIteration()
@@ -185,6 +239,7 @@ void LSPI::PolicyIteration()
 	Vector old_w;
 	real distance;
 	int iteration = 0;
+	FeaturiseSamples();
 	while(1)
         {
             //Policy Evaluation
@@ -223,6 +278,8 @@ void LSPI::Reset()
 }
 real LSPI::getValue(const Vector& state, int action)
 {
-	return Product(BasisFunction(state,action),w);
+	BlockVector Phi;
+	BasisFunction(state, action, Phi);
+	return Product(Phi, w);
 }
 
@@ -18,6 +18,7 @@
 #include "Vector.h"
 #include "Matrix.h"
 #include "BasisSet.h"
+#include "BlockVector.h"
 #include "ContinuousPolicy.h"
 #include "RandomPolicy.h"
 #include <vector>
@@ -38,15 +39,22 @@ protected:
 	RBFBasisSet* bfs;
 	Rollout<Vector,int,AbstractPolicy<Vector, int> >* Samples;
 	FixedContinuousPolicy policy;
+	Matrix state_features; ///< basis features of the sampled states, one row per sample
+	Matrix next_state_features; ///< basis features of the sampled next states
+	Vector scratch; ///< one row of features
+	void CachedBasisFunction(const Matrix& F, int k, int action, BlockVector& Phi);
+	int CachedSelectAction(int k);
 public:	
 	LSPI(real gamma_, real Delta_, int n_dimension_, int n_actions_, int max_iteration_, RBFBasisSet* bfs_, Rollout<Vector,int,AbstractPolicy<Vector, int> >* Samples_);
 	LSPI(real gamma_, real Delta_, int n_dimension_, int n_actions_, int max_iteration_, int algorithm_, RBFBasisSet* bfs_, Rollout<Vector,int,AbstractPolicy<Vector, int> >* Samples_);
 	~LSPI();
 	
 	Vector BasisFunction(const Vector& state, int action);
+	void BasisFunction(const Vector& state, int action, BlockVector& Phi);
 	void LSTDQ();
 	void LSTDQ(const Vector& state, const int& action, const real& reward, const Vector& state_, const int& action_, const bool& endsim, const bool& update = true);
 	void LSTDQ_OPT();
+	void FeaturiseSamples();
 	void PolicyIteration();
 	void Reset();
 	void Update();
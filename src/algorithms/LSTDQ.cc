@@ -10,6 +10,7 @@
  ***************************************************************************/
 
 #include "LSTDQ.h"
+#include "RecursiveLSTDQ.h"
 
 LSTDQ::LSTDQ(real gamma_,
              int n_dimension_,
@@ -57,23 +58,36 @@ LSTDQ::~LSTDQ()
 
 Vector LSTDQ::BasisFunction(const Vector& state, int action) const
 {
-    bfs.Evaluate(state);
-    Vector Phi_state = bfs.F();
     Vector Phi(n_basis);
+    BasisFunction(state, action, Phi);
+    return Phi;
+}
+
+/// Compute the features of a state-action pair into Phi, without allocating.
+void LSTDQ::BasisFunction(const Vector& state, int action, Vector& Phi) const
+{
+    bfs.Evaluate(state);
+    const Vector& Phi_state = bfs.F();
+    Phi.Resize(n_basis);
+    Phi.Clear();
     Phi[(bfs.size() + 1)*action] = 1.0;
     
     for(int i = 0; i<bfs.size(); ++i)
         {
             Phi[(bfs.size() + 1)*action + i + 1] = Phi_state[i];
         }
-    return Phi;
+}
+
+/// Compute the features of a state-action pair, keeping only the block of the action.
+void LSTDQ::BasisFunction(const Vector& state, int action, BlockVector& Phi) const
+{
+    bfs.Evaluate(state, action, n_actions, Phi);
 }
 
 void LSTDQ::Calculate()
 {
-    Vector Phi_;
-    Vector Phi;
-    Matrix res;
+    BlockVector Phi_;
+    BlockVector Phi;
     A = Matrix::Unity(n_basis,n_basis) * 1e-6;
     b.Clear();
 	
@@ -83,52 +97,41 @@ void LSTDQ::Calculate()
 			Swarning("sample legnth %d is %d\n", i, Samples.length(i));
 		}
         for(int t=0; t<(int)Samples.length(i) - 1; ++t) {
-            Vector s_t = Samples.state(i,t); 
             int a_t = Samples.action(i,t);
-            Phi_ = BasisFunction(s_t, a_t);
+            BasisFunction(Samples.state(i,t), a_t, Phi_);
             if (Samples.terminated(i) && t >= (int)Samples.length(i) - 3) {
-                res =  OuterProduct(Phi_, Phi_);
+                AddOuterProduct(A, 1.0, Phi_, Phi_);
             } else {
-                Vector s2 = Samples.state(i, t+1);
                 //int a2 = policy.SelectAction(s2);
                 int a2 = Samples.action(i, t+1);
-                Phi = BasisFunction(s2, a2);
-                res = OuterProduct(Phi_,(Phi_ - (Phi*gamma)));
+                BasisFunction(Samples.state(i, t+1), a2, Phi);
+                AddOuterProduct(A, 1.0, Phi_, Phi_);
+                AddOuterProduct(A, -gamma, Phi_, Phi);
             }
-            A += res;
-            b += Phi_* Samples.reward(i,t);
+            Phi_.AddTo(b, Samples.reward(i,t));
         }
     }
     const Matrix w_ = A.Inverse_LU();
     w = w_*b;
 }
+/// Calculate the weights recursively, without inverting A.
 void LSTDQ::Calculate_Opt()
 {
-    Vector Phi_;
-    Vector Phi;
-    Vector Phi_dif;
-    Matrix res;
-    real d = 0.000001;
-    A = Matrix::Unity(n_basis,n_basis) * (1/d);
-    b.Clear();
+    Vector Phi_(n_basis);
+    Vector Phi(n_basis);
+    RecursiveLSTDQ rls(n_basis, gamma);
     
     for(uint i=0; i<Samples.size(); ++i) {
 		//logmsg ("Trajectory %d\n", i);
         for(int t=0; t<(int) Samples.length(i) - 1; ++t) {
 			//logmsg ("Time %d/%d\n", t, Samples.length(i));
-            Phi_ = BasisFunction(Samples.state(i,t), Samples.action(i,t));
+            BasisFunction(Samples.state(i,t), Samples.action(i,t), Phi_);
             Vector s = Samples.state(i, t+1);
-            Phi = BasisFunction(s,policy.SelectAction(s));
-            Phi_dif = Phi_ - (Phi*gamma);
-            res = OuterProduct(Phi_,Phi_dif);
-            const Matrix p = A;
-            real v = Product(p*Phi_,Phi_dif);
-            A -= (((A*res)*A) / (v + 1));
-            b += Phi_ * Samples.reward(i,t);
+            BasisFunction(s, policy.SelectAction(s), Phi);
+            rls.Observe(Phi_, Samples.reward(i,t), Phi);
         }
     }
-    const Matrix w_ = A;
-    w = w_*b;
+    w = rls.getWeights();
 }
 
 /// This seems to return zero all the time!
@@ -137,6 +140,8 @@ real LSTDQ::getValue(const Vector& state, int action) const
 	//Vector phi = BasisFunction(state,action);
 	//printf ("PHI: "); phi.print(stdout);
 	//printf("W: "); w.print(stdout);
-    return Product(BasisFunction(state,action),w);
+    BlockVector Phi;
+    BasisFunction(state, action, Phi);
+    return Product(Phi, w);
 }
 
@@ -17,6 +17,7 @@
 #include "Vector.h"
 #include "Matrix.h"
 #include "BasisSet.h"
+#include "BlockVector.h"
 #include "ContinuousPolicy.h"
 #include "RandomPolicy.h"
 #include <vector>
@@ -52,6 +53,8 @@ public:
 	~LSTDQ();
 	
 	Vector BasisFunction(const Vector& state, int action) const;
+	void BasisFunction(const Vector& state, int action, Vector& Phi) const;
+	void BasisFunction(const Vector& state, int action, BlockVector& Phi) const;
 	void Calculate();
 	void Calculate_Opt();
 	void Reset();
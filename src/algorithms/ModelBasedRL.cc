@@ -26,6 +26,8 @@ ModelBasedRL::ModelBasedRL(int n_states_,
       model(model_),
 	  rng(rng_),
       use_value_iteration(use_value_iteration_),
+      use_prioritized_sweeping(false),
+      max_backups(-1),
       total_steps(0)
 {
     state = -1;
@@ -91,7 +93,11 @@ int ModelBasedRL::Act(real reward, int next_state)
         //mdp = model->CreateMeanMDP();
         // update values
         value_iteration->setMDP(mdp);
-        value_iteration->ComputeStateValues(1e-6,1);
+        if (use_prioritized_sweeping) {
+            value_iteration->ComputeStateValuesPrioritized(1e-6, max_backups);
+        } else {
+            value_iteration->ComputeStateValues(1e-6,1);
+        }
         for (int i=0; i<n_actions; i++) {
             tmpQ[i] = value_iteration->getValue(next_state, i);
         }
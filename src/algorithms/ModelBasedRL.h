@@ -49,6 +49,8 @@ protected:
     std::vector<real> tmpQ;
 	RandomNumberGenerator* rng;
     bool use_value_iteration;
+    bool use_prioritized_sweeping; ///< re-plan by prioritized sweeping
+    int max_backups; ///< backups per step for prioritized sweeping, -1 for no limit
     int total_steps;
 public:
     ModelBasedRL(int n_states_,
@@ -77,6 +79,18 @@ public:
         }
     }
 
+    /** Re-plan after each step by prioritized sweeping.
+
+        Only the states affected by the new transition are backed up,
+        with at most max_backups_ backups per step, instead of a full
+        sweep over all states.
+    */
+    void setPrioritizedSweeping(bool use_prioritized_sweeping_, int max_backups_ = -1)
+    {
+        use_prioritized_sweeping = use_prioritized_sweeping_;
+        max_backups = max_backups_;
+    }
+
     virtual void setFixedRewards(const Matrix& rewards) 
     {
         model->setFixedRewards(rewards);
@@ -23,15 +23,59 @@
 #include "Grid.h"
 #include "Environment.h"
 #include "Random.h"
+#include "ThreadPool.h"
+#include "Arena.h"
+#include <atomic>
+#include <cassert>
+#include <chrono>
 #include <limits>
+#include <mutex>
 
 /** The original UCT Monte Carlo Tree Seach algorithm.
    
-	
+	By default the search is serial, and uses the environment, policy
+	and random number generator given to the constructor. For a
+	parallel search, add one worker per thread with addWorker() and
+	choose a mode with setParallelMode():
+
+	- ROOT_PARALLEL: every worker grows its own tree, and the root
+	  statistics of all trees are merged to select the action.
+
+	- TREE_PARALLEL: all workers grow a single tree. Visit counts are
+	  atomic, each node has a lock for expansion and updates, and
+	  nodes on a path that is still being simulated carry a virtual
+	  loss, so that workers spread out over the tree.
+
+	Each worker must own its environment, rollout policy and random
+	number generator. The environment instances must be safe to step
+	concurrently with each other. Workers can also simulate on clones
+	of the environment model, each with its own random stream.
+
+	Nodes and their child tables are allocated from per-worker pools,
+	which are cleared after every decision, so that a search does not
+	call malloc or free per node once the pools have grown.
  */
 template <class S, class A>
 class MonteCarloTreeSearch
 {
+public:
+  enum ParallelMode {
+    SERIAL,
+    ROOT_PARALLEL,
+    TREE_PARALLEL
+  };
+  struct NodeStorage;
+  /// Everything a thread needs to run simulations on its own.
+  struct Worker {
+    ContinuousStateEnvironment* environment;
+    AbstractPolicy<S, A>* policy;
+    RandomNumberGenerator* rng;
+    NodeStorage* storage; // where the nodes expanded by this worker live
+    Worker(ContinuousStateEnvironment* environment_, AbstractPolicy<S, A>* policy_, RandomNumberGenerator* rng_)
+      : environment(environment_), policy(policy_), rng(rng_), storage(NULL)
+    {
+    }
+  };
 private:
   real gamma;                    // Discount factor.
   ContinuousStateEnvironment* environment; // The environment model.
@@ -40,6 +84,12 @@ private:
   int MaxDepth;                  // Maximum tree depth.
   int NRollouts;                 // Number of sampled rollouts.
   int nActions;
+  ParallelMode mode;             // How to use the workers.
+  std::vector<Worker> workers;   // One per thread, for the parallel modes.
+  std::vector<ContinuousStateEnvironment*> clones; // Worker environments we own.
+  ThreadPool* pool;              // Threads for the workers, NULL to run them in turn.
+  real virtual_loss;             // Value assumed for simulations in progress.
+  real time_budget;              // Seconds per decision, if positive.
 public:
   struct Node {
     int depth;     // Depth
@@ -52,29 +102,33 @@ public:
 
     double epsilon;
     
-    std::vector<Node*> children; //Pointer to the childrens
-    int nVisits;  // Number of visits
-    double aveValue; // Mean Value
+    Node** children; //Pointer to the childrens, nActions of them
+    std::atomic<int> nVisits;  // Number of visits
+    std::atomic<int> nVirtual; // Simulations through this node still in progress
+    std::atomic<double> aveValue; // Mean Value
+    std::mutex lock; // Protects children and statistics in tree-parallel search
 
     // Constructor
-    Node(const int& depth_, const S& state_, const double& reward_, MonteCarloTreeSearch::Node* const father_ , MonteCarloTreeSearch& tree_, const bool& terminal_ = false)
+    Node(const int& depth_, const S& state_, const double& reward_, MonteCarloTreeSearch::Node* const father_ , MonteCarloTreeSearch& tree_, Node** children_, const bool& terminal_ = false)
       :	depth(depth_),   
         state(state_),   //Node's state representation.
 	reward(reward_), //Reward received during the transition from the father node.
 	father(father_), //Father node.
 	tree(tree_),
-	terminal(terminal_)
+	terminal(terminal_),
+	children(children_)
     {
       epsilon  = 1E-06;
       aveValue = 0; 
       nVisits  = 0; 
+      nVirtual = 0;
       leaf     = true;
-      children.resize(tree.nActions,NULL);
     }
     
-    Node(const S& state_, MonteCarloTreeSearch& tree_) 
+    Node(const S& state_, MonteCarloTreeSearch& tree_, Node** children_) 
       : state(state_),   //Node's state representation.
-	tree(tree_)
+	tree(tree_),
+	children(children_)
     {
       depth    = 0;
       reward   = 0;
@@ -82,17 +136,11 @@ public:
       terminal = false;
       aveValue = 0;
       nVisits  = 0;
+      nVirtual = 0;
       leaf     = true;
-      children.resize(tree.nActions,NULL);
-    }
-
-    // Destructor
-    ~Node() {
-      for(int i=0; i < tree.nActions; ++i)
-	delete children[i];
     }
 
-    void selectAction() {
+    void selectAction(Worker& worker) {
       Node* cur = this;
       double RollingValue = 0;
 
@@ -107,9 +155,9 @@ public:
       } else {
 	// Expansion phase
 	//	while(cur->getDepth()+1 < tree.MaxDepth && cur->isTerminal() == false) {
-	  cur = cur->expand();
+	  cur = cur->expand(worker);
 	  //} 
-	RollingValue = rollOut(cur->state);
+	RollingValue = rollOut(cur->state, worker);
       }
 
       // Backpropagation phase
@@ -120,8 +168,55 @@ public:
       }	
     }
 
+    /** One simulation through a tree shared with other threads.
+
+	The path is chosen and expanded under the node locks, and virtual
+	loss is added along it. The rollout then runs without any locks.
+    */
+    void selectActionShared(Worker& worker) {
+      Node* cur = this;
+      double RollingValue = 0;
+      bool expanded = false;
+
+      while (cur->isTerminal() == false) {
+	std::lock_guard<std::mutex> guard(cur->lock);
+	Node* next;
+	if (cur->isLeaf()) {
+	  next = cur->expand(worker);
+	  expanded = true;
+	} else {
+	  next = cur->UCTsearch();
+	}
+	assert(next != NULL);
+	next->nVirtual++;
+	cur = next;
+	if (expanded) {
+	  break;
+	}
+      }
+
+      if (expanded && cur->isTerminal() == false) {
+	RollingValue = rollOut(cur->state, worker);
+      } else {
+	RollingValue = cur->getReward();
+      }
+
+      while (cur != NULL) {
+	{
+	  // visits and pending simulations change together under the lock
+	  std::lock_guard<std::mutex> guard(cur->lock);
+	  cur->updateStats(RollingValue);
+	  if (cur->father) {
+	    cur->nVirtual--;
+	  }
+	}
+	RollingValue = cur->getReward() + tree.gamma*RollingValue;
+	cur = cur->father;
+      }
+    }
+
     //Tree expansion
-    Node* expand() {
+    Node* expand(Worker& worker) {
       std::vector<int> Unvisited; //Pointer to the childrens
       int action;
       // The unvisited children are declared
@@ -135,22 +230,22 @@ public:
       if(Unvisited.empty()) {
 	real bestValue = -1000000000;
 	for(int i = 0; i < tree.nActions; i++) {
-	  real curValue = (children[i]->getReward() + tree.gamma*children[i]->aveValue) + 1000*sqrt((sqrt(2)*log(nVisits)) / (children[i]->nVisits)); //UCT Search
+	  real curValue = (children[i]->getReward() + tree.gamma*children[i]->aveValue) + 1000*sqrt((sqrt(2)*log((real) nVisits)) / (children[i]->nVisits)); //UCT Search
 	  if(curValue > bestValue) {
 	    action = i;
 	    bestValue = curValue;
 	  }
 	}
       } else {	
-	action = Unvisited[tree.rng->discrete_uniform(Unvisited.size())];
+	action = Unvisited[worker.rng->discrete_uniform(Unvisited.size())];
       }
-      tree.environment->Reset();
-      tree.environment->setState(state);
-      bool running    = tree.environment->Act(action);
-      S child_state   = tree.environment->getState();
-      real reward     = tree.environment->getReward();
+      worker.environment->Reset();
+      worker.environment->setState(state);
+      bool running    = worker.environment->Act(action);
+      S child_state   = worker.environment->getState();
+      real reward     = worker.environment->getReward();
 
-      children[action] = new Node(depth + 1, child_state, reward, this, tree, !running); // The specific child is created
+      children[action] = tree.NewNode(*worker.storage, depth + 1, child_state, reward, this, !running); // The specific child is created
 
       return children[action];
     }
@@ -159,8 +254,27 @@ public:
     Node* UCTsearch() {
       real bestValue = -1000000000000;
       Node* selected = NULL;
+      int n_pending = nVirtual;
+      // Simulations in progress count as visits with value virtual_loss
+      real logN = log(std::max(1, nVisits + n_pending));
       for(int i = 0; i < tree.nActions; ++i) {
-	real curValue = (children[i]->getReward() + tree.gamma*children[i]->aveValue) + 1000*sqrt((log(nVisits)) / (children[i]->nVisits)); //UCT Search
+	Node* child = children[i];
+	int n, n_virtual;
+	real value;
+	{
+	  std::lock_guard<std::mutex> guard(child->lock);
+	  n = child->nVisits;
+	  n_virtual = child->nVirtual;
+	  value = child->aveValue;
+	}
+	if (n + n_virtual == 0) {
+	  return child; // unvisited: infinite exploration bonus
+	}
+	if (n_virtual > 0) {
+	  value = (n * value + n_virtual * tree.virtual_loss) / (n + n_virtual);
+	  n += n_virtual;
+	}
+	real curValue = (child->getReward() + tree.gamma*value) + 1000*sqrt(logN / n); //UCT Search
 	if(curValue > bestValue) {
 	  selected = children[i];
 	  bestValue = curValue;
@@ -168,12 +282,14 @@ public:
       }
       return selected;
     }
-    double rollOut(S state_) {
+    double rollOut(S state_, Worker& worker) {
       int t = 0;
       int horizon = 1000; // tree.MaxDepth - depth;
-      tree.environment->Reset();
-      tree.environment->setState(state_);
-      tree.policy.Reset();
+      ContinuousStateEnvironment* environment = worker.environment;
+      AbstractPolicy<S, A>& policy = *worker.policy;
+      environment->Reset();
+      environment->setState(state_);
+      policy.Reset();
       bool running = true;
       real discount = 1.0;
       real total_reward = 0.0;
@@ -182,17 +298,17 @@ public:
       real reward = 0.0;
       do {
 	//get current state
-	S state = tree.environment->getState();
+	S state = environment->getState();
               
 	//choose an action using Random policy
-	tree.policy.Observe(reward, state);
-	A action = tree.policy.SelectAction();
+	policy.Observe(reward, state);
+	A action = policy.SelectAction();
 
 	//execute the selected action
-	running = tree.environment->Act(action);
+	running = environment->Act(action);
               
 	// get reward
-	reward = tree.environment->getReward();
+	reward = environment->getReward();
               
 	total_reward += reward;
 	discounted_reward += discount * reward;
@@ -241,10 +357,25 @@ public:
     }
     void updateStats(double value) {
       nVisits++;
-      aveValue += (value - aveValue)/ nVisits; // Mean value
+      aveValue = aveValue + (value - aveValue)/ nVisits; // Mean value
+    }
+  };
+
+  /// Nodes and child tables of one worker
+  struct NodeStorage {
+    ObjectPool<Node> nodes;
+    Arena children;
+    void Clear() {
+      nodes.Clear();
+      children.Clear();
     }
   };
 
+  Node* NewNode(NodeStorage& storage, int depth, const S& state, real reward, Node* father, bool terminal = false) {
+    Node** children = storage.children.template NewArray<Node*>(nActions);
+    return storage.nodes.New(depth, state, reward, father, *this, children, terminal);
+  }
+
   //Constructor
   MonteCarloTreeSearch(const real& gamma_, ContinuousStateEnvironment* environment_, RandomNumberGenerator* rng_, AbstractPolicy<S, A>& policy_, const int& MaxDepth_ =  100, const int& NRollouts_ = 1000)
     :gamma(gamma_),
@@ -252,30 +383,117 @@ public:
      rng(rng_),
      policy(policy_),
      MaxDepth(MaxDepth_),
-     NRollouts(NRollouts_)
+     NRollouts(NRollouts_),
+     mode(SERIAL),
+     pool(NULL),
+     virtual_loss(0.0),
+     time_budget(0.0)
   {
     nActions = environment->getNActions(); 
   };
 
   //Destructor
   ~MonteCarloTreeSearch(){
-    delete root;
+    for (uint k=0; k<workers.size(); ++k) {
+      delete workers[k].storage;
+    }
+    for (uint k=0; k<clones.size(); ++k) {
+      delete clones[k];
+    }
   };
 
+  /// Add a worker for the parallel modes. The caller keeps ownership.
+  void addWorker(ContinuousStateEnvironment* environment_, AbstractPolicy<S, A>* policy_, RandomNumberGenerator* rng_) {
+    workers.push_back(Worker(environment_, policy_, rng_));
+    workers.back().storage = new NodeStorage;
+  }
+  /** Add a worker that simulates on a clone of the environment model.
+
+      The clone uses the stream of the seed numbered by the worker, so
+      that workers see independent noise. Returns false if the model
+      cannot be cloned.
+   */
+  bool addWorker(AbstractPolicy<S, A>* policy_, RandomNumberGenerator* rng_, unsigned long seed) {
+    ContinuousStateEnvironment* clone = environment->Clone();
+    if (!clone) {
+      return false;
+    }
+    clone->setRandomStream(seed, workers.size());
+    clones.push_back(clone);
+    addWorker(clone, policy_, rng_);
+    return true;
+  }
+  /// Use a thread pool to run the workers; NULL runs them in turn.
+  void setThreadPool(ThreadPool* pool_) {
+    pool = pool_;
+  }
+  void setParallelMode(ParallelMode mode_) {
+    mode = mode_;
+  }
+  /// The value of a simulation that is still in progress, in tree-parallel search.
+  void setVirtualLoss(real virtual_loss_) {
+    virtual_loss = virtual_loss_;
+  }
+  /// Search for the given number of seconds per decision, instead of
+  /// a fixed number of rollouts. Non-positive values restore the
+  /// rollout budget.
+  void setTimeBudget(real seconds) {
+    time_budget = seconds;
+  }
+
   int SelectAction(S state_) {
- 
-    root = new Node(0, state_, 0.0, NULL, *this);
-  
-    for(int i=0; i<NRollouts; ++i) {
-      root->selectAction();
+    std::vector<Node*> roots;
+    deadline = std::chrono::steady_clock::now()
+      + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(time_budget));
+    if (mode == SERIAL || workers.empty()) {
+      Worker worker(environment, &policy, rng);
+      worker.storage = &storage;
+      roots.push_back(NewNode(storage, 0, state_, 0.0, NULL));
+      std::atomic<int> budget(NRollouts);
+      Search(roots[0], worker, budget, false);
+    } else if (mode == ROOT_PARALLEL) {
+      // every tree gets an equal share of the rollouts
+      int n_workers = workers.size();
+      roots.resize(n_workers);
+      for (int k=0; k<n_workers; ++k) {
+	roots[k] = NewNode(*workers[k].storage, 0, state_, 0.0, NULL);
+      }
+      RunWorkers([&](int k) {
+	  std::atomic<int> budget(NRollouts / n_workers + ((k < NRollouts % n_workers) ? 1 : 0));
+	  Search(roots[k], workers[k], budget, false);
+	});
+    } else {
+      roots.push_back(NewNode(*workers[0].storage, 0, state_, 0.0, NULL));
+      std::atomic<int> budget(NRollouts);
+      RunWorkers([&](int k) { Search(roots[0], workers[k], budget, true); });
     }
 
+    // Merge the root statistics of all trees
     int sel_action = 0;
-    double bestValue = root->children[0]->reward + gamma*root->children[0]->aveValue;
+    double bestValue = -std::numeric_limits<double>::infinity();
     
     //Find the best among the available actions
-    for(int action = 1; action < nActions; ++action) {
-      double curValue = root->children[action]->reward + gamma*root->children[action]->aveValue;
+    for(int action = 0; action < nActions; ++action) {
+      double n = 0;
+      double reward = 0;
+      double value = 0;
+      for (uint k=0; k<roots.size(); ++k) {
+	Node* child = roots[k]->children[action];
+	if (child && child->nVisits > 0) {
+	  n += child->nVisits;
+	  reward += child->nVisits * child->reward;
+	  value += child->nVisits * child->aveValue;
+	}
+      }
+      if (n == 0) {
+	continue;
+      }
+      double curValue;
+      if (roots.size() == 1) {
+	curValue = roots[0]->children[action]->reward + gamma*roots[0]->children[action]->aveValue;
+      } else {
+	curValue = (reward + gamma*value) / n;
+      }
       if(curValue > bestValue) {
 	sel_action = action;
 	bestValue = curValue;
@@ -284,12 +502,43 @@ public:
     environment->Reset();
     environment->setState(state_);
 
-    delete root;
+    storage.Clear();
+    for (uint k=0; k<workers.size(); ++k) {
+      workers[k].storage->Clear();
+    }
 
     return sel_action;
   };
 protected:
   std::vector< std::vector<Node*> > levels;
-  Node* root;
+  NodeStorage storage; // nodes of the serial search
+  std::chrono::steady_clock::time_point deadline; // end of the time budget
+
+  /// Claim one rollout of the budget
+  bool ClaimRollout(std::atomic<int>& budget) {
+    if (time_budget > 0) {
+      return std::chrono::steady_clock::now() < deadline;
+    }
+    return budget-- > 0;
+  }
+  /// Run simulations from the root until the budget is used up.
+  void Search(Node* node, Worker& worker, std::atomic<int>& budget, bool shared) {
+    while (ClaimRollout(budget)) {
+      if (shared) {
+	node->selectActionShared(worker);
+      } else {
+	node->selectAction(worker);
+      }
+    }
+  }
+  void RunWorkers(const std::function<void (int)>& f) {
+    if (pool) {
+      pool->Run(workers.size(), f);
+    } else {
+      for (uint k=0; k<workers.size(); ++k) {
+	f(k);
+      }
+    }
+  }
 };
 #endif
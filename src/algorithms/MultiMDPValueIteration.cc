@@ -16,11 +16,13 @@
 #include "Vector.h"
 #include <cmath>
 #include <cassert>
+#include <algorithm>
 
 /// Setup a value iteration procedure for a list of MDPs with weights w and discount factor gamma
 MultiMDPValueIteration::MultiMDPValueIteration(const Vector& w_,
                                                const std::vector<const DiscreteMDP*> &mdp_list_,
                                                real gamma_) :
+    batch(mdp_list_),
     w(w_),
     mdp_list(mdp_list_),
     gamma(gamma_),
@@ -29,16 +31,8 @@ MultiMDPValueIteration::MultiMDPValueIteration(const Vector& w_,
     assert (mdp_list.size());
     assert (gamma>=0 && gamma <=1);
     assert ((int) mdp_list.size() == w.Size());
-    n_actions = mdp_list[0]->getNActions();
-    n_states = mdp_list[0]->getNStates();
-    for (int i=1; i<n_mdps; ++i) {
-        if (n_actions != mdp_list[i]->getNActions()) {
-            throw std::runtime_error("Number of actions in MDPs does not agree\n");
-        }
-        if (n_states != mdp_list[i]->getNStates()) {
-            throw std::runtime_error("Number of states in MDPs does not agree\n");
-        }
-    }
+    n_actions = batch.getNActions();
+    n_states = batch.getNStates();
     Reset();
 }
 
@@ -69,6 +63,22 @@ void MultiMDPValueIteration::Reset()
         Q[i].Resize(n_states, n_actions);
         Q[i].Clear();
     }
+    V_batch.assign(n_states * n_mdps, 0.0);
+    V_individual.assign(n_states * n_mdps, 0.0);
+    Q_batch.assign(n_states * n_actions * n_mdps, 0.0);
+}
+
+/// Copy the batched values into the individual value functions
+void MultiMDPValueIteration::CopyValues(const std::vector<real>& V_values)
+{
+    for (int mu=0; mu<n_mdps; ++mu) {
+        for (int s=0; s<n_states; ++s) {
+            V[mu](s) = V_values[s * n_mdps + mu];
+            for (int a=0; a<n_actions; ++a) {
+                Q[mu](s, a) = Q_batch[batch.getID(s, a) * n_mdps + mu];
+            }
+        }
+    }
 }
 
 
@@ -87,19 +97,12 @@ MultiMDPValueIteration::~MultiMDPValueIteration()
  */
 real MultiMDPValueIteration::ComputeStateActionValueForSingleMDP(int mu, int s, int a)
 {
-    Vector& V_i = V[mu];
-    const DiscreteMDP* mdp = mdp_list[mu];
-    real Q_mu_sa = 0.0; 
-    const DiscreteStateSet& next = mdp->getNextStates(s, a);
-    for (DiscreteStateSet::iterator i=next.begin();
-         i!=next.end();
-         ++i) {
-        int s2 = *i;
-        real P = mdp->getTransitionProbability(s, a, s2);
-        real V2 = V_i(s2);
-        Q_mu_sa += P * V2;
-    } 
-    real r_sa = mdp->getExpectedReward(s,a);
+    int i = batch.getID(s, a);
+    real Q_mu_sa = 0.0;
+    for (int j=batch.row_offset[i]; j<batch.row_offset[i + 1]; ++j) {
+        Q_mu_sa += batch.probability[j * n_mdps + mu] * V[mu](batch.next_state[j]);
+    }
+    real r_sa = batch.reward[i * n_mdps + mu];
     Q_mu_sa = r_sa + gamma * Q_mu_sa;
     Q[mu](s,a) = Q_mu_sa;
     return Q_mu_sa;
@@ -148,34 +151,24 @@ void MultiMDPValueIteration::ComputeStateValues(real threshold, int max_iter)
     int n_iter = 0;
 
     //logmsg ("Runnign ComputeStateValues with epsilon: %f, iter: %d, gamma: %f", threshold, max_iter, gamma);
+    const int K = n_mdps;
+    std::vector<int> a_max(n_states);         
     do {
-        // Calculate Q_{mu,t}(s,a) from V_mu(s)
-        for (int mu=0; mu<n_mdps; ++mu) {
-            const DiscreteMDP* mdp = mdp_list[mu];
-            for (int s=0; s<n_states; ++s) {
-                for (int a=0; a<n_actions; ++a) {
-                    real R_sa = mdp->getExpectedReward(s, a);
-                    real Q_msa = 0.0;
-                    for (int s2=0; s2<n_states; ++s2) {
-                        real P = mdp->getTransitionProbability(s, a, s2);
-                        real V2 = V[mu](s2);
-                        Q_msa += P * V2;
-                    }
-                    Q[mu](s, a) = R_sa + gamma * Q_msa;
-                    //printf ("Q_%d(%d, %d) = %f = %f + %f * %f\n",
-                    //mu, s, a, Q[mu](s,a),
-                    //R_sa, gamma, Q_msa);
-                }
+        // Calculate Q_{mu,t}(s,a) from V_mu(s), for all mu at once
+        for (int s=0; s<n_states; ++s) {
+            for (int a=0; a<n_actions; ++a) {
+                batch.Backup(s, a, gamma, &V_batch[0],
+                             &Q_batch[batch.getID(s, a) * K]);
             }
-            
         }
 
         // calculate Q_{xi, t}(s,a)
         for (int s=0; s<n_states; ++s) {
             for (int a=0; a<n_actions; ++a) {
+                const real* Q_sa = &Q_batch[batch.getID(s, a) * K];
                 Q_xi(s,a) = 0.0;
                 for (int mu=0; mu<n_mdps; ++mu) {
-                    Q_xi(s,a) += w(mu) * Q[mu](s,a);
+                    Q_xi(s,a) += w(mu) * Q_sa[mu];
                 }
                 //printf ("Q_xi(%d, %d) = %f\n", s, a, Q_xi(s,a));
             }
@@ -183,7 +176,6 @@ void MultiMDPValueIteration::ComputeStateValues(real threshold, int max_iter)
         
 
         // Calculate a_t^*(s), V_{xi, t}(s)
-        std::vector<int> a_max(n_states);         
         for (int s=0; s<n_states; ++s) {
             a_max[s] = 0;
             real Q_max = Q_xi(s,0);
@@ -198,9 +190,10 @@ void MultiMDPValueIteration::ComputeStateValues(real threshold, int max_iter)
         }
 
         // Calculate V_{mu, t}(s)
-        for (int mu=0; mu<n_mdps; ++mu) {
-            for (int s=0; s<n_states; ++s) {
-                V[mu](s) = Q[mu](s, a_max[s]);
+        for (int s=0; s<n_states; ++s) {
+            const real* Q_sa = &Q_batch[batch.getID(s, a_max[s]) * K];
+            for (int mu=0; mu<n_mdps; ++mu) {
+                V_batch[s * K + mu] = Q_sa[mu];
             }
         }
 
@@ -216,9 +209,55 @@ void MultiMDPValueIteration::ComputeStateValues(real threshold, int max_iter)
 		//printf("%f # delta\n", Delta);
         n_iter++;
     } while(Delta >= threshold && max_iter != 0);
+    CopyValues(V_batch);
     //logmsg("Exiting at delta :%f, iter :%d\n", Delta, n_iter);		
 }
 
+/** Compute the optimal value function of each MDP separately.
+
+    This performs value iteration on all MDPs at once, as
+    ValueIteration::ComputeStateValuesStandard() would on each one of
+    them. Delta is the largest change over the MDPs, so that the
+    process only ends when all of them are below the threshold, or
+    after max_iter iterations.
+
+    The results are then given by getValue(mu, s, a), or in V and Q.
+*/
+void MultiMDPValueIteration::ComputeIndividualStateValues(real threshold, int max_iter)
+{
+    const int K = n_mdps;
+    std::vector<real> V_next(n_states * K);
+    std::vector<real> delta(K);
+    do {
+        for (int s=0; s<n_states; ++s) {
+            real* V_s = &V_next[s * K];
+            for (int a=0; a<n_actions; ++a) {
+                real* Q_sa = &Q_batch[batch.getID(s, a) * K];
+                batch.Backup(s, a, gamma, &V_individual[0], Q_sa);
+                for (int mu=0; mu<K; ++mu) {
+                    if (a == 0 || Q_sa[mu] > V_s[mu]) {
+                        V_s[mu] = Q_sa[mu];
+                    }
+                }
+            }
+        }
+        for (int mu=0; mu<K; ++mu) {
+            delta[mu] = 0.0;
+        }
+        for (int s=0; s<n_states; ++s) {
+            for (int mu=0; mu<K; ++mu) {
+                delta[mu] += fabs(V_next[s * K + mu] - V_individual[s * K + mu]);
+            }
+        }
+        Delta = *std::max_element(delta.begin(), delta.end());
+        V_individual.swap(V_next);
+        if (max_iter > 0) {
+            max_iter--;
+        }
+    } while(Delta >= threshold && max_iter != 0);
+    CopyValues(V_individual);
+}
+
 
 
 
@@ -14,6 +14,7 @@
 #define MULTI_MDP_VALUE_ITERATION_H
 
 #include "DiscreteMDP.h"
+#include "CompiledMDPBatch.h"
 #include "DiscretePolicy.h"
 #include "real.h"
 #include <vector>
@@ -28,9 +29,22 @@
     The main assumption in this algorithm is that the policy is
     reactive and oblivious. In that case, we can use a fixed
     probability measure.
+
+    All MDPs in the list are compiled into a single batch, so that
+    each sweep backs them all up in one pass over the transitions.
+    ComputeIndividualStateValues() uses the same batch to compute the
+    optimal value function of every MDP separately. The two
+    computations keep separate values, so that each one continues
+    from its own previous solution.
  */
 class MultiMDPValueIteration
 {
+protected:
+    CompiledMDPBatch batch; ///< compiled batch of the MDPs
+    std::vector<real> V_batch; ///< values of the MDPs under the common policy, [state][mdp]
+    std::vector<real> V_individual; ///< optimal values of the MDPs, [state][mdp]
+    std::vector<real> Q_batch; ///< action values of the MDPs, [state-action][mdp]
+    void CopyValues(const std::vector<real>& V_values);
 public:
     Vector w;
     std::vector<const DiscreteMDP*> mdp_list;
@@ -56,6 +70,7 @@ public:
 
     void ComputeStateValues(real threshold, int max_iter=-1);
     void ComputeStateActionValues(real threshold, int max_iter=-1);
+    void ComputeIndividualStateValues(real threshold, int max_iter=-1);
     inline real getValue (int state, int action)
     {
         assert(state>=0 && state < n_states);
@@ -67,6 +82,12 @@ public:
         assert(state>=0 && state < n_states);
         return V_xi(state);
     }
+    /// Value of MDP mu for the last computation
+    inline real getValue (int mu, int state, int action)
+    {
+        assert(mu >= 0 && mu < n_mdps);
+        return Q[mu](state, action);
+    }
     FixedDiscretePolicy* getPolicy();
     void setMDPList(const std::vector<const DiscreteMDP*>& mdp_list_)
     {
@@ -74,6 +95,7 @@ public:
 
         assert(mdp_list.size() == (uint) n_mdps);
         assert(w.Size() == n_mdps);
+        batch.setMDPList(mdp_list);
 
         real w_i = 1.0 / (real) n_mdps;
         for (int i=0; i<n_mdps; i++) {
@@ -88,6 +110,7 @@ public:
 
         assert(mdp_list.size() == (uint) n_mdps);
         assert(w.Size() == n_mdps);
+        batch.setMDPList(mdp_list);
     }
 protected:
     real ComputeActionValueForMDPs(int s, int a);
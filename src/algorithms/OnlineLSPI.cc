@@ -18,7 +18,8 @@ n_dimension(n_dimension_),
 n_actions(n_actions_), 
 max_iteration(max_iteration_),
 bfs(bfs_), 
-policy(n_dimension, n_actions, bfs)
+policy(n_dimension, n_actions, bfs),
+rls(n_actions_*(bfs_->size() + 1), gamma_)
 {
 	assert(gamma>=0 && gamma <=1);
 	n_basis = n_actions*(bfs->size() + 1);
@@ -37,7 +38,8 @@ n_actions(n_actions_),
 max_iteration(max_iteration_),
 algorithm(algorithm_),
 bfs(bfs_), 
-policy(n_dimension, n_actions, bfs)
+policy(n_dimension, n_actions, bfs),
+rls(n_actions_*(bfs_->size() + 1), gamma_)
 {
 	assert(gamma>=0 && gamma <=1);
 	assert(algorithm>=1 && algorithm<=2);
@@ -65,6 +67,12 @@ Vector OnlineLSPI::BasisFunction(const Vector& state, int action)
 	}
 	return Phi;
 }
+
+/// Compute the features of a state-action pair, keeping only the block of the action.
+void OnlineLSPI::BasisFunction(const Vector& state, int action, BlockVector& Phi)
+{
+	bfs->Evaluate(state, action, n_actions, Phi);
+}
 void OnlineLSPI::LSTD(const Vector& state, const int& action, const real& reward, const Vector& state_, const int& action_, const bool& endsim, const bool& update) 
 { 
 	if( algorithm == 1 )
@@ -74,45 +82,40 @@ void OnlineLSPI::LSTD(const Vector& state, const int& action, const real& reward
 }
 void OnlineLSPI::LSTDQ(const Vector& state, const int& action, const real& reward, const Vector& state_, const int& action_, const bool& endsim, const bool& update) 
 {
-	Vector Phi_;
-	Vector Phi;
-	Matrix res;
+	BlockVector Phi_;
+	BlockVector Phi;
 	
-	Phi_ = BasisFunction(state, action);
-	if(endsim) {
-		res = OuterProduct(Phi_, Phi_);
-	}
-	else {
-		Phi = BasisFunction(state_,action_);
-		res = OuterProduct(Phi_,(Phi_ - (Phi*gamma)));
+	BasisFunction(state, action, Phi_);
+	AddOuterProduct(A, 1.0, Phi_, Phi_);
+	if(!endsim) {
+		BasisFunction(state_, action_, Phi);
+		AddOuterProduct(A, -gamma, Phi_, Phi);
 	}
 	
-	A += res;
-	b += Phi_*reward;
+	Phi_.AddTo(b, reward);
 }
+/** Add a transition to the recursive estimate.
+
+	This costs O(n^2) for n basis functions. If update is set, the
+	policy is updated with the new weights straight away.
+*/
 void OnlineLSPI::LSTDQ_OPT(const Vector& state, const int& action, const real& reward, const Vector& state_, const int& action_, const bool& endsim, const bool& update)
 {
 	Vector Phi_;
 	Vector Phi;
-	Vector Phi_dif;
-	Matrix res;
-	real d = 0.000001;
-	A = Matrix::Unity(n_basis,n_basis) * (1/d);
-	b.Clear();
 	
 	Phi_ = BasisFunction(state, action);
 	if(endsim){
-		Phi_dif = Phi_;
+		rls.ObserveTerminal(Phi_, reward);
 	}
 	else{
 		Phi = BasisFunction(state_, action_);
-		Phi_dif = Phi_ - (Phi*gamma);
+		rls.Observe(Phi_, reward, Phi);
+	}
+	if (update) {
+		w = rls.getWeights();
+		policy.Update(w);
 	}
-	res = OuterProduct(Phi_,Phi_dif);
-	const Matrix p = A;
-	real v = Product(p*Phi_,Phi_dif);
-	A -= (((A*res)*A) / (v + 1));
-	b += Phi_ * reward;
 }
 void OnlineLSPI::Update()
 {
@@ -121,8 +124,7 @@ void OnlineLSPI::Update()
 		w = w_*b;
 	}
 	else if( algorithm == 2) {
-		const Matrix w_ = A;
-		w = w_*b;
+		w = rls.getWeights();
 	}
 	policy.Update(w);
 }
@@ -131,9 +133,12 @@ void OnlineLSPI::Reset()
 	A = Matrix::Unity(n_basis,n_basis) * 1e-6;
 	b = Vector::Null(n_basis);
 	w = Vector::Null(n_basis);	
+	rls.Reset();
 }
 real OnlineLSPI::getValue(const Vector& state, int action)
 {
-	return Product(BasisFunction(state,action),w);
+	BlockVector Phi;
+	BasisFunction(state, action, Phi);
+	return Product(Phi, w);
 }
 
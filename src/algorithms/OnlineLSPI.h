@@ -18,8 +18,10 @@
 #include "Vector.h"
 #include "Matrix.h"
 #include "BasisSet.h"
+#include "BlockVector.h"
 #include "ContinuousPolicy.h"
 #include "RandomPolicy.h"
+#include "RecursiveLSTDQ.h"
 #include <vector>
 
 class OnlineLSPI{
@@ -36,17 +38,24 @@ protected:
 	Vector w;
 	RBFBasisSet* bfs;
 	FixedContinuousPolicy policy;
+	RecursiveLSTDQ rls; ///< used by algorithm 2
 public:	
 	OnlineLSPI(real gamma_, real Delta_, int n_dimension_, int n_actions_, int max_iteration_, RBFBasisSet* bfs_);
 	OnlineLSPI(real gamma_, real Delta_, int n_dimension_, int n_actions_, int max_iteration_, int algorithm_, RBFBasisSet* bfs_);
 	~OnlineLSPI();
 	
 	Vector BasisFunction(const Vector& state, int action);
+	void BasisFunction(const Vector& state, int action, BlockVector& Phi);
 	void LSTD(const Vector& state, const int& action, const real& reward, const Vector& state_, const int& action_, const bool& endsim, const bool& update = true); 
 	void LSTDQ(const Vector& state, const int& action, const real& reward, const Vector& state_, const int& action_, const bool& endsim, const bool& update = true);
 	void LSTDQ_OPT(const Vector& state, const int& action, const real& reward, const Vector& state_, const int& action_, const bool& endsim, const bool& update = true);
 	void Reset();
 	void Update();
+	/// Set the forgetting factor of the recursive algorithm
+	void setForgetting(real forgetting)
+	{
+		rls.setForgetting(forgetting);
+	}
 	real getValue(const Vector& state, int action);
 	FixedContinuousPolicy& ReturnPolicy()
 	{
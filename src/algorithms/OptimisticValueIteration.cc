@@ -23,6 +23,7 @@
 OptimisticValueIteration::OptimisticValueIteration(const DiscreteMDPCounts* mdp,
                                                    real gamma,
                                                    real baseline)
+    : pool(NULL)
 {
     assert (mdp);
     assert (gamma>=0 && gamma <=1);
@@ -86,6 +87,7 @@ void OptimisticValueIteration::ComputeStateValuesAugmentedMDP(real delta,
     augmented_mdp.Check();
 
     ValueIteration vi(&augmented_mdp, gamma);
+    vi.setThreadPool(pool);
     vi.ComputeStateValues(threshold, max_iter);
     for (int s=0; s<n_states; s++) {
         int a_aug = 0;
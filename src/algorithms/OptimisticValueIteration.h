@@ -15,16 +15,21 @@
 
 #include "DiscretePolicy.h"
 #include "DiscreteMDPCounts.h"
+#include "ThreadPool.h"
 #include "real.h"
 #include <vector>
 
 
 /** Optimistic value iteration.
 
-    Perform value iteration on an augmented MDP.
+    Perform value iteration on an augmented MDP. The augmented MDP
+    has n_states times more actions than the original, so it is worth
+    solving it in parallel by setting a thread pool.
 */
 class OptimisticValueIteration
 {
+protected:
+    ThreadPool* pool; ///< threads for value iteration, NULL if serial
 public:
     const DiscreteMDPCounts* mdp;
     real gamma;
@@ -39,6 +44,11 @@ public:
                              real baseline=0.0);
     ~OptimisticValueIteration();
     void Reset();
+    /// Use a thread pool for value iteration; NULL for serial sweeps.
+    inline void setThreadPool(ThreadPool* pool_)
+    {
+        pool = pool_;
+    }
 
     /// Perform value iteration for unknown rewards and transitions.
     inline void ComputeStateValues(real delta,
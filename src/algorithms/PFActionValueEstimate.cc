@@ -11,6 +11,7 @@
  ***************************************************************************/
 
 #include "PFActionValueEstimate.h"
+#include <algorithm>
 
 PFActionValueEstimate::PFActionValueEstimate(int n_actions, int n_members)
 {
@@ -20,9 +21,12 @@ PFActionValueEstimate::PFActionValueEstimate(int n_actions, int n_members)
     this->n_actions = n_actions;
     q.resize(n_actions);
     s.resize(n_actions);
+    mean.resize(n_actions);
     for (int i=0; i<n_actions; i++) {
         q[i].Init(n_members, prior, transitions, observations);
+        q[i].setLogWeights(true);
         q[i].Reset();
+        mean[i] = q[i].GetMean();
     }
 }
 
@@ -32,6 +36,7 @@ void PFActionValueEstimate::Reset()
 {
     for (int i=0; i<n_actions; i++) {
         q[i].Reset();
+        mean[i] = q[i].GetMean();
     }
 }
 
@@ -47,12 +52,13 @@ PFActionValueEstimate::~PFActionValueEstimate()
 void PFActionValueEstimate::Observe (int a, real r)
 {
     q[a].Observe(r);
+    mean[a] = q[a].GetMean();
 }
 
 /// Get the mean reward of action a
 real PFActionValueEstimate::GetMean (int a)
 {
-    return q[a].GetMean();
+    return mean[a];
 }
 
 /// Get the mean reward of action a
@@ -81,9 +87,9 @@ int PFActionValueEstimate::Sample()
 int PFActionValueEstimate::GetMax()
 {
     int arg_max = 0;
-    real max = q[0].GetMean();
+    real max = mean[0];
     for (int i=1; i<n_actions; i++) {
-        real m = q[i].GetMean();
+        real m = mean[i];
         if (max < m) {
             max = m;
             arg_max = i;
@@ -97,13 +103,13 @@ int PFActionValueEstimate::GetSecondMax()
     int arg_max2 = 0;
     real max;
     if (arg_max==0) {
-        max = q[1].GetMean();
+        max = mean[1];
     } else {
-        max = q[0].GetMean();
+        max = mean[0];
     }
     for (int i=0; i<n_actions; i++) {
         if (i!=arg_max){
-            real m = q[i].GetMean();
+            real m = mean[i];
             if (max < m) {
                 max = m;
                 arg_max2 = i;
@@ -124,42 +130,36 @@ real PFActionValueEstimate::GetMemberValue(int a, int i)
     return q[a].y[i];
 }
 
-/// Get a simple estimate of P(q_i - q_j > delta)
+/** Get an estimate of P(q_i - q_j > delta).
+
+    The particles of j are sorted, so that the weight of the particles
+    of j below each particle of i is found by binary search. This takes
+    O((N + M) log M) time rather than O(NM).
+*/
 real PFActionValueEstimate::GetProbability(int i, int j, real delta)
 {
-    real P = 0.0f;
     int N = q[i].N;
     int M = q[j].N;
-#if 1
-    real S = 0.0f;
-    for (int n=0; n<N; n++) {
-        for (int m=0; m<M; m++) {
-            real pair_density = q[i].w[n] * q[j].w[m];
-            S += pair_density;
-            if (q[i].y[n] - q[j].y[m] > delta) {
-                P += pair_density;
-            }
-        }
+    std::vector<std::pair<real, real> > sorted(M);
+    for (int m=0; m<M; m++) {
+        sorted[m] = std::make_pair(q[j].y[m], q[j].w[m]);
     }
-    return P / S;
-#else
-    // pretend to be sampling
-    real S=0.0f;
+    std::sort(sorted.begin(), sorted.end());
+    std::vector<real> value(M);
+    std::vector<real> cumulative(M + 1);
+    cumulative[0] = 0.0;
+    for (int m=0; m<M; m++) {
+        value[m] = sorted[m].first;
+        cumulative[m + 1] = cumulative[m] + sorted[m].second;
+    }
+    real P = 0.0;
+    real S = 0.0;
     for (int n=0; n<N; n++) {
-        int m = rand()%M;
-        S += q[i].w[n];
-        if (q[i].y[n] - q[j].y[n] > delta) {
-            P += q[i].w[n] *  q[j].w[m];
-        }
+        real w_n = q[i].w[n];
+        // particles of j with q_i - q_j > delta
+        int below = std::lower_bound(value.begin(), value.end(), q[i].y[n] - delta) - value.begin();
+        P += w_n * cumulative[below];
+        S += w_n;
     }
-    return P/S;
-#endif
+    return P / (S * cumulative[M]);
 }
-
-
-
-
-
-
-
-
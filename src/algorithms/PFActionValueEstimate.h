@@ -17,12 +17,17 @@
 #include "Distribution.h"
 
 /** A population estimate of actions
+
+    The filters keep log-weights, and the mean of each arm is cached
+    after every observation, so that policies querying the means do
+    not sweep over the particles.
  */
 class PFActionValueEstimate : public ActionValueEstimate
 {
 public:
     std::vector<BernoulliGridParticleFilter> q; ///< The estimates
     std::vector<real> s; ///< The samples
+    std::vector<real> mean; ///< The mean of each estimate
     int n_actions;
     UniformDistribution* transitions;
     BernoulliDistribution* observations;
@@ -21,7 +21,7 @@ PolicyEvaluation::PolicyEvaluation(FixedDiscretePolicy* policy_,
                                    const DiscreteMDP* mdp_, 
                                    real gamma_,
                                    real baseline_) 
-    : policy(policy_), mdp(mdp_), gamma(gamma_), baseline(baseline_)
+    : model(mdp_), policy(policy_), mdp(mdp_), gamma(gamma_), baseline(baseline_)
 {
     assert (mdp);
     assert (gamma>=0 && gamma <=1);
@@ -56,6 +56,8 @@ PolicyEvaluation::~PolicyEvaluation()
 void PolicyEvaluation::ComputeStateValues(real threshold, int max_iter)
 {
     assert(policy);
+    model.setMDP(mdp);
+    model.Update();
     int n_iter = 0;
     do {
         Delta = 0.0;
@@ -119,20 +121,14 @@ void PolicyEvaluation::RecomputeStateValuesFeatureExpectation()
 
 
 
-/// Get the value of a particular state-action pair
+/** Get the value of a particular state-action pair.
+
+    This uses the MDP as it was at the last call to ComputeStateValues().
+*/
 real PolicyEvaluation::getValue (int state, int action) const
 {
-    real V_next = 0.0;
-    //for (int s2=0; s2<n_states; s2++) {
-    DiscreteStateSet next = mdp->getNextStates(state, action);
-    for (DiscreteStateSet::iterator i=next.begin();
-         i!=next.end();
-         ++i) {
-        int s2 = *i;
-        real P = mdp->getTransitionProbability(state, action, s2);
-        V_next += P * V[s2];
-    }
-	real V_s = mdp->getExpectedReward(state, action) + gamma*V_next - baseline;
+    real V_next = model.Expectation(state, action, V);
+	real V_s = model.getExpectedReward(state, action) + gamma*V_next - baseline;
     return V_s;
 }
 
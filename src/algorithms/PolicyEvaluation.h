@@ -14,12 +14,20 @@
 #define POLICY_EVALUATION_H
 
 #include "DiscreteMDP.h"
+#include "CompiledDiscreteMDP.h"
 #include "DiscretePolicy.h"
 #include "real.h"
 #include <vector>
 
+/** Evaluate a fixed policy on a discrete MDP.
+
+    State-action values are computed from a compiled snapshot of the
+    MDP, refreshed by ComputeStateValues().
+ */
 class PolicyEvaluation
 {
+protected:
+    CompiledDiscreteMDP model; ///< compiled snapshot of the MDP
 public:
     FixedDiscretePolicy* policy;
     const DiscreteMDP* mdp;
@@ -280,7 +280,7 @@ std::pair<Vector, bool> RolloutState::BestGroupAction(real delta)
     TODO This does not work at the moment.
  */
 
-void RolloutState::Bootstrap(KDTree<RolloutState>& tree,
+void RolloutState::Bootstrap(FlatKDTree<RolloutState>& tree,
                              real L)
 {
     Vector Q_U((int) environment->getNActions()); // Upper bound on Q
@@ -293,13 +293,11 @@ void RolloutState::Bootstrap(KDTree<RolloutState>& tree,
         if (rollout->running) {
             error_bound = exp(rollout->T * log_gamma);
             Vector s_T = rollout->end_state;
-            OrderedFixedList<KDNode> knn_list = tree.FindKNearestNeighbours(s_T, 3);
+            std::vector<void_FlatKDTree::Neighbour> neighbours;
+            tree.FindKNearestNeighbours(s_T, 3, neighbours);
 #if 0
-            std::list<std::pair<real, KDNode*> >::iterator knn_iter;
-            for (knn_iter = knn_list.S.begin();
-                 knn_iter != knn_list.S.end();
-                 ++knn_iter) {
-                KDNode* node = knn_iter->second;
+            for (uint k=0; k<neighbours.size(); ++k) {
+                RolloutState* state = tree.getObject(neighbours[k].second);
             }
 #endif
         }
@@ -504,10 +502,11 @@ real RSAPI::LipschitzBound()
 void RSAPI::Bootstrap()
 {
     /// Make a KNN tree.
-    KDTree<RolloutState> tree(environment->getNStates());
+    FlatKDTree<RolloutState> tree(environment->getNStates());
     for (uint i=0; i<states.size(); ++i) {
         tree.AddVectorObject(states[i]->start_state, states[i]);
     }
+    tree.Build();
 
 #if 0
     for (uint i=0; i<states.size(); ++i) {
@@ -17,7 +17,7 @@
 #include "Vector.h"
 #include "AbstractPolicy.h"
 #include "Classifier.h"
-#include "KDTree.h"
+#include "FlatKDTree.h"
 #include <vector>
 
 class RandomNumberGenerator;
@@ -47,7 +47,7 @@ public:
     int BestHighProbabilityAction(real delta);
     int BestEmpiricalAction(real delta);
     std::pair<Vector, bool> BestGroupAction(real delta);
-    void Bootstrap(KDTree<RolloutState>& tree,
+    void Bootstrap(FlatKDTree<RolloutState>& tree,
                    real L);
 	real Gap();
 };
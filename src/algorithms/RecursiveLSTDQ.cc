@@ -0,0 +1,86 @@
+/* -*- Mode: C++; -*- */
+// copyright (c) 2013 by Christos Dimitrakakis <christos.dimitrakakis@gmail.com>
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "RecursiveLSTDQ.h"
+#include "debug.h"
+#include <cmath>
+
+RecursiveLSTDQ::RecursiveLSTDQ(int n_basis_, real gamma_, real forgetting_, real delta_)
+	: n_basis(n_basis_),
+	  gamma(gamma_),
+	  forgetting(forgetting_),
+	  delta(delta_),
+	  P(n_basis, n_basis),
+	  w(n_basis),
+	  d(n_basis),
+	  P_phi(n_basis),
+	  d_P(n_basis)
+{
+	assert(n_basis > 0);
+	assert(gamma >= 0 && gamma <= 1);
+	assert(forgetting > 0 && forgetting <= 1);
+	assert(delta > 0);
+	Reset();
+}
+
+/// Forget all transitions
+void RecursiveLSTDQ::Reset()
+{
+	P.Clear();
+	for (int i=0; i<n_basis; ++i) {
+		P(i, i) = 1.0 / delta;
+	}
+	w.Clear();
+}
+
+/// Add a transition from features phi to features phi_next.
+void RecursiveLSTDQ::Observe(const Vector& phi, real reward, const Vector& phi_next, real weight)
+{
+	AddScaled(phi, -gamma, phi_next, d);
+	Update(phi, reward, weight);
+}
+
+/// Add a transition ending the episode.
+void RecursiveLSTDQ::ObserveTerminal(const Vector& phi, real reward, real weight)
+{
+	d = phi;
+	Update(phi, reward, weight);
+}
+
+/** Add \f$\rho \phi d^\top\f$ to A and \f$\rho \phi r\f$ to b.
+
+	With \f$\beta\f$ the forgetting factor, the inverse becomes
+	\f[
+	P \leftarrow \beta^{-1} \left(P - \frac{\rho P \phi d^\top P}{\beta + \rho d^\top P \phi}\right),
+	\f]
+	and the solution \f$w \leftarrow w + k (r - d^\top w)\f$, with gain
+	\f$k = \rho P \phi / (\beta + \rho d^\top P \phi)\f$.
+*/
+void RecursiveLSTDQ::Update(const Vector& phi, real reward, real weight)
+{
+	assert(phi.Size() == n_basis);
+	if (weight == 0) {
+		return;
+	}
+	Product(P, phi, P_phi);
+	Product(d, P, d_P);
+	real denominator = forgetting + weight * Product(d, P_phi);
+	if (fabs(denominator) < 1e-12) {
+		Swarning("Skipping singular update\n");
+		return;
+	}
+	real gain = weight / denominator;
+	w.AddScaled(gain * (reward - Product(d, w)), P_phi);
+	P -= OuterProduct(P_phi, d_P) * gain;
+	if (forgetting != 1.0) {
+		P *= 1.0 / forgetting;
+	}
+}
@@ -0,0 +1,89 @@
+// -*- Mode: c++ -*-
+// copyright (c) 2013 by Christos Dimitrakakis <christos.dimitrakakis@gmail.com>
+// $Revision$
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef RECURSIVE_LSTDQ_H
+#define RECURSIVE_LSTDQ_H
+
+#include "real.h"
+#include "Vector.h"
+#include "Matrix.h"
+
+/** Recursive least-squares LSTD-Q.
+
+	LSTD-Q solves \f$A w = b\f$, with
+	\f[
+	A = \delta I + \sum_t \rho_t \phi_t (\phi_t - \gamma \phi'_t)^\top,
+	\qquad
+	b = \sum_t \rho_t \phi_t r_t,
+	\f]
+	where \f$\phi_t\f$ are the features of the state-action pair at
+	time t, \f$\phi'_t\f$ those of the next pair (zero at the end of an
+	episode), and \f$\rho_t\f$ are sample weights.
+
+	Instead of inverting A whenever the weights are needed, the
+	inverse \f$P = A^{-1}\f$ and the solution w are updated after each
+	transition with the Sherman-Morrison formula, at a cost of
+	\f$O(n^2)\f$ for n features. The weights are thus always
+	available.
+
+	With a forgetting factor \f$\beta < 1\f$, A and b are multiplied
+	by \f$\beta\f$ before each new transition is added, so that old
+	transitions are gradually discounted.
+
+	Since A is not symmetric, its inverse is maintained directly
+	rather than through a Cholesky factor.
+ */
+class RecursiveLSTDQ
+{
+protected:
+	int n_basis; ///< number of features
+	real gamma; ///< discount factor
+	real forgetting; ///< forgetting factor
+	real delta; ///< regulariser, so that initially A = delta I
+	Matrix P; ///< inverse of A
+	Vector w; ///< current solution
+	Vector d; ///< scratch: phi - gamma phi'
+	Vector P_phi; ///< scratch: P phi
+	Vector d_P; ///< scratch: d' P
+	void Update(const Vector& phi, real reward, real weight);
+public:
+	RecursiveLSTDQ(int n_basis_, real gamma_, real forgetting_ = 1.0, real delta_ = 1e-6);
+	void Reset();
+	void Observe(const Vector& phi, real reward, const Vector& phi_next, real weight = 1.0);
+	void ObserveTerminal(const Vector& phi, real reward, real weight = 1.0);
+	void setForgetting(real forgetting_)
+	{
+		assert(forgetting_ > 0 && forgetting_ <= 1);
+		forgetting = forgetting_;
+	}
+	int getNBasis() const
+	{
+		return n_basis;
+	}
+	/// The current weights
+	const Vector& getWeights() const
+	{
+		return w;
+	}
+	/// The current inverse of A
+	const Matrix& getInverse() const
+	{
+		return P;
+	}
+	/// The value for features phi
+	real getValue(const Vector& phi) const
+	{
+		return Product(phi, w);
+	}
+};
+
+#endif
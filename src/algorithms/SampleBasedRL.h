@@ -47,8 +47,7 @@ protected:
     int current_state; ///< current state
     int current_action; ///< current action
     MDPModel* model; ///< pointer to the base MDP model
-    std::vector<ValueIteration*> value_iteration; ///< value iteration on each separate model
-    MultiMDPValueIteration* multi_value_iteration; ///< multi-MDP value iteration
+    MultiMDPValueIteration* multi_value_iteration; ///< multi-MDP value iteration, for both bounds
     std::vector<real> tmpQ;
     Vector VU; ///< upper bound value
     Vector VL; ///< lower bound value
@@ -40,6 +40,7 @@ private:
 	int nActions;  // Number of available actions.
 	Matrix Q;    // State-Actions values.
 	Matrix C;    // Counters.
+	Vector N;    // Total visits of each state, the row sums of C.
 public:
 	UCTMC(const real& gamma_, const real& c_uct_, ContinuousStateEnvironment* environment_, RandomNumberGenerator* rng_, const EvenGrid &discretize_, const real& learning_rate_, const real& lambda_, const int& MaxDepth_, const int& NRollouts_)
 		: gamma(gamma_),
@@ -56,6 +57,7 @@ public:
 
 		Q = Matrix(discretize.getNIntervals(), nActions);
 		C = Matrix(discretize.getNIntervals(), nActions);
+		N = Vector(discretize.getNIntervals());
 	};
 	void setEnvironment(ContinuousStateEnvironment* environment_) {
 		environment = environment_;
@@ -65,6 +67,7 @@ public:
 	void UCT_Reset() {
 		Q = Matrix(discretize.getNIntervals(), nActions);
 		C = Matrix(discretize.getNIntervals(), nActions);
+		N = Vector(discretize.getNIntervals());
 	};
 
 	real UCT_Search(S state, int depth, bool terminal){
@@ -76,10 +79,11 @@ public:
 		real SampleReturn = 0;
 
 		int bestAction = 0;
-		real bestValue = Q(index, bestAction) + 2*c_uct*sqrt( log(C.RowSum(index)) / (C(index,bestAction)+1) );
+		real log_visits = log(N(index));
+		real bestValue = Q(index, bestAction) + 2*c_uct*sqrt( log_visits / (C(index,bestAction)+1) );
     
 		for(int a = 1; a < nActions; ++a) {
-			real value = Q(index, a) + 2*c_uct*sqrt( log(C.RowSum(index)) / (C(index,a)+1) );
+			real value = Q(index, a) + 2*c_uct*sqrt( log_visits / (C(index,a)+1) );
 			if(value > bestValue) {
 				bestValue = value;
 				bestAction = a;
@@ -94,6 +98,7 @@ public:
    
 		SampleReturn = reward + gamma*UCT_Search(nextState, depth + 1, !running);
 		C(index, bestAction) += 1;
+		N(index) += 1;
 		Q(index, bestAction) += (SampleReturn - Q(index, bestAction))/ C(index, bestAction);
 		// Note: it's best to use learning-rate when lambda < 1.
 	
@@ -16,8 +16,27 @@
 #include "Vector.h"
 #include <cmath>
 #include <cassert>
+#include <algorithm>
+
+/// Number of transitions (plus actions) per block of states in parallel sweeps
+#define VI_BLOCK_SIZE 4096
+
+/// Read a value that other threads may be writing
+static inline real RelaxedLoad(const real* x)
+{
+    real y;
+    __atomic_load(x, &y, __ATOMIC_RELAXED);
+    return y;
+}
+
+/// Write a value that other threads may be reading
+static inline void RelaxedStore(real* x, real y)
+{
+    __atomic_store(x, &y, __ATOMIC_RELAXED);
+}
 
 ValueIteration::ValueIteration(const DiscreteMDP* mdp, real gamma, real baseline)
+    : model(mdp), pool(NULL)
 {
     assert (mdp);
     assert (gamma>=0 && gamma <=1);
@@ -41,7 +60,11 @@ void ValueIteration::Reset()
     dQ.Resize(n_states, n_actions);
     pQ.Resize(n_states, n_actions);
 
-    
+    queue.clear();
+    queue_position.assign(n_states, -1);
+    priority.assign(n_states, 0.0);
+    sweep_all = true;
+
     for (int s=0; s<n_states; s++) {
         V(s) = 0.0;
         dV(s) = 0.0;
@@ -58,6 +81,151 @@ ValueIteration::~ValueIteration()
 {
 }
 
+/// Maximum action value for state s
+real ValueIteration::MaxActionValue(int s) const
+{
+    real Q_max = Q(s, 0);
+    for (int a=1; a<n_actions; a++) {
+        if (Q(s, a) > Q_max) {
+            Q_max = Q(s, a);
+        }
+    }
+    return Q_max;
+}
+
+/// Back up the action values of s from V and return the largest one
+real ValueIteration::Backup(int s)
+{
+    for (int a=0; a<n_actions; a++) {
+        Q(s, a) = model.getExpectedReward(s, a) - baseline
+            + gamma * model.Expectation(s, a, V);
+    }
+    return MaxActionValue(s);
+}
+
+/** Bring the compiled model up to date.
+
+    The predecessor index, once built, is updated along with it.
+*/
+void ValueIteration::UpdateModel()
+{
+    model.Update();
+    if ((int) predecessors.size() != n_states) {
+        return;
+    }
+    const std::vector<int>& rows = model.changed_rows;
+    if ((int) rows.size() == n_states * n_actions) {
+        BuildPredecessors();
+    } else {
+        for (unsigned int i=0; i<rows.size(); ++i) {
+            AddPredecessors(rows[i]);
+        }
+    }
+}
+
+/// Index the predecessors of all states
+void ValueIteration::BuildPredecessors()
+{
+    successors.assign(n_states, std::vector<std::pair<int, int> >());
+    predecessors.assign(n_states, std::vector<std::pair<int, real> >());
+    for (int i=0; i<n_states * n_actions; ++i) {
+        AddPredecessors(i);
+    }
+}
+
+/** Add the transitions of a row to the predecessor index.
+
+    Each predecessor \f$s\f$ of \f$s'\f$ is stored along with a bound
+    on \f$\max_a P(s' | s, a)\f$. The successors of each state are kept
+    sorted, along with their slot in the predecessor list, so that a
+    row is merged into the index in time linear in its size and in
+    the number of successors of its state. Transitions that have since
+    vanished are not removed, which only loosens the bounds.
+*/
+void ValueIteration::AddPredecessors(int row)
+{
+    int s = row / n_actions;
+    std::vector<std::pair<int, int> >& known = successors[s];
+    std::vector<std::pair<int, int> > merged;
+    unsigned int i = 0;
+    int n_new = 0;
+    for (int k=model.row_offset[row]; k<model.row_offset[row + 1]; ++k) {
+        int s2 = model.next_state[k];
+        real P = model.probability[k];
+        while (i < known.size() && known[i].first < s2) {
+            merged.push_back(known[i++]);
+        }
+        if (i < known.size() && known[i].first == s2) {
+            real& bound = predecessors[s2][known[i].second].second;
+            bound = std::max(bound, P);
+            merged.push_back(known[i++]);
+        } else {
+            merged.push_back(std::make_pair(s2, (int) predecessors[s2].size()));
+            predecessors[s2].push_back(std::make_pair(s, P));
+            n_new++;
+        }
+    }
+    if (!n_new) {
+        return;
+    }
+    merged.insert(merged.end(), known.begin() + i, known.end());
+    known.swap(merged);
+}
+
+/// Move the i-th state of the heap up to its place
+void ValueIteration::SiftUp(int i)
+{
+    int s = queue[i];
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (priority[queue[parent]] >= priority[s]) {
+            break;
+        }
+        queue[i] = queue[parent];
+        queue_position[queue[i]] = i;
+        i = parent;
+    }
+    queue[i] = s;
+    queue_position[s] = i;
+}
+
+/// Move the i-th state of the heap down to its place
+void ValueIteration::SiftDown(int i)
+{
+    int n = queue.size();
+    int s = queue[i];
+    while (2 * i + 1 < n) {
+        int child = 2 * i + 1;
+        if (child + 1 < n && priority[queue[child + 1]] > priority[queue[child]]) {
+            child++;
+        }
+        if (priority[queue[child]] <= priority[s]) {
+            break;
+        }
+        queue[i] = queue[child];
+        queue_position[queue[i]] = i;
+        i = child;
+    }
+    queue[i] = s;
+    queue_position[s] = i;
+}
+
+/** Raise the residual bound of s, queueing s if it exceeds the threshold.
+
+    A state already in the queue is only moved up, so that the queue
+    never holds more than one entry per state.
+*/
+void ValueIteration::RaisePriority(int s, real increase, real threshold)
+{
+    priority[s] += increase;
+    if (queue_position[s] >= 0) {
+        SiftUp(queue_position[s]);
+    } else if (priority[s] > threshold) {
+        queue.push_back(s);
+        SiftUp(queue.size() - 1);
+    }
+}
+
 /** Compute state values using value iteration.
 
 	The process ends either when the error is below the given threshold,
@@ -67,24 +235,17 @@ ValueIteration::~ValueIteration()
 void ValueIteration::ComputeStateValuesStandard(real threshold, int max_iter)
 {
     int n_iter = 0;
+    UpdateModel();
     do {
         Delta = 0.0;
         pV = V;
         for (int s=0; s<n_states; s++) {
             for (int a=0; a<n_actions; a++) {
-                real V_next_sa = 0.0;
-                const DiscreteStateSet& next = mdp->getNextStates(s, a);
-                for (DiscreteStateSet::iterator i=next.begin();
-                     i!=next.end();
-                     ++i) {
-                    int s2 = *i;
-                    real P = mdp->getTransitionProbability(s, a, s2);
-                    V_next_sa += P * pV(s2);
-                }
-                Q(s, a) = mdp->getExpectedReward(s, a) - baseline 
+                real V_next_sa = model.Expectation(s, a, pV);
+                Q(s, a) = model.getExpectedReward(s, a) - baseline 
 					+ gamma * V_next_sa;
             }
-            V(s) = Max(Q.getRow(s));
+            V(s) = MaxActionValue(s);
             Delta += fabs(V(s) - pV(s));
         }
         
@@ -97,26 +258,185 @@ void ValueIteration::ComputeStateValuesStandard(real threshold, int max_iter)
 }
 
 
+/** Compute state values using value iteration over a thread pool.
+
+    The states are split into blocks of similar numbers of
+    transitions, and the blocks are handed out to the threads.
+
+    In the default, synchronous (Jacobi) mode, each sweep reads the
+    previous values and writes the new ones into a second buffer, the
+    two buffers swapping roles after every sweep. Q and V are then
+    bit-identical to those of ComputeStateValuesStandard() at every
+    iteration, whatever the number of threads. Delta is summed within
+    each block first, so it can differ in the last bits.
+
+    In asynchronous (Gauss-Seidel) mode, values are updated in place
+    and each thread sees the latest values written by the others, as
+    in ComputeStateValuesAsynchronous(). The result then depends on
+    the scheduling of threads, but the iteration converges all the
+    same, as the Bellman operator is a contraction.
+
+    Without a thread pool, the blocks are processed serially.
+*/
+void ValueIteration::ComputeStateValuesParallel(real threshold, int max_iter, bool asynchronous)
+{
+    UpdateModel();
+    std::vector<int> block = model.PartitionStates(VI_BLOCK_SIZE);
+    int n_blocks = block.size() - 1;
+    std::vector<real> block_delta(n_blocks);
+    real* V_curr = V.x;
+    real* V_next = asynchronous ? V.x : pV.x;
+    if (asynchronous) {
+        pV = V;
+    }
+
+    std::function<void (int)> sweep = [&] (int k) {
+        real delta = 0.0;
+        for (int s=block[k]; s<block[k + 1]; ++s) {
+            for (int a=0; a<n_actions; a++) {
+                real V_next_sa = 0.0;
+                for (int j=model.RowBegin(s, a); j<model.RowEnd(s, a); ++j) {
+                    int s2 = model.next_state[j];
+                    real V_s2 = asynchronous ? RelaxedLoad(&V_curr[s2]) : V_curr[s2];
+                    V_next_sa += model.probability[j] * V_s2;
+                }
+                Q(s, a) = model.getExpectedReward(s, a) - baseline
+                    + gamma * V_next_sa;
+            }
+            real V_s = MaxActionValue(s);
+            if (asynchronous) {
+                delta += fabs(V_s - pV(s));
+                pV(s) = V_s;
+                RelaxedStore(&V_next[s], V_s);
+            } else {
+                delta += fabs(V_s - V_curr[s]);
+                V_next[s] = V_s;
+            }
+        }
+        block_delta[k] = delta;
+    };
+
+    int n_iter = 0;
+    do {
+        if (pool) {
+            pool->Run(n_blocks, sweep);
+        } else {
+            for (int k=0; k<n_blocks; ++k) {
+                sweep(k);
+            }
+        }
+        Delta = 0.0;
+        for (int k=0; k<n_blocks; ++k) {
+            Delta += block_delta[k];
+        }
+        if (!asynchronous) {
+            std::swap(V_curr, V_next);
+        }
+        if (max_iter > 0) {
+            max_iter--;
+        }
+        n_iter++;
+    } while(Delta >= threshold && max_iter != 0);
+
+    // The last values are in V_curr and the previous ones in V_next.
+    if (!asynchronous && V_curr != V.x) {
+        for (int s=0; s<n_states; s++) {
+            std::swap(V.x[s], pV.x[s]);
+        }
+    }
+}
+
+/** Compute state values by prioritized sweeping.
+
+    Instead of sweeping over all states, states are backed up one at a
+    time, in order of decreasing bound on their Bellman residual
+    \f$|\max_a Q(s,a) - V(s)|\f$, kept in an indexed max-heap. Whenever
+    the value of a state \f$s'\f$ changes by \f$\delta\f$, the bound of
+    each predecessor \f$s\f$ grows by \f$\gamma \max_a P(s' | s, a)
+    |\delta|\f$, so that the change propagates backwards only as far as
+    it matters, without backing up the predecessors right away.
+
+    The heap is seeded with the states whose transitions or rewards
+    changed since the model was last updated. If the values had
+    converged for the previous model, re-planning thus costs time
+    proportional to the effect of the changes rather than to the size
+    of the MDP. On the first call after construction, Reset() or
+    setMDP() with a different MDP, all states are seeded.
+
+    The process ends when no residual exceeds the threshold, or after
+    max_backups backups. Setting max_backups to -1 means there is no
+    limit. States still queued are kept for the next call. Delta is
+    set to the largest residual bound in the queue.
+
+    Returns the number of backups performed.
+*/
+int ValueIteration::ComputeStateValuesPrioritized(real threshold, int max_backups)
+{
+    UpdateModel();
+    if ((int) predecessors.size() != n_states) {
+        BuildPredecessors();
+    }
+    std::vector<int> seeds;
+    if (sweep_all) {
+        for (int s=0; s<n_states; s++) {
+            seeds.push_back(s);
+        }
+        sweep_all = false;
+    } else {
+        for (unsigned int i=0; i<model.changed_rows.size(); ++i) {
+            seeds.push_back(model.changed_rows[i] / n_actions);
+        }
+    }
+    for (unsigned int i=0; i<seeds.size(); ++i) {
+        int s = seeds[i];
+        real residual = fabs(Backup(s) - V(s));
+        RaisePriority(s, std::max((real) 0.0, residual - priority[s]), threshold);
+    }
+
+    int n_backups = 0;
+    while (!queue.empty() && n_backups != max_backups) {
+        int s = queue[0];
+        queue_position[s] = -1;
+        int last = queue.back();
+        queue.pop_back();
+        if (!queue.empty()) {
+            queue[0] = last;
+            SiftDown(0);
+        }
+        priority[s] = 0.0;
+        real V_s = Backup(s);
+        real change = fabs(V_s - V(s));
+        V(s) = V_s;
+        n_backups++;
+        if (change == 0.0) {
+            continue;
+        }
+        const std::vector<std::pair<int, real> >& previous = predecessors[s];
+        for (unsigned int i=0; i<previous.size(); ++i) {
+            RaisePriority(previous[i].first, gamma * previous[i].second * change, threshold);
+        }
+    }
+    Delta = queue.empty() ? 0.0 : priority[queue[0]];
+    return n_backups;
+}
+
 /** Compute values only partially.
 */
 void ValueIteration::PartialUpdate(real step_size)
 {
+    UpdateModel();
     pV = V;
     for (int s=0; s<n_states; s++) {
         for (int a=0; a<n_actions; a++) {
             real Q_sa = 0.0;
-            const DiscreteStateSet& next = mdp->getNextStates(s, a);
-            for (DiscreteStateSet::iterator i=next.begin();
-                 i!=next.end();
-                 ++i) {
-                int s2 = *i;
-                real P = mdp->getTransitionProbability(s, a, s2);
-                real R = mdp->getExpectedReward(s, a) - baseline;
-                Q_sa += P * (R + gamma * pV(s2));
+            real R = model.getExpectedReward(s, a) - baseline;
+            for (int k=model.RowBegin(s, a); k<model.RowEnd(s, a); ++k) {
+                real P = model.probability[k];
+                Q_sa += P * (R + gamma * pV(model.next_state[k]));
             }
             Q(s, a) = (1.0 - step_size) * Q(s,a) + step_size * Q_sa;
         }
-        V(s) = Max(Q.getRow(s));
+        V(s) = MaxActionValue(s);
     }
 }
 
@@ -124,19 +444,16 @@ void ValueIteration::PartialUpdate(real step_size)
 */
 void ValueIteration::PartialUpdateOnPolicy(real step_size)
 {
+    UpdateModel();
     pV = V;
     for (int s=0; s<n_states; s++) {
         int a_policy = ArgMax(Q.getRow(s));
         for (int a=0; a<n_actions; a++) {
             real Q_sa = 0.0;
-            const DiscreteStateSet& next = mdp->getNextStates(s, a);
-            for (DiscreteStateSet::iterator i=next.begin();
-                 i!=next.end();
-                 ++i) {
-                int s2 = *i;
-                real P = mdp->getTransitionProbability(s, a, s2);
-                real R = mdp->getExpectedReward(s, a) - baseline;
-                Q_sa += P * (R + gamma * pV(s2));
+            real R = model.getExpectedReward(s, a) - baseline;
+            for (int k=model.RowBegin(s, a); k<model.RowEnd(s, a); ++k) {
+                real P = model.probability[k];
+                Q_sa += P * (R + gamma * pV(model.next_state[k]));
             }
             Q(s, a) = (1.0 - step_size) * Q(s,a) + step_size * Q_sa;
         }
@@ -170,6 +487,7 @@ void ValueIteration::PartialUpdateOnPolicy(real step_size)
 void ValueIteration::ComputeStateValuesElimination(real threshold, int max_iter)
 {
     int n_iter = 0;
+    UpdateModel();
     dQ.Clear();
     do {
         Delta = 0.0;
@@ -179,18 +497,14 @@ void ValueIteration::ComputeStateValuesElimination(real threshold, int max_iter)
             for (int a=0; a<n_actions; a++) {
                 if (dQ(s,a) < 0) continue;
                 real Q_sa = 0.0;
-                const DiscreteStateSet& next = mdp->getNextStates(s, a);
-                for (DiscreteStateSet::iterator i=next.begin();
-                     i!=next.end();
-                     ++i) {
-                    int s2 = *i;
-                    real P = mdp->getTransitionProbability(s, a, s2);
-                    real R = mdp->getExpectedReward(s, a) - baseline;
-                    Q_sa += P * (R + gamma * pV(s2));
+                real R = model.getExpectedReward(s, a) - baseline;
+                for (int k=model.RowBegin(s, a); k<model.RowEnd(s, a); ++k) {
+                    real P = model.probability[k];
+                    Q_sa += P * (R + gamma * pV(model.next_state[k]));
                 }
                 Q(s, a) = Q_sa;
             }
-            V(s) = Max(Q.getRow(s));
+            V(s) = MaxActionValue(s);
             dV(s) = V(s) - pV(s);
             Delta += fabs(dV(s));
         }
@@ -225,23 +539,20 @@ void ValueIteration::ComputeStateValuesElimination(real threshold, int max_iter)
 void ValueIteration::ComputeStateValuesAsynchronous(real threshold, int max_iter)
 {
     int n_iter = 0;
+    UpdateModel();
     do {
         Delta = 0.0;
         for (int s=0; s<n_states; s++) {
             for (int a=0; a<n_actions; a++) {
                 real Q_sa = 0.0;
-                const DiscreteStateSet& next = mdp->getNextStates(s, a);
-                for (DiscreteStateSet::iterator i=next.begin();
-                     i!=next.end();
-                     ++i) {
-                    int s2 = *i;
-                    real P = mdp->getTransitionProbability(s, a, s2);
-                    real R = mdp->getExpectedReward(s, a) - baseline;
-                    Q_sa += P * (R + gamma * V(s2));
+                real R = model.getExpectedReward(s, a) - baseline;
+                for (int k=model.RowBegin(s, a); k<model.RowEnd(s, a); ++k) {
+                    real P = model.probability[k];
+                    Q_sa += P * (R + gamma * V(model.next_state[k]));
                 }
                 Q(s, a) = Q_sa;
             }
-            V(s) = Max(Q.getRow(s));
+            V(s) = MaxActionValue(s);
             Delta += fabs(V(s) - pV(s));
             pV(s) = V(s);
         }
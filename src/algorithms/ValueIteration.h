@@ -14,17 +14,46 @@
 #define VALUE_ITERATION_H
 
 #include "DiscreteMDP.h"
+#include "CompiledDiscreteMDP.h"
 #include "DiscretePolicy.h"
 #include "Matrix.h"
 #include "Vector.h"
+#include "ThreadPool.h"
 #include "real.h"
 #include <vector>
 
-/** A value iteration algorithm for discrete MDPs */
+/** A value iteration algorithm for discrete MDPs.
+
+    The backups are performed on a compiled snapshot of the MDP, which
+    is brought up to date at the start of every computation.
+
+    If a thread pool is set, ComputeStateValues() sweeps over blocks of
+    states in parallel.
+
+    For MDPs that change a little at a time, such as the mean MDP of a
+    model being learnt online, ComputeStateValuesPrioritized() only
+    backs up the states affected by the changes.
+ */
 class ValueIteration
 {
 protected:
     const DiscreteMDP* mdp; ///< pointer to the MDP
+    CompiledDiscreteMDP model; ///< compiled snapshot of the MDP
+    ThreadPool* pool; ///< threads for parallel sweeps, NULL if serial
+    std::vector<std::vector<std::pair<int, int> > > successors; ///< next states of each state, with their slot in predecessors
+    std::vector<std::vector<std::pair<int, real> > > predecessors; ///< states leading to each state, with a bound on the probability
+    std::vector<int> queue; ///< max-heap of states by residual, for prioritized sweeping
+    std::vector<int> queue_position; ///< position of each state in the heap, -1 if not queued
+    std::vector<real> priority; ///< bound on the residual of each state
+    bool sweep_all; ///< whether prioritized sweeping must start from all states
+    real MaxActionValue(int s) const;
+    real Backup(int s);
+    void UpdateModel();
+    void BuildPredecessors();
+    void AddPredecessors(int row);
+    void RaisePriority(int s, real increase, real threshold);
+    void SiftUp(int i);
+    void SiftDown(int i);
 public:
     real gamma; ///< discount factor
     int n_states; ///< number of states
@@ -43,9 +72,15 @@ public:
     inline void ComputeStateValues(real threshold, int max_iter=-1)
     {
 //		ComputeStateValuesElimination(threshold, max_iter);
-		ComputeStateValuesStandard(threshold, max_iter);
+        if (pool) {
+            ComputeStateValuesParallel(threshold, max_iter);
+        } else {
+            ComputeStateValuesStandard(threshold, max_iter);
+        }
     }
     void ComputeStateValuesStandard(real threshold, int max_iter=-1);
+    void ComputeStateValuesParallel(real threshold, int max_iter=-1, bool asynchronous=false);
+    int ComputeStateValuesPrioritized(real threshold, int max_backups=-1);
     void PartialUpdate(real stepsize);
     void PartialUpdateOnPolicy(real stepsize);
     void ComputeStateValuesAsynchronous(real threshold, int max_iter=-1);
@@ -54,7 +89,16 @@ public:
     /// Set the MDP to something else
     inline void setMDP(const DiscreteMDP* mdp_)
     {
+        if (mdp_ != mdp) {
+            sweep_all = true;
+        }
         mdp = mdp_;
+        model.setMDP(mdp);
+    }
+    /// Use a thread pool for ComputeStateValues(); NULL for serial sweeps.
+    inline void setThreadPool(ThreadPool* pool_)
+    {
+        pool = pool_;
     }
     inline void setDiscount(real gamma_) {
         assert(gamma >= 0.0 && gamma <= 1.0);
@@ -251,7 +251,7 @@ int main(int argc, char* argv[])
 
 	
 	RBFBasisSet* RBFs = new RBFBasisSet(Discretisation,scale);
-	OnlineLSPI* lspi = new OnlineLSPI(gamma, delta, state_dimension, n_actions, max_iteration, RBFs);
+	OnlineLSPI* lspi = new OnlineLSPI(gamma, delta, state_dimension, n_actions, max_iteration, algorithm, RBFs);
 	
 	Vector state;
 	Vector next_state;
@@ -290,7 +290,7 @@ int main(int argc, char* argv[])
 	      else
 		next_action = policy_lspi.SelectAction(next_state);
 				
-	      lspi->LSTDQ(state, action, reward, next_state, next_action, environment->getEndsim(),false);
+	      lspi->LSTD(state, action, reward, next_state, next_action, environment->getEndsim(),false);
 	      steps++;
 	      total_reward += reward;
 	      epsilon *= 0.9968;
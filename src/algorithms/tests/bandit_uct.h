@@ -15,8 +15,10 @@
 #include "PolicyEvaluation.h"
 #include "ValueIteration.h"
 #include "BetaDistribution.h"
+#include "SingularDistribution.h"
 #include "Random.h"
 #include "EasyClock.h"
+#include "Arena.h"
 
 #include <list>
 #include <vector>
@@ -268,6 +270,8 @@ public:
 
     Node* root;
     
+    ObjectPool<Node> node_pool; ///< storage for the nodes
+    ObjectPool<Edge> edge_pool; ///< storage for the edges
     std::list<Node*> nodes; ///< a list of nodes for book-keeping purposes
     //std::list<Edge*> edges; ///< a list of edges for book-keeping purposes
     
@@ -284,7 +288,7 @@ public:
         n_actions(n_actions_),
         gamma(gamma_)
     {
-        root = new Node;
+        root = node_pool.New();
         root->belief = prior;
         root->state = state;
         root->index = 0;
@@ -294,15 +298,10 @@ public:
         nodes.push_back(root);
     }
 
+    /// Nodes and edges are freed along with their pools
     ~BeliefTree()
     {
         DeleteDensities();
-
-        for (typename std::list<Node*>::iterator i=nodes.begin();
-             i!=nodes.end(); ++i) {
-            Node* n = *i;
-            DeleteNode(n);
-        }
     }
 
     // Should be called after created MDPs are discarded
@@ -333,7 +332,7 @@ public:
     /// Return the newly created node
     Node* ExpandAction(Node *selected_node, int a, real r, int s, int verbose = 0)
     {
-        Node* next = new Node;
+        Node* next = node_pool.New();
         next->belief = selected_node->belief;
         next->state = s;
         next->index = nodes.size();
@@ -347,7 +346,7 @@ public:
         next->belief.update(selected_node->state, a, r, s); // update the belif
         
         // save the edge connecting the previous node to the next
-        Edge* next_edge = new Edge(selected_node,
+        Edge* next_edge = edge_pool.New(selected_node,
                                  next, //was: nodes[nodes.size()-1],
                                  a, // action taken
                                  r, // reward observed
@@ -410,6 +409,18 @@ public:
         root->depth = 0;
         root->in_edge = NULL;
         UpdateNodes(root, 0);
+        nodes.clear();
+        CollectNodes(root);
+    }
+
+    /// Put all nodes below node in the book-keeping list
+    void CollectNodes(Node* node)
+    {
+        nodes.push_back(node);
+        for (typename std::list<Edge*>::iterator j = node->outs.begin();
+             j != node->outs.end(); ++j) {
+            CollectNodes((*j)->dst);
+        }
     }
     
     /// Update index and depth information of nodes
@@ -447,9 +458,9 @@ public:
         for (typename std::list<Edge*>::iterator j = node->outs.begin();
              j != node->outs.end(); ++j) {
             Edge* edge = *j;
-            delete edge;
+            edge_pool.Delete(edge);
         }
-        delete node;
+        node_pool.Delete(node);
     }
 
     void RecursiveDeleteExcept(Node* node, Node* exception)
@@ -466,7 +477,6 @@ public:
             }
         }
         DeleteNode(node);
-        nodes.remove(node);
     }
     /// Expand a node in the tree
     void Expand(Node* node, int verbose = 0)
@@ -503,7 +513,7 @@ public:
         int terminal = n_nodes;
 		
         // clear mean MDP
-        DiscreteMDP mdp(n_nodes + 1, n_actions, NULL, NULL);
+        DiscreteMDP mdp(n_nodes + 1, n_actions, NULL);
 
         // no reward in the first state
         {
@@ -586,7 +596,7 @@ public:
         if (verbose >= 90) {
             printf ("Creating MDP with %d nodes\n", n_nodes);
         }
-        DiscreteMDP mdp(n_nodes + 1, n_actions, NULL, NULL);
+        DiscreteMDP mdp(n_nodes + 1, n_actions, NULL);
         // assume MDP is cleared
         // no reward in the first state
         {
@@ -53,6 +53,48 @@ int main(void)
     Q.push_back(GetQValues(mdp_list[0], gamma));
     Q.push_back(GetQValues(mdp_list[1], gamma));
 
+    // the batched individual values should match separate value iteration
+    {
+        Vector w(2);
+        w(0) = 0.5;
+        w(1) = 0.5;
+        MultiMDPValueIteration batch_value_iteration(w, mdp_list, gamma);
+        batch_value_iteration.ComputeIndividualStateValues(0.0, 100);
+        real max_difference = 0.0;
+        for (int mu=0; mu<2; ++mu) {
+            ValueIteration value_iteration(mdp_list[mu], gamma);
+            value_iteration.ComputeStateValuesStandard(0.0, 100);
+            for (int s=0; s<mdp_list[mu]->getNStates(); ++s) {
+                for (int a=0; a<mdp_list[mu]->getNActions(); ++a) {
+                    real d = fabs(value_iteration.getValue(s, a)
+                                  - batch_value_iteration.getValue(mu, s, a));
+                    max_difference = std::max(max_difference, d);
+                }
+            }
+        }
+        printf ("%g # batched value difference\n", max_difference);
+        if (max_difference > 0) {
+            return -1;
+        }
+
+        // the common policy values do not start from the individual ones
+        MultiMDPValueIteration fresh_value_iteration(w, mdp_list, gamma);
+        fresh_value_iteration.ComputeStateValues(1e-3, 5);
+        batch_value_iteration.ComputeStateValues(1e-3, 5);
+        real order_difference = 0.0;
+        for (int s=0; s<mdp_list[0]->getNStates(); ++s) {
+            for (int a=0; a<mdp_list[0]->getNActions(); ++a) {
+                order_difference = std::max(order_difference,
+                                            fabs(fresh_value_iteration.getValue(s, a)
+                                                 - batch_value_iteration.getValue(s, a)));
+            }
+        }
+        printf ("%g # call order difference\n", order_difference);
+        if (order_difference > 0) {
+            return -1;
+        }
+    }
+
     for (real weight = 0; weight<=1; weight+=0.01) {
         Vector w(2);
         w(0) = weight;
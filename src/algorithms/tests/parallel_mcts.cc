@@ -0,0 +1,143 @@
+/* -*- Mode: C++; -*- */
+// copyright (c) 2013 by Christos Dimitrakakis <christos.dimitrakakis@gmail.com>
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifdef MAKE_MAIN
+
+#include "MonteCarloTreeSearch.h"
+#include "XoshiroRNG.h"
+#include "ThreadPool.h"
+#include <chrono>
+#include <vector>
+
+/** A deterministic walk on a line.
+
+	Actions move left, stay or move right. The episode ends at either
+	end of the line, with reward 1 on the right and -1 on the left.
+ */
+class LineWalk : public ContinuousStateEnvironment
+{
+public:
+    LineWalk() : ContinuousStateEnvironment(1, 3)
+    {
+        state.Resize(1);
+        state_lower_bound = Vector(1);
+        state_upper_bound = Vector(1);
+        state_lower_bound(0) = -5;
+        state_upper_bound(0) = 5;
+        Reset();
+    }
+    virtual void Reset()
+    {
+        state(0) = 0;
+        reward = 0;
+        endsim = false;
+    }
+    virtual bool Act(const int& action)
+    {
+        state(0) += action - 1;
+        reward = 0;
+        if (state(0) >= state_upper_bound(0)) {
+            reward = 1;
+            endsim = true;
+        } else if (state(0) <= state_lower_bound(0)) {
+            reward = -1;
+            endsim = true;
+        }
+        return !endsim;
+    }
+    virtual LineWalk* Clone() const
+    {
+        return new LineWalk(*this);
+    }
+    virtual const char* Name() const
+    {
+        return "Line walk";
+    }
+};
+
+int main()
+{
+    int n_errors = 0;
+    int n_workers = 4;
+    int n_rollouts = 2000;
+    real gamma = 0.95;
+
+    LineWalk environment;
+    XoshiroRNG rng(1);
+    RandomPolicy policy(environment.getNActions(), &rng);
+
+    std::vector<XoshiroRNG*> rngs(n_workers);
+    std::vector<RandomPolicy*> policies(n_workers);
+    for (int k=0; k<n_workers; ++k) {
+        rngs[k] = new XoshiroRNG(1, k + 1);
+        policies[k] = new RandomPolicy(environment.getNActions(), rngs[k]);
+    }
+    ThreadPool pool(n_workers);
+
+    const char* names[] = {"serial", "root-parallel", "tree-parallel"};
+    MonteCarloTreeSearch<Vector, int>::ParallelMode modes[] = {
+        MonteCarloTreeSearch<Vector, int>::SERIAL,
+        MonteCarloTreeSearch<Vector, int>::ROOT_PARALLEL,
+        MonteCarloTreeSearch<Vector, int>::TREE_PARALLEL
+    };
+    for (int m=0; m<3; ++m) {
+        MonteCarloTreeSearch<Vector, int> mcts(gamma, &environment, &rng, policy, 100, n_rollouts);
+        for (int k=0; k<n_workers; ++k) {
+            if (!mcts.addWorker(policies[k], rngs[k], 1)) {
+                n_errors++;
+            }
+        }
+        mcts.setThreadPool(&pool);
+        mcts.setParallelMode(modes[m]);
+        mcts.setVirtualLoss(-1.0);
+
+        // walk to the goal
+        Vector state = environment.getState();
+        int n_steps = 0;
+        bool running = true;
+        auto start = std::chrono::steady_clock::now();
+        while (running && n_steps < 20) {
+            int action = mcts.SelectAction(state);
+            running = environment.Act(action);
+            state = environment.getState();
+            n_steps++;
+        }
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        printf("%s: %d steps, reward %f, %f s\n", names[m], n_steps, environment.getReward(), elapsed);
+        if (environment.getReward() != 1 || n_steps > 7) {
+            n_errors++;
+        }
+        environment.Reset();
+
+        // a wall-clock budget per decision
+        mcts.setTimeBudget(0.05);
+        start = std::chrono::steady_clock::now();
+        int action = mcts.SelectAction(environment.getState());
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        printf("%s: 0.05 s budget took %f s, action %d\n", names[m], elapsed, action);
+        if (elapsed > 0.5 || action != 2) {
+            n_errors++;
+        }
+    }
+
+    for (int k=0; k<n_workers; ++k) {
+        delete rngs[k];
+        delete policies[k];
+    }
+    if (n_errors) {
+        printf("%d errors\n", n_errors);
+        return -1;
+    }
+    printf("OK\n");
+    return 0;
+}
+
+#endif
@@ -0,0 +1,122 @@
+/* -*- Mode: C++; -*- */
+// copyright (c) 2013 by Christos Dimitrakakis <christos.dimitrakakis@gmail.com>
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifdef MAKE_MAIN
+
+#include "RecursiveLSTDQ.h"
+#include "Random.h"
+#include "EasyClock.h"
+#include <cmath>
+#include <vector>
+
+Vector RandomFeatures(int n)
+{
+    Vector phi(n);
+    for (int i=0; i<n; ++i) {
+        phi(i) = urandom();
+    }
+    return phi;
+}
+
+/// Solve the weighted, discounted LSTD-Q problem directly
+Vector BatchSolution(const std::vector<Vector>& phi,
+                     const std::vector<Vector>& phi_next,
+                     const std::vector<real>& reward,
+                     const std::vector<real>& weight,
+                     real gamma, real forgetting, real delta)
+{
+    int n = phi[0].Size();
+    int T = phi.size();
+    Matrix A = Matrix::Unity(n, n) * (delta * pow(forgetting, T));
+    Vector b(n);
+    for (int t=0; t<T; ++t) {
+        real c = weight[t] * pow(forgetting, T - 1 - t);
+        Vector d = phi[t] - phi_next[t] * gamma;
+        A += OuterProduct(phi[t], d) * c;
+        b.AddScaled(c * reward[t], phi[t]);
+    }
+    return A.Inverse_LU() * b;
+}
+
+int main()
+{
+    int n_errors = 0;
+    int n = 20;
+    int T = 100;
+    real gamma = 0.9;
+    real delta = 1e-3;
+
+    std::vector<Vector> phi(T);
+    std::vector<Vector> phi_next(T);
+    std::vector<real> reward(T);
+    std::vector<real> weight(T);
+    for (int t=0; t<T; ++t) {
+        phi[t] = RandomFeatures(n);
+        phi_next[t] = RandomFeatures(n);
+        reward[t] = urandom(-1.0, 1.0);
+        weight[t] = urandom(0.5, 2.0);
+    }
+
+    real forgetting[] = {1.0, 0.99};
+    for (int k=0; k<2; ++k) {
+        RecursiveLSTDQ rls(n, gamma, forgetting[k], delta);
+        for (int t=0; t<T; ++t) {
+            rls.Observe(phi[t], reward[t], phi_next[t], weight[t]);
+        }
+        Vector w = BatchSolution(phi, phi_next, reward, weight,
+                                 gamma, forgetting[k], delta);
+        real error = (rls.getWeights() - w).L1Norm() / w.L1Norm();
+        printf("forgetting %f: relative error %g\n", forgetting[k], error);
+        if (error > 1e-6) {
+            n_errors++;
+        }
+    }
+
+    // terminal transitions have no next state
+    {
+        RecursiveLSTDQ rls(n, gamma, 1.0, delta);
+        Vector zero(n);
+        for (int t=0; t<T; ++t) {
+            phi_next[t] = zero;
+            rls.ObserveTerminal(phi[t], reward[t], weight[t]);
+        }
+        Vector w = BatchSolution(phi, phi_next, reward, weight,
+                                 gamma, 1.0, delta);
+        real error = (rls.getWeights() - w).L1Norm() / w.L1Norm();
+        printf("terminal: relative error %g\n", error);
+        if (error > 1e-6) {
+            n_errors++;
+        }
+    }
+
+    // time per transition for a large number of features
+    int N = 1000;
+    int n_steps = 100;
+    RecursiveLSTDQ rls(N, gamma);
+    Vector x = RandomFeatures(N);
+    Vector y = RandomFeatures(N);
+    double start_time = GetCPU();
+    for (int t=0; t<n_steps; ++t) {
+        rls.Observe(x, 1.0, y);
+    }
+    double end_time = GetCPU();
+    printf("%d features: %f s per transition\n",
+           N, (end_time - start_time) / n_steps);
+
+    if (n_errors) {
+        printf("%d errors\n", n_errors);
+        return -1;
+    }
+    printf("OK\n");
+    return 0;
+}
+
+#endif
@@ -21,6 +21,7 @@
 #include "MersenneTwister.h"
 #include "DiscreteChain.h"
 #include "EasyClock.h"
+#include "ThreadPool.h"
 
 int main (void)
 {
@@ -103,6 +104,100 @@ int main (void)
         }
         delete policy;
     }
+
+    {
+        // a large MDP with a few successors per state-action pair
+        int n_big = 20000;
+        int n_big_actions = 4;
+        DiscreteMDP sparse_mdp(n_big, n_big_actions);
+        for (int s=0; s<n_big; ++s) {
+            for (int a=0; a<n_big_actions; ++a) {
+                for (int k=0; k<3; ++k) {
+                    sparse_mdp.setTransitionProbability(s, a, (int) floor(n_big * rng.uniform()), 1.0 / 3.0);
+                }
+                sparse_mdp.setFixedReward(s, a, rng.uniform());
+            }
+        }
+        const DiscreteMDP* big_mdp = &sparse_mdp;
+        ValueIteration serial(big_mdp, gamma);
+        double start_time = GetCPU();
+        serial.ComputeStateValuesStandard(0.0, 100);
+        double end_time = GetCPU();
+        printf("\nStandard time (%d states): %f\n", n_big, end_time - start_time);
+
+        ThreadPool pool(4);
+        ValueIteration parallel(big_mdp, gamma);
+        parallel.setThreadPool(&pool);
+        start_time = GetCPU();
+        parallel.ComputeStateValues(0.0, 100);
+        end_time = GetCPU();
+        printf("Parallel time (%d threads): %f\n", pool.getNThreads(), end_time - start_time);
+        int n_differences = 0;
+        for (int s=0; s<n_big; ++s) {
+            if (serial.getValue(s) != parallel.getValue(s)) {
+                n_differences++;
+            }
+        }
+        printf("%d values differ from the serial ones\n", n_differences);
+
+        ValueIteration gauss_seidel(big_mdp, gamma);
+        gauss_seidel.setThreadPool(&pool);
+        gauss_seidel.ComputeStateValuesParallel(1e-6, -1, true);
+        real max_error = 0.0;
+        serial.ComputeStateValuesStandard(1e-6, -1);
+        for (int s=0; s<n_big; ++s) {
+            max_error = std::max(max_error, (real) fabs(serial.getValue(s) - gauss_seidel.getValue(s)));
+        }
+        printf("Asynchronous parallel error: %f\n", max_error);
+
+        if (n_differences) {
+            return -1;
+        }
+    }
+
+    {
+        // a ring of states, re-planned after a few local changes
+        int n_ring = 20000;
+        int n_ring_actions = 2;
+        real ring_gamma = 0.95;
+        DiscreteMDP ring_mdp(n_ring, n_ring_actions);
+        for (int s=0; s<n_ring; ++s) {
+            for (int a=0; a<n_ring_actions; ++a) {
+                int s_next = (s + n_ring + 2 * a - 1) % n_ring;
+                ring_mdp.setTransitionProbability(s, a, s_next, 0.9);
+                ring_mdp.setTransitionProbability(s, a, s, 0.1);
+                ring_mdp.setFixedReward(s, a, rng.uniform());
+            }
+        }
+        ValueIteration standard(&ring_mdp, ring_gamma);
+        ValueIteration prioritized(&ring_mdp, ring_gamma);
+        standard.ComputeStateValuesStandard(1e-9, -1);
+        prioritized.ComputeStateValuesPrioritized(1e-9);
+
+        for (int i=0; i<10; ++i) {
+            int s = (int) floor(n_ring * rng.uniform());
+            int a = (int) floor(n_ring_actions * rng.uniform());
+            ring_mdp.setTransitionProbability(s, a, s, 0.2);
+            ring_mdp.setTransitionProbability(s, a, (s + n_ring + 2 * a - 1) % n_ring, 0.8);
+            ring_mdp.setFixedReward(s, a, rng.uniform());
+        }
+        double start_time = GetCPU();
+        standard.ComputeStateValuesStandard(1e-9, -1);
+        double end_time = GetCPU();
+        printf("\nStandard re-planning time (%d states): %f\n", n_ring, end_time - start_time);
+        start_time = GetCPU();
+        int n_backups = prioritized.ComputeStateValuesPrioritized(1e-9);
+        end_time = GetCPU();
+        printf("Prioritized re-planning time: %f, %d backups\n", end_time - start_time, n_backups);
+        real max_error = 0.0;
+        for (int s=0; s<n_ring; ++s) {
+            max_error = std::max(max_error, (real) fabs(standard.getValue(s) - prioritized.getValue(s)));
+        }
+        printf("Prioritized error: %g\n", max_error);
+        if (max_error > 1e-6) {
+            return -1;
+        }
+    }
     printf("\nDone\n");
     return 0.0;
 }
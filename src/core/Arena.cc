@@ -0,0 +1,64 @@
+/* -*- Mode: C++; -*- */
+// copyright (c) 2013 by Christos Dimitrakakis <christos.dimitrakakis@gmail.com>
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "Arena.h"
+#include <cstdlib>
+
+Arena::Arena(size_t block_size_)
+	: block_size(block_size_), current(0), offset(0)
+{
+}
+
+Arena::~Arena()
+{
+	Clear();
+	for (size_t i=0; i<blocks.size(); ++i) {
+		free(blocks[i]);
+	}
+}
+
+/** Allocate size bytes.
+
+	\param alignment must be a power of two, at most that of malloc.
+*/
+void* Arena::Allocate(size_t size, size_t alignment)
+{
+	assert((alignment & (alignment - 1)) == 0);
+	if (size > block_size / 4) {
+		char* x = (char*) malloc(size);
+		large.push_back(x);
+		return x;
+	}
+	while (true) {
+		if (current == blocks.size()) {
+			blocks.push_back((char*) malloc(block_size));
+			offset = 0;
+		}
+		size_t start = (offset + alignment - 1) & ~(alignment - 1);
+		if (start + size <= block_size) {
+			offset = start + size;
+			return blocks[current] + start;
+		}
+		current++;
+		offset = 0;
+	}
+}
+
+/// Release everything allocated, keeping the blocks for reuse.
+void Arena::Clear()
+{
+	for (size_t i=0; i<large.size(); ++i) {
+		free(large[i]);
+	}
+	large.clear();
+	current = 0;
+	offset = 0;
+}
@@ -0,0 +1,137 @@
+// -*- Mode: c++ -*-
+// copyright (c) 2013 by Christos Dimitrakakis <christos.dimitrakakis@gmail.com>
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <utility>
+#include <vector>
+
+/** A bump allocator for plain data.
+
+	Memory is handed out from large blocks, and is only given back all
+	at once, with Clear(). The blocks are kept, so that an arena that
+	is cleared and refilled, e.g. once per search, stops calling malloc
+	after the first round. Nothing is constructed or destroyed, so only
+	use it for types that need no destructor.
+ */
+class Arena
+{
+protected:
+	size_t block_size; ///< size of each block
+	std::vector<char*> blocks; ///< the blocks, in order of use
+	std::vector<char*> large; ///< allocations larger than a block
+	size_t current; ///< block in use
+	size_t offset; ///< first free byte in the current block
+public:
+	Arena(size_t block_size_ = 65536);
+	~Arena();
+	void* Allocate(size_t size, size_t alignment = sizeof(void*));
+	/// Allocate n value-initialised elements
+	template <class T>
+	T* NewArray(int n)
+	{
+		T* x = (T*) Allocate(n * sizeof(T), alignof(T));
+		for (int i=0; i<n; ++i) {
+			new (&x[i]) T();
+		}
+		return x;
+	}
+	void Clear();
+private:
+	Arena(const Arena&);
+	Arena& operator=(const Arena&);
+};
+
+/** A pool of objects of a single type.
+
+	Objects are placed in chunks of contiguous storage. New() takes
+	the most recently freed slot, or else the next unused slot, so
+	allocation never calls malloc once the pool has grown to its
+	working size. Delete() destroys a single object, while Clear()
+	destroys all live objects at once, keeping the storage.
+
+	A pool is not thread-safe: use one per thread.
+ */
+template <class T>
+class ObjectPool
+{
+protected:
+	int chunk_size; ///< objects per chunk
+	std::vector<T*> chunks; ///< raw storage
+	int n_used; ///< slots ever handed out since the last Clear()
+	std::vector<T*> free_slots; ///< slots freed with Delete()
+public:
+	ObjectPool(int chunk_size_ = 1024)
+		: chunk_size(chunk_size_), n_used(0)
+	{
+		assert(chunk_size > 0);
+	}
+	~ObjectPool()
+	{
+		Clear();
+		for (size_t i=0; i<chunks.size(); ++i) {
+			::operator delete(chunks[i]);
+		}
+	}
+	/// Construct an object in the pool
+	template <class... Args>
+	T* New(Args&&... args)
+	{
+		void* slot;
+		if (!free_slots.empty()) {
+			slot = free_slots.back();
+			free_slots.pop_back();
+		} else {
+			int c = n_used / chunk_size;
+			if (c == (int) chunks.size()) {
+				chunks.push_back((T*) ::operator new(chunk_size * sizeof(T)));
+			}
+			slot = &chunks[c][n_used % chunk_size];
+			n_used++;
+		}
+		return new (slot) T(std::forward<Args>(args)...);
+	}
+	/// Destroy an object, and keep its slot for reuse
+	void Delete(T* x)
+	{
+		x->~T();
+		free_slots.push_back(x);
+	}
+	/// Number of live objects
+	int Size() const
+	{
+		return n_used - (int) free_slots.size();
+	}
+	/// Destroy all live objects
+	void Clear()
+	{
+		std::sort(free_slots.begin(), free_slots.end(), std::less<T*>());
+		for (int i=0; i<n_used; ++i) {
+			T* x = &chunks[i / chunk_size][i % chunk_size];
+			if (!std::binary_search(free_slots.begin(), free_slots.end(), x, std::less<T*>())) {
+				x->~T();
+			}
+		}
+		free_slots.clear();
+		n_used = 0;
+	}
+private:
+	ObjectPool(const ObjectPool&);
+	ObjectPool& operator=(const ObjectPool&);
+};
+
+#endif
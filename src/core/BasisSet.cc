@@ -12,6 +12,9 @@
 #include "BasisSet.h"
 
 RBFBasisSet::RBFBasisSet(const EvenGrid& grid, real scale)
+	: n_dim(0),
+	  valid_features(false),
+	  valid_log_features(false)
 {
 	n_bases = 0;
     for (int i=0; i<grid.getNIntervals(); ++i) {
@@ -22,42 +25,74 @@ RBFBasisSet::RBFBasisSet(const EvenGrid& grid, real scale)
 
 RBFBasisSet::~RBFBasisSet()
 {
-    for (uint i=0;  i<centers.size(); ++i) {
-        delete centers[i];
-    }
 }
 
-void RBFBasisSet::AddCenter(const Vector& v, const Vector& b)
+/// Append a centre v with bandwidths b
+void RBFBasisSet::AddCenter(const real* v, const real* b)
 {
-    RBF* rbf = new RBF(v, b);
-    centers.push_back(rbf);
+    for (int j=0; j<n_dim; ++j) {
+        assert(b[j] > 0);
+        center[j].push_back(v[j]);
+        inv_beta[j].push_back(1.0 / b[j]);
+    }
     n_bases++;
-	features.Resize(centers.size());
+	features.Resize(n_bases);
 	features[n_bases-1] = 0.0;
-	log_features.Resize(centers.size());
+	log_features.Resize(n_bases);
 	log_features[n_bases-1] = 0.0;
     valid_features = false;
     valid_log_features = false;
 }
 
+void RBFBasisSet::AddCenter(const Vector& v, const Vector& b)
+{
+    if (n_bases == 0) {
+        n_dim = v.Size();
+        center.resize(n_dim);
+        inv_beta.resize(n_dim);
+    }
+    assert(v.Size() == n_dim && b.Size() == n_dim);
+    AddCenter(v.x, b.x);
+}
+
 void RBFBasisSet::AddCenter(const Vector& v, real b)
 {
-    RBF* rbf = new RBF(v, b);
-    centers.push_back(rbf);
-	n_bases++;
-	features.Resize(centers.size());
-	features[n_bases-1] = 0.0;
-	log_features.Resize(centers.size());
-	log_features[n_bases-1] = 0.0;
-    valid_features = false;
-    valid_log_features = false;
+    Vector beta(v.Size());
+    for (int j=0; j<beta.Size(); ++j) {
+        beta(j) = b;
+    }
+    AddCenter(v, beta);
+}
+
+/** Compute \f$r_i = \sum_j ((x_j - c_{ij}) / \beta_{ij})^2\f$ for all centres.
+
+	The inner loop runs over the centres, so that it is vectorised.
+*/
+void RBFBasisSet::SquaredDistances(const real* x, real* r) const
+{
+    if (n_bases == 0) {
+        return;
+    }
+    for (int i=0; i<n_bases; ++i) {
+        r[i] = 0.0;
+    }
+    for (int j=0; j<n_dim; ++j) {
+        const real* c = &center[j][0];
+        const real* ib = &inv_beta[j][0];
+        const real x_j = x[j];
+        for (int i=0; i<n_bases; ++i) {
+            real d = (x_j - c[i]) * ib[i];
+            r[i] += d * d;
+        }
+    }
 }
 
 void RBFBasisSet::logEvaluate(const Vector& x)
 {
+    assert(x.Size() == n_dim);
+    SquaredDistances(x.x, log_features.x);
     real log_sum = LOG_ZERO;
     for (int i=0; i<n_bases; ++i) {
-        log_features[i] = centers[i]->logEvaluate(x);
         log_sum = logAdd(log_features[i], log_sum);
     }
     for (int i=0; i<n_bases; ++i) {
@@ -67,21 +102,60 @@ void RBFBasisSet::logEvaluate(const Vector& x)
     valid_features = false;
 }
 
-//void RBFBasisSet::Evaluate(const Vector& x)
-//{
-//    logEvaluate(x);
-//    for (int i=0; i<n_bases; ++i) {
-//        features[i] = exp(log_features[i]);
-//    }
-//    valid_features = true;
-//}
-
 void RBFBasisSet::Evaluate(const Vector& x)
 {
+    assert(x.Size() == n_dim);
+    real* f = features.x;
+    SquaredDistances(x.x, f);
 	for(int i = 0; i<n_bases; ++i){
-		features[i] = centers[i]->Evaluate(x);
+		f[i] = exp(-0.5 * f[i]);
 	}
 	valid_log_features = true;
 	valid_features = true;
 }
 
+/** Evaluate the features of many states at once.
+
+	Each row of X is a state. Row k of F is set to the features of
+	state k; F is resized if necessary. The features returned by F()
+	are left untouched.
+*/
+void RBFBasisSet::Evaluate(const Matrix& X, Matrix& F) const
+{
+    assert(X.Columns() == n_dim);
+    int N = X.Rows();
+    if (F.Rows() != N || F.Columns() != n_bases) {
+        F.Resize(N, n_bases);
+    }
+    Vector x(n_dim);
+    Vector f(n_bases);
+    for (int k=0; k<N; ++k) {
+        for (int j=0; j<n_dim; ++j) {
+            x(j) = X(k, j);
+        }
+        SquaredDistances(x.x, f.x);
+        for (int i=0; i<n_bases; ++i) {
+            F(k, i) = exp(-0.5 * f(i));
+        }
+    }
+}
+
+/** Evaluate state-action features.
+
+	Each action has its own copy of the features, preceded by a
+	constant term, so there are n_actions * (size() + 1) features in
+	total. Only the block of the given action is non-zero.
+*/
+void RBFBasisSet::Evaluate(const Vector& x, int action, int n_actions, BlockVector& phi)
+{
+	assert(action >= 0 && action < n_actions);
+	Evaluate(x);
+	int block_size = n_bases + 1;
+	phi.n = n_actions * block_size;
+	phi.offset = action * block_size;
+	phi.block.Resize(block_size);
+	phi.block[0] = 1.0;
+	for (int i=0; i<n_bases; ++i) {
+		phi.block[i + 1] = features[i];
+	}
+}
@@ -15,6 +15,7 @@
 #include <vector>
 #include <cassert>
 #include "Vector.h"
+#include "BlockVector.h"
 #include "Grid.h"
 
 /** A simple radial basis function */
@@ -39,33 +40,46 @@ public:
     /// Get the density at point x
     real Evaluate(const Vector& x)
     {
-		Vector d = pow((x - center)/beta, 2.0);
-		real r = d.Sum();
-        //real d = EuclideanNorm(&x, &center);
-        return exp(-0.5*r);
+        return exp(-0.5*logEvaluate(x));
     }
     /// Evaluate the log density
     real logEvaluate(const Vector& x)
     {
-		Vector d = pow((x - center)/beta,2);
-
-		return d.Sum();
+        assert(x.Size() == center.Size());
+        real r = 0.0;
+        for (int i=0; i<center.Size(); ++i) {
+            real d = (x[i] - center[i]) / beta[i];
+            r += d * d;
+        }
+		return r;
     //    return (-beta) * EuclideanNorm(&x, &center);		
     }
 };
 
+/** A set of radial basis functions.
+
+	The centres and bandwidths are stored dimension by dimension, in
+	contiguous arrays over all basis functions. The features of a
+	state are thus computed by a loop over the basis functions that
+	the compiler can vectorise, without any temporaries.
+ */
 class RBFBasisSet
 {
 protected:
-    std::vector<RBF*> centers;
+    int n_dim; ///< dimension of the input
+    std::vector< std::vector<real> > center; ///< center[j][i]: coordinate j of centre i
+    std::vector< std::vector<real> > inv_beta; ///< inv_beta[j][i]: inverse bandwidth j of centre i
 
 	Vector log_features;
 	Vector features;
     bool valid_features;
     bool valid_log_features;
     int n_bases;
+    void SquaredDistances(const real* x, real* r) const;
+    void AddCenter(const real* v, const real* b);
 public:
     RBFBasisSet() :
+        n_dim(0),
         valid_features(false),
         valid_log_features(false),
         n_bases(0)
@@ -75,6 +89,8 @@ public:
 	void AddCenter(const Vector& v, const Vector& b);
     void AddCenter(const Vector& v, real b);
     void Evaluate(const Vector& x);
+    void Evaluate(const Vector& x, int action, int n_actions, BlockVector& phi);
+    void Evaluate(const Matrix& X, Matrix& F) const;
     void logEvaluate(const Vector& x);
     int size()
     {
@@ -86,7 +102,7 @@ public:
         assert(valid_log_features);
         return log_features[j];
     }
-	Vector log_F()
+	const Vector& log_F() const
 	{
 		return log_features;
 	}
@@ -96,7 +112,7 @@ public:
         assert(valid_features);
         return features[j];
     }
-	Vector F()
+	const Vector& F() const
 	{
 		return features;
 	}
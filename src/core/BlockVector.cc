@@ -0,0 +1,73 @@
+/* -*- Mode: C++; -*- */
+// copyright (c) 2013 by Christos Dimitrakakis <christos.dimitrakakis@gmail.com>
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "BlockVector.h"
+#include <algorithm>
+
+/// Add alpha times this vector to y, touching only the block.
+void BlockVector::AddTo(Vector& y, real alpha) const
+{
+	assert(y.Size() == n);
+	real* dst = &y.x[offset];
+	for (int i=0; i<block.Size(); ++i) {
+		dst[i] += alpha * block.x[i];
+	}
+}
+
+/// Return the full vector
+Vector BlockVector::getDense() const
+{
+	Vector y(n);
+	AddTo(y);
+	return y;
+}
+
+/// Dot product with a dense vector, over the block only.
+real Product(const BlockVector& x, const Vector& y)
+{
+	assert(x.n == y.Size());
+	const real* z = &y.x[x.offset];
+	real sum = 0.0;
+	for (int i=0; i<x.block.Size(); ++i) {
+		sum += x.block.x[i] * z[i];
+	}
+	return sum;
+}
+
+/// Dot product with a dense vector, over the block only.
+real Product(const Vector& x, const BlockVector& y)
+{
+	return Product(y, x);
+}
+
+/// Dot product over the overlap of the blocks.
+real Product(const BlockVector& x, const BlockVector& y)
+{
+	assert(x.n == y.n);
+	int begin = std::max(x.offset, y.offset);
+	int end = std::min(x.End(), y.End());
+	real sum = 0.0;
+	for (int i=begin; i<end; ++i) {
+		sum += x.block.x[i - x.offset] * y.block.x[i - y.offset];
+	}
+	return sum;
+}
+
+/** Add \f$\alpha u v'\f$ to A.
+
+	Only the rows of the block of u and the columns of the block of v
+	are touched.
+*/
+void AddOuterProduct(Matrix& A, real alpha, const BlockVector& u, const BlockVector& v)
+{
+	assert(A.Rows() == u.n && A.Columns() == v.n);
+	A.AddOuterProduct(alpha, u.block, v.block, u.offset, v.offset);
+}
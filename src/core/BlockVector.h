@@ -0,0 +1,79 @@
+// -*- Mode: c++ -*-
+// copyright (c) 2013 by Christos Dimitrakakis <christos.dimitrakakis@gmail.com>
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef BLOCK_VECTOR_H
+#define BLOCK_VECTOR_H
+
+#include "Vector.h"
+#include "Matrix.h"
+
+/** A vector that is zero outside a single contiguous block.
+
+	This is the shape of state-action features built by giving each
+	action its own copy of a set of state features: only the block
+	of the chosen action is non-zero. Products with dense vectors and
+	rank-1 updates of matrices then only touch the block, rather than
+	all actions.
+
+	Elements [offset, offset + block.Size()) are stored in block; all
+	others are zero.
+ */
+class BlockVector
+{
+public:
+	int n; ///< dimension
+	int offset; ///< position of the first element of the block
+	Vector block; ///< the non-zero block
+	BlockVector()
+		: n(0), offset(0)
+	{
+	}
+	BlockVector(int n_, int offset_, int block_size)
+		: n(n_), offset(offset_), block(block_size)
+	{
+		assert(offset >= 0 && offset + block_size <= n);
+	}
+	/// Resize, and set all elements to zero
+	void Resize(int n_, int offset_, int block_size)
+	{
+		assert(offset_ >= 0 && offset_ + block_size <= n_);
+		n = n_;
+		offset = offset_;
+		block.Resize(block_size);
+		block.Clear();
+	}
+	int Size() const
+	{
+		return n;
+	}
+	/// One past the last element of the block
+	int End() const
+	{
+		return offset + block.Size();
+	}
+	real operator() (int i) const
+	{
+		assert(i >= 0 && i < n);
+		if (i < offset || i >= End()) {
+			return 0.0;
+		}
+		return block(i - offset);
+	}
+	void AddTo(Vector& y, real alpha = 1.0) const;
+	Vector getDense() const;
+};
+
+real Product(const BlockVector& x, const Vector& y);
+real Product(const Vector& x, const BlockVector& y);
+real Product(const BlockVector& x, const BlockVector& y);
+void AddOuterProduct(Matrix& A, real alpha, const BlockVector& u, const BlockVector& v);
+
+#endif
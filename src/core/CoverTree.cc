@@ -10,6 +10,7 @@
  ***************************************************************************/
 
 #include "CoverTree.h"
+#include "ThreadPool.h"
 
 /// Constructor needs a point and a level
 CoverTree::Node::Node (const CoverTree& tree_, 
@@ -327,12 +328,14 @@ const void CoverTree::SamplingNode(Node* n, const Vector& R)
 }
 const void CoverTree::SamplingTree()
 {
+  Invalidate();
   num_sampling_nodes = 0;
   SamplingNode(root);
 }
 const void CoverTree::SamplingTree(const Vector& R)
 {
   assert(R.Size() == num_nodes);
+  Invalidate();
   SamplingNode(root,R);
 }
 Vector CoverTree::BasisCreation(const Vector& state) const
@@ -387,6 +390,42 @@ const std::vector< std::pair<int,real> > CoverTree::ExternalBasisCreation(const
   return phi;
 }
 
+/** Create the basis features of many states at once.
+
+    The features of the i-th state are the same as those of
+    ExternalBasisCreation(states[i]), but the path is found in the
+    compact layout, and states are processed on the thread pool, if
+    there is one.
+*/
+void CoverTree::ExternalBasisCreation(const std::vector<Vector>& states, std::vector< std::vector< std::pair<int,real> > >& phi) const
+{
+  int n_states = states.size();
+  phi.resize(n_states);
+  Compact();
+  RunBatch(n_states, [&](int i) {
+      std::vector< std::pair<int, real> >& phi_i = phi[i];
+      phi_i.clear();
+      if (compact_nodes.empty()) {
+        return;
+      }
+      assert(states[i].Size() == n_dimensions);
+      const real* x = states[i].x;
+      int k = CompactNearestNeighbour(0, x, CompactDistance(0, x)).first;
+      while (k >= 0) {
+        const CompactNode& node = compact_nodes[k];
+        if (node.basis_index >= 0) {
+          const real* y = &compact_points[k * n_dimensions];
+          real r = 0.0;
+          for (int j=0; j<n_dimensions; ++j) {
+            r += pow((x[j] - y[j]) / node.beta, 2.0);
+          }
+          phi_i.push_back(std::pair<int, real>(node.basis_index, exp(-0.5*r)));
+        }
+        k = node.father;
+      }
+    });
+}
+
 /** Insert a new point in the tree.
  
     Q_i is the set of points such that the new point may be a nearest
@@ -614,6 +653,7 @@ CoverTree::Node* CoverTree::Insert(const Vector& new_point, const Vector& phi, c
 } /// Insert a new point in the tree
 CoverTree::Node* CoverTree::Insert(const Vector& new_point, void* obj)
 {
+  Invalidate();
   total_samples++;
   if (!root) {
 #ifdef DEBUG_COVER_TREE
@@ -636,6 +676,7 @@ CoverTree::Node* CoverTree::Insert(const Vector& new_point, void* obj)
 CoverTree::Node* CoverTree::Insert(const Vector& new_point, const Vector& next_state, const real& reward, const bool& absorb, void* obj)
 {
   Vector phi = BasisCreation(new_point);
+  Invalidate();
   total_samples++;
   if (!root) {
 #ifdef DEBUG_COVER_TREE
@@ -758,6 +799,113 @@ const CoverTree::Node* CoverTree::SelectedNearestNeighbour(const Vector& query_p
   }
   return found;
 }
+
+/** Make the compact copy of the tree.
+
+    Nodes are stored in level order, starting from the root, so that
+    the children of each node occupy a contiguous range. Their points
+    are copied, in the same order, to a single array.
+*/
+void CoverTree::Compact() const
+{
+  if (compacted) {
+    return;
+  }
+  compact_nodes.clear();
+  compact_points.clear();
+  n_dimensions = 0;
+  if (root) {
+    n_dimensions = root->point.Size();
+    compact_nodes.reserve(num_nodes);
+    compact_points.reserve(num_nodes * n_dimensions);
+    CompactNode root_node;
+    root_node.father = -1;
+    root_node.node = root;
+    compact_nodes.push_back(root_node);
+    for (uint k=0; k<compact_nodes.size(); ++k) {
+      const Node* node = compact_nodes[k].node;
+      compact_nodes[k].first_child = compact_nodes.size();
+      compact_nodes[k].n_children = node->Size();
+      compact_nodes[k].basis_index = node->basis_flag ? node->basis_index : -1;
+      compact_nodes[k].separation = exp(node->level * log_c);
+      compact_nodes[k].beta = pow(2.0, (real) node->level);
+      for (int j=0; j<n_dimensions; ++j) {
+        compact_points.push_back(node->point(j));
+      }
+      for (int j=0; j<node->Size(); ++j) {
+        CompactNode child;
+        child.father = k;
+        child.node = node->children[j];
+        compact_nodes.push_back(child);
+      }
+    }
+  }
+  compacted = true;
+}
+
+/** Find the nearest node in the compact subtree of node k.
+
+    This follows Node::NearestNeighbour(), so both give the same
+    result.
+*/
+std::pair<int, real> CoverTree::CompactNearestNeighbour(int k, const real* x, real distance) const
+{
+  std::pair<int, real> retval(k, distance);
+  const CompactNode& node = compact_nodes[k];
+  int end = node.first_child + node.n_children;
+  for (int c=node.first_child; c<end; ++c) {
+    real dist_c = CompactDistance(c, x);
+    if (dist_c - node.separation <= retval.second) {
+      std::pair<int, real> sub = CompactNearestNeighbour(c, x, dist_c);
+      if (sub.second < retval.second) {
+        retval = sub;
+      }
+    }
+  }
+  return retval;
+}
+
+/// Run queries 0..n_queries-1 in blocks, on the thread pool if there is one.
+void CoverTree::RunBatch(int n_queries, const std::function<void (int)>& query) const
+{
+  const int block_size = 64;
+  int n_blocks = (n_queries + block_size - 1) / block_size;
+  std::function<void (int)> run_block = [&](int b) {
+    int end = std::min(n_queries, (b + 1) * block_size);
+    for (int i=b * block_size; i<end; ++i) {
+      query(i);
+    }
+  };
+  if (pool) {
+    pool->Run(n_blocks, run_block);
+  } else {
+    for (int b=0; b<n_blocks; ++b) {
+      run_block(b);
+    }
+  }
+}
+
+/** Find the nearest neighbour of every query.
+
+    The search uses the compact copy of the tree, and only reads it,
+    so queries can run on the thread pool.
+*/
+void CoverTree::NearestNeighbours(const std::vector<Vector>& queries, std::vector<const Node*>& neighbours) const
+{
+  int n_queries = queries.size();
+  neighbours.resize(n_queries);
+  Compact();
+  RunBatch(n_queries, [&](int i) {
+      if (compact_nodes.empty()) {
+        neighbours[i] = NULL;
+        return;
+      }
+      assert(queries[i].Size() == n_dimensions);
+      const real* x = queries[i].x;
+      int k = CompactNearestNeighbour(0, x, CompactDistance(0, x)).first;
+      neighbours[i] = compact_nodes[k].node;
+    });
+}
 const Vector CoverTree::GenerateState(const Vector& query_point) const
 {
   const Node* found	= SelectedNearestNeighbour(query_point);
@@ -805,6 +953,7 @@ const void CoverTree::SetNumBasisNodes(int num) {
 }
 
 const void CoverTree::Reset() {
+  Invalidate();
   delete root;
   root					= NULL;
   num_nodes				= 0;
@@ -955,6 +1104,9 @@ CoverTree::CoverTree(real c, real a_, real N0_, RBFBasisSet* RBFs_, bool Samplin
   ThompsonSampling		= Sampling;
   Basis.clear();
   tree_level	= std::numeric_limits<int>::max();
+  n_dimensions	= 0;
+  compacted		= false;
+  pool			= NULL;
 }
 
 /** Destructor */
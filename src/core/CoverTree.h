@@ -18,6 +18,11 @@
 #include "Random.h"
 #include "BasisSet.h"
 #include "BayesianMultivariateRegression.h"
+#include <functional>
+#include <vector>
+#include <utility>
+
+class ThreadPool;
 
 #undef DEBUG_COVER_TREE
 #undef DEBUG_COVER_TREE_NN
@@ -43,6 +48,12 @@
  
  4. If \f$i \in S_n\f$ and \f$j \in C(i)\f$, 
  
+ Besides the linked nodes, the tree can keep a compact copy of
+ itself, made by Compact(): the nodes are stored in level order, so
+ that the children of each node are next to each other, and all
+ points are stored in a single array. Batch queries use the compact
+ copy, and can run on a thread pool. The copy is made again after
+ the tree has changed.
  */
 class CoverTree
 	{
@@ -269,6 +280,18 @@ class CoverTree
 			}
 		};
 		
+		/// A node in the compact, level-ordered layout
+		struct CompactNode
+		{
+			int first_child;	///< Index of the first child
+			int n_children;		///< Number of children, stored after the first
+			int father;			///< Index of the father, or -1 for the root
+			int basis_index;	///< Basis index, or -1 if the node is not a basis
+			real separation;	///< c^level, bounding the distance to descendants
+			real beta;			///< 2^level, the width of the basis function
+			const Node* node;	///< The node itself
+		};
+		
 		const real	metric(const CoverSet& Q, const Vector& p) const;
 		void		UpdateStatistics(const Vector& input, const Vector& output);
 		const void	SamplingNode(Node* n);
@@ -278,6 +301,7 @@ class CoverTree
 		
 		Vector        BasisCreation(const Vector& state) const;
 		const std::vector< std::pair<int,real> > ExternalBasisCreation(const Vector& state) const;
+		void	ExternalBasisCreation(const std::vector<Vector>& states, std::vector< std::vector< std::pair<int,real> > >& phi) const;
 		
 		Node*		Insert(const Vector& new_point, const CoverSet& Q_i, const int level, void* obj);
 		Node*		Insert(const Vector& new_point, const Vector& phi, const Vector& next_state, const real& reward, const bool& absorb, const CoverSet& Q_i, const int level, void* obj);
@@ -286,6 +310,13 @@ class CoverTree
 		
 		const Node*  	NearestNeighbour(const Vector& query_point) const;
 		const Node*  	SelectedNearestNeighbour(const Vector& query_point) const;
+		void			NearestNeighbours(const std::vector<Vector>& queries, std::vector<const Node*>& neighbours) const;
+		void			Compact() const;
+		/// Use a thread pool for batch queries; NULL runs them in turn.
+		void			setThreadPool(ThreadPool* pool_)
+		{
+			pool = pool_;
+		}
 		const Vector	GenerateState(const Vector& query_point) const;
 		const real   	GenerateReward(const Vector& query_point) const;
 		const real    GetValueFunction(const Vector& query_point) const;
@@ -310,6 +341,21 @@ class CoverTree
 		bool	Check(const CoverSet& parents, const int level) const;
 		real	Separation(const CoverSet& Q) const;
 		Node*	FindNearestNeighbour(const Vector& query_point) const;
+		std::pair<int, real> CompactNearestNeighbour(int k, const real* x, real distance) const;
+		real	CompactDistance(int k, const real* x) const
+		{
+			const real* y = &compact_points[k * n_dimensions];
+			real d = 0.0;
+			for (int j=0; j<n_dimensions; ++j) {
+				d += fabs(x[j] - y[j]);
+			}
+			return d;
+		}
+		void	Invalidate()
+		{
+			compacted = false;
+		}
+		void	RunBatch(int n_queries, const std::function<void (int)>& query) const;
 		int  	tree_level;
 		int  	num_nodes;
 		real	log_c;
@@ -326,6 +372,12 @@ class CoverTree
 		bool RewardPred;		//Reward prediction
 		bool ThompsonSampling;  //Thompson sampling
 		Node* root;
+		///Compact layout; rebuilt on demand by the const batch queries.
+		mutable std::vector<CompactNode> compact_nodes;	///< Nodes in level order
+		mutable std::vector<real> compact_points;		///< Node points, in the same order
+		mutable int n_dimensions;						///< Dimension of the points
+		mutable bool compacted;							///< The compact layout is up to date
+		ThreadPool* pool;								///< Threads for batch queries, or NULL
 	};
 
 
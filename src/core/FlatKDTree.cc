@@ -0,0 +1,295 @@
+/* -*- Mode: C++; -*- */
+// copyright (c) 2013 by Christos Dimitrakakis <christos.dimitrakakis@gmail.com>
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "FlatKDTree.h"
+#include "ThreadPool.h"
+#include <algorithm>
+
+/// Offer a point to a bounded max-heap of the K nearest points
+static inline void Consider(std::vector<void_FlatKDTree::Neighbour>& heap, int K, real d, int i)
+{
+    if ((int) heap.size() < K) {
+        heap.push_back(void_FlatKDTree::Neighbour(d, i));
+        std::push_heap(heap.begin(), heap.end());
+    } else if (d < heap.front().first) {
+        std::pop_heap(heap.begin(), heap.end());
+        heap.back() = void_FlatKDTree::Neighbour(d, i);
+        std::push_heap(heap.begin(), heap.end());
+    }
+}
+
+/// Compare points along one dimension
+class CoordinateLess
+{
+    const std::vector<real>& points;
+    int stride;
+    int dimension;
+public:
+    CoordinateLess(const std::vector<real>& points_, int stride_, int dimension_)
+        : points(points_), stride(stride_), dimension(dimension_)
+    {
+    }
+    bool operator() (int i, int j) const
+    {
+        return points[i * stride + dimension] < points[j * stride + dimension];
+    }
+};
+
+void_FlatKDTree::void_FlatKDTree(int n_dimensions_, int bucket_size_)
+    : n_dimensions(n_dimensions_),
+      bucket_size(bucket_size_),
+      n_built(0),
+      pool(NULL)
+{
+    assert(n_dimensions > 0);
+    assert(bucket_size > 0);
+}
+
+void_FlatKDTree::~void_FlatKDTree()
+{
+}
+
+/// Add a point with an associated object, and return its number
+int void_FlatKDTree::AddVector(const Vector& x, const void* object)
+{
+    assert(x.Size() == n_dimensions);
+    int i = Size();
+    for (int j=0; j<n_dimensions; ++j) {
+        points.push_back(x(j));
+    }
+    objects.push_back(object);
+    Insert(i);
+
+    int n_overflow_max = std::max(4 * bucket_size, (int) sqrt((real) Size()));
+    if (Size() >= 2 * std::max(n_built, bucket_size)
+        || (int) overflow.size() > n_overflow_max) {
+        Build();
+    }
+    return i;
+}
+
+/// Put point i into the leaf of its cell, or into the overflow list
+void void_FlatKDTree::Insert(int i)
+{
+    if (nodes.empty()) {
+        overflow.push_back(i);
+        return;
+    }
+    const real* x = &points[i * n_dimensions];
+    int k = 0;
+    while (nodes[k].dimension >= 0) {
+        const Node& node = nodes[k];
+        k = (x[node.dimension] <= node.split) ? node.lower : node.upper;
+    }
+    Node& leaf = nodes[k];
+    if (leaf.end < leaf.capacity) {
+        std::copy(x, x + n_dimensions, &slots[leaf.end * n_dimensions]);
+        slot_index[leaf.end] = i;
+        leaf.end++;
+    } else {
+        overflow.push_back(i);
+    }
+}
+
+/// Rebuild the tree from all points
+void void_FlatKDTree::Build()
+{
+    nodes.clear();
+    slots.clear();
+    slot_index.clear();
+    overflow.clear();
+    n_built = Size();
+    if (!n_built) {
+        return;
+    }
+    std::vector<int> index(n_built);
+    for (int i=0; i<n_built; ++i) {
+        index[i] = i;
+    }
+    nodes.reserve(2 * (n_built / bucket_size + 1));
+    slot_index.reserve(2 * n_built + bucket_size);
+    MakeNode(index, 0, n_built);
+    slots.resize(slot_index.size() * n_dimensions);
+    for (int s=0; s<(int) slot_index.size(); ++s) {
+        if (slot_index[s] >= 0) {
+            const real* x = &points[slot_index[s] * n_dimensions];
+            std::copy(x, x + n_dimensions, &slots[s * n_dimensions]);
+        }
+    }
+}
+
+/** Make the subtree of points index[begin, end), and return its node.
+
+    The points are split at the median along the dimension with the
+    largest spread: the lower child has the points before the median
+    and the upper child the rest, so that all points of the lower
+    child are no larger than the split, and all points of the upper
+    child no smaller.
+*/
+int void_FlatKDTree::MakeNode(std::vector<int>& index, int begin, int end)
+{
+    int id = nodes.size();
+    nodes.push_back(Node());
+
+    int dimension = -1;
+    real spread = 0.0;
+    if (end - begin > bucket_size) {
+        for (int j=0; j<n_dimensions; ++j) {
+            real lo = points[index[begin] * n_dimensions + j];
+            real hi = lo;
+            for (int i=begin + 1; i<end; ++i) {
+                real x = points[index[i] * n_dimensions + j];
+                lo = std::min(lo, x);
+                hi = std::max(hi, x);
+            }
+            if (hi - lo > spread) {
+                spread = hi - lo;
+                dimension = j;
+            }
+        }
+    }
+
+    if (dimension < 0) {
+        // a leaf, with room for new points
+        Node& node = nodes[id];
+        node.dimension = -1;
+        node.split = 0.0;
+        node.lower = -1;
+        node.upper = -1;
+        node.begin = slot_index.size();
+        node.end = node.begin + (end - begin);
+        node.capacity = node.begin + std::max(2 * bucket_size, end - begin);
+        for (int i=begin; i<end; ++i) {
+            slot_index.push_back(index[i]);
+        }
+        slot_index.resize(node.capacity, -1);
+        return id;
+    }
+
+    int mid = begin + (end - begin) / 2;
+    std::nth_element(index.begin() + begin, index.begin() + mid, index.begin() + end,
+                     CoordinateLess(points, n_dimensions, dimension));
+    real split = points[index[mid] * n_dimensions + dimension];
+    int lower = MakeNode(index, begin, mid);
+    int upper = MakeNode(index, mid, end);
+    Node& node = nodes[id];
+    node.dimension = dimension;
+    node.split = split;
+    node.lower = lower;
+    node.upper = upper;
+    node.begin = node.end = node.capacity = 0;
+    return id;
+}
+
+/// Search the subtree of a node, nearest cell first.
+void void_FlatKDTree::Search(int k, const real* x, int K, std::vector<Neighbour>& heap) const
+{
+    const Node& node = nodes[k];
+    if (node.dimension < 0) {
+        for (int s=node.begin; s<node.end; ++s) {
+            Consider(heap, K, Distance(x, &slots[s * n_dimensions]), slot_index[s]);
+        }
+        return;
+    }
+    real delta = x[node.dimension] - node.split;
+    int first, second;
+    if (delta <= 0) {
+        first = node.lower;
+        second = node.upper;
+    } else {
+        first = node.upper;
+        second = node.lower;
+    }
+    Search(first, x, K, heap);
+    // the other cell is at least |delta| away
+    if ((int) heap.size() < K || fabs(delta) < heap.front().first) {
+        Search(second, x, K, heap);
+    }
+}
+
+/// Find the K nearest points to x, in order of distance.
+void void_FlatKDTree::Query(const real* x, int K, std::vector<Neighbour>& neighbours) const
+{
+    neighbours.clear();
+    if (K <= 0) {
+        return;
+    }
+    neighbours.reserve(K + 1);
+    for (uint i=0; i<overflow.size(); ++i) {
+        Consider(neighbours, K, Distance(x, &points[overflow[i] * n_dimensions]), overflow[i]);
+    }
+    if (!nodes.empty()) {
+        Search(0, x, K, neighbours);
+    }
+    std::sort_heap(neighbours.begin(), neighbours.end());
+}
+
+/// Find the nearest point to x, or -1 if the tree is empty.
+int void_FlatKDTree::FindNearestNeighbour(const Vector& x) const
+{
+    std::vector<Neighbour> neighbours;
+    FindKNearestNeighbours(x, 1, neighbours);
+    if (neighbours.empty()) {
+        return -1;
+    }
+    return neighbours[0].second;
+}
+
+/// Find the K nearest points to x, in order of distance.
+void void_FlatKDTree::FindKNearestNeighbours(const Vector& x, int K,
+                                             std::vector<Neighbour>& neighbours) const
+{
+    assert(x.Size() == n_dimensions);
+    Query(x.x, K, neighbours);
+}
+
+/// Find the K nearest points to x by linear search.
+void void_FlatKDTree::FindKNearestNeighboursLinear(const Vector& x, int K,
+                                                   std::vector<Neighbour>& neighbours) const
+{
+    assert(x.Size() == n_dimensions);
+    neighbours.clear();
+    for (int i=0; i<Size(); ++i) {
+        Consider(neighbours, K, Distance(x.x, &points[i * n_dimensions]), i);
+    }
+    std::sort_heap(neighbours.begin(), neighbours.end());
+}
+
+/** Find the K nearest points to every row of X.
+
+    Rows are searched in blocks, on the thread pool if there is one.
+*/
+void void_FlatKDTree::FindKNearestNeighbours(const Matrix& X, int K,
+                                             std::vector<std::vector<Neighbour> >& neighbours) const
+{
+    assert(X.Columns() == n_dimensions);
+    int n_rows = X.Rows();
+    neighbours.resize(n_rows);
+    const int block_size = 64;
+    int n_blocks = (n_rows + block_size - 1) / block_size;
+    std::function<void (int)> search_block = [&](int b) {
+        std::vector<real> x(n_dimensions);
+        int end = std::min(n_rows, (b + 1) * block_size);
+        for (int i=b * block_size; i<end; ++i) {
+            for (int j=0; j<n_dimensions; ++j) {
+                x[j] = X(i, j);
+            }
+            Query(&x[0], K, neighbours[i]);
+        }
+    };
+    if (pool) {
+        pool->Run(n_blocks, search_block);
+    } else {
+        for (int b=0; b<n_blocks; ++b) {
+            search_block(b);
+        }
+    }
+}
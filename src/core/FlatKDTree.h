@@ -0,0 +1,150 @@
+/* -*- Mode: C++; -*- */
+// copyright (c) 2013 by Christos Dimitrakakis <christos.dimitrakakis@gmail.com>
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef FLAT_KD_TREE_H
+#define FLAT_KD_TREE_H
+
+#include "Vector.h"
+#include "Matrix.h"
+#include <cmath>
+#include <vector>
+#include <utility>
+
+class ThreadPool;
+
+/** A KD tree stored in flat arrays.
+
+    Unlike void_KDTree, which stores one point per node, the points
+    are kept in leaf buckets: the tree is built by splitting at the
+    median along the dimension of largest spread, until at most
+    bucket_size points remain. Nodes are kept in a single array, and
+    the points of each leaf are copied next to each other, so that a
+    query scans contiguous memory.
+
+    Distances are L1 distances, as in void_KDTree.
+
+    Points can be added at any time. Each leaf has room for twice the
+    bucket size, and a new point goes into the leaf of its cell if
+    there is room, or into a short list that is searched linearly
+    otherwise. The tree is rebuilt when that list grows too long, or
+    when the number of points has doubled since the last build. Call
+    Build() after adding many points at once.
+
+    Points are numbered in the order in which they were added.
+ */
+class void_FlatKDTree
+{
+public:
+    /// The distance to a point, and its number
+    typedef std::pair<real, int> Neighbour;
+protected:
+    struct Node {
+        int dimension; ///< split dimension, or -1 for a leaf
+        real split; ///< split value
+        int lower; ///< child with x[dimension] <= split
+        int upper; ///< child with x[dimension] >= split
+        int begin; ///< first slot of a leaf
+        int end; ///< one past the last used slot of a leaf
+        int capacity; ///< one past the last slot of a leaf
+    };
+    int n_dimensions; ///< dimensionality of space
+    int bucket_size; ///< maximum number of points in a leaf after a build
+    std::vector<real> points; ///< all points, in the order added
+    std::vector<const void*> objects; ///< associated objects
+    std::vector<Node> nodes; ///< all nodes; the root is the first
+    std::vector<real> slots; ///< leaf points, copied leaf by leaf
+    std::vector<int> slot_index; ///< number of the point in each slot
+    std::vector<int> overflow; ///< points added to full leaves
+    int n_built; ///< number of points at the last build
+    ThreadPool* pool; ///< threads for batch queries, or NULL
+
+    int MakeNode(std::vector<int>& index, int begin, int end);
+    void Insert(int i);
+    real Distance(const real* x, const real* y) const
+    {
+        real d = 0.0;
+        for (int j=0; j<n_dimensions; ++j) {
+            d += fabs(x[j] - y[j]);
+        }
+        return d;
+    }
+    void Search(int node, const real* x, int K, std::vector<Neighbour>& heap) const;
+    void Query(const real* x, int K, std::vector<Neighbour>& neighbours) const;
+public:
+    void_FlatKDTree(int n_dimensions_, int bucket_size_ = 8);
+    virtual ~void_FlatKDTree();
+    int AddVector(const Vector& x, const void* object);
+    void Build();
+    int FindNearestNeighbour(const Vector& x) const;
+    void FindKNearestNeighbours(const Vector& x, int K,
+                                std::vector<Neighbour>& neighbours) const;
+    void FindKNearestNeighboursLinear(const Vector& x, int K,
+                                      std::vector<Neighbour>& neighbours) const;
+    void FindKNearestNeighbours(const Matrix& X, int K,
+                                std::vector<std::vector<Neighbour> >& neighbours) const;
+    /// Use a thread pool for batch queries; NULL runs them in turn.
+    void setThreadPool(ThreadPool* pool_)
+    {
+        pool = pool_;
+    }
+    /// Number of points
+    int Size() const
+    {
+        return (int) objects.size();
+    }
+    /// Number of nodes
+    int getNumberOfNodes() const
+    {
+        return (int) nodes.size();
+    }
+    Vector getPoint(int i) const
+    {
+        Vector x(n_dimensions);
+        for (int j=0; j<n_dimensions; ++j) {
+            x(j) = points[i * n_dimensions + j];
+        }
+        return x;
+    }
+    const void* getVoidObject(int i) const
+    {
+        return objects[i];
+    }
+};
+
+/// This template makes the void* type safe.
+template <typename T>
+class FlatKDTree : public void_FlatKDTree
+{
+public:
+    FlatKDTree(int n, int bucket_size = 8) : void_FlatKDTree(n, bucket_size)
+    {
+    }
+    /// Add a point with an associated object, and return its number
+    int AddVectorObject(const Vector& x, T* object)
+    {
+        return AddVector(x, (const void*) object);
+    }
+    T* getObject(int i) const
+    {
+        return (T*) objects[i];
+    }
+    /// Find the nearest object, or NULL if the tree is empty.
+    T* FindNearestObject(const Vector& x) const
+    {
+        int i = FindNearestNeighbour(x);
+        if (i < 0) {
+            return NULL;
+        }
+        return getObject(i);
+    }
+};
+
+#endif
@@ -403,7 +403,7 @@ Matrix& Matrix::operator-= (const Matrix& rhs)
 }
 
 /// Create a matrix through the multiplication of two other matrices.
-Matrix Matrix::operator* (const Matrix& rhs)
+Matrix Matrix::operator* (const Matrix& rhs) const
 {
     if (Columns() != rhs.Rows()) {
         throw std::domain_error("Matrix multiplication error\n");
@@ -566,20 +566,97 @@ Vector operator* (const Matrix& lhs, const Vector& rhs)
         fprintf (stderr, "Multiplication: (%d x %d) * (%d x 1)\n", lhs.Rows(), lhs.Columns(), rhs.Size());
         throw std::domain_error("matrix-vector multiplication error\n");
     }
+    Vector v(lhs.Rows());
+    Product(lhs, rhs, v);
+    return v;
+}
 
-    int K = lhs.Rows();
-    int N = lhs.Columns();
+/** Set \f$y = \alpha A x + \beta y\f$ through the BLAS (gemv).
 
-    Vector v(K);
+    y is resized if necessary, in which case beta must be zero.
+*/
+void Product (const Matrix& A, const Vector& x, Vector& y, real alpha, real beta)
+{
+    if (x.Size() != A.Columns()) {
+        throw std::domain_error("matrix-vector multiplication error\n");
+    }
+    if (y.Size() != A.Rows()) {
+        assert(beta == 0.0);
+        y.Resize(A.Rows());
+    }
+    if (A.rows == 0 || A.columns == 0) {
+        y *= beta;
+        return;
+    }
+    cblas_dgemv(CblasRowMajor, A.transposed ? CblasTrans : CblasNoTrans,
+                A.rows, A.columns, alpha, A.x, A.columns,
+                x.x, 1, beta, y.x, 1);
+}
 
-    for (int i=0; i<K; ++i) {
-        real vi = 0;
-        for (int j=0; j<N; ++j) {
-            vi += lhs(i,j) * rhs(j);
-        }
-        v(i) = vi;
+/** Set \f$y = \alpha A' x + \beta y\f$, that is \f$y' = \alpha x' A + \beta y'\f$, through the BLAS (gemv).
+
+    y is resized if necessary, in which case beta must be zero.
+*/
+void Product (const Vector& x, const Matrix& A, Vector& y, real alpha, real beta)
+{
+    if (x.Size() != A.Rows()) {
+        throw std::domain_error("vector-matrix multiplication error\n");
     }
-    return v;
+    if (y.Size() != A.Columns()) {
+        assert(beta == 0.0);
+        y.Resize(A.Columns());
+    }
+    if (A.rows == 0 || A.columns == 0) {
+        y *= beta;
+        return;
+    }
+    cblas_dgemv(CblasRowMajor, A.transposed ? CblasNoTrans : CblasTrans,
+                A.rows, A.columns, alpha, A.x, A.columns,
+                x.x, 1, beta, y.x, 1);
+}
+
+/** Add \f$\alpha u v'\f$ in place through the BLAS (ger).
+ */
+Matrix& Matrix::AddOuterProduct (real alpha, const Vector& u, const Vector& v)
+{
+    if (u.Size() != Rows() || v.Size() != Columns()) {
+        throw std::domain_error("outer product dimensions do not agree\n");
+    }
+    return AddOuterProduct(alpha, u, v, 0, 0);
+}
+
+/** Add \f$\alpha u v'\f$ to the block of the matrix starting at (row, column).
+ */
+Matrix& Matrix::AddOuterProduct (real alpha, const Vector& u, const Vector& v, int row, int column)
+{
+    if (row < 0 || column < 0
+        || row + u.Size() > Rows() || column + v.Size() > Columns()) {
+        throw std::domain_error("outer product does not fit in the matrix\n");
+    }
+    if (u.Size() == 0 || v.Size() == 0) {
+        return *this;
+    }
+    // the storage holds the transpose, to which we add alpha v u'
+    if (transposed) {
+        cblas_dger(CblasRowMajor, v.Size(), u.Size(), alpha,
+                   v.x, 1, u.x, 1, &x[column * columns + row], columns);
+    } else {
+        cblas_dger(CblasRowMajor, u.Size(), v.Size(), alpha,
+                   u.x, 1, v.x, 1, &x[row * columns + column], columns);
+    }
+    return *this;
+}
+
+/// Rank-1 update.
+Matrix& Matrix::operator+= (const OuterProductExpression& rhs)
+{
+    return AddOuterProduct(rhs.alpha, rhs.u, rhs.v);
+}
+
+/// Rank-1 update.
+Matrix& Matrix::operator-= (const OuterProductExpression& rhs)
+{
+    return AddOuterProduct(-rhs.alpha, rhs.u, rhs.v);
 }
 
 real Matrix::det() const
@@ -29,6 +29,8 @@
 
 #define ACCURACY_LIMIT 1e-12
 
+class OuterProductExpression;
+
 /** \brief An n-by-m dimensional matrix.
 
     TODO: Use the BLAS interface for some / most routines.
@@ -65,8 +67,12 @@ public:
     Matrix& operator+= (const Matrix& rhs);
     Matrix operator- (const Matrix& rhs);
     Matrix& operator-= (const Matrix& rhs);
+    Matrix& operator+= (const OuterProductExpression& rhs);
+    Matrix& operator-= (const OuterProductExpression& rhs);
+    Matrix& AddOuterProduct (real alpha, const Vector& u, const Vector& v);
+    Matrix& AddOuterProduct (real alpha, const Vector& u, const Vector& v, int row, int column);
     Matrix& operator*= (const real& rhs);
-    Matrix operator* (const Matrix& rhs);
+    Matrix operator* (const Matrix& rhs) const;
     Matrix operator* (const real& rhs);
     Matrix operator+ (const real& rhs);
     Matrix operator- (const real& rhs);
@@ -155,6 +161,8 @@ public:
     friend Matrix operator* (const real& lhs, const Matrix& rhs);
     friend Matrix operator* (const Vector& lhs, const Matrix& rhs);
     friend Vector operator* (const Matrix& lhs, const Vector& rhs);
+    friend void Product (const Matrix& A, const Vector& x, Vector& y, real alpha, real beta);
+    friend void Product (const Vector& x, const Matrix& A, Vector& y, real alpha, real beta);
 protected:
     int rows; ///< number of rows in the matrix
     int columns; ///< number of columns in the matrix
@@ -173,6 +181,8 @@ protected:
 Matrix operator* (const real& lhs, const Matrix& rhs);
 Matrix operator* (const Vector& lhs, const Matrix& rhs);
 Vector operator* (const Matrix& lhs, const Vector& rhs);
+void Product (const Matrix& A, const Vector& x, Vector& y, real alpha = 1.0, real beta = 0.0);
+void Product (const Vector& x, const Matrix& A, Vector& y, real alpha = 1.0, real beta = 0.0);
 real Mahalanobis2 (const Vector& x, const Matrix& A, const Vector& y);
 
 /// Kronecker product
@@ -181,11 +191,59 @@ inline Matrix Kron (const Matrix& lhs, const Matrix& rhs)
 	return lhs.Kron(rhs);
 }
 
-inline Matrix OuterProduct (const Vector& lhs, const Vector& rhs)
+/** A lazily evaluated outer product \f$\alpha u v'\f$.
+
+    The expression turns into a Matrix wherever one is needed. Adding
+    it to or subtracting it from a matrix, however, is a rank-1 update
+    done in place by the BLAS (ger), without forming the product.
+    Scaling it only changes \f$\alpha\f$.
+
+    The vectors are held by reference, so the expression must not
+    outlive the statement that creates it.
+*/
+class OuterProductExpression
+{
+public:
+    const Vector& u; ///< column vector
+    const Vector& v; ///< row vector
+    real alpha; ///< scale
+    OuterProductExpression(const Vector& u_, const Vector& v_, real alpha_ = 1.0)
+        : u(u_), v(v_), alpha(alpha_)
+    {
+    }
+    OuterProductExpression operator* (real c) const
+    {
+        return OuterProductExpression(u, v, alpha * c);
+    }
+    OuterProductExpression operator/ (real c) const
+    {
+        return OuterProductExpression(u, v, alpha / c);
+    }
+    OuterProductExpression operator- () const
+    {
+        return OuterProductExpression(u, v, -alpha);
+    }
+    /// Form the product
+    operator Matrix () const
+    {
+        Matrix R(u.n, v.n);
+        MatrixProduct(u, v, R);
+        if (alpha != 1.0) {
+            R *= alpha;
+        }
+        return R;
+    }
+};
+
+inline OuterProductExpression operator* (real c, const OuterProductExpression& rhs)
+{
+    return rhs * c;
+}
+
+/// The outer product \f$u v'\f$, evaluated lazily.
+inline OuterProductExpression OuterProduct (const Vector& lhs, const Vector& rhs)
 {
-    Matrix R(lhs.n, rhs.n);
-    MatrixProduct(lhs, rhs, R);
-    return R;
+    return OuterProductExpression(lhs, rhs);
 }
 
 Matrix Transpose (const Matrix& rhs);
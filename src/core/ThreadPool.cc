@@ -0,0 +1,117 @@
+// -*- Mode: c++ -*-
+// copyright (c) 2013 by Christos Dimitrakakis <christos.dimitrakakis@gmail.com>
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "ThreadPool.h"
+#include <cassert>
+
+/** Create a pool.
+
+	\param n_threads total number of threads, including the caller;
+	if not positive, the number of hardware threads is used.
+*/
+ThreadPool::ThreadPool(int n_threads)
+	: job(NULL),
+	  n_tasks(0),
+	  next_task(0),
+	  generation(0),
+	  n_busy(0),
+	  shutdown(false)
+{
+	if (n_threads <= 0) {
+		n_threads = HardwareThreads();
+	}
+	for (int i=1; i<n_threads; ++i) {
+		workers.push_back(std::thread(&ThreadPool::Work, this));
+	}
+}
+
+/// Stop and join all workers
+ThreadPool::~ThreadPool()
+{
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		shutdown = true;
+	}
+	job_ready.notify_all();
+	for (unsigned int i=0; i<workers.size(); ++i) {
+		workers[i].join();
+	}
+}
+
+/// Number of threads supported by the hardware, at least 1.
+int ThreadPool::HardwareThreads()
+{
+	int n = (int) std::thread::hardware_concurrency();
+	return (n > 0) ? n : 1;
+}
+
+/// Grab tasks until there are none left
+void ThreadPool::ProcessTasks(const std::function<void (int)>& f, int n)
+{
+	for (int i = next_task++; i < n; i = next_task++) {
+		f(i);
+	}
+}
+
+/// The worker loop
+void ThreadPool::Work()
+{
+	unsigned long seen = 0;
+	while (true) {
+		const std::function<void (int)>* f;
+		int n;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			job_ready.wait(lock, [&] { return shutdown || generation != seen; });
+			if (shutdown) {
+				return;
+			}
+			seen = generation;
+			f = job;
+			n = n_tasks;
+		}
+		ProcessTasks(*f, n);
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			if (--n_busy == 0) {
+				job_done.notify_one();
+			}
+		}
+	}
+}
+
+/// Call f(i) for i = 0, ..., n_tasks_ - 1 and wait for all calls to finish.
+void ThreadPool::Run(int n_tasks_, const std::function<void (int)>& f)
+{
+	if (n_tasks_ <= 0) {
+		return;
+	}
+	if (workers.empty() || n_tasks_ == 1) {
+		for (int i=0; i<n_tasks_; ++i) {
+			f(i);
+		}
+		return;
+	}
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		assert(n_busy == 0);
+		job = &f;
+		n_tasks = n_tasks_;
+		next_task = 0;
+		n_busy = workers.size();
+		++generation;
+	}
+	job_ready.notify_all();
+	ProcessTasks(f, n_tasks_);
+	std::unique_lock<std::mutex> lock(mutex);
+	job_done.wait(lock, [&] { return n_busy == 0; });
+	job = NULL;
+}
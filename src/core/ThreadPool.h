@@ -0,0 +1,60 @@
+// -*- Mode: c++ -*-
+// copyright (c) 2013 by Christos Dimitrakakis <christos.dimitrakakis@gmail.com>
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/** A fixed set of worker threads for data-parallel loops.
+
+	Run(n_tasks, f) calls f(i) for every i in [0, n_tasks) and returns
+	once all calls have finished. Tasks are handed out dynamically,
+	and the calling thread works on them too, so a pool of n threads
+	owns n - 1 workers. A pool with a single thread runs everything
+	inline.
+
+	Run() must not be called concurrently from different threads on
+	the same pool, nor from inside a task.
+*/
+class ThreadPool
+{
+protected:
+	std::vector<std::thread> workers; ///< the worker threads
+	std::mutex mutex; ///< protects the job description
+	std::condition_variable job_ready; ///< signals a new job or shutdown
+	std::condition_variable job_done; ///< signals that all workers are idle
+	const std::function<void (int)>* job; ///< current job
+	int n_tasks; ///< number of tasks in the current job
+	std::atomic<int> next_task; ///< next task to hand out
+	unsigned long generation; ///< job counter, to wake workers once per job
+	int n_busy; ///< workers still on the current job
+	bool shutdown; ///< set when the pool is destroyed
+	void Work();
+	void ProcessTasks(const std::function<void (int)>& f, int n);
+public:
+	ThreadPool(int n_threads = 0);
+	~ThreadPool();
+	/// Number of threads working on a job, including the caller
+	int getNThreads() const
+	{
+		return (int) workers.size() + 1;
+	}
+	void Run(int n_tasks, const std::function<void (int)>& f);
+	static int HardwareThreads();
+};
+
+#endif
@@ -9,6 +9,7 @@
 #include <cstdlib>
 #include <cstring>
 #include <cassert>
+#include <utility>
 
 
 Vector Vector::Unity(int N_, enum BoundsCheckingStatus check)
@@ -50,94 +51,91 @@ void CopyVector (Vector* const lhs, const Vector * const rhs)
 
 
 #if 1
+/** Point x to storage for N_ elements.
+
+    Up to VECTOR_BUFFER_SIZE elements are kept in the object itself.
+*/
+void Vector::Allocate(int N_)
+{
+    n = N_;
+    if (n <= VECTOR_BUFFER_SIZE) {
+        x = buffer;
+        maxN = VECTOR_BUFFER_SIZE;
+    } else {
+        x = (real*) malloc(sizeof(real)*n);
+        maxN = n;
+    }
+}
+
 Vector::Vector()
 {
-    n = 0;
-    maxN = 0;
-    x = NULL;
+    Allocate(0);
     checking_bounds = NO_CHECK_BOUNDS;
 }
 
 /// Always create a zero vector
 Vector::Vector(int N_, enum BoundsCheckingStatus check)
 {
-    n = N_;
-    maxN = n;
-    if (n==0) {
-        x = NULL;
-    } else {
-        x = (real*) calloc(n, sizeof(real));
-    }
+    Allocate(N_);
+    memset(x, 0, sizeof(real)*n);
     checking_bounds = check;
 }
 
 Vector::Vector(uint N_, enum BoundsCheckingStatus check)
 {
-    n = N_;
-    maxN = n;
-    if (n==0) {
-        x = NULL;
-    } else {
-        x = (real*) calloc(n, sizeof(real));
-    }
+    Allocate(N_);
+    memset(x, 0, sizeof(real)*n);
     checking_bounds = check;
 }
 
 Vector::Vector(real z, enum BoundsCheckingStatus check)
 {
-    n = 1;
-    maxN = n;
-    x = (real*) calloc(n, sizeof(real));
+    Allocate(1);
     x[0] = z;
     checking_bounds = check;
 }
 
 
-/** Copy from an array.
-    TODO replace assignment with memcopy
-*/
+/// Copy from an array.
 Vector::Vector (int N_, real* y, enum BoundsCheckingStatus check)
 {
-    n = N_;
-    maxN = n;
-    if (n==0) {
-        x = NULL;
-    } else {
-        x = (real*) malloc(sizeof(real)*n);
-        memcpy(x, y, sizeof(real)*n);
-    }
+    Allocate(N_);
+    memcpy(x, y, sizeof(real)*n);
     checking_bounds = check;
 }
 
-/** Copy constructor
-    TODO replace assignment with memcopy
-*/
+/// Copy constructor
 Vector::Vector (const Vector& rhs)
 {
-    n = rhs.n;
-    maxN = n;
-    if (n==0) {
-        x = NULL;
+    Allocate(rhs.n);
+    memcpy(x, rhs.x, sizeof(real)*n);
+    checking_bounds = rhs.checking_bounds;
+}
+
+/** Move constructor.
+
+    Heap storage is taken over from rhs, which is left empty. Short
+    vectors are simply copied.
+*/
+Vector::Vector (Vector&& rhs) noexcept
+{
+    if (rhs.isAllocated()) {
+        x = rhs.x;
+        n = rhs.n;
+        maxN = rhs.maxN;
+        rhs.Allocate(0);
     } else {
-        x = (real*) malloc(sizeof(real)*n);
-        for (int i=0; i<n; i++) {
-            x[i] = rhs[i];
-        }
+        Allocate(rhs.n);
+        memcpy(x, rhs.x, sizeof(real)*n);
     }
     checking_bounds = rhs.checking_bounds;
 }
 
 Vector::Vector (const std::vector<real>& rhs)
 {
-    n = rhs.size();
-    maxN = n;
-    if (n==0) {
-        x = NULL;
-    } else {
-        x = (real*) malloc(sizeof(real)*n);
-        for (int i=0; i<n; i++) {
-            x[i] = rhs[i];
-        }
+    Allocate(rhs.size());
+    for (int i=0; i<n; i++) {
+        x[i] = rhs[i];
     }
     checking_bounds = NO_CHECK_BOUNDS;
 }
@@ -146,7 +144,7 @@ Vector::Vector (const std::vector<real>& rhs)
 /// Destructor
 Vector::~Vector()
 {
-    if (x) {
+    if (isAllocated()) {
         free(x);
     }
 }
@@ -242,8 +240,30 @@ Vector& Vector::operator= (const Vector& rhs)
 {
     if (this == &rhs) return *this;
     Resize(rhs.n);
-    for (int i=0; i<n; i++) {
-        x[i] = rhs[i];
+    memcpy(x, rhs.x, sizeof(real)*n);
+    return *this;
+}
+
+/** Move assignment.
+
+    Heap storage is swapped with rhs, so that the old storage of this
+    vector is released or reused along with rhs.
+*/
+Vector& Vector::operator= (Vector&& rhs) noexcept
+{
+    if (this == &rhs) return *this;
+    if (rhs.isAllocated() && isAllocated()) {
+        std::swap(x, rhs.x);
+        std::swap(n, rhs.n);
+        std::swap(maxN, rhs.maxN);
+    } else if (rhs.isAllocated()) {
+        x = rhs.x;
+        n = rhs.n;
+        maxN = rhs.maxN;
+        rhs.Allocate(0);
+    } else {
+        Resize(rhs.n);
+        memcpy(x, rhs.x, sizeof(real)*n);
     }
     return *this;
 }
@@ -329,7 +349,7 @@ real Vector::Sum(const int start, const int end) const
 }
 
 /// Addition
-const Vector Vector::operator+ (const Vector& rhs) const
+Vector Vector::operator+ (const Vector& rhs) const
 {
     assert (rhs.n==n);
     Vector lhs (n);
@@ -350,7 +370,7 @@ Vector& Vector::operator+= (const Vector& rhs)
 }
 
 /// Subtraction
-const Vector Vector::operator- (const Vector& rhs) const
+Vector Vector::operator- (const Vector& rhs) const
 {
     assert (rhs.n==n);
     Vector lhs (n);
@@ -372,7 +392,7 @@ Vector& Vector::operator-= (const Vector& rhs)
 
 
 /// Per-element multiplication
-const Vector Vector::operator* (const Vector& rhs) const
+Vector Vector::operator* (const Vector& rhs) const
 {
     assert (rhs.n==n);
     Vector lhs (n);
@@ -393,7 +413,7 @@ Vector& Vector::operator*= (const Vector& rhs)
 }
 
 /// Per-element division
-const Vector Vector::operator/ (const Vector& rhs) const
+Vector Vector::operator/ (const Vector& rhs) const
 {
     assert (rhs.n==n);
     Vector lhs (n);
@@ -416,7 +436,7 @@ Vector& Vector::operator/= (const Vector& rhs)
 
 /* ----------- SCALAR OPERATORS -------------------------*/
 /// Scalar addition
-const Vector Vector::operator+ (const real& rhs) const
+Vector Vector::operator+ (const real& rhs) const
 {
     Vector lhs (n);
     for (int i=0; i<n; i++) {
@@ -425,7 +445,7 @@ const Vector Vector::operator+ (const real& rhs) const
     return lhs;
 }
 /// Scalar subtraction
-const Vector Vector::operator- (const real& rhs) const
+Vector Vector::operator- (const real& rhs) const
 {
     Vector lhs (n);
     for (int i=0; i<n; i++) {
@@ -435,7 +455,7 @@ const Vector Vector::operator- (const real& rhs) const
 }
 
 /// Scalar multiplication by -1
-const Vector Vector:: operator- () const
+Vector Vector:: operator- () const
 {
 	Vector lhs(n);
 	for (int i=0; i<n; i++) {
@@ -445,7 +465,7 @@ const Vector Vector:: operator- () const
 }
 
 /// Scalar multiplication
-const Vector Vector::operator* (const real& rhs) const
+Vector Vector::operator* (const real& rhs) const
 {
     Vector lhs (n);
     for (int i=0; i<n; i++) {
@@ -454,7 +474,7 @@ const Vector Vector::operator* (const real& rhs) const
     return lhs;
 }
 /// Scalar division
-const Vector Vector::operator/ (const real& rhs) const
+Vector Vector::operator/ (const real& rhs) const
 {
     Vector lhs (n);
     real inv = 1.0 / rhs;
@@ -505,6 +525,16 @@ Vector& Vector::operator/= (const real& rhs)
     return *this;
 }
 
+/// Add alpha * rhs in place, as in the BLAS axpy.
+Vector& Vector::AddScaled (real alpha, const Vector& rhs)
+{
+    assert (rhs.n==n);
+    for (int i=0; i<n; i++) {
+        x[i] += alpha * rhs.x[i];
+    }
+    return *this;
+}
+
 /// Exponentiation
 
 
@@ -540,27 +570,27 @@ void Vector::Clear()
 /// Change size
 void Vector::Resize(int N_)
 { 
-    n = N_;
-    if (n > maxN) {
-        if (maxN == 0) {
-            x = (real*) malloc (sizeof(real)*n);
+    if (N_ > maxN) {
+        if (isAllocated()) {
+            x = (real*) realloc(x, sizeof(real)*N_);
         } else {
-            x = (real*) realloc(x, sizeof(real)*n);
+            x = (real*) malloc (sizeof(real)*N_);
+            memcpy(x, buffer, sizeof(real)*n);
         }
-        maxN = n;
+        maxN = N_;
     }
+    n = N_;
 }
 
+/// Append an element, growing the storage geometrically
 void Vector::AddElement(const real& rhs)
 {
-	n = n + 1;
-	if (maxN == 0) {
-		x = (real*) malloc (sizeof(real)*(n));
-	} else {
-		x = (real*) realloc(x, sizeof(real)*(n));
+	int m = n;
+	if (m == maxN) {
+		Resize(2 * m);
 	}
-	maxN = n;
-	x[n-1] = rhs;
+	n = m + 1;
+	x[m] = rhs;
 }
 #endif
 
@@ -589,6 +619,42 @@ void Sub (const Vector* lhs, const Vector* rhs, Vector* res)
 }  
 
 
+/// \brief Add vector lhs to rhs, save result to res, resizing it if necessary.
+/// It is safe to use identical handles for all arguments.
+void Add (const Vector& lhs, const Vector& rhs, Vector& res)
+{
+    int n=lhs.n;
+    assert(n==rhs.n);
+    res.Resize(n);
+    for (int i=0; i<n; i++) {
+        res.x[i] = lhs.x[i] + rhs.x[i];
+    }
+}
+
+/// \brief Sub vector rhs from lhs, save result to res, resizing it if necessary.
+/// It is safe to use identical handles for all arguments.
+void Sub (const Vector& lhs, const Vector& rhs, Vector& res)
+{
+    int n=lhs.n;
+    assert(n==rhs.n);
+    res.Resize(n);
+    for (int i=0; i<n; i++) {
+        res.x[i] = lhs.x[i] - rhs.x[i];
+    }
+}
+
+/// \brief Save lhs + alpha * rhs to res, resizing it if necessary.
+/// It is safe to use identical handles for all arguments.
+void AddScaled (const Vector& lhs, real alpha, const Vector& rhs, Vector& res)
+{
+    int n=lhs.n;
+    assert(n==rhs.n);
+    res.Resize(n);
+    for (int i=0; i<n; i++) {
+        res.x[i] = lhs.x[i] + alpha * rhs.x[i];
+    }
+}
+
 /// \brief Multiply lhs and rhs element by element, save result to res.
 /// It is safe to use identical handles for all arguments.
 void Mul (const Vector* lhs, const Vector* rhs, Vector* res)
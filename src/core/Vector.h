@@ -30,7 +30,16 @@
 #define DEFAULT_CHECK_BOUNDS CHECK_BOUNDS
 #endif
 
-/// An n-dimensional vector.
+/// Vectors with up to this many elements are stored without allocation
+#define VECTOR_BUFFER_SIZE 6
+
+/** An n-dimensional vector.
+
+    Short vectors, such as the states of most continuous environments,
+    are stored in a buffer inside the object, so that creating and
+    copying them never allocates memory. Longer vectors are allocated
+    on the heap, and are moved rather than copied out of temporaries.
+*/
 class Vector : public Object
 {
 public:
@@ -46,10 +55,12 @@ public:
     explicit Vector (real x, enum BoundsCheckingStatus check = DEFAULT_CHECK_BOUNDS);
 
     Vector (const Vector& rhs);
+    Vector (Vector&& rhs) noexcept;
     Vector (const std::vector<real>& rhs);
     ~Vector ();
     Vector& operator= (const real& rhs);
     Vector& operator= (const Vector& rhs);
+    Vector& operator= (Vector&& rhs) noexcept;
     void Clear();
     void Resize(int N_);
 	void AddElement(const real& rhs);
@@ -82,29 +93,37 @@ public:
 	const bool operator> (const real& rhs) const;
     const bool operator> (const Vector& rhs) const;
     const bool operator== (const Vector& rhs) const;
-    const Vector operator+ (const Vector& rhs) const;
-    const Vector operator- (const Vector& rhs) const;
-    const Vector operator* (const Vector& rhs) const;
-    const Vector operator/ (const Vector& rhs) const;
+    Vector operator+ (const Vector& rhs) const;
+    Vector operator- (const Vector& rhs) const;
+    Vector operator* (const Vector& rhs) const;
+    Vector operator/ (const Vector& rhs) const;
     Vector& operator+= (const Vector& rhs);
     Vector& operator-= (const Vector& rhs);
     Vector& operator*= (const Vector& rhs);
     Vector& operator/= (const Vector& rhs);
-    const Vector operator+ (const real& rhs) const;
-    const Vector operator- (const real& rhs) const;
-	const Vector operator- () const;
-    const Vector operator* (const real& rhs) const;
-    const Vector operator/ (const real& rhs) const;
+    Vector operator+ (const real& rhs) const;
+    Vector operator- (const real& rhs) const;
+	Vector operator- () const;
+    Vector operator* (const real& rhs) const;
+    Vector operator/ (const real& rhs) const;
     Vector& operator+= (const real& rhs);
     Vector& operator-= (const real& rhs);
     Vector& operator*= (const real& rhs);
     Vector& operator/= (const real& rhs);
+    Vector& AddScaled (real alpha, const Vector& rhs);
 	
     void print(FILE* f) const;
     void printf(FILE* f) const;
 private:
     int maxN;
     enum BoundsCheckingStatus checking_bounds;
+    real buffer[VECTOR_BUFFER_SIZE]; ///< storage for short vectors
+    void Allocate(int N_);
+    /// Whether the elements are stored in the heap
+    inline bool isAllocated() const
+    {
+        return x != buffer;
+    }
 };
 
 
@@ -158,6 +177,9 @@ real Product (const Vector* const lhs, const Vector* const rhs);
 void MatrixProduct (const Vector* lhs, const Vector* rhs, Matrix* res);
 real Product (const Vector& lhs, const Vector& rhs);
 void MatrixProduct (const Vector& lhs, const Vector& rhs, Matrix& res);
+void Add (const Vector& lhs, const Vector& rhs, Vector& res);
+void Sub (const Vector& lhs, const Vector& rhs, Vector& res);
+void AddScaled (const Vector& lhs, real alpha, const Vector& rhs, Vector& res);
 
 //real EuclideanNorm (const Vector* lhs, const Vector* rhs);
 //real SquareNorm (const Vector* lhs, const Vector* rhs);
@@ -292,7 +314,7 @@ inline real Volume(const Vector& x)
 	return V;
 }
 /// Exponentiation
-inline const Vector exp (const Vector& rhs)
+inline Vector exp (const Vector& rhs)
 {
     int n = rhs.Size();
     Vector lhs (n);
@@ -303,7 +325,7 @@ inline const Vector exp (const Vector& rhs)
 }
 
 /// Power, by element
-inline const Vector pow (const Vector& rhs, const real p)
+inline Vector pow (const Vector& rhs, const real p)
 {
     int n = rhs.Size();
     Vector lhs (n);
@@ -315,7 +337,7 @@ inline const Vector pow (const Vector& rhs, const real p)
 
 
 /// Hypertangentification
-inline const Vector tanh (const Vector& rhs)
+inline Vector tanh (const Vector& rhs)
 {
     int n = rhs.Size();
     Vector lhs (n);
@@ -327,7 +349,7 @@ inline const Vector tanh (const Vector& rhs)
 
 
 /// Logarithmication
-inline const Vector log (const Vector& rhs)
+inline Vector log (const Vector& rhs)
 {
     int n = rhs.Size();
     Vector lhs (n);
@@ -338,7 +360,7 @@ inline const Vector log (const Vector& rhs)
 }
 
 /// Absolute value
-inline const Vector abs (const Vector& rhs)
+inline Vector abs (const Vector& rhs)
 {
     int n = rhs.Size();
     Vector lhs (n);
@@ -349,7 +371,7 @@ inline const Vector abs (const Vector& rhs)
 }
 
 /// logAdd
-inline const Vector logAdd (const Vector& x, const Vector& y)
+inline Vector logAdd (const Vector& x, const Vector& y)
 {
 	int n = x.Size();
 	assert (x.Size() == y.Size());
@@ -0,0 +1,145 @@
+/* -*- Mode: C++; -*- */
+// copyright (c) 2013 by Christos Dimitrakakis <christos.dimitrakakis@gmail.com>
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifdef MAKE_MAIN
+
+#include "Arena.h"
+#include "EasyClock.h"
+#include <cstdio>
+#include <cstdint>
+
+/// A tree node that counts its live instances
+struct CountedNode
+{
+    static int n_live;
+    int depth;
+    CountedNode** children;
+    CountedNode(int depth_, CountedNode** children_)
+        : depth(depth_), children(children_)
+    {
+        n_live++;
+    }
+    ~CountedNode()
+    {
+        n_live--;
+    }
+};
+int CountedNode::n_live = 0;
+
+/// A node that frees its children, as with plain allocation
+struct HeapNode
+{
+    HeapNode* children[4];
+    HeapNode()
+    {
+        for (int i=0; i<4; ++i) {
+            children[i] = NULL;
+        }
+    }
+    ~HeapNode()
+    {
+        for (int i=0; i<4; ++i) {
+            delete children[i];
+        }
+    }
+};
+
+int main()
+{
+    int n_errors = 0;
+
+    // objects are constructed, reused and destroyed
+    {
+        ObjectPool<CountedNode> pool(16);
+        Arena arena(256);
+        std::vector<CountedNode*> x;
+        for (int i=0; i<100; ++i) {
+            CountedNode** children = arena.NewArray<CountedNode*>(4);
+            for (int j=0; j<4; ++j) {
+                if (children[j] != NULL) {
+                    n_errors++;
+                }
+            }
+            if ((uintptr_t) children % sizeof(void*)) {
+                n_errors++;
+            }
+            x.push_back(pool.New(i, children));
+        }
+        if (CountedNode::n_live != 100 || pool.Size() != 100) {
+            n_errors++;
+        }
+        pool.Delete(x[10]);
+        pool.Delete(x[20]);
+        CountedNode* y = pool.New(0, (CountedNode**) NULL);
+        if (y != x[20] || CountedNode::n_live != 99) {
+            n_errors++;
+        }
+        pool.Clear();
+        arena.Clear();
+        if (CountedNode::n_live != 0 || pool.Size() != 0) {
+            n_errors++;
+        }
+        // large arrays do not fit in a block
+        int* z = arena.NewArray<int>(1000);
+        z[999] = 1;
+        pool.New(1, (CountedNode**) NULL);
+    }
+    if (CountedNode::n_live != 0) {
+        printf("%d nodes not destroyed\n", CountedNode::n_live);
+        n_errors++;
+    }
+
+    // building and tearing down trees
+    int n_nodes = 1000000;
+    int n_trees = 5;
+    double start_time = GetCPU();
+    for (int t=0; t<n_trees; ++t) {
+        HeapNode* root = new HeapNode;
+        std::vector<HeapNode*> open(1, root);
+        for (int i=1, k=0; i<n_nodes; ++i) {
+            HeapNode* node = new HeapNode;
+            open[k / 4]->children[k % 4] = node;
+            open.push_back(node);
+            k++;
+        }
+        delete root;
+    }
+    double end_time = GetCPU();
+    printf("new/delete: %f\n", end_time - start_time);
+
+    ObjectPool<CountedNode> pool;
+    Arena arena;
+    start_time = GetCPU();
+    for (int t=0; t<n_trees; ++t) {
+        std::vector<CountedNode*> open;
+        open.push_back(pool.New(0, arena.NewArray<CountedNode*>(4)));
+        for (int i=1, k=0; i<n_nodes; ++i) {
+            CountedNode* parent = open[k / 4];
+            CountedNode* node = pool.New(parent->depth + 1, arena.NewArray<CountedNode*>(4));
+            parent->children[k % 4] = node;
+            open.push_back(node);
+            k++;
+        }
+        pool.Clear();
+        arena.Clear();
+    }
+    end_time = GetCPU();
+    printf("Pool: %f\n", end_time - start_time);
+
+    if (n_errors) {
+        printf("%d errors\n", n_errors);
+        return -1;
+    }
+    printf("OK\n");
+    return 0;
+}
+
+#endif
@@ -0,0 +1,140 @@
+/* -*- Mode: C++; -*- */
+// copyright (c) 2013 by Christos Dimitrakakis <christos.dimitrakakis@gmail.com>
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifdef MAKE_MAIN
+
+#include "BlockVector.h"
+#include "BasisSet.h"
+#include "Grid.h"
+#include "Random.h"
+#include "EasyClock.h"
+#include <cmath>
+
+/// Count the elements of A and B differing by more than epsilon
+int Compare(const Matrix& A, const Matrix& B, real epsilon = 1e-9)
+{
+    int n_errors = 0;
+    for (int i=0; i<A.Rows(); ++i) {
+        for (int j=0; j<A.Columns(); ++j) {
+            if (fabs(A(i, j) - B(i, j)) > epsilon) {
+                n_errors++;
+            }
+        }
+    }
+    return n_errors;
+}
+
+int Compare(const Vector& x, const Vector& y, real epsilon = 1e-9)
+{
+    int n_errors = 0;
+    for (int i=0; i<x.Size(); ++i) {
+        if (fabs(x(i) - y(i)) > epsilon) {
+            n_errors++;
+        }
+    }
+    return n_errors;
+}
+
+int main()
+{
+    int n_errors = 0;
+
+    // state-action features from a grid of RBFs
+    Vector lower(2);
+    Vector upper(2);
+    upper(0) = 1.0;
+    upper(1) = 1.0;
+    EvenGrid grid(lower, upper, 4);
+    RBFBasisSet bfs(grid, 1.0);
+    int n_actions = 5;
+    int n = n_actions * (bfs.size() + 1);
+
+    Vector x(2);
+    x(0) = 0.3;
+    x(1) = 0.6;
+    BlockVector phi;
+    bfs.Evaluate(x, 2, n_actions, phi);
+    Vector dense(n);
+    dense(2 * (bfs.size() + 1)) = 1.0;
+    for (int i=0; i<bfs.size(); ++i) {
+        dense(2 * (bfs.size() + 1) + i + 1) = bfs.F(i);
+    }
+    n_errors += Compare(phi.getDense(), dense);
+    for (int i=0; i<n; ++i) {
+        if (phi(i) != dense(i)) {
+            n_errors++;
+        }
+    }
+
+    // products and updates against their dense versions
+    BlockVector psi;
+    x(0) = 0.9;
+    bfs.Evaluate(x, 4, n_actions, psi);
+    Vector w(n);
+    for (int i=0; i<n; ++i) {
+        w(i) = urandom(-1.0, 1.0);
+    }
+    if (fabs(Product(phi, w) - Product(dense, w)) > 1e-9) {
+        n_errors++;
+    }
+    if (fabs(Product(phi, psi) - Product(dense, psi.getDense())) > 1e-9) {
+        n_errors++;
+    }
+    if (fabs(Product(phi, phi) - Product(dense, dense)) > 1e-9) {
+        n_errors++;
+    }
+
+    Vector b(n);
+    Vector b_dense(n);
+    phi.AddTo(b, 0.5);
+    psi.AddTo(b, -2.0);
+    b_dense = dense * 0.5 - psi.getDense() * 2.0;
+    n_errors += Compare(b, b_dense);
+
+    real gamma = 0.9;
+    Matrix A = Matrix::Unity(n, n);
+    Matrix A_dense = A;
+    AddOuterProduct(A, 1.0, phi, phi);
+    AddOuterProduct(A, -gamma, phi, psi);
+    A_dense += OuterProduct(dense, dense - psi.getDense() * gamma);
+    n_errors += Compare(A, A_dense);
+
+    Matrix At = Matrix::Unity(n, n);
+    At.Transpose();
+    AddOuterProduct(At, 1.0, phi, psi);
+    Matrix At_dense = Matrix::Unity(n, n);
+    At_dense += OuterProduct(dense, psi.getDense());
+    n_errors += Compare(At, At_dense);
+
+    // accumulation cost
+    int iter = 10000;
+    double start_time = GetCPU();
+    for (int k=0; k<iter; ++k) {
+        A += OuterProduct(dense, dense);
+    }
+    double end_time = GetCPU();
+    printf("Dense: %f\n", end_time - start_time);
+    start_time = GetCPU();
+    for (int k=0; k<iter; ++k) {
+        AddOuterProduct(A, 1.0, phi, phi);
+    }
+    end_time = GetCPU();
+    printf("Block: %f\n", end_time - start_time);
+
+    if (n_errors) {
+        printf("%d errors\n", n_errors);
+        return -1;
+    }
+    printf("OK\n");
+    return 0;
+}
+
+#endif
@@ -0,0 +1,106 @@
+/* -*- Mode: C++; -*- */
+// copyright (c) 2013 by Christos Dimitrakakis <christos.dimitrakakis@gmail.com>
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifdef MAKE_MAIN
+
+#include "CoverTree.h"
+#include "ThreadPool.h"
+#include "Random.h"
+#include "EasyClock.h"
+#include <vector>
+
+typedef std::vector< std::pair<int, real> > Path;
+
+Vector RandomPoint(int n_dimensions)
+{
+    Vector x(n_dimensions);
+    for (int j=0; j<n_dimensions; ++j) {
+        x(j) = urandom();
+    }
+    return x;
+}
+
+/// Compare the batch results with single queries
+int CheckBatch(const CoverTree& tree, const std::vector<Vector>& Q)
+{
+    int n_errors = 0;
+    std::vector<const CoverTree::Node*> neighbours;
+    std::vector<Path> paths;
+    tree.NearestNeighbours(Q, neighbours);
+    tree.ExternalBasisCreation(Q, paths);
+    for (uint i=0; i<Q.size(); ++i) {
+        if (neighbours[i] != tree.NearestNeighbour(Q[i])) {
+            n_errors++;
+        }
+        Path path = tree.ExternalBasisCreation(Q[i]);
+        if (path.size() != paths[i].size()) {
+            n_errors++;
+            continue;
+        }
+        for (uint k=0; k<path.size(); ++k) {
+            if (path[k].first != paths[i][k].first
+                || fabs(path[k].second - paths[i][k].second) > 1e-12) {
+                n_errors++;
+            }
+        }
+    }
+    return n_errors;
+}
+
+int main()
+{
+    int n_errors = 0;
+    int n_dimensions = 3;
+    int n_points = 2000;
+    int n_queries = 5000;
+
+    CoverTree tree(2.0);
+    std::vector<Vector> Q(n_queries);
+    for (int i=0; i<n_queries; ++i) {
+        Q[i] = RandomPoint(n_dimensions);
+    }
+
+    // the compact copy must follow insertions and basis sampling
+    ThreadPool pool(4);
+    for (int i=0; i<n_points; ++i) {
+        Vector x = RandomPoint(n_dimensions);
+        tree.Insert(x, x * 0.5, 0.0);
+        if ((i + 1) % 500 == 0) {
+            tree.SamplingTree();
+            tree.setThreadPool((i / 500) % 2 ? &pool : NULL);
+            n_errors += CheckBatch(tree, Q);
+            printf("%d points, %d basis nodes, %d errors\n",
+                   i + 1, tree.GetNumBasisNodes(), n_errors);
+        }
+    }
+
+    tree.setThreadPool(NULL);
+    std::vector<const CoverTree::Node*> neighbours;
+    double start_time = GetCPU();
+    for (int i=0; i<n_queries; ++i) {
+        tree.NearestNeighbour(Q[i]);
+    }
+    double end_time = GetCPU();
+    printf("Single queries: %f s, ", end_time - start_time);
+    start_time = GetCPU();
+    tree.NearestNeighbours(Q, neighbours);
+    end_time = GetCPU();
+    printf("batch queries: %f s\n", end_time - start_time);
+
+    if (n_errors) {
+        printf("%d errors\n", n_errors);
+        return -1;
+    }
+    printf("OK\n");
+    return 0;
+}
+
+#endif
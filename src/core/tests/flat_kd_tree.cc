@@ -0,0 +1,160 @@
+/* -*- Mode: C++; -*- */
+// copyright (c) 2013 by Christos Dimitrakakis <christos.dimitrakakis@gmail.com>
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifdef MAKE_MAIN
+
+#include "FlatKDTree.h"
+#include "KDTree.h"
+#include "ThreadPool.h"
+#include "Random.h"
+#include "EasyClock.h"
+#include <vector>
+
+typedef void_FlatKDTree::Neighbour Neighbour;
+
+Vector RandomPoint(int n_dimensions)
+{
+    Vector x(n_dimensions);
+    for (int j=0; j<n_dimensions; ++j) {
+        x(j) = urandom();
+    }
+    return x;
+}
+
+/// Count the neighbours at different distances
+int Compare(const std::vector<Neighbour>& x, const std::vector<Neighbour>& y)
+{
+    if (x.size() != y.size()) {
+        return 1;
+    }
+    int n_errors = 0;
+    for (uint k=0; k<x.size(); ++k) {
+        if (fabs(x[k].first - y[k].first) > 1e-12) {
+            n_errors++;
+        }
+    }
+    return n_errors;
+}
+
+int main()
+{
+    int n_errors = 0;
+    int n_dimensions = 4;
+    int n_points = 20000;
+    int n_queries = 2000;
+    int K = 10;
+
+    std::vector<Vector> X(n_points);
+    std::vector<int> number(n_points);
+    for (int i=0; i<n_points; ++i) {
+        X[i] = RandomPoint(n_dimensions);
+        number[i] = i;
+    }
+    Matrix Z(n_queries, n_dimensions);
+    for (int i=0; i<n_queries; ++i) {
+        for (int j=0; j<n_dimensions; ++j) {
+            Z(i, j) = urandom();
+        }
+    }
+
+    // bulk construction
+    FlatKDTree<int> tree(n_dimensions);
+    for (int i=0; i<n_points; ++i) {
+        tree.AddVectorObject(X[i], &number[i]);
+    }
+    tree.Build();
+    std::vector<Neighbour> linear, neighbours;
+    for (int i=0; i<n_queries; ++i) {
+        Vector z = Z.getRow(i);
+        tree.FindKNearestNeighboursLinear(z, K, linear);
+        tree.FindKNearestNeighbours(z, K, neighbours);
+        n_errors += Compare(linear, neighbours);
+        if (*tree.FindNearestObject(z) != linear[0].second) {
+            n_errors++;
+        }
+    }
+    printf("Bulk: %d nodes, %d errors\n", tree.getNumberOfNodes(), n_errors);
+
+    // incremental insertion, queried as it grows
+    FlatKDTree<int> incremental(n_dimensions);
+    for (int i=0; i<n_points; ++i) {
+        // clustered points fill some leaves first
+        Vector x = X[i];
+        if (i % 2) {
+            x *= 0.1;
+        }
+        incremental.AddVectorObject(x, &number[i]);
+        if (i % 97 == 0) {
+            Vector z = Z.getRow(i % n_queries);
+            incremental.FindKNearestNeighboursLinear(z, K, linear);
+            incremental.FindKNearestNeighbours(z, K, neighbours);
+            n_errors += Compare(linear, neighbours);
+        }
+    }
+    printf("Incremental: %d nodes, %d errors\n", incremental.getNumberOfNodes(), n_errors);
+
+    // batch queries, in turn and on threads
+    std::vector<std::vector<Neighbour> > batch;
+    ThreadPool pool(4);
+    for (int p=0; p<2; ++p) {
+        tree.setThreadPool(p ? &pool : NULL);
+        tree.FindKNearestNeighbours(Z, K, batch);
+        for (int i=0; i<n_queries; ++i) {
+            tree.FindKNearestNeighbours(Z.getRow(i), K, neighbours);
+            n_errors += Compare(batch[i], neighbours);
+        }
+    }
+    tree.setThreadPool(NULL);
+    printf("Batch: %d errors\n", n_errors);
+
+    // against the pointer-based tree
+    KDTree<int> kd_tree(n_dimensions);
+    double start_time = GetCPU();
+    for (int i=0; i<n_points; ++i) {
+        kd_tree.AddVectorObject(X[i], &number[i]);
+    }
+    double end_time = GetCPU();
+    printf("KDTree: build %f s, ", end_time - start_time);
+    start_time = GetCPU();
+    for (int i=0; i<n_queries; ++i) {
+        OrderedFixedList<KDNode> knn_list = kd_tree.FindKNearestNeighbours(Z.getRow(i), K);
+    }
+    end_time = GetCPU();
+    printf("query %f s\n", end_time - start_time);
+
+    FlatKDTree<int> flat_tree(n_dimensions);
+    start_time = GetCPU();
+    for (int i=0; i<n_points; ++i) {
+        flat_tree.AddVectorObject(X[i], &number[i]);
+    }
+    flat_tree.Build();
+    end_time = GetCPU();
+    printf("FlatKDTree: build %f s, ", end_time - start_time);
+    start_time = GetCPU();
+    for (int i=0; i<n_queries; ++i) {
+        flat_tree.FindKNearestNeighbours(Z.getRow(i), K, neighbours);
+    }
+    end_time = GetCPU();
+    printf("query %f s, ", end_time - start_time);
+    start_time = GetCPU();
+    flat_tree.FindKNearestNeighbours(Z, K, batch);
+    end_time = GetCPU();
+    printf("batch query %f s\n", end_time - start_time);
+
+    if (n_errors) {
+        printf("%d errors\n", n_errors);
+        return -1;
+    }
+    printf("OK\n");
+    return 0;
+}
+
+#endif
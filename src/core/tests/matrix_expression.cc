@@ -0,0 +1,181 @@
+/* -*- Mode: C++; -*- */
+// copyright (c) 2013 by Christos Dimitrakakis <christos.dimitrakakis@gmail.com>
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifdef MAKE_MAIN
+
+#include "Matrix.h"
+#include "Random.h"
+#include "EasyClock.h"
+#include <cmath>
+
+Vector RandomVector(int n)
+{
+    Vector x(n);
+    for (int i=0; i<n; ++i) {
+        x(i) = urandom(-1.0, 1.0);
+    }
+    return x;
+}
+
+Matrix RandomMatrix(int rows, int columns)
+{
+    Matrix A(rows, columns);
+    for (int i=0; i<rows; ++i) {
+        for (int j=0; j<columns; ++j) {
+            A(i, j) = urandom(-1.0, 1.0);
+        }
+    }
+    return A;
+}
+
+/// Count the elements of A and B differing by more than epsilon
+int Compare(const Matrix& A, const Matrix& B, real epsilon = 1e-9)
+{
+    if (A.Rows() != B.Rows() || A.Columns() != B.Columns()) {
+        return 1;
+    }
+    int n_errors = 0;
+    for (int i=0; i<A.Rows(); ++i) {
+        for (int j=0; j<A.Columns(); ++j) {
+            if (fabs(A(i, j) - B(i, j)) > epsilon) {
+                n_errors++;
+            }
+        }
+    }
+    return n_errors;
+}
+
+int Compare(const Vector& x, const Vector& y, real epsilon = 1e-9)
+{
+    if (x.Size() != y.Size()) {
+        return 1;
+    }
+    int n_errors = 0;
+    for (int i=0; i<x.Size(); ++i) {
+        if (fabs(x(i) - y(i)) > epsilon) {
+            n_errors++;
+        }
+    }
+    return n_errors;
+}
+
+int main()
+{
+    int n_errors = 0;
+    int N = 7;
+    int K = 5;
+
+    Vector u = RandomVector(N);
+    Vector v = RandomVector(K);
+    Matrix A = RandomMatrix(N, K);
+
+    // dense outer product
+    Matrix D(N, K);
+    for (int i=0; i<N; ++i) {
+        for (int j=0; j<K; ++j) {
+            D(i, j) = u(i) * v(j);
+        }
+    }
+    Matrix P = OuterProduct(u, v);
+    n_errors += Compare(P, D);
+    n_errors += Compare(OuterProduct(u, v) * 2.0, D * 2.0);
+
+    // rank-1 updates, on normal and transposed storage
+    Matrix B = A;
+    B += OuterProduct(u, v);
+    n_errors += Compare(B, A + D);
+    B = A;
+    B -= 0.5 * OuterProduct(u, v);
+    n_errors += Compare(B, A - D * 0.5);
+    Matrix At(K, N);
+    Matrix Dt(K, N);
+    for (int i=0; i<N; ++i) {
+        for (int j=0; j<K; ++j) {
+            At(j, i) = A(i, j);
+            Dt(j, i) = D(i, j);
+        }
+    }
+    Matrix E = At;
+    E.AddOuterProduct(-1.0 / 3.0, v, u);
+    n_errors += Compare(E, At - Dt / 3.0);
+    Matrix C = A;
+    C.Transpose();
+    C -= OuterProduct(v, u) / 4.0;
+    n_errors += Compare(C, At - Dt / 4.0);
+
+    // matrix-vector products, on normal and transposed storage
+    Vector Av(N);
+    Vector uA(K);
+    Product(A, v, Av);
+    Product(u, A, uA);
+    Vector Av_dense(N);
+    Vector uA_dense(K);
+    for (int i=0; i<N; ++i) {
+        for (int j=0; j<K; ++j) {
+            Av_dense(i) += A(i, j) * v(j);
+            uA_dense(j) += u(i) * A(i, j);
+        }
+    }
+    n_errors += Compare(Av, Av_dense);
+    n_errors += Compare(uA, uA_dense);
+    n_errors += Compare(A * v, Av_dense);
+    C = A;
+    C.Transpose();
+    n_errors += Compare(C * u, uA_dense);
+    Product(C, u, uA, 2.0, -1.0);
+    n_errors += Compare(uA, uA_dense);
+    Product(v, C, Av);
+    n_errors += Compare(Av, Av_dense);
+
+    // Sherman-Morrison update of an inverse
+    int M = 50;
+    Matrix S = Matrix::Unity(M, M) + RandomMatrix(M, M) * 0.1;
+    Matrix S_inv = S.Inverse_LU();
+    Vector x = RandomVector(M);
+    Vector y = RandomVector(M);
+    Vector Sx(M);
+    Vector yS(M);
+    Product(S_inv, x, Sx);
+    Product(y, S_inv, yS);
+    S_inv -= OuterProduct(Sx, yS) / (1 + Product(Sx, y));
+    S += OuterProduct(x, y);
+    n_errors += Compare(S_inv, S.Inverse_LU(), 1e-6);
+
+    // timing of the update against the dense version, on the
+    // always invertible I + k x x'
+    int iter = 1000;
+    Matrix R = Matrix::Unity(M, M);
+    double start_time = GetCPU();
+    for (int k=0; k<iter; ++k) {
+        Matrix res = OuterProduct(x, x);
+        R -= (((R*res)*R) / (1 + Product(R*x, x)));
+    }
+    double end_time = GetCPU();
+    printf("Dense: %f\n", end_time - start_time);
+    R = Matrix::Unity(M, M);
+    start_time = GetCPU();
+    for (int k=0; k<iter; ++k) {
+        Product(R, x, Sx);
+        Product(x, R, yS);
+        R -= OuterProduct(Sx, yS) / (1 + Product(Sx, x));
+    }
+    end_time = GetCPU();
+    printf("Rank-1: %f\n", end_time - start_time);
+
+    if (n_errors) {
+        printf("%d errors\n", n_errors);
+        return -1;
+    }
+    printf("OK\n");
+    return 0;
+}
+
+#endif
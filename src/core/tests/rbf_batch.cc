@@ -0,0 +1,103 @@
+/* -*- Mode: c++ -*- */
+// copyright (c) 2013 by Christos Dimitrakakis <christos.dimitrakakis@gmail.com>
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifdef MAKE_MAIN
+
+#include "BasisSet.h"
+#include "Random.h"
+#include "EasyClock.h"
+#include <cmath>
+#include <vector>
+
+int main(int argc, char** argv)
+{
+    int n_errors = 0;
+    int n_dim = 3;
+    int n_centers = 200;
+    int n_states = 10000;
+
+    // centres with different bandwidths along each dimension
+    RBFBasisSet basis;
+    std::vector<RBF*> rbf;
+    for (int i=0; i<n_centers; ++i) {
+        Vector c(n_dim);
+        Vector beta(n_dim);
+        for (int j=0; j<n_dim; ++j) {
+            c(j) = urandom();
+            beta(j) = urandom(0.1, 1.0);
+        }
+        basis.AddCenter(c, beta);
+        rbf.push_back(new RBF(c, beta));
+    }
+
+    Matrix X(n_states, n_dim);
+    for (int k=0; k<n_states; ++k) {
+        for (int j=0; j<n_dim; ++j) {
+            X(k, j) = urandom(-0.5, 1.5);
+        }
+    }
+
+    // reference: one RBF object at a time
+    Matrix F_ref(n_states, n_centers);
+    double start_time = GetCPU();
+    for (int k=0; k<n_states; ++k) {
+        Vector x = X.getRow(k);
+        for (int i=0; i<n_centers; ++i) {
+            F_ref(k, i) = rbf[i]->Evaluate(x);
+        }
+    }
+    double end_time = GetCPU();
+    printf("Separate RBFs: %f\n", end_time - start_time);
+
+    // one state at a time
+    start_time = GetCPU();
+    for (int k=0; k<n_states; ++k) {
+        Vector x = X.getRow(k);
+        basis.Evaluate(x);
+        for (int i=0; i<n_centers; ++i) {
+            if (fabs(basis.F(i) - F_ref(k, i)) > 1e-12) {
+                n_errors++;
+            }
+        }
+    }
+    end_time = GetCPU();
+    printf("Single: %f\n", end_time - start_time);
+
+    // all states at once
+    Matrix F;
+    start_time = GetCPU();
+    basis.Evaluate(X, F);
+    end_time = GetCPU();
+    printf("Batch: %f\n", end_time - start_time);
+    if (F.Rows() != n_states || F.Columns() != n_centers) {
+        n_errors++;
+    } else {
+        for (int k=0; k<n_states; ++k) {
+            for (int i=0; i<n_centers; ++i) {
+                if (fabs(F(k, i) - F_ref(k, i)) > 1e-12) {
+                    n_errors++;
+                }
+            }
+        }
+    }
+
+    for (int i=0; i<n_centers; ++i) {
+        delete rbf[i];
+    }
+    if (n_errors) {
+        printf("%d errors\n", n_errors);
+        return -1;
+    }
+    printf("OK\n");
+    return 0;
+}
+
+#endif
@@ -0,0 +1,138 @@
+/* -*- Mode: C++; -*- */
+// copyright (c) 2013 by Christos Dimitrakakis <christos.dimitrakakis@gmail.com>
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifdef MAKE_MAIN
+
+#include "Vector.h"
+#include "EasyClock.h"
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/// Check that x(i) == offset + i for all i < n
+int CheckRange(const Vector& x, int n, real offset)
+{
+    if (x.Size() != n) {
+        return 1;
+    }
+    for (int i=0; i<n; ++i) {
+        if (x(i) != offset + i) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+Vector Range(int n, real offset)
+{
+    Vector x(n);
+    for (int i=0; i<n; ++i) {
+        x(i) = offset + i;
+    }
+    return x;
+}
+
+int main(int argc, char** argv)
+{
+    int n_errors = 0;
+    int sizes[] = {0, 2, VECTOR_BUFFER_SIZE, VECTOR_BUFFER_SIZE + 1, 1000};
+    for (int k=0; k<5; ++k) {
+        int n = sizes[k];
+        Vector x = Range(n, 1.0);
+        Vector y(x);
+        n_errors += CheckRange(y, n, 1.0);
+
+        // moving leaves the source empty only if it owned heap storage
+        Vector z(std::move(y));
+        n_errors += CheckRange(z, n, 1.0);
+
+        // move assignment between all combinations of sizes
+        for (int j=0; j<5; ++j) {
+            Vector w = Range(sizes[j], 2.0);
+            w = Range(n, 3.0);
+            n_errors += CheckRange(w, n, 3.0);
+            w = x;
+            n_errors += CheckRange(w, n, 1.0);
+        }
+
+        // growing out of the inline buffer keeps the elements
+        Vector g = Range(n, 1.0);
+        g.Resize(n + 10);
+        for (int i=n; i<n + 10; ++i) {
+            g(i) = 1.0 + i;
+        }
+        n_errors += CheckRange(g, n + 10, 1.0);
+        for (int i=0; i<100; ++i) {
+            g.AddElement(1.0 + g.Size());
+        }
+        n_errors += CheckRange(g, n + 110, 1.0);
+
+        // fused operations
+        Vector u = Range(n, 0.0);
+        u.AddScaled(2.0, Range(n, 1.0));
+        for (int i=0; i<n; ++i) {
+            if (u(i) != 3.0 * i + 2.0) {
+                n_errors++;
+            }
+        }
+        Vector v;
+        AddScaled(Range(n, 2.0), -2.0, Range(n, 1.0), v);
+        u *= 0.0;
+        Add(u, v, u);
+        Sub(Range(n, 0.0), u, u);
+        Vector expected = Range(n, 0.0) - (Range(n, 2.0) - Range(n, 1.0) * 2.0);
+        for (int i=0; i<n; ++i) {
+            if (u(i) != expected(i)) {
+                n_errors++;
+            }
+        }
+    }
+
+    // vectors of vectors are moved, not copied, when they grow
+    static_assert(std::is_nothrow_move_constructible<Vector>::value,
+                  "std::vector<Vector> would copy on reallocation");
+    static_assert(std::is_nothrow_move_assignable<Vector>::value,
+                  "Vector move assignment may throw");
+    std::vector<Vector> list;
+    for (int i=0; i<1000; ++i) {
+        list.push_back(Range(i % 20, i));
+    }
+    for (int i=0; i<1000; ++i) {
+        n_errors += CheckRange(list[i], i % 20, i);
+    }
+
+    int N = 4;
+    int iter = 1000000;
+    Vector x = Range(N, 0.0);
+    Vector y = Range(N, 1.0);
+    Vector z(N);
+    double start_time = GetCPU();
+    for (int k=0; k<iter; ++k) {
+        z = x - y * 0.5;
+    }
+    double end_time = GetCPU();
+    printf("Operators: %f\n", end_time - start_time);
+    start_time = GetCPU();
+    for (int k=0; k<iter; ++k) {
+        AddScaled(x, -0.5, y, z);
+    }
+    end_time = GetCPU();
+    printf("Fused: %f\n", end_time - start_time);
+
+    if (n_errors) {
+        printf("%d errors\n", n_errors);
+        return -1;
+    }
+    printf("OK\n");
+    return 0;
+}
+
+#endif
@@ -89,10 +89,10 @@ void Acrobot::Reset()
 //	theta2		= urandom(state_lower_bound[1],state_upper_bound[1]);
 //	theta1Dot	= urandom(state_lower_bound[2],state_upper_bound[2]);
 //	theta2Dot	= urandom(state_lower_bound[3],state_upper_bound[3]);
-	theta1		= urandom() - 0.5;
-	theta2		= urandom() - 0.5;
-	theta1Dot	= urandom() - 0.5;
-	theta2Dot	= urandom() - 0.5;
+	theta1		= Uniform() - 0.5;
+	theta2		= Uniform() - 0.5;
+	theta1Dot	= Uniform() - 0.5;
+	theta2Dot	= Uniform() - 0.5;
 
 	state[0] = theta1;
 	state[1] = theta2;
@@ -132,7 +132,7 @@ void Acrobot::Simulate(const int action)
 	
 	//torque is in [-1,1]
 	//We'll make noise equal to at most +/- 1
-	real theNoise = parameters.transitionNoise*2.0*(urandom() - 0.5);
+	real theNoise = parameters.transitionNoise*2.0*(Uniform() - 0.5);
 	
 	torque+=theNoise;
 	
@@ -155,21 +155,21 @@ void Acrobot::Simulate(const int action)
 		state[0] += state[2] * parameters.dt;
 		state[1] += state[3] * parameters.dt;
 	}
-	if (abs(state[2]) > parameters.maxTheta1Dot) {
+	if (fabs(state[2]) > parameters.maxTheta1Dot) {
 		state[2] = signum(state[2]) * parameters.maxTheta1Dot;
 	}
 	
-	if (abs(state[3]) > parameters.maxTheta2Dot) {
+	if (fabs(state[3]) > parameters.maxTheta2Dot) {
 		state[3] = signum(state[3]) * parameters.maxTheta2Dot;
 	}
 	/* Put a hard constraint on the Acrobot physics, thetas MUST be in [-PI,+PI]
 	 * if they reach a top then angular velocity becomes zero
 	 */
-	if (abs(state[1]) > M_PI) {
+	if (fabs(state[1]) > M_PI) {
 		state[1] = signum(state[1]) * M_PI;
 		state[3] = 0;
 	}
-	if (abs(state[0]) > M_PI) {
+	if (fabs(state[0]) > M_PI) {
 		state[0] = signum(state[0]) * M_PI;
 		state[2] = 0;
 	}
@@ -202,3 +202,101 @@ real Acrobot::signum(const real& num) {
 
 }
 
+BatchAcrobot::BatchAcrobot(const Acrobot& environment, int n_lanes)
+	: BatchEnvironment(n_lanes, 4, 3),
+	  parameters(environment.parameters),
+	  torque(n_lanes)
+{
+	Reset();
+}
+
+void BatchAcrobot::Reset(int lane)
+{
+	for (int i=0; i<4; ++i) {
+		state[i](lane) = Uniform(lane) - 0.5;
+	}
+	reward(lane) = -1;
+	running[lane] = 1;
+}
+
+/// Clamp x to [-bound, bound]
+static inline real Clamp(real x, real bound)
+{
+	return (x > bound) ? bound : ((x < -bound) ? -bound : x);
+}
+
+int BatchAcrobot::Act(const int* action)
+{
+	for (int k=0; k<n_lanes; ++k) {
+		assert(action[k] >= 0 && action[k] < n_actions);
+		if (running[k]) {
+			torque(k) = (real) (action[k] - 1)
+				+ parameters.transitionNoise*2.0*(Uniform(k) - 0.5);
+		} else {
+			torque(k) = 0.0;
+		}
+	}
+
+	const Acrobot::Parameters& p = parameters;
+	// constant parts of the dynamics
+	const real d1_const = p.m1 * (p.lc1 * p.lc1);
+	const real d1_arm = p.l1 * p.l1 + p.lc2 * p.lc2;
+	const real d1_cos = 2.0 * p.l1 * p.lc2;
+	const real m2_l1_lc2 = p.m2 * p.l1 * p.lc2;
+	const real theta2_den = p.m2 * (p.lc2 * p.lc2) + p.I2;
+	const real g1 = (p.m1 * p.lc1 + p.m2 * p.l1) * p.g;
+	const real g2 = p.m2 * p.lc2 * p.g;
+
+	real* theta1 = state[0].x;
+	real* theta2 = state[1].x;
+	real* dtheta1 = state[2].x;
+	real* dtheta2 = state[3].x;
+	real* r = reward.x;
+	const real* u = torque.x;
+	int n_running = 0;
+	for (int k=0; k<n_lanes; ++k) {
+		real s0 = theta1[k];
+		real s1 = theta2[k];
+		real s2 = dtheta1[k];
+		real s3 = dtheta2[k];
+		for (int count=0; count<4; ++count) {
+			real cos1 = cos(s1);
+			real sin1 = sin(s1);
+			real d1 = d1_const + p.m2 * (d1_arm + d1_cos * cos1) + p.I1 + p.I2;
+			real d2 = p.m2 * (p.lc2 * p.lc2 + p.l1 * p.lc2 * cos1) + p.I2;
+			real phi_2 = g2 * cos(s0 + s1 - M_PI / 2.0);
+			real phi_1 = -(m2_l1_lc2 * (s3 * s3) * sin1 - 2.0 * m2_l1_lc2 * s2 * s3 * sin1)
+				+ g1 * cos(s0 - M_PI / 2.0) + phi_2;
+			real theta2_ddot = (u[k] + (d2 / d1) * phi_1 - m2_l1_lc2 * (s2 * s2) * sin1 - phi_2)
+				/ (theta2_den - d2 * d2 / d1);
+			real theta1_ddot = -(d2 * theta2_ddot + phi_1) / d1;
+			s2 += theta1_ddot * p.dt;
+			s3 += theta2_ddot * p.dt;
+			s0 += s2 * p.dt;
+			s1 += s3 * p.dt;
+		}
+		s2 = Clamp(s2, p.maxTheta1Dot);
+		s3 = Clamp(s3, p.maxTheta2Dot);
+		// the angles stop at +/- pi
+		if (fabs(s1) > M_PI) {
+			s1 = (s1 > 0) ? M_PI : -M_PI;
+			s3 = 0;
+		}
+		if (fabs(s0) > M_PI) {
+			s0 = (s0 > 0) ? M_PI : -M_PI;
+			s2 = 0;
+		}
+		real feet_height = -(p.l1 * cos(s0) + p.l2 * sin(M_PI / 2 - s0 - s1));
+
+		bool run = running[k];
+		bool end = (feet_height > p.acrobotGoalPosition);
+		theta1[k] = run ? s0 : theta1[k];
+		theta2[k] = run ? s1 : theta2[k];
+		dtheta1[k] = run ? s2 : dtheta1[k];
+		dtheta2[k] = run ? s3 : dtheta2[k];
+		r[k] = run ? (end ? 0.0 : -1.0) : 0.0;
+		running[k] = run && !end;
+		n_running += running[k];
+	}
+	return n_running;
+}
@@ -13,6 +13,7 @@
 #define ACROBOT_H
 
 #include "Environment.h"
+#include "BatchEnvironment.h"
 #include "Vector.h"
 #include "real.h"
 #include "AbstractPolicy.h"
@@ -50,9 +51,14 @@ protected:
     Vector action_upper_bound;
     Vector action_lower_bound;
 	real signum(const real& num);
+	friend class BatchAcrobot;
 public:
 	Acrobot(bool random_parameters = false);
 	virtual ~Acrobot();
+	virtual Acrobot* Clone() const
+	{
+		return new Acrobot(*this);
+	}
     virtual void Reset();
     virtual bool Act(const int& action);
     virtual void Simulate(const int action);	
@@ -110,6 +116,26 @@ public:
 	
 };
 
+/// A batch of acrobots with the parameters of a given acrobot
+class BatchAcrobot : public BatchEnvironment
+{
+protected:
+	Acrobot::Parameters parameters;
+	Vector torque; ///< noisy torque of each lane
+public:
+	BatchAcrobot(const Acrobot& environment, int n_lanes);
+	virtual ~BatchAcrobot()
+	{
+	}
+	using BatchEnvironment::Reset;
+	virtual void Reset(int lane);
+	virtual int Act(const int* action);
+	virtual const char* Name() const
+	{
+		return "Acrobot";
+	}
+};
+
 class AcrobotGenerator
 	{
 	public:
@@ -0,0 +1,87 @@
+// -*- Mode: c++ -*-
+// copyright (c) 2013 by Christos Dimitrakakis <christos.dimitrakakis@gmail.com>
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "BatchEnvironment.h"
+
+BatchEnvironment::BatchEnvironment(int n_lanes_, int n_states_, int n_actions_)
+	: n_lanes(n_lanes_),
+	  n_states(n_states_),
+	  n_actions(n_actions_),
+	  state(n_states_, Vector(n_lanes_)),
+	  reward(n_lanes_),
+	  running(n_lanes_, 0),
+	  streams(n_lanes_)
+{
+	setRandomStream(0);
+}
+
+/// Give lane k stream k of the seed, with one jump per lane
+void BatchEnvironment::setRandomStream(unsigned long seed)
+{
+	if (n_lanes == 0) {
+		return;
+	}
+	streams[0].setStream(seed, 0);
+	for (int k=1; k<n_lanes; ++k) {
+		streams[k] = streams[k - 1];
+		streams[k].Jump();
+	}
+}
+
+/// Reset all lanes
+void BatchEnvironment::Reset()
+{
+	for (int k=0; k<n_lanes; ++k) {
+		Reset(k);
+	}
+}
+
+/// Reset the lanes that have terminated, and return how many there were
+int BatchEnvironment::ResetTerminated()
+{
+	int n_reset = 0;
+	for (int k=0; k<n_lanes; ++k) {
+		if (!running[k]) {
+			Reset(k);
+			n_reset++;
+		}
+	}
+	return n_reset;
+}
+
+int BatchEnvironment::getNRunning() const
+{
+	int n_running = 0;
+	for (int k=0; k<n_lanes; ++k) {
+		n_running += running[k];
+	}
+	return n_running;
+}
+
+/// The state of one lane
+Vector BatchEnvironment::getState(int lane) const
+{
+	Vector x(n_states);
+	for (int i=0; i<n_states; ++i) {
+		x(i) = state[i](lane);
+	}
+	return x;
+}
+
+/// Set the state of one lane; the lane is then running.
+void BatchEnvironment::setState(int lane, const Vector& x)
+{
+	assert(x.Size() == n_states);
+	for (int i=0; i<n_states; ++i) {
+		state[i](lane) = x(i);
+	}
+	running[lane] = 1;
+}
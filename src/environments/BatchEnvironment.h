@@ -0,0 +1,115 @@
+// -*- Mode: c++ -*-
+// copyright (c) 2013 by Christos Dimitrakakis <christos.dimitrakakis@gmail.com>
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef BATCH_ENVIRONMENT_H
+#define BATCH_ENVIRONMENT_H
+
+#include "Vector.h"
+#include "XoshiroRNG.h"
+#include <vector>
+
+/**
+   \ingroup EnvironmentGroup
+ */
+/*@{*/
+
+/** A batch of independent copies of a continuous environment,
+	stepped together.
+
+	The copies are called lanes. The state is stored by variable:
+	state[i] holds variable i of every lane, so that the dynamics are
+	loops over contiguous arrays, with no virtual call or heap
+	allocation per copy.
+
+	Lanes that have reached an absorbing state are masked: Act()
+	leaves their state unchanged and gives them zero reward, like the
+	scalar environments, until they are reset.
+
+	Lane k draws its noise from stream k of the batch seed, so that it
+	follows the same trajectory as the scalar environment with
+	setRandomStream(seed, k).
+ */
+class BatchEnvironment
+{
+protected:
+	int n_lanes; ///< number of copies
+	int n_states; ///< state dimension
+	int n_actions; ///< number of actions
+	std::vector<Vector> state; ///< state[i](k) is variable i of lane k
+	Vector reward; ///< reward of each lane
+	std::vector<char> running; ///< whether each lane is still running
+	std::vector<XoshiroRNG> streams; ///< random stream of each lane
+	/// Uniform random number in [lower, upper) for a lane
+	real Uniform(int lane, real lower, real upper)
+	{
+		return streams[lane].uniform(lower, upper);
+	}
+	/// Uniform random number in [0,1) for a lane
+	real Uniform(int lane)
+	{
+		return streams[lane].uniform();
+	}
+public:
+	BatchEnvironment(int n_lanes_, int n_states_, int n_actions_);
+	virtual ~BatchEnvironment()
+	{
+	}
+	/// Reset one lane to a starting state
+	virtual void Reset(int lane) = 0;
+	/** Take one step in every running lane.
+
+		action[k] is the action of lane k; it is ignored for lanes that
+		have terminated. Returns the number of lanes still running.
+	*/
+	virtual int Act(const int* action) = 0;
+	virtual const char* Name() const = 0;
+
+	void Reset();
+	int ResetTerminated();
+	void setRandomStream(unsigned long seed);
+	int getNRunning() const;
+	Vector getState(int lane) const;
+	void setState(int lane, const Vector& x);
+
+	int getNLanes() const
+	{
+		return n_lanes;
+	}
+	int getNStates() const
+	{
+		return n_states;
+	}
+	int getNActions() const
+	{
+		return n_actions;
+	}
+	/// Variable i of all lanes
+	const Vector& getVariable(int i) const
+	{
+		return state[i];
+	}
+	const Vector& getReward() const
+	{
+		return reward;
+	}
+	real getReward(int lane) const
+	{
+		return reward(lane);
+	}
+	bool isRunning(int lane) const
+	{
+		return running[lane] != 0;
+	}
+};
+
+/*@}*/
+
+#endif
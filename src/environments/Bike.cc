@@ -152,8 +152,8 @@ bool Bike::Act(const int& action)
 
 void Bike::Simulate(const int action)
 {
-	static real rCM, rf, rb;
-	static real T, d, phi;
+	real rCM, rf, rb;
+	real T, d, phi;
 	real temp;
 
 	if(action == 0) {
@@ -178,7 +178,7 @@ void Bike::Simulate(const int action)
 	}
 	//T = 2.0*(((real)action / 3.0)-1.0);
 //	d = 0.02*((real)(action % 3)-1.0);
-	d = d + 0.04*(0.5-urandom()); /* Max noise is 2 cm */
+	d = d + 0.04*(0.5-Uniform()); /* Max noise is 2 cm */
 //	state.print(stdout);
 	if (state[0] == 0.0) {
 		rCM = rf = rb = 9999999.0; /* just a large number */
@@ -65,9 +65,33 @@ protected:
     Vector action_lower_bound;
     void Simulate();
 	real sign(const real& num);
+	/// Tyre positions and headings
+	virtual void getHiddenState(Vector& hidden) const
+	{
+		hidden.Resize(6);
+		hidden(0) = xf;
+		hidden(1) = yf;
+		hidden(2) = xb;
+		hidden(3) = yb;
+		hidden(4) = psi;
+		hidden(5) = psi_goal;
+	}
+	virtual void setHiddenState(const Vector& hidden)
+	{
+		xf = hidden(0);
+		yf = hidden(1);
+		xb = hidden(2);
+		yb = hidden(3);
+		psi = hidden(4);
+		psi_goal = hidden(5);
+	}
 public:
 	Bike(bool random_parameters = false);
 	virtual ~Bike();
+	virtual Bike* Clone() const
+	{
+		return new Bike(*this);
+	}
     virtual void Reset();
     virtual bool Act(const int& action);
     virtual void Simulate(const int action);	
@@ -84,16 +84,16 @@ void CartPole::Reset()
     reward = 1.0;
 #if 1
     /// Cart position
-    state[0] =  urandom(-0.1, 0.1);
+    state[0] =  Uniform(-0.1, 0.1);
 	/// Cart velocity
     state[1] = 0.0;
 	// Theta
-    state[2] = urandom(-0.01, 0.01);
+    state[2] = Uniform(-0.01, 0.01);
 	// dTheta/dt
     state[3] = 0; //urandom(-0.001, 0.001);
 #else
 	for (int i=0; i<4; ++i) {
-		state[i] = urandom(state_lower_bound[i], state_upper_bound[i]);
+		state[i] = Uniform(state_lower_bound[i], state_upper_bound[i]);
 	}
 #endif
     endsim = false;
@@ -132,7 +132,7 @@ void CartPole::Simulate(const int action)
     }
 	
 	//Noise of 1.0 means possibly full opposite action
-	real thisNoise=2.0*parameters.noise*parameters.FORCE_MAG*(urandom()-0.5);
+	real thisNoise=2.0*parameters.noise*parameters.FORCE_MAG*(Uniform()-0.5);
 //	real thisNoise = 0.0;
 	force+=thisNoise;
 	
@@ -168,3 +168,77 @@ void CartPole::Simulate(const int action)
 	
 }
 
+BatchCartPole::BatchCartPole(const CartPole& environment, int n_lanes)
+	: BatchEnvironment(n_lanes, 4, 3),
+	  parameters(environment.parameters),
+	  TOTAL_MASS(environment.TOTAL_MASS),
+	  POLEMASS_LENGTH(environment.POLEMASS_LENGTH),
+	  lower(environment.state_lower_bound),
+	  upper(environment.state_upper_bound),
+	  force(n_lanes)
+{
+	Reset();
+}
+
+void BatchCartPole::Reset(int lane)
+{
+	state[0](lane) = Uniform(lane, -0.1, 0.1);
+	state[1](lane) = 0.0;
+	state[2](lane) = Uniform(lane, -0.01, 0.01);
+	state[3](lane) = 0.0;
+	reward(lane) = 1.0;
+	running[lane] = 1;
+}
+
+int BatchCartPole::Act(const int* action)
+{
+	for (int k=0; k<n_lanes; ++k) {
+		assert(action[k] >= 0 && action[k] < n_actions);
+		if (running[k]) {
+			force(k) = parameters.FORCE_MAG * (real) (action[k] - 1)
+				+ 2.0*parameters.noise*parameters.FORCE_MAG*(Uniform(k)-0.5);
+		} else {
+			force(k) = 0.0;
+		}
+	}
+
+	real* x = state[0].x;
+	real* dx = state[1].x;
+	real* theta = state[2].x;
+	real* dtheta = state[3].x;
+	real* r = reward.x;
+	const real* f = force.x;
+	const real TAU = parameters.TAU;
+	int n_running = 0;
+	for (int k=0; k<n_lanes; ++k) {
+		real costheta = cos(theta[k]);
+		real sintheta = sin(theta[k]);
+		real temp = (f[k] + POLEMASS_LENGTH * dtheta[k] * dtheta[k] * sintheta) / TOTAL_MASS;
+		real thetaacc = (parameters.GRAVITY * sintheta - costheta * temp)
+			/ (parameters.LENGTH * (CartPole::FOURTHIRDS - parameters.MASSPOLE * costheta * costheta / TOTAL_MASS));
+		real xacc = temp - POLEMASS_LENGTH * thetaacc * costheta / TOTAL_MASS;
+
+		real next_x = x[k] + TAU * dx[k];
+		real next_dx = dx[k] + TAU * xacc;
+		real next_theta = theta[k] + TAU * dtheta[k];
+		real next_dtheta = dtheta[k] + TAU * thetaacc;
+		while (next_theta >= M_PI) {
+			next_theta -= 2.0 * M_PI;
+		}
+		while (next_theta < -M_PI) {
+			next_theta += 2.0 * M_PI;
+		}
+
+		bool run = running[k];
+		bool end = (next_x < lower(0) || next_x > upper(0)
+					|| next_theta < lower(2) || next_theta > upper(2));
+		x[k] = run ? next_x : x[k];
+		dx[k] = run ? next_dx : dx[k];
+		theta[k] = run ? next_theta : theta[k];
+		dtheta[k] = run ? next_dtheta : dtheta[k];
+		r[k] = run ? (end ? -1.0 : 1.0) : 0.0;
+		running[k] = run && !end;
+		n_running += running[k];
+	}
+	return n_running;
+}
@@ -13,6 +13,7 @@
 #define CART_POLE_H
 
 #include "Environment.h"
+#include "BatchEnvironment.h"
 #include "Vector.h"
 #include "real.h"
 #include "AbstractPolicy.h"
@@ -41,9 +42,14 @@ protected:
     void Simulate();
     void penddot(Vector& xdot, real u, Vector& x);
     void pendulum_simulate(int action);
+    friend class BatchCartPole;
 public:
     CartPole(bool random_parameters = false);
     virtual ~CartPole();
+    virtual CartPole* Clone() const
+    {
+        return new CartPole(*this);
+    }
     virtual void Reset();
     virtual bool Act(const int& action);
     virtual void Simulate(const int action);
@@ -103,6 +109,28 @@ public:
 };
 
 
+/// A batch of cart-poles with the parameters of a given cart-pole
+class BatchCartPole : public BatchEnvironment
+{
+protected:
+    CartPole::Parameters parameters;
+    real TOTAL_MASS, POLEMASS_LENGTH;
+    Vector lower; ///< lower bound on the state, for termination
+    Vector upper; ///< upper bound on the state, for termination
+    Vector force; ///< noisy force of each lane
+public:
+    BatchCartPole(const CartPole& environment, int n_lanes);
+    virtual ~BatchCartPole()
+    {
+    }
+    using BatchEnvironment::Reset;
+    virtual void Reset(int lane);
+    virtual int Act(const int* action);
+    virtual const char* Name() const
+    {
+        return "Cart Pole RL";
+    }
+};
 
 class CartPoleGenerator
 {
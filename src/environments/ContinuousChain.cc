@@ -55,7 +55,7 @@ void ContinuousChain::Simulate(int action)
     }
 
     
-    state[0] += urandom()*.5*input;
+    state[0] += Uniform()*.5*input;
 
     reward = -0.1;
     if (state[0] >= 1.0) {
@@ -32,6 +32,10 @@ protected:
 public:
     ContinuousChain();
     virtual ~ContinuousChain();
+    virtual ContinuousChain* Clone() const
+    {
+        return new ContinuousChain(*this);
+    }
     virtual void Reset();
     virtual bool Act(int action);
     virtual void Simulate(int action);
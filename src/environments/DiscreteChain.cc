@@ -16,6 +16,15 @@ DiscreteChain::~DiscreteChain()
     delete mdp;
 }
 
+/// A copy with its own internal model, in the same state
+DiscreteChain* DiscreteChain::Clone() const
+{
+    DiscreteChain* clone = new DiscreteChain(*this);
+    clone->mdp = getMDP();
+    clone->mdp->Reset(state);
+    return clone;
+}
+
 void DiscreteChain::Reset()
 {
     state = 0;
@@ -27,7 +36,7 @@ bool DiscreteChain::Act(const int& action)
 {
     int action_taken = action;
 	int forward = action;
-	if (urandom() < slip) {
+	if (Uniform() < slip) {
 		forward = 1 - forward;
 	}
 	action_taken = forward;
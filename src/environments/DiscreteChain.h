@@ -47,6 +47,7 @@ public:
     DiscreteChain(int n, real slip_ = 0.2, real start_ = 0.2, real end_ = 1.0);
     
     virtual ~DiscreteChain();
+    virtual DiscreteChain* Clone() const;
     
     virtual void Reset();
     virtual bool Act(const int& action);
@@ -70,7 +71,12 @@ public:
         return mdp->getExpectedReward(state, action);
     }
 
-
+protected:
+    /// Keep the internal model in the restored state
+    virtual void setHiddenState(const Vector& hidden)
+    {
+        mdp->Reset(state);
+    }
 };
 
 class DiscreteChainGenerator : public EnvironmentGenerator<int, int>
@@ -15,6 +15,15 @@ DoubleLoop::~DoubleLoop()
 	delete model;
 }
 
+/// A copy with its own internal model, in the same state
+DoubleLoop* DoubleLoop::Clone() const
+{
+	DoubleLoop* clone = new DoubleLoop(*this);
+	clone->model = getMDP();
+	clone->model->setState(state);
+	return clone;
+}
+
 /// Start in state 1 or 2 (2 or 3 here) with equal probability
 void DoubleLoop::Reset()
 {
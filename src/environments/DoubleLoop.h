@@ -30,6 +30,7 @@ public:
     DoubleLoop(real r_left_ = 2.0, real r_right_ = 1.0);
     
     virtual ~DoubleLoop();
+    virtual DoubleLoop* Clone() const;
     
     virtual void Reset();
     virtual bool Act(const int&action);
@@ -50,6 +51,12 @@ public:
     }
 
     virtual DiscreteMDP* getMDP() const;
+protected:
+    /// Keep the internal model in the restored state
+    virtual void setHiddenState(const Vector& hidden)
+    {
+        model->setState(state);
+    }
 };
 
 #endif
@@ -15,6 +15,8 @@
 
 #include "MDP.h"
 #include "Vector.h"
+#include "Random.h"
+#include "XoshiroRNG.h"
 #include <cstdlib>
 /**
    \defgroup EnvironmentGroup Environments
@@ -23,6 +25,24 @@
    \ingroup EnvironmentGroup
  */
 /*@{*/
+
+/** The dynamic state of an environment, as a value.
+
+	Besides the observable state, this holds the position of the
+	environment's random stream, if it has one, and any hidden
+	variables of the dynamics.
+ */
+template <typename S>
+struct EnvironmentSnapshot
+{
+    S state; ///< the current state
+    real reward; ///< the current reward
+    bool endsim; ///< absorbing state
+    bool has_stream; ///< whether the environment had its own stream
+    XoshiroRNG stream; ///< the random stream
+    Vector hidden; ///< other variables, as defined by the environment
+};
+
 /// Template for environments
 template <typename S, typename A>
 class Environment
@@ -35,8 +55,29 @@ protected:
     uint n_actions; ///< The action dimension
     S state_lower_bound; ///< lower bound on the states
     S state_upper_bound; ///< upper bound on the states
+    XoshiroRNG* stream; ///< own random stream, or NULL to use the global generator
+
+    /// Uniform random number in [0,1) from the environment's stream
+    real Uniform()
+    {
+        return stream ? stream->uniform() : urandom();
+    }
+    /// Uniform random number in [lower, upper) from the environment's stream
+    real Uniform(real lower, real upper)
+    {
+        return stream ? stream->uniform(lower, upper) : urandom(lower, upper);
+    }
+    /// Save dynamic variables that are not part of the state
+    virtual void getHiddenState(Vector& hidden) const
+    {
+    }
+    /// Restore the variables saved by getHiddenState(); the state has
+    /// already been restored.
+    virtual void setHiddenState(const Vector& hidden)
+    {
+    }
 public:
-    Environment() : n_states(1), n_actions(1)
+    Environment() : n_states(1), n_actions(1), stream(NULL)
     {
         state_lower_bound = 0;
         state_upper_bound = 0;
@@ -45,7 +86,7 @@ public:
     }
 
     Environment(int n_states_, int n_actions_)
-  : n_states(n_states_), n_actions(n_actions_)
+  : n_states(n_states_), n_actions(n_actions_), stream(NULL)
     {
         state_lower_bound = 0;
         state_upper_bound = n_states;
@@ -53,8 +94,105 @@ public:
 		endsim = false;
     }
 
+    /// Copies get a copy of the random stream, at the same position
+    Environment(const Environment<S, A>& rhs)
+        : state(rhs.state),
+          reward(rhs.reward),
+          endsim(rhs.endsim),
+          n_states(rhs.n_states),
+          n_actions(rhs.n_actions),
+          state_lower_bound(rhs.state_lower_bound),
+          state_upper_bound(rhs.state_upper_bound),
+          stream(rhs.stream ? new XoshiroRNG(*rhs.stream) : NULL)
+    {
+    }
+
+    Environment<S, A>& operator= (const Environment<S, A>& rhs)
+    {
+        if (this != &rhs) {
+            state = rhs.state;
+            reward = rhs.reward;
+            endsim = rhs.endsim;
+            n_states = rhs.n_states;
+            n_actions = rhs.n_actions;
+            state_lower_bound = rhs.state_lower_bound;
+            state_upper_bound = rhs.state_upper_bound;
+            delete stream;
+            stream = rhs.stream ? new XoshiroRNG(*rhs.stream) : NULL;
+        }
+        return *this;
+    }
+
     virtual ~Environment() 
     {
+        delete stream;
+    }
+
+    /** Return an independent copy of the environment, or NULL if the
+        environment cannot be copied.
+
+        The copy is in the same state, and has a copy of the random
+        stream. Use setRandomStream() on copies that should not see
+        the same noise.
+    */
+    virtual Environment<S, A>* Clone() const
+    {
+        return NULL;
+    }
+
+    /** Give the environment its own random stream.
+
+        The stream is the k-th xoshiro stream of the seed, so that
+        environments simulated in parallel see independent noise.
+        Environments without a stream use the global generator.
+    */
+    void setRandomStream(unsigned long seed, int k = 0)
+    {
+        if (!stream) {
+            stream = new XoshiroRNG;
+        }
+        stream->setStream(seed, k);
+    }
+
+    /// Save the dynamic state of the environment
+    void Snapshot(EnvironmentSnapshot<S>& snapshot) const
+    {
+        snapshot.state = state;
+        snapshot.reward = reward;
+        snapshot.endsim = endsim;
+        snapshot.has_stream = (stream != NULL);
+        if (stream) {
+            snapshot.stream = *stream;
+        }
+        getHiddenState(snapshot.hidden);
+    }
+
+    /// Return the dynamic state of the environment
+    EnvironmentSnapshot<S> Snapshot() const
+    {
+        EnvironmentSnapshot<S> snapshot;
+        Snapshot(snapshot);
+        return snapshot;
+    }
+
+    /** Restore a state saved with Snapshot().
+
+        The environment then continues exactly as it would have from
+        the time of the snapshot, including its random stream.
+    */
+    void Restore(const EnvironmentSnapshot<S>& snapshot)
+    {
+        state = snapshot.state;
+        reward = snapshot.reward;
+        endsim = snapshot.endsim;
+        if (snapshot.has_stream) {
+            if (!stream) {
+                stream = new XoshiroRNG(snapshot.stream);
+            } else {
+                *stream = snapshot.stream;
+            }
+        }
+        setHiddenState(snapshot.hidden);
     }
 
     /// put the environment in its "natural: state
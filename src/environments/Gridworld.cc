@@ -303,7 +303,7 @@ void Gridworld::Reset()
     int x, y;
     int n_gridpoints = height*width;
     do {
-        state = rand()%(n_gridpoints);
+        state = stream ? stream->discrete_uniform(n_gridpoints) : rand()%(n_gridpoints);
         x = state % height;
         y = (state - x) / width;
     } while(whatIs(x, y) != GRID);
@@ -313,6 +313,31 @@ void Gridworld::Reset()
     my_mdp->Reset(state);
 }
 
+/// A copy with its own internal model, in the same state
+Gridworld* Gridworld::Clone() const
+{
+    Gridworld* clone = new Gridworld(*this);
+    clone->my_mdp = getMDP();
+    clone->my_mdp->Reset(state);
+    return clone;
+}
+
+void Gridworld::getHiddenState(Vector& hidden) const
+{
+    hidden.Resize(3);
+    hidden(0) = ox;
+    hidden(1) = oy;
+    hidden(2) = total_time;
+}
+
+void Gridworld::setHiddenState(const Vector& hidden)
+{
+    ox = (uint) hidden(0);
+    oy = (uint) hidden(1);
+    total_time = (int) hidden(2);
+    my_mdp->Reset(state);
+}
+
 bool Gridworld::Act(const int& action)
 {
     int x = state % width;
@@ -39,6 +39,7 @@ public:
               real goal_ = 1.0,
               real step_ = -0.1);
     virtual ~Gridworld();
+    virtual Gridworld* Clone() const;
 
     static void GetMazeDimensions(const char* fname);
     
@@ -87,6 +88,8 @@ public:
 
 protected:
     void CalculateDimensions(const char* fname);
+    virtual void getHiddenState(Vector& hidden) const;
+    virtual void setHiddenState(const Vector& hidden);
     uint height;
     uint width;
     //uint n_aactions;
@@ -69,8 +69,8 @@ LinearDynamicQuadratic::~LinearDynamicQuadratic()
 
 void LinearDynamicQuadratic::Reset()
 {
-	state[0] = urandom(parameters.L_POS, parameters.U_POS);
-    state[1] = urandom(parameters.L_VEL, parameters.U_VEL);
+	state[0] = Uniform(parameters.L_POS, parameters.U_POS);
+    state[1] = Uniform(parameters.L_VEL, parameters.U_VEL);
 	// state[0] = -0.5;
 	//	state[1] = 0.0;
 	
@@ -106,7 +106,7 @@ void LinearDynamicQuadratic::Simulate(const int& action)
     }
 	
 	
-    real noise = urandom(-parameters.MCNOISE, parameters.MCNOISE);
+    real noise = Uniform(-parameters.MCNOISE, parameters.MCNOISE);
     input += noise;
     
 	real vel = state[1];
@@ -34,6 +34,10 @@ protected:
 public:
 	LinearDynamicQuadratic(bool random_parameters = false);
 	virtual ~LinearDynamicQuadratic();
+	virtual LinearDynamicQuadratic* Clone() const
+	{
+		return new LinearDynamicQuadratic(*this);
+	}
 	virtual void Reset();
 	virtual bool Act(const int& action);
 	virtual void Simulate(const int& action);
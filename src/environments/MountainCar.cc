@@ -79,8 +79,8 @@ MountainCar::~MountainCar()
 
 void MountainCar::Reset()
 {
-    state[0] = urandom(parameters.L_POS, parameters.U_POS);
-    state[1] = urandom(parameters.L_VEL, parameters.U_VEL);
+    state[0] = Uniform(parameters.L_POS, parameters.U_POS);
+    state[1] = Uniform(parameters.L_VEL, parameters.U_VEL);
    // state[0] = -0.5;
 //	state[1] = 0.0;
 
@@ -116,7 +116,7 @@ void MountainCar::Simulate(const int action)
     }
 
 
-    real noise = urandom(-parameters.MCNOISE, parameters.MCNOISE);
+    real noise = Uniform(-parameters.MCNOISE, parameters.MCNOISE);
     input += noise;
     
     state[1] = state[1] + parameters.INPUT*input - parameters.GRAVITY*cos(3.0*state[0]);
@@ -148,3 +148,56 @@ void MountainCar::Simulate(const int action)
   
 }
 
+BatchMountainCar::BatchMountainCar(const MountainCar& environment, int n_lanes)
+    : BatchEnvironment(n_lanes, 2, 3),
+      parameters(environment.parameters),
+      input(n_lanes)
+{
+    Reset();
+}
+
+void BatchMountainCar::Reset(int lane)
+{
+    state[0](lane) = Uniform(lane, parameters.L_POS, parameters.U_POS);
+    state[1](lane) = Uniform(lane, parameters.L_VEL, parameters.U_VEL);
+    reward(lane) = 0.0;
+    running[lane] = 1;
+}
+
+int BatchMountainCar::Act(const int* action)
+{
+    // draw the noise first, so that the dynamics are a plain loop
+    for (int k=0; k<n_lanes; ++k) {
+        assert(action[k] >= 0 && action[k] < n_actions);
+        if (running[k]) {
+            input(k) = (real) (action[k] - 1)
+                + Uniform(k, -parameters.MCNOISE, parameters.MCNOISE);
+        } else {
+            input(k) = 0.0;
+        }
+    }
+
+    real* position = state[0].x;
+    real* velocity = state[1].x;
+    real* r = reward.x;
+    const real* u = input.x;
+    int n_running = 0;
+    for (int k=0; k<n_lanes; ++k) {
+        real v = velocity[k] + parameters.INPUT*u[k] - parameters.GRAVITY*cos(3.0*position[k]);
+        v = (v > parameters.U_VEL) ? parameters.U_VEL : v;
+        v = (v < parameters.L_VEL) ? parameters.L_VEL : v;
+        real p = position[k] + v;
+        p = (p > parameters.U_POS) ? parameters.U_POS : p;
+        bool bottom = (p < parameters.L_POS);
+        p = bottom ? parameters.L_POS + 0.01 : p;
+        v = bottom ? 0.01 : v;
+        bool run = running[k];
+        bool end = (p == parameters.U_POS);
+        position[k] = run ? p : position[k];
+        velocity[k] = run ? v : velocity[k];
+        r[k] = (run && !end) ? -1.0 : 0.0;
+        running[k] = run && !end;
+        n_running += running[k];
+    }
+    return n_running;
+}
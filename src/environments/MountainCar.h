@@ -15,6 +15,7 @@
 #define MOUNTAINCAR_H
 
 #include "Environment.h"
+#include "BatchEnvironment.h"
 #include "Vector.h"
 #include "real.h"
 
@@ -39,9 +40,14 @@ protected:
     Vector action_upper_bound;
     Vector action_lower_bound;
     void Simulate();
+    friend class BatchMountainCar;
 public:
     MountainCar(bool random_parameters = false);
     virtual ~MountainCar();
+    virtual MountainCar* Clone() const
+    {
+        return new MountainCar(*this);
+    }
     virtual void Reset();
     virtual bool Act(const int& action);
     virtual void Simulate(const int action);
@@ -95,6 +101,26 @@ public:
     }
 };
 
+/// A batch of mountain cars with the parameters of a given car
+class BatchMountainCar : public BatchEnvironment
+{
+protected:
+    MountainCar::Parameters parameters;
+    Vector input; ///< noisy input of each lane
+public:
+    BatchMountainCar(const MountainCar& environment, int n_lanes);
+    virtual ~BatchMountainCar()
+    {
+    }
+    using BatchEnvironment::Reset;
+    virtual void Reset(int lane);
+    virtual int Act(const int* action);
+    virtual const char* Name() const
+    {
+        return "Mountain Car";
+    }
+};
+
 class MountainCarGenerator
 {
 public:
@@ -98,8 +98,8 @@ void MountainCar3D::Simulate(int action)
     default: Serror("Undefined action %d\n", action);
     }
     
-    input_x += urandom(-MCNOISE, MCNOISE);
-    input_y += urandom(-MCNOISE, MCNOISE);
+    input_x += Uniform(-MCNOISE, MCNOISE);
+    input_y += Uniform(-MCNOISE, MCNOISE);
     
     state[2] += INPUT*input_x - GRAVITY*cos(3.0*state[0]);
     state[3] += INPUT*input_y - GRAVITY*cos(3.0*state[1]);
@@ -39,6 +39,10 @@ protected:
 public:
     MountainCar3D();
     virtual ~MountainCar3D();
+    virtual MountainCar3D* Clone() const
+    {
+        return new MountainCar3D(*this);
+    }
     virtual void Reset();
     virtual bool Act(int action);
     virtual void Simulate(int action);
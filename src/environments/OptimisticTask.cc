@@ -29,7 +29,7 @@ bool OptimisticTask::Act(const int& action)
         }
         break;
     case 1:
-        if (urandom() < delta) {
+        if (Uniform() < delta) {
             if (action == 0) {
                 state = 0;
             } else {
@@ -41,6 +41,10 @@ public:
     
     virtual ~OptimisticTask()
     {}
+    virtual OptimisticTask* Clone() const
+    {
+        return new OptimisticTask(*this);
+    }
     
     virtual void Reset();
     virtual bool Act(const int& action);
@@ -79,14 +79,14 @@ void Pendulum::Reset()
   //	    state[1] = urandom(-0.001, 0.001);
 #if 1
   // Theta
-  state[0] =  urandom(-0.01, 0.01);
+  state[0] =  Uniform(-0.01, 0.01);
   //	state[0] =  (2*urandom() - 1)*0.2;
   // dTheta/dt
-  state[1] = urandom(-0.001, 0.001);
+  state[1] = Uniform(-0.001, 0.001);
   //	state[1] =  (2*urandom() - 1)*0.2;
 #else
   for (int i=0; i<2; ++i) {
-    state[i] = urandom(state_lower_bound[i], state_upper_bound[i]);
+    state[i] = Uniform(state_lower_bound[i], state_upper_bound[i]);
   }
 #endif
   endsim = false;
@@ -134,7 +134,7 @@ void Pendulum::Simulate(const int action)
   case 2:  input = +50.0; break;
   }
 
-  noise = urandom(-parameters.max_noise, parameters.max_noise);
+  noise = Uniform(-parameters.max_noise, parameters.max_noise);
   input += noise;
 
   // Simulate for 0.1 seconds
@@ -155,3 +155,71 @@ void Pendulum::Simulate(const int action)
     endsim = false;
   }
 }
+
+BatchPendulum::BatchPendulum(const Pendulum& environment, int n_lanes)
+  : BatchEnvironment(n_lanes, 2, 3),
+    parameters(environment.parameters),
+    CCa(environment.CCa),
+    input(n_lanes)
+{
+  // the same number of steps as the loop in Pendulum::Simulate()
+  n_steps = 0;
+  for (real t=0.0; t<=0.1; t+=parameters.Dt) {
+    n_steps++;
+  }
+  Reset();
+}
+
+void BatchPendulum::Reset(int lane)
+{
+  state[0](lane) = Uniform(lane, -0.01, 0.01);
+  state[1](lane) = Uniform(lane, -0.001, 0.001);
+  reward(lane) = 1.0;
+  running[lane] = 1;
+}
+
+int BatchPendulum::Act(const int* action)
+{
+  for (int k=0; k<n_lanes; ++k) {
+    assert(action[k] >= 0 && action[k] < n_actions);
+    if (running[k]) {
+      input(k) = 50.0 * (real) (action[k] - 1)
+        + Uniform(k, -parameters.max_noise, parameters.max_noise);
+    } else {
+      input(k) = 0.0;
+    }
+  }
+
+  real* theta = state[0].x;
+  real* dtheta = state[1].x;
+  real* r = reward.x;
+  const real* u = input.x;
+  const char* run = &running[0];
+  const real Dt = parameters.Dt;
+  const real g = parameters.gravity;
+  const real m = parameters.pendulum_mass;
+  const real l = parameters.pendulum_length;
+  for (int step=0; step<n_steps; ++step) {
+    for (int k=0; k<n_lanes; ++k) {
+      real cx = cos(theta[k]);
+      real dtheta2 = dtheta[k]*dtheta[k];
+      real ddtheta = (g * sin(theta[k])
+                      - 0.5*CCa * m * l * dtheta2 * sin(2.0*theta[k])
+                      - CCa * cx * u[k])
+        / (4.0/3.0*l - CCa*m*l*cx*cx);
+      real next_theta = theta[k] + dtheta[k] * Dt;
+      real next_dtheta = dtheta[k] + ddtheta * Dt;
+      theta[k] = run[k] ? next_theta : theta[k];
+      dtheta[k] = run[k] ? next_dtheta : dtheta[k];
+    }
+  }
+
+  int n_running = 0;
+  for (int k=0; k<n_lanes; ++k) {
+    bool end = (fabs(theta[k]) > M_PI/2.0);
+    r[k] = (run[k] && end) ? -1.0 : 0.0;
+    running[k] = run[k] && !end;
+    n_running += running[k];
+  }
+  return n_running;
+}
@@ -15,6 +15,7 @@
 #define PENDULUM_H
 
 #include "Environment.h"
+#include "BatchEnvironment.h"
 #include "Vector.h"
 #include "real.h"
 #include "AbstractPolicy.h"
@@ -41,9 +42,14 @@ protected:
     void Simulate();
     void penddot(Vector& xdot, real u, Vector& x);
     void pendulum_simulate(int action);
+    friend class BatchPendulum;
 public:
     Pendulum(bool random_parameters = false);
     virtual ~Pendulum();
+    virtual Pendulum* Clone() const
+    {
+        return new Pendulum(*this);
+    }
     virtual void Reset();
     virtual bool Act(const int& action);
     virtual void Simulate(const int action);
@@ -107,6 +113,27 @@ public:
 };
 
 
+/// A batch of pendulums with the parameters of a given pendulum
+class BatchPendulum : public BatchEnvironment
+{
+protected:
+    Pendulum::Parameters parameters;
+    real CCa; ///< inverse total mass
+    int n_steps; ///< integration steps per action
+    Vector input; ///< noisy input of each lane
+public:
+    BatchPendulum(const Pendulum& environment, int n_lanes);
+    virtual ~BatchPendulum()
+    {
+    }
+    using BatchEnvironment::Reset;
+    virtual void Reset(int lane);
+    virtual int Act(const int* action);
+    virtual const char* Name() const
+    {
+        return "Pendulum";
+    }
+};
 
 class PendulumGenerator
 {
@@ -77,8 +77,8 @@ PuddleWorld::~PuddleWorld(){}
 
 void PuddleWorld::Reset()
 {
-	state[0] = urandom(parameters.L_POS_Y,parameters.U_POS_Y - 0.1);
-	state[1] = urandom(parameters.L_POS_Y,parameters.U_POS_Y - 0.1);
+	state[0] = Uniform(parameters.L_POS_Y,parameters.U_POS_Y - 0.1);
+	state[1] = Uniform(parameters.L_POS_Y,parameters.U_POS_Y - 0.1);
 	endsim   = false;
 	reward   = -1;
 }
@@ -116,8 +116,10 @@ void PuddleWorld::Simulate(const int action)
 
 	//We add noise in the transition.
 	NormalDistribution R;
-	state[0] = state[0] + (R.generate())*parameters.MCNOISE*parameters.AGENTSPEED;
-	state[1] = state[1] + (R.generate())*parameters.MCNOISE*parameters.AGENTSPEED;
+	real noise_x = stream ? stream->normal() : R.generate();
+	real noise_y = stream ? stream->normal() : R.generate();
+	state[0] = state[0] + noise_x*parameters.MCNOISE*parameters.AGENTSPEED;
+	state[1] = state[1] + noise_y*parameters.MCNOISE*parameters.AGENTSPEED;
 
 	if(state[0] > parameters.U_POS_X){
 		state[0] = parameters.U_POS_X;
@@ -72,6 +72,10 @@ protected:
 public:
     PuddleWorld(bool random_parameters = false);
     virtual ~PuddleWorld();
+    virtual PuddleWorld* Clone() const
+    {
+        return new PuddleWorld(*this);
+    }
     virtual void Reset();
     virtual bool Act(const int& action);
     virtual void Simulate(const int action);
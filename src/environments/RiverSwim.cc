@@ -18,10 +18,19 @@ RiverSwim::~RiverSwim()
 	delete model;
 }
 
+/// A copy with its own internal model, in the same state
+RiverSwim* RiverSwim::Clone() const
+{
+	RiverSwim* clone = new RiverSwim(*this);
+	clone->model = getMDP();
+	clone->model->setState(state);
+	return clone;
+}
+
 /// Start in state 1 or 2 (2 or 3 here) with equal probability
 void RiverSwim::Reset()
 {
-	if (urandom() < 0.5) {
+	if (Uniform() < 0.5) {
 		state = 2;
 	} else {
 		state = 3;
@@ -34,6 +34,7 @@ public:
     RiverSwim(int n = 6, real r_start_ = 0.0005, real r_end_ = 1.0);
     
     virtual ~RiverSwim();
+    virtual RiverSwim* Clone() const;
     
     virtual void Reset();
     virtual bool Act(const int& action);
@@ -44,6 +45,12 @@ public:
     }
 
     virtual DiscreteMDP* getMDP() const;
+protected:
+    /// Keep the internal model in the restored state
+    virtual void setHiddenState(const Vector& hidden)
+    {
+        model->setState(state);
+    }
 };
 
 #endif
@@ -66,7 +66,7 @@ SinModel::~SinModel()
 
 void SinModel::Reset()
 {
-  state[0] = urandom(parameters.L_POS, parameters.U_POS);
+  state[0] = Uniform(parameters.L_POS, parameters.U_POS);
 	
   endsim = false;
   reward = 0.0;
@@ -97,7 +97,8 @@ void SinModel::Simulate(const int action)
   default: Serror("Undefined action %d\n", action);
   }
     
-  state[0] = sin(state[0]) + noise.generate();
+  state[0] = sin(state[0])
+    + (stream ? noise.generate(*stream) : noise.generate());
     
   reward = 0;
   endsim = false;
@@ -38,6 +38,10 @@ protected:
 public:
   SinModel(bool random_parameters = false);
   virtual ~SinModel();
+  virtual SinModel* Clone() const
+  {
+    return new SinModel(*this);
+  }
   virtual void Reset();
   virtual bool Act(const int& action);
   virtual void Simulate(const int action);
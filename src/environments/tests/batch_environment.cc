@@ -0,0 +1,137 @@
+/* -*- Mode: C++; -*- */
+// copyright (c) 2013 by Christos Dimitrakakis <christos.dimitrakakis@gmail.com>
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifdef MAKE_MAIN
+
+#include "MountainCar.h"
+#include "Pendulum.h"
+#include "CartPole.h"
+#include "Acrobot.h"
+#include "XoshiroRNG.h"
+#include "EasyClock.h"
+#include <vector>
+
+/** Check that every lane of the batch follows the scalar environment
+	with the same random stream, including termination and resets.
+*/
+template <class E, class B>
+int CheckLanes(const E& prototype, int n_lanes, int T)
+{
+    int n_errors = 0;
+    unsigned long seed = 5678;
+    B batch(prototype, n_lanes);
+    batch.setRandomStream(seed);
+    batch.Reset();
+    std::vector<E*> environments(n_lanes);
+    for (int k=0; k<n_lanes; ++k) {
+        environments[k] = new E(prototype);
+        environments[k]->setRandomStream(seed, k);
+        environments[k]->Reset();
+    }
+
+    XoshiroRNG rng(1);
+    std::vector<int> action(n_lanes);
+    int n_episodes = 0;
+    for (int t=0; t<T; ++t) {
+        for (int k=0; k<n_lanes; ++k) {
+            action[k] = rng.discrete_uniform(batch.getNActions());
+        }
+        batch.Act(&action[0]);
+        for (int k=0; k<n_lanes; ++k) {
+            bool running = environments[k]->Act(action[k]);
+            real error = (environments[k]->getState() - batch.getState(k)).L1Norm();
+            if (error > 1e-9
+                || environments[k]->getReward() != batch.getReward(k)
+                || running != batch.isRunning(k)) {
+                n_errors++;
+            }
+            if (!running) {
+                environments[k]->Reset();
+            }
+        }
+        n_episodes += batch.ResetTerminated();
+    }
+    printf("%s: %d lanes, %d steps, %d episodes, %d errors\n",
+           batch.Name(), n_lanes, T, n_episodes, n_errors);
+    for (int k=0; k<n_lanes; ++k) {
+        delete environments[k];
+    }
+    return n_errors;
+}
+
+/// Compare the transition rate of scalar and batch stepping
+template <class E, class B>
+void Speed(const E& prototype, int n_lanes, int T)
+{
+    std::vector<Environment<Vector, int>*> environments(n_lanes);
+    for (int k=0; k<n_lanes; ++k) {
+        environments[k] = new E(prototype);
+        environments[k]->Reset();
+    }
+    double start_time = GetCPU();
+    for (int t=0; t<T; ++t) {
+        for (int k=0; k<n_lanes; ++k) {
+            if (!environments[k]->Act(t % 3)) {
+                environments[k]->Reset();
+            }
+        }
+    }
+    double scalar_time = GetCPU() - start_time;
+
+    B batch(prototype, n_lanes);
+    std::vector<int> action(n_lanes);
+    start_time = GetCPU();
+    for (int t=0; t<T; ++t) {
+        for (int k=0; k<n_lanes; ++k) {
+            action[k] = t % 3;
+        }
+        batch.Act(&action[0]);
+        batch.ResetTerminated();
+    }
+    double batch_time = GetCPU() - start_time;
+    real n_transitions = (real) n_lanes * T;
+    printf("%s: scalar %g, batch %g transitions/s\n", batch.Name(),
+           n_transitions / scalar_time, n_transitions / batch_time);
+    for (int k=0; k<n_lanes; ++k) {
+        delete environments[k];
+    }
+}
+
+int main()
+{
+    int n_errors = 0;
+    MountainCar mountain_car;
+    Pendulum pendulum;
+    CartPole cart_pole;
+    Acrobot acrobot;
+    acrobot.setRandomness(0.1);
+
+    n_errors += CheckLanes<MountainCar, BatchMountainCar>(mountain_car, 16, 1000);
+    n_errors += CheckLanes<Pendulum, BatchPendulum>(pendulum, 16, 1000);
+    n_errors += CheckLanes<CartPole, BatchCartPole>(cart_pole, 16, 1000);
+    n_errors += CheckLanes<Acrobot, BatchAcrobot>(acrobot, 16, 1000);
+
+    int n_lanes = 1000;
+    int T = 200;
+    Speed<MountainCar, BatchMountainCar>(mountain_car, n_lanes, T);
+    Speed<Pendulum, BatchPendulum>(pendulum, n_lanes, T);
+    Speed<CartPole, BatchCartPole>(cart_pole, n_lanes, T);
+    Speed<Acrobot, BatchAcrobot>(acrobot, n_lanes, T);
+
+    if (n_errors) {
+        printf("%d errors\n", n_errors);
+        return -1;
+    }
+    printf("OK\n");
+    return 0;
+}
+
+#endif
@@ -0,0 +1,176 @@
+/* -*- Mode: C++; -*- */
+// copyright (c) 2013 by Christos Dimitrakakis <christos.dimitrakakis@gmail.com>
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifdef MAKE_MAIN
+
+#include "MountainCar.h"
+#include "Pendulum.h"
+#include "CartPole.h"
+#include "Acrobot.h"
+#include "Bike.h"
+#include "PuddleWorld.h"
+#include "LinearDynamicQuadratic.h"
+#include "DiscreteChain.h"
+#include <cmath>
+#include <vector>
+
+real Difference(const Vector& x, const Vector& y)
+{
+    return (x - y).L1Norm();
+}
+
+real Difference(int x, int y)
+{
+    return fabs((real) (x - y));
+}
+
+/// Take T steps, with a fixed action sequence
+template <typename S>
+void Run(Environment<S, int>& environment, int T, std::vector<S>& states, std::vector<real>& rewards)
+{
+    states.clear();
+    rewards.clear();
+    for (int t=0; t<T; ++t) {
+        environment.Act((t / 3) % environment.getNActions());
+        states.push_back(environment.getState());
+        rewards.push_back(environment.getReward());
+    }
+}
+
+/// Count the steps where the two trajectories differ
+template <typename S>
+int Compare(const std::vector<S>& x_states, const std::vector<real>& x_rewards,
+            const std::vector<S>& y_states, const std::vector<real>& y_rewards)
+{
+    int n_differences = 0;
+    for (uint t=0; t<x_states.size(); ++t) {
+        if (Difference(x_states[t], y_states[t]) > 0
+            || x_rewards[t] != y_rewards[t]) {
+            n_differences++;
+        }
+    }
+    return n_differences;
+}
+
+/** Check that restoring a snapshot, or cloning, reproduces the
+    trajectory exactly, and that clones with other streams diverge if
+    the environment is noisy.
+*/
+template <typename S>
+int CheckEnvironment(Environment<S, int>& environment, bool noisy)
+{
+    int n_errors = 0;
+    int T = 50;
+    environment.setRandomStream(1234);
+    environment.Reset();
+    std::vector<S> states, replay_states;
+    std::vector<real> rewards, replay_rewards;
+    Run(environment, 5, states, rewards);
+
+    EnvironmentSnapshot<S> snapshot = environment.Snapshot();
+    Environment<S, int>* clone = environment.Clone();
+    Environment<S, int>* other = environment.Clone();
+    if (!clone || !other) {
+        fprintf(stderr, "%s: could not clone\n", environment.Name());
+        delete clone;
+        delete other;
+        return 1;
+    }
+    other->setRandomStream(1234, 1);
+
+    Run(environment, T, states, rewards);
+
+    environment.Restore(snapshot);
+    Run(environment, T, replay_states, replay_rewards);
+    if (Compare(states, rewards, replay_states, replay_rewards)) {
+        fprintf(stderr, "%s: restored trajectory differs\n", environment.Name());
+        n_errors++;
+    }
+
+    Run(*clone, T, replay_states, replay_rewards);
+    if (Compare(states, rewards, replay_states, replay_rewards)) {
+        fprintf(stderr, "%s: cloned trajectory differs\n", environment.Name());
+        n_errors++;
+    }
+
+    Run(*other, T, replay_states, replay_rewards);
+    int n_differences = Compare(states, rewards, replay_states, replay_rewards);
+    if (noisy && !n_differences) {
+        fprintf(stderr, "%s: other stream gives the same trajectory\n", environment.Name());
+        n_errors++;
+    }
+    printf("%s: %d/%d steps differ with another stream\n",
+           environment.Name(), n_differences, T);
+
+    delete clone;
+    delete other;
+    return n_errors;
+}
+
+int main()
+{
+    int n_errors = 0;
+    {
+        MountainCar environment;
+        environment.setRandomness(0.1);
+        n_errors += CheckEnvironment(environment, true);
+    }
+    {
+        Pendulum environment;
+        n_errors += CheckEnvironment(environment, true);
+    }
+    {
+        CartPole environment;
+        n_errors += CheckEnvironment(environment, true);
+    }
+    {
+        Acrobot environment;
+        environment.setRandomness(0.1);
+        n_errors += CheckEnvironment(environment, true);
+    }
+    {
+        Bike environment;
+        n_errors += CheckEnvironment(environment, true);
+    }
+    {
+        PuddleWorld environment;
+        n_errors += CheckEnvironment(environment, true);
+    }
+    {
+        LinearDynamicQuadratic environment;
+        n_errors += CheckEnvironment(environment, false);
+    }
+    {
+        DiscreteChain environment(5);
+        n_errors += CheckEnvironment(environment, true);
+    }
+
+    // without a stream, the snapshot still restores the state
+    {
+        MountainCar environment;
+        environment.Reset();
+        EnvironmentSnapshot<Vector> snapshot = environment.Snapshot();
+        environment.Act(0);
+        environment.Restore(snapshot);
+        if (Difference(environment.getState(), snapshot.state) > 0) {
+            n_errors++;
+        }
+    }
+
+    if (n_errors) {
+        printf("%d errors\n", n_errors);
+        return -1;
+    }
+    printf("OK\n");
+    return 0;
+}
+
+#endif
@@ -0,0 +1,259 @@
+// -*- Mode: c++ -*-
+// copyright (c) 2013 by Christos Dimitrakakis <christos.dimitrakakis@gmail.com>
+// $Revision$
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "CompiledDiscreteMDP.h"
+#include <algorithm>
+
+/// Compile the MDP
+CompiledDiscreteMDP::CompiledDiscreteMDP(const DiscreteMDP* mdp_)
+	: mdp(mdp_), stamp(0), n_states(0), n_actions(0)
+{
+	assert(mdp);
+	Update();
+}
+
+/** Use another MDP.
+
+	If the MDP is different from the current one, the next Update()
+	rebuilds the snapshot from scratch.
+*/
+void CompiledDiscreteMDP::setMDP(const DiscreteMDP* mdp_)
+{
+	assert(mdp_);
+	if (mdp_ != mdp) {
+		mdp = mdp_;
+		stamp = 0;
+	}
+}
+
+/// Read the non-zero transitions of one state-action pair
+void CompiledDiscreteMDP::CompileRow(int s, int a,
+									 std::vector<int>& states,
+									 std::vector<real>& probabilities) const
+{
+	const DiscreteStateSet& next = mdp->getNextStates(s, a);
+	for (DiscreteStateSet::const_iterator i=next.begin();
+		 i!=next.end();
+		 ++i) {
+		int s2 = *i;
+		real P = mdp->getTransitionProbability(s, a, s2);
+		if (P > 0) {
+			states.push_back(s2);
+			probabilities.push_back(P);
+		}
+	}
+}
+
+/// Rebuild all rows
+void CompiledDiscreteMDP::Rebuild()
+{
+	n_states = mdp->getNStates();
+	n_actions = mdp->getNActions();
+	int N = n_states * n_actions;
+	row_offset.resize(N + 1);
+	next_state.clear();
+	probability.clear();
+	reward.resize(N);
+	for (int s=0; s<n_states; ++s) {
+		for (int a=0; a<n_actions; ++a) {
+			row_offset[getID(s, a)] = next_state.size();
+			CompileRow(s, a, next_state, probability);
+		}
+	}
+	row_offset[N] = next_state.size();
+}
+
+/** Refresh the expected rewards of the rows whose reward was set.
+
+	Rows whose reward changed are added to changed_rows, unless their
+	transitions have already been recompiled. If the reward
+	distribution no longer lists all the rows set since the last
+	build, every row is refreshed.
+*/
+void CompiledDiscreteMDP::UpdateRewards()
+{
+	const DiscreteSpaceRewardDistribution& R = mdp->reward_distribution;
+	std::vector<int> rows;
+	if (R.getModifications().getModifiedRows(stamp, rows)) {
+		std::sort(rows.begin(), rows.end());
+		rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+	} else {
+		rows.resize(n_states * n_actions);
+		for (int i=0; i<n_states * n_actions; ++i) {
+			rows[i] = i;
+		}
+	}
+	// the recompiled rows are sorted, and already listed as changed
+	int n_recompiled = changed_rows.size();
+	for (unsigned int k=0; k<rows.size(); ++k) {
+		int i = rows[k];
+		real r = mdp->getExpectedReward(i / n_actions, i % n_actions);
+		if (r != reward[i]
+			&& !std::binary_search(changed_rows.begin(),
+								   changed_rows.begin() + n_recompiled, i)) {
+			changed_rows.push_back(i);
+		}
+		reward[i] = r;
+	}
+}
+
+/** Bring the snapshot up to date with the MDP.
+
+	The rows modified since the last build are taken from the
+	modification logs of the transition and reward distributions, so
+	that the cost depends on the number of modified rows rather than
+	on the size of the MDP. Their transitions are compiled again. If
+	all of them keep their size, they are overwritten in place.
+	Otherwise, the unchanged rows are copied over to the new arrays
+	without consulting the MDP.
+
+	Returns the number of rows whose transitions were recompiled. All
+	rows that changed are listed in changed_rows.
+*/
+int CompiledDiscreteMDP::Update()
+{
+	int n_compiled = 0;
+	unsigned long last_stamp = ModificationLog::getLastStamp();
+	changed_rows.clear();
+	if (stamp == 0
+		|| n_states != mdp->getNStates()
+		|| n_actions != mdp->getNActions()) {
+		Rebuild();
+		n_compiled = n_states * n_actions;
+		changed_rows.resize(n_compiled);
+		for (int i=0; i<n_compiled; ++i) {
+			changed_rows[i] = i;
+			reward[i] = mdp->getExpectedReward(i / n_actions, i % n_actions);
+		}
+	} else if (last_stamp != stamp) {
+		UpdateTransitions();
+		n_compiled = changed_rows.size();
+		UpdateRewards();
+	}
+	stamp = last_stamp;
+	return n_compiled;
+}
+
+/** Recompile the rows modified since the last build.
+
+	The rows are listed in changed_rows, in increasing order.
+*/
+void CompiledDiscreteMDP::UpdateTransitions()
+{
+	const DiscreteTransitionDistribution& T = mdp->transition_distribution;
+	std::vector<int>& dirty = changed_rows;
+	if (T.getModifications().getModifiedRows(stamp, dirty)) {
+		std::sort(dirty.begin(), dirty.end());
+		dirty.erase(std::unique(dirty.begin(), dirty.end()), dirty.end());
+	} else {
+		dirty.clear();
+		for (int s=0; s<n_states; ++s) {
+			for (int a=0; a<n_actions; ++a) {
+				if (T.getRowStamp(s, a) > stamp) {
+					dirty.push_back(getID(s, a));
+				}
+			}
+		}
+	}
+	int n_compiled = dirty.size();
+	if (n_compiled == 0) {
+		return;
+	}
+
+	// Compile the dirty rows and check whether they changed size
+	std::vector<int> dirty_offset(n_compiled + 1);
+	std::vector<int> dirty_states;
+	std::vector<real> dirty_probabilities;
+	bool same_size = true;
+	for (int k=0; k<n_compiled; ++k) {
+		int i = dirty[k];
+		dirty_offset[k] = dirty_states.size();
+		CompileRow(i / n_actions, i % n_actions,
+				   dirty_states, dirty_probabilities);
+		int new_size = dirty_states.size() - dirty_offset[k];
+		if (new_size != row_offset[i + 1] - row_offset[i]) {
+			same_size = false;
+		}
+	}
+	dirty_offset[n_compiled] = dirty_states.size();
+
+	if (same_size) {
+		for (int k=0; k<n_compiled; ++k) {
+			int dst = row_offset[dirty[k]];
+			for (int j=dirty_offset[k]; j<dirty_offset[k + 1]; ++j, ++dst) {
+				next_state[dst] = dirty_states[j];
+				probability[dst] = dirty_probabilities[j];
+			}
+		}
+	} else {
+		int N = n_states * n_actions;
+		std::vector<int> new_offset(N + 1);
+		std::vector<int> new_states;
+		std::vector<real> new_probabilities;
+		int n_new = next_state.size() + dirty_states.size();
+		new_states.reserve(n_new);
+		new_probabilities.reserve(n_new);
+		int k = 0;
+		for (int i=0; i<N; ++i) {
+			new_offset[i] = new_states.size();
+			if (k < n_compiled && dirty[k] == i) {
+				new_states.insert(new_states.end(),
+								  dirty_states.begin() + dirty_offset[k],
+								  dirty_states.begin() + dirty_offset[k + 1]);
+				new_probabilities.insert(new_probabilities.end(),
+										 dirty_probabilities.begin() + dirty_offset[k],
+										 dirty_probabilities.begin() + dirty_offset[k + 1]);
+				++k;
+			} else {
+				new_states.insert(new_states.end(),
+								  next_state.begin() + row_offset[i],
+								  next_state.begin() + row_offset[i + 1]);
+				new_probabilities.insert(new_probabilities.end(),
+										 probability.begin() + row_offset[i],
+										 probability.begin() + row_offset[i + 1]);
+			}
+		}
+		new_offset[N] = new_states.size();
+		row_offset.swap(new_offset);
+		next_state.swap(new_states);
+		probability.swap(new_probabilities);
+	}
+}
+
+/** Split the states into contiguous blocks of similar cost.
+
+	The cost of a state is the number of its transitions plus the
+	number of actions. Block k contains the states in
+	[boundary[k], boundary[k+1]), and each block except the last
+	costs at least block_size.
+
+	The split only depends on the MDP and block_size. Quantities
+	reduced block by block are thus the same whatever the number of
+	threads working on the blocks.
+*/
+std::vector<int> CompiledDiscreteMDP::PartitionStates(int block_size) const
+{
+	assert(block_size > 0);
+	std::vector<int> boundary(1, 0);
+	int start = 0;
+	for (int s=0; s<n_states; ++s) {
+		int end = row_offset[(s + 1) * n_actions] + (s + 1) * n_actions;
+		if (end - start >= block_size) {
+			boundary.push_back(s + 1);
+			start = end;
+		}
+	}
+	if (boundary.back() != n_states) {
+		boundary.push_back(n_states);
+	}
+	return boundary;
+}
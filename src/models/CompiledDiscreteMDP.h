@@ -0,0 +1,126 @@
+// -*- Mode: c++ -*-
+// copyright (c) 2013 by Christos Dimitrakakis <christos.dimitrakakis@gmail.com>
+// $Revision$
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef COMPILED_DISCRETE_MDP_H
+#define COMPILED_DISCRETE_MDP_H
+
+#include "DiscreteMDP.h"
+#include "Vector.h"
+#include "real.h"
+#include <vector>
+
+/** A frozen, compressed sparse row view of a DiscreteMDP.
+
+	The transitions of each state-action pair \f$(s,a)\f$ are stored
+	contiguously, in increasing order of next state, in the range
+	[row_offset[i], row_offset[i+1]) of the next_state and probability
+	arrays, where \f$i = s |A| + a\f$. The expected rewards are stored
+	in a dense array indexed in the same way.
+
+	The snapshot does not follow changes in the MDP automatically.
+	Calling Update() brings it up to date: only the rows listed as
+	modified since the last build by the transition and reward
+	distributions (see ModificationLog) are read again from the MDP.
+	The rows whose transitions or reward changed are listed in
+	changed_rows. Changes made directly to a reward Distribution
+	object after it was given to the MDP are not seen; call
+	Invalidate() after such changes.
+ */
+class CompiledDiscreteMDP
+{
+protected:
+	const DiscreteMDP* mdp; ///< the MDP being compiled
+	unsigned long stamp; ///< last stamp seen by the build, 0 if not built
+	void Rebuild();
+	void CompileRow(int s, int a,
+					std::vector<int>& states,
+					std::vector<real>& probabilities) const;
+	void UpdateTransitions();
+	void UpdateRewards();
+public:
+	int n_states; ///< number of states
+	int n_actions; ///< number of actions
+	std::vector<int> row_offset; ///< start of each row, plus one past the end
+	std::vector<int> next_state; ///< next states, row by row
+	std::vector<real> probability; ///< transition probabilities, row by row
+	std::vector<real> reward; ///< expected reward of each state-action pair
+	std::vector<int> changed_rows; ///< rows changed by the last Update()
+
+	CompiledDiscreteMDP(const DiscreteMDP* mdp_);
+	void setMDP(const DiscreteMDP* mdp_);
+	int Update();
+	/// Rebuild the whole snapshot on the next Update()
+	void Invalidate()
+	{
+		stamp = 0;
+	}
+	std::vector<int> PartitionStates(int block_size) const;
+	const DiscreteMDP* getMDP() const
+	{
+		return mdp;
+	}
+	inline int getNStates() const
+	{
+		return n_states;
+	}
+	inline int getNActions() const
+	{
+		return n_actions;
+	}
+	/// Total number of stored transitions
+	inline int getNTransitions() const
+	{
+		return (int) next_state.size();
+	}
+	inline int getID(int s, int a) const
+	{
+		assert(s >= 0 && s < n_states);
+		assert(a >= 0 && a < n_actions);
+		return s * n_actions + a;
+	}
+	inline int RowBegin(int s, int a) const
+	{
+		return row_offset[getID(s, a)];
+	}
+	inline int RowEnd(int s, int a) const
+	{
+		return row_offset[getID(s, a) + 1];
+	}
+	inline real getExpectedReward(int s, int a) const
+	{
+		return reward[getID(s, a)];
+	}
+	/// Return \f$\sum_{s'} P(s' | s, a) V(s')\f$.
+	inline real Expectation(int s, int a, const real* V) const
+	{
+		int i = getID(s, a);
+		real sum = 0.0;
+		for (int k=row_offset[i]; k<row_offset[i + 1]; ++k) {
+			sum += probability[k] * V[next_state[k]];
+		}
+		return sum;
+	}
+	/// Return \f$\sum_{s'} P(s' | s, a) V(s')\f$.
+	inline real Expectation(int s, int a, const Vector& V) const
+	{
+		assert(V.Size() == n_states);
+		return Expectation(s, a, V.x);
+	}
+	/// Return \f$\sum_{s'} P(s' | s, a) V(s')\f$.
+	inline real Expectation(int s, int a, const std::vector<real>& V) const
+	{
+		assert((int) V.size() == n_states);
+		return Expectation(s, a, &V[0]);
+	}
+};
+
+#endif
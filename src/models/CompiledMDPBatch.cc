@@ -0,0 +1,73 @@
+// -*- Mode: c++ -*-
+// copyright (c) 2013 by Christos Dimitrakakis <christos.dimitrakakis@gmail.com>
+// $Revision$
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "CompiledMDPBatch.h"
+#include <algorithm>
+#include <stdexcept>
+
+/// Compile a batch of MDPs
+CompiledMDPBatch::CompiledMDPBatch(const std::vector<const DiscreteMDP*>& mdp_list)
+	: n_mdps(0), n_states(0), n_actions(0)
+{
+	setMDPList(mdp_list);
+}
+
+/** Compile another batch of MDPs.
+
+	Each row is the sorted union of the next states of the MDPs, with
+	a zero probability for the MDPs that cannot reach the state.
+*/
+void CompiledMDPBatch::setMDPList(const std::vector<const DiscreteMDP*>& mdp_list)
+{
+	assert(mdp_list.size() > 0);
+	n_mdps = mdp_list.size();
+	n_states = mdp_list[0]->getNStates();
+	n_actions = mdp_list[0]->getNActions();
+	for (int k=1; k<n_mdps; ++k) {
+		if (n_actions != mdp_list[k]->getNActions()) {
+			throw std::runtime_error("Number of actions in MDPs does not agree\n");
+		}
+		if (n_states != mdp_list[k]->getNStates()) {
+			throw std::runtime_error("Number of states in MDPs does not agree\n");
+		}
+	}
+
+	const int K = n_mdps;
+	int N = n_states * n_actions;
+	row_offset.resize(N + 1);
+	next_state.clear();
+	probability.clear();
+	reward.resize(N * K);
+	std::vector<int> row;
+	for (int s=0; s<n_states; ++s) {
+		for (int a=0; a<n_actions; ++a) {
+			int i = getID(s, a);
+			row_offset[i] = next_state.size();
+			row.clear();
+			for (int k=0; k<K; ++k) {
+				const DiscreteStateSet& next = mdp_list[k]->getNextStates(s, a);
+				row.insert(row.end(), next.begin(), next.end());
+				reward[i * K + k] = mdp_list[k]->getExpectedReward(s, a);
+			}
+			std::sort(row.begin(), row.end());
+			row.erase(std::unique(row.begin(), row.end()), row.end());
+			for (unsigned int j=0; j<row.size(); ++j) {
+				int s2 = row[j];
+				next_state.push_back(s2);
+				for (int k=0; k<K; ++k) {
+					probability.push_back(mdp_list[k]->getTransitionProbability(s, a, s2));
+				}
+			}
+		}
+	}
+	row_offset[N] = next_state.size();
+}
@@ -0,0 +1,92 @@
+// -*- Mode: c++ -*-
+// copyright (c) 2013 by Christos Dimitrakakis <christos.dimitrakakis@gmail.com>
+// $Revision$
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef COMPILED_MDP_BATCH_H
+#define COMPILED_MDP_BATCH_H
+
+#include "DiscreteMDP.h"
+#include "real.h"
+#include <vector>
+
+/** A compressed sparse row view of a batch of DiscreteMDPs.
+
+	The MDPs must have the same number of states and actions, as
+	when they are sampled from the same posterior. The rows are laid
+	out as in CompiledDiscreteMDP, but hold the union of the next
+	states of all \f$K\f$ MDPs. The probabilities of transition
+	\f$j\f$ under the \f$K\f$ MDPs are stored contiguously, at
+	probability[j*K + k], and so are the rewards of row \f$i\f$, at
+	reward[i*K + k].
+
+	Values are expected in the same layout, with V[s*K + k] the value
+	of state \f$s\f$ for MDP \f$k\f$. A single pass over the structure
+	then backs up all MDPs, and the inner loop over the batch is
+	contiguous for the compiler to vectorise.
+ */
+class CompiledMDPBatch
+{
+public:
+	int n_mdps; ///< number of MDPs in the batch
+	int n_states; ///< number of states
+	int n_actions; ///< number of actions
+	std::vector<int> row_offset; ///< start of each row, plus one past the end
+	std::vector<int> next_state; ///< next states, row by row
+	std::vector<real> probability; ///< transition probabilities, [transition][mdp]
+	std::vector<real> reward; ///< expected rewards, [state-action][mdp]
+
+	CompiledMDPBatch(const std::vector<const DiscreteMDP*>& mdp_list);
+	void setMDPList(const std::vector<const DiscreteMDP*>& mdp_list);
+	inline int getNMDPs() const
+	{
+		return n_mdps;
+	}
+	inline int getNStates() const
+	{
+		return n_states;
+	}
+	inline int getNActions() const
+	{
+		return n_actions;
+	}
+	inline int getID(int s, int a) const
+	{
+		assert(s >= 0 && s < n_states);
+		assert(a >= 0 && a < n_actions);
+		return s * n_actions + a;
+	}
+	/** Back up a state-action pair for all MDPs.
+
+		Sets \f$Q_k = r_k(s,a) + \gamma \sum_{s'} P_k(s' | s, a) V_k(s')\f$
+		for every MDP \f$k\f$, with \f$V_k(s')\f$ = V[s'*K + k].
+	*/
+	inline void Backup(int s, int a, real gamma, const real* V, real* Q) const
+	{
+		const int K = n_mdps;
+		int i = getID(s, a);
+		const real* R = &reward[i * K];
+		for (int k=0; k<K; ++k) {
+			Q[k] = 0.0;
+		}
+		for (int j=row_offset[i]; j<row_offset[i + 1]; ++j) {
+			const real* P = &probability[j * K];
+			const real* V_next = &V[next_state[j] * K];
+			for (int k=0; k<K; ++k) {
+				Q[k] += P[k] * V_next[k];
+			}
+		}
+		for (int k=0; k<K; ++k) {
+			Q[k] = R[k] + gamma * Q[k];
+		}
+	}
+};
+
+#endif
@@ -13,12 +13,13 @@
 #define CONTEXT_TREE_RL_H
 
 #include <vector>
-#include <list>
 #include "real.h"
 #include "Vector.h"
 #include "Ring.h"
 #include "BetaDistribution.h"
 #include "NormalDistribution.h"
+#include "ContextTreeStore.h"
+#include "Arena.h"
 
 /** A context tree implementation.
     
@@ -27,55 +28,31 @@
     concatenation of observation-action pairs \f$x_t = (z_t, a_t)\f$,
     with \f$x_t \in X = Z \times A\f$, \f$a_t \in A\f$ and \f$z_t \in
     Z\f$.
-    
+
+    The nodes are kept in a ContextTreeStore, with the reward models
+    in a pool. With a node budget, the least recently used contexts
+    are pruned, so memory stays bounded on long interactions.
 */
 class ContextTreeRL
 {
 public:
-    // public classes
-    struct Node
+    /// Data kept at each node, besides the counts and weights
+    struct NodeData
     {
-        int n_branches; ///< \f$|X|\f$
-        int n_outcomes; ///< \f$|Y|\f$
-        int depth; ///< depth
-        Node* prev; ///< previous node
-        std::vector<Node*> next; ///< pointers to next nodes
-        Vector P; ///< probability of next symbols
-        Vector alpha; ///< parameters of next symbols
-        const real prior_alpha; ///< implicit prior value of alpha
-        real w; ///< backoff weight
-        real log_w; ///< log of w
-        real log_w_prior; ///< initial value
         //BetaDistribution reward_prior;
         //NormalDistributionUnknownMean reward_prior;
-        NormalUnknownMeanPrecision reward_prior;
+        NormalUnknownMeanPrecision* reward_prior; ///< reward model
         real Q; ///< last Q value of the context
         real w_prod; ///< \f$\prod_k (1 - w_k)\f$
         real context_probability; ///< last probability of the context
-
-        Node(int n_branches_,
-             int n_outcomes_);
-        Node(Node* prev_);
-        ~Node();
-
-        real Observe(Ring<int>& history,
-                     Ring<int>::iterator x,
-                     int z,
-                     real r,
-                     real probability,
-                     std::list<Node*>& active_contexts);
-        real QValue(Ring<int>& history,
-                     Ring<int>::iterator x,
-                    real Q_prev);
-        void Show();
-        int NChildren();
-    };  
+    };
     // public methods
     ContextTreeRL(int n_branches_,
                   int n_observations,
                   int n_actions,
                   int n_symbols_,
-                  int max_depth_= 0);
+                  int max_depth_= 0,
+                  int node_budget = 0);
     ~ContextTreeRL();
     real Observe(int x, int z, real r);
     void Show();
@@ -83,15 +60,30 @@ public:
     real QValue(int x);
     real QLearning(real step_size,  real gamma, int observation, real reward);
     real Sarsa(real step_size,  real gamma, int observation, real reward);
+    /// Limit the number of nodes, pruning the least recently used contexts
+    void setNodeBudget(int node_budget)
+    {
+        store.setBudget(node_budget);
+    }
+    int getNodeBudget() const
+    {
+        return store.getBudget();
+    }
 protected: 
     int n_branches;
     int n_observations;
     int n_actions;
     int n_symbols;
     int max_depth;
-    Node* root;
+    real prior_alpha; ///< implicit prior value of alpha
+    std::vector<real> log_w_prior; ///< initial log-weight at each depth
+    ContextTreeStore<NodeData> store; ///< the nodes
+    ObjectPool<NormalUnknownMeanPrecision> reward_priors; ///< reward models of the nodes
     Ring<int> history;
-    std::list<Node*> active_contexts;
+    std::vector<int> active_contexts; ///< the active node at each depth
+    std::vector<real> w; ///< workspace for the active weights
+    void NewNode(int depth, int i);
+    real QValue(Ring<int>& context);
 };
 
 
@@ -11,6 +11,8 @@
 
 #include "DirichletTransitions.h"
 #include "Distribution.h"
+#include "Random.h"
+#include "ranlib.h"
 
 DirichletTransitions::DirichletTransitions(int n_states_,
 										   int n_actions_,
@@ -39,14 +41,19 @@ DirichletTransitions::~DirichletTransitions()
 
 real DirichletTransitions::Observe(int state, int action, int next_state)
 {
-	DiscreteStateAction SA(state, action);
-	auto got = P.find(SA);
-	if (got == P.end()) {
-		// arrgh C++
-		return P.insert(std::make_pair(SA, DirichletDistribution(n_states, prior_mass))).first->second.Observe(next_state);
+	Counts& counts = P[DiscreteStateAction(state, action)];
+	int i = counts.find(next_state);
+	real alpha = prior_mass;
+	if (i < 0) {
+		counts.next_state.push_back(next_state);
+		counts.count.push_back(1.0);
 	} else {
-		return got->second.Observe(next_state);
+		alpha += counts.count[i];
+		counts.count[i] += 1.0;
 	}
+	real p = alpha / (prior_mass * (real) n_states + (real) counts.n_observations);
+	counts.n_observations++;
+	return p;
 }
 
 
@@ -71,7 +78,7 @@ Vector DirichletTransitions::generate(int state, int action) const
 		}
 		return p;
 	} 
-	return got->second.generate();
+	return DirichletDistribution(getParameters(state, action)).generate();
 }
 
 Vector DirichletTransitions::getMarginal(int state, int action) const
@@ -89,7 +96,9 @@ Vector DirichletTransitions::getMarginal(int state, int action) const
 		}
 		return p;
 	} 
-	return got->second.getMarginal();
+	Vector p = getParameters(state, action);
+	p /= prior_mass * (real) n_states + (real) got->second.n_observations;
+	return p;
 }
 
 Vector DirichletTransitions::getParameters(int state, int action) const
@@ -107,7 +116,15 @@ Vector DirichletTransitions::getParameters(int state, int action) const
 		}
 		return p;
 	} 
-	return got->second.getParameters();
+	const Counts& counts = got->second;
+	Vector p(n_states);
+	for (int j=0; j<n_states; j++) {
+		p(j) = prior_mass;
+	}
+	for (uint i=0; i<counts.next_state.size(); ++i) {
+		p(counts.next_state[i]) += counts.count[i];
+	}
+	return p;
 }
 
 
@@ -126,7 +143,13 @@ real DirichletTransitions::marginal_pdf(int state, int action, int next_state) c
 			}
 		}
 	} 
-	return got->second.marginal_pdf(next_state);
+	const Counts& counts = got->second;
+	int i = counts.find(next_state);
+	real alpha = prior_mass;
+	if (i >= 0) {
+		alpha += counts.count[i];
+	}
+	return alpha / (prior_mass * (real) n_states + (real) counts.n_observations);
 }
 
 int DirichletTransitions::getCounts(int state, int action) const
@@ -136,6 +159,111 @@ int DirichletTransitions::getCounts(int state, int action) const
 	if (got == P.end()) {
 		return 0;
 	} else {
-		return got->second.getCounts();
+		return got->second.n_observations;
+	}
+}
+
+void DirichletTransitions::getUnknown(int state, SparseDistribution& p) const
+{
+	p.clear();
+	if (uniform_unknown) {
+		real z = 1.0 / (real) n_states;
+		for (int j=0; j<n_states; j++) {
+			p.push_back(std::make_pair(j, z));
+		}
+	} else {
+		p.push_back(std::make_pair(state, 1.0));
+	}
+}
+
+/// Rejection sampling, unless most states have been observed
+int DirichletTransitions::generateUnobserved(const Counts& counts) const
+{
+	int n_unobserved = n_states - (int) counts.next_state.size();
+	assert(n_unobserved > 0);
+	if (2 * n_unobserved >= n_states) {
+		while (true) {
+			int j = urandom(0, n_states);
+			if (j < n_states && counts.find(j) < 0) {
+				return j;
+			}
+		}
+	}
+	int k = urandom(0, n_unobserved);
+	for (int j=0; j<n_states; j++) {
+		if (counts.find(j) < 0) {
+			if (!k) {
+				return j;
+			}
+			k--;
+		}
+	}
+	return n_states - 1;
+}
+
+/** Draw a sparse multinomial parameter vector.
+
+	The posterior is sampled exactly for the observed next states.
+	The mass of the unobserved next states is drawn as a single
+	Gamma variable and placed on one of them, chosen uniformly. The
+	sample's expected value is still the posterior mean.
+ */
+void DirichletTransitions::generate(int state, int action, SparseDistribution& p) const
+{
+	auto got = P.find(DiscreteStateAction(state, action));
+	if (got == P.end()) {
+		getUnknown(state, p);
+		return;
+	}
+	const Counts& counts = got->second;
+	int n_observed = (int) counts.next_state.size();
+	int n_unobserved = n_states - n_observed;
+	p.resize(n_observed);
+	real sum = 0.0;
+	for (int i=0; i<n_observed; ++i) {
+		real x = gengam(1.0, prior_mass + counts.count[i]);
+		p[i] = std::make_pair(counts.next_state[i], x);
+		sum += x;
+	}
+	if (n_unobserved > 0) {
+		real x = gengam(1.0, prior_mass * (real) n_unobserved);
+		p.push_back(std::make_pair(generateUnobserved(counts), x));
+		sum += x;
+	}
+	real invsum = 1.0 / sum;
+	for (uint i=0; i<p.size(); ++i) {
+		p[i].second *= invsum;
+	}
+}
+
+/** Get the sparse marginal over next states.
+
+	The marginal mass of the unobserved next states is placed on the
+	current state, in line with the self-transition of unvisited
+	state-action pairs.
+ */
+void DirichletTransitions::getMarginal(int state, int action, SparseDistribution& p) const
+{
+	auto got = P.find(DiscreteStateAction(state, action));
+	if (got == P.end()) {
+		getUnknown(state, p);
+		return;
+	}
+	const Counts& counts = got->second;
+	int n_observed = (int) counts.next_state.size();
+	int n_unobserved = n_states - n_observed;
+	real invsum = 1.0 / (prior_mass * (real) n_states + (real) counts.n_observations);
+	p.resize(n_observed);
+	for (int i=0; i<n_observed; ++i) {
+		p[i] = std::make_pair(counts.next_state[i], (prior_mass + counts.count[i]) * invsum);
+	}
+	if (n_unobserved > 0) {
+		real rest = prior_mass * (real) n_unobserved * invsum;
+		int i = counts.find(state);
+		if (i >= 0) {
+			p[i].second += rest;
+		} else {
+			p.push_back(std::make_pair(state, rest));
+		}
 	}
 }
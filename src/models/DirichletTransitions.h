@@ -21,16 +21,45 @@
 	Here the prior mass is distributed uniformly over the state space.
 	
 	By default, an unvisited state-action pair has a uniform distribution state. This behaviour may not be ideal.
+
+	The posterior of each state-action pair is stored sparsely: only
+	the observed next states and their counts are kept, while every
+	unobserved next state has the prior mass. The sparse methods
+	lump the posterior mass of the unobserved next states together,
+	so that they cost time proportional to the number of observed
+	next states rather than the number of states.
  */
 class DirichletTransitions 
 {
 public:
+	/// A sparse distribution over next states
+	typedef std::vector<std::pair<int, real> > SparseDistribution;
+	/// Counts of the observed next states of a state-action pair
+	struct Counts
+	{
+		std::vector<int> next_state; ///< observed next states
+		std::vector<real> count; ///< number of times each was seen
+		int n_observations; ///< total number of observations
+		Counts() : n_observations(0)
+		{
+		}
+		/// Position of a next state, or -1 if unobserved
+		int find(int state) const
+		{
+			for (int i=0; i<(int) next_state.size(); ++i) {
+				if (next_state[i] == state) {
+					return i;
+				}
+			}
+			return -1;
+		}
+	};
 	int n_states; ///< number of states
 	int n_actions; ///< number of actions
-	real prior_mass; ///< total prior mass to place
+	real prior_mass; ///< prior mass of each next state
 	bool uniform_unknown; ///< whether to use a uniform distribution for unknown states
-	/// The set of Dirichlet distributions
-	std::unordered_map<DiscreteStateAction, DirichletDistribution> P;
+	/// The posterior counts of each visited state-action pair
+	std::unordered_map<DiscreteStateAction, Counts> P;
 
 	/// The standard constructor
 	DirichletTransitions(int n_states_, int n_actions_,
@@ -59,6 +88,17 @@ public:
 
 	/// Get the number of visits to this state-action pair
 	int getCounts(int state, int action) const;
+
+	/// Draw a sparse multinomial parameter vector
+	void generate(int state, int action, SparseDistribution& p) const;
+
+	/// Get the sparse marginal over next states
+	void getMarginal(int state, int action, SparseDistribution& p) const;
+protected:
+	/// The distribution of an unvisited state-action pair
+	void getUnknown(int state, SparseDistribution& p) const;
+	/// Draw one of the unobserved next states uniformly
+	int generateUnobserved(const Counts& counts) const;
 };
 
 typedef TransitionDistribution<int, int> DiscreteTransitionDistribution;
@@ -97,11 +97,38 @@ void DiscreteMDPCounts::AddTransition(int s, int a, real r, int s2)
 
     real expected_reward = getExpectedReward(s,a);
     mean_mdp.reward_distribution.setFixedReward(s, a, expected_reward);
-    for (int s_next=0; s_next<n_states; s_next++) {
-		real p = transitions.marginal_pdf(s, a, s_next);
-        mean_mdp.setTransitionProbability(s, a, s_next, p);
+    transitions.getMarginal(s, a, row);
+    setTransitionRow(&mean_mdp, s, a, row);
+}
+
+/** Replace a row of transition probabilities.
+
+    Next states that are not in the new row are removed first.
+ */
+void DiscreteMDPCounts::setTransitionRow(DiscreteMDP* mdp, int s, int a,
+                                         const DirichletTransitions::SparseDistribution& p) const
+{
+    const DiscreteStateSet& next_states = mdp->getNextStates(s, a);
+    if (!next_states.empty()) {
+        std::vector<int> stale;
+        for (DiscreteStateSet::const_iterator i = next_states.begin();
+             i != next_states.end();
+             ++i) {
+            bool found = false;
+            for (uint k=0; k<p.size() && !found; ++k) {
+                found = (p[k].first == *i);
+            }
+            if (!found) {
+                stale.push_back(*i);
+            }
+        }
+        for (uint k=0; k<stale.size(); ++k) {
+            mdp->setTransitionProbability(s, a, stale[k], 0.0);
+        }
+    }
+    for (uint k=0; k<p.size(); ++k) {
+        mdp->setTransitionProbability(s, a, p[k].first, p[k].second);
     }
-    
 }
 
 //void DiscreteMDPCounts::SetNextReward(int s, int a, real r)
@@ -175,15 +202,15 @@ void DiscreteMDPCounts::ShowModel() const
 DiscreteMDP* DiscreteMDPCounts::generate() const
 {
     DiscreteMDP* mdp = new DiscreteMDP(n_states, n_actions, NULL);
+    DirichletTransitions::SparseDistribution C;
     for (int s=0; s<n_states; s++) {
         for (int a=0; a<n_actions; a++) {
-            //Vector C =  P[getID (s,a)].getMarginal();
-            Vector C =  transitions.generate(s,a);
+            transitions.generate(s, a, C);
             real expected_reward = GenerateReward(s,a);
             mdp->reward_distribution.addFixedReward(s, a, expected_reward);
-            for (int s2=0; s2<n_states; s2++) {
-                if (C[s2]) {
-                    mdp->setTransitionProbability(s, a, s2, C[s2]);
+            for (uint k=0; k<C.size(); ++k) {
+                if (C[k].second) {
+                    mdp->setTransitionProbability(s, a, C[k].first, C[k].second);
                 }
             }
         }
@@ -212,14 +239,13 @@ void DiscreteMDPCounts::CopyMeanMDP(DiscreteMDP* mdp) const
         throw std::runtime_error("incorrect number of actions");
     }
 
+    DirichletTransitions::SparseDistribution C;
     for (int s=0; s<n_states; s++) {
         for (int a=0; a<n_actions; a++) {
-            Vector C =  transitions.getMarginal(s, a);
+            transitions.getMarginal(s, a, C);
             real expected_reward = getExpectedReward(s,a);
             mdp->reward_distribution.addFixedReward(s, a, expected_reward);
-            for (int s2=0; s2<n_states; s2++) {
-                mdp->setTransitionProbability(s, a, s2, C[s2]);
-            }
+            setTransitionRow(mdp, s, a, C);
         }
     }
     
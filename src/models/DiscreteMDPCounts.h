@@ -24,6 +24,10 @@
 #include <unordered_map>
 
 /** This implementation of an MDP model is based on transition counts.
+
+    Sampled and mean MDPs only contain the observed transitions of
+    each state-action pair, plus one entry holding the posterior mass
+    of the unobserved ones (see DirichletTransitions).
  */
 class DiscreteMDPCounts : public MDPModel
 {
@@ -49,6 +53,10 @@ protected:
         return s*n_actions + a;
     }
     Vector getDirichletParameters (int s, int a) const;
+    /// Replace a row of transition probabilities
+    void setTransitionRow(DiscreteMDP* mdp, int s, int a,
+                          const DirichletTransitions::SparseDistribution& p) const;
+    DirichletTransitions::SparseDistribution row; ///< workspace for rows
 public:
     DiscreteMDPCounts (int n_states, int n_actions, real init_transition_count= 0.5, RewardFamily reward_family=NORMAL);
     virtual ~DiscreteMDPCounts();
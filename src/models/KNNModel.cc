@@ -31,7 +31,7 @@ KNNModel::KNNModel(int n_actions_, int n_dim_, real gamma_, bool optimistic, rea
       max_samples(-1), threshold(n_actions * 10)
 {
     for (int i=0; i<n_actions; ++i) {
-        kd_tree[i] = new KDTree<TrajectorySample> (n_dim);
+        kd_tree[i] = new FlatKDTree<TrajectorySample> (n_dim);
     }
 }
 
@@ -55,15 +55,13 @@ KNNModel::~KNNModel()
 void KNNModel::AddSample(TrajectorySample sample, int K, real beta)
 {
     if (max_samples < 0 || samples.size() < (uint) max_samples) {
-        OrderedFixedList<KDNode> node_list = kd_tree[sample.a]->FindKNearestNeighbours(sample.s, K);
+        std::vector<void_FlatKDTree::Neighbour> neighbours;
+        kd_tree[sample.a]->FindKNearestNeighbours(sample.s, K, neighbours);
         RBF rbf(sample.s, beta);
-        //std::list<std::pair<real, KDNode*> >::iterator it;
-        KDTree<TrajectorySample>::iterator it;
 
         real w = 0;
-        for (it = node_list.S.begin(); it != node_list.S.end(); ++it) {
-            KDNode* node = it->second;
-            TrajectorySample* near_sample = kd_tree[sample.a]->getObject(node);
+        for (uint k=0; k<neighbours.size(); ++k) {
+            TrajectorySample* near_sample = kd_tree[sample.a]->getObject(neighbours[k].second);
             w += rbf.Evaluate(near_sample->s);
         }
         if (w < urandom()*threshold) {
@@ -104,24 +102,20 @@ void KNNModel::GetExpectedTransition(real alpha, Vector& x, int action, real& re
         y[i] = 0;
     }
 
-    OrderedFixedList<KDNode> node_list = kd_tree[action]->FindKNearestNeighbours(x, K);
-    
-    std::list<std::pair<real, KDNode*> >::iterator it;
+    std::vector<void_FlatKDTree::Neighbour> neighbours;
+    kd_tree[action]->FindKNearestNeighbours(x, K, neighbours);
     
     real sum = 0;
     Vector w(K);
-    int i=0;
-    for (it = node_list.S.begin(); it != node_list.S.end(); ++it, ++i) {
-        KDNode* node = it->second;
-        TrajectorySample* sample = kd_tree[action]->getObject(node);
+    int n = neighbours.size();
+    for (int i=0; i<n; ++i) {
+        TrajectorySample* sample = kd_tree[action]->getObject(neighbours[i].second);
         w[i] =  rbf.Evaluate(sample->s);
         sum += w[i];
     }
     w /= sum;
-    i = 0;
-    for (it = node_list.S.begin(); it != node_list.S.end(); ++it, ++i) {
-        KDNode* node = it->second;
-        TrajectorySample* sample = kd_tree[action]->getObject(node);
+    for (int i=0; i<n; ++i) {
+        TrajectorySample* sample = kd_tree[action]->getObject(neighbours[i].second);
         y += (sample->s2 + (x - sample->s)*alpha)* w[i];
         reward += sample->r * w[i];
     }
@@ -136,15 +130,13 @@ real KNNModel::GetExpectedActionValue(Vector& x, int action, int K, real b)
 {
     RBF rbf(x, b);
 
-    OrderedFixedList<KDNode> node_list = kd_tree[action]->FindKNearestNeighbours(x, K);
-    
-    std::list<std::pair<real, KDNode*> >::iterator it;
+    std::vector<void_FlatKDTree::Neighbour> neighbours;
+    kd_tree[action]->FindKNearestNeighbours(x, K, neighbours);
     
     real sum = 0;
     real Q = 0.0;
-    for (it = node_list.S.begin(); it != node_list.S.end(); ++it) {
-        KDNode* node = it->second;
-        TrajectorySample* sample = kd_tree[action]->getObject(node);
+    for (uint k=0; k<neighbours.size(); ++k) {
+        TrajectorySample* sample = kd_tree[action]->getObject(neighbours[k].second);
         real w =  rbf.Evaluate(sample->s);
         Q += sample->V * w;
         sum += w;
@@ -210,16 +202,14 @@ void KNNModel::UpdateValue(TrajectorySample& start_sample,
     Vector Q(n_actions);
 
     for (int a=0; a<n_actions; ++a) {
-        OrderedFixedList<KDNode> node_list = kd_tree[a]->FindKNearestNeighbours(start_sample.s, K);
-        
-        KDTree<TrajectorySample>::iterator it;
+        std::vector<void_FlatKDTree::Neighbour> neighbours;
+        kd_tree[a]->FindKNearestNeighbours(start_sample.s, K, neighbours);
     
         real sum = 0;
         Q[a] = 0.0;
         //printf("Action %d: ", a);
-        for (it = node_list.S.begin(); it != node_list.S.end(); ++it) {
-            KDNode* node = it->second;
-            TrajectorySample* sample = kd_tree[a]->getObject(node);
+        for (uint k=0; k<neighbours.size(); ++k) {
+            TrajectorySample* sample = kd_tree[a]->getObject(neighbours[k].second);
             Vector y = sample->s2 + (start_sample.s - sample->s) * alpha;
             real w =  rbf.Evaluate(sample->s);
             real Qa_i = (sample->r + gamma*GetExpectedValue(y, K, b));
@@ -231,7 +221,7 @@ void KNNModel::UpdateValue(TrajectorySample& start_sample,
             sum += w;
         }
         Q[a] /= sum;
-        if (node_list.S.size() == 0) {
+        if (neighbours.size() == 0) {
             Q[a] = 0.0;
         }
         //printf ("-> %f\n", Q[a]);
@@ -13,7 +13,7 @@
 #define KNN_MODEL_H
 
 #include "Vector.h"
-#include "KDTree.h"
+#include "FlatKDTree.h"
 #include <list>
 #include <vector>
 
@@ -41,7 +41,7 @@ class KNNModel
 protected:
     int n_actions; ///< The number of actions
     int n_dim; ///< The number of state dimensions
-    std::vector<KDTree<TrajectorySample>*> kd_tree; ///< One tree per action
+    std::vector<FlatKDTree<TrajectorySample>*> kd_tree; ///< One tree per action
     //RBFBasisSet basis;
     std::list<TrajectorySample> samples;
     real gamma;
@@ -0,0 +1,36 @@
+// -*- Mode: c++ -*-
+// copyright (c) 2013 by Christos Dimitrakakis <christos.dimitrakakis@gmail.com>
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "ModificationLog.h"
+#include <algorithm>
+
+std::atomic<unsigned long> ModificationLog::last_stamp(0);
+
+/** Append the rows modified after the stamp since to rows.
+
+	A row is listed once for every modification.
+
+	\return false if the log no longer lists all those modifications,
+	in which case every row must be considered modified.
+*/
+bool ModificationLog::getModifiedRows(unsigned long since, std::vector<int>& rows) const
+{
+	if (since == 0 || since + 1 < start) {
+		return false;
+	}
+	std::vector<std::pair<unsigned long, int> >::const_iterator i
+		= std::upper_bound(entries.begin(), entries.end(),
+						   std::make_pair(since, n_rows));
+	for (; i != entries.end(); ++i) {
+		rows.push_back(i->second);
+	}
+	return true;
+}
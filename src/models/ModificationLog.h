@@ -0,0 +1,80 @@
+// -*- Mode: c++ -*-
+// copyright (c) 2013 by Christos Dimitrakakis <christos.dimitrakakis@gmail.com>
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef MODIFICATION_LOG_H
+#define MODIFICATION_LOG_H
+
+#include <atomic>
+#include <utility>
+#include <vector>
+
+/** A list of the rows of a table that have been modified.
+
+	Every modification gets a stamp from a counter shared by all logs
+	and all threads, so stamps from different tables can be compared.
+	A reader remembers the last stamp it has seen and asks for the
+	rows modified since then.
+
+	The list is cleared once it has as many entries as the table has
+	rows. Readers that have not looked at the log since must then
+	check every row, which keeps that cost amortised over the
+	modifications.
+ */
+class ModificationLog
+{
+protected:
+	int n_rows; ///< number of rows in the table
+	unsigned long start; ///< all modifications stamped from start on are listed
+	std::vector<std::pair<unsigned long, int> > entries; ///< (stamp, row), by increasing stamp
+	static std::atomic<unsigned long> last_stamp; ///< global modification counter
+public:
+	ModificationLog(int n_rows_)
+		: n_rows(n_rows_), start(NewStamp())
+	{
+	}
+	/// A copy counts as modified in all rows
+	ModificationLog(const ModificationLog& rhs)
+		: n_rows(rhs.n_rows), start(NewStamp())
+	{
+	}
+	/// An assigned log counts as modified in all rows
+	ModificationLog& operator= (const ModificationLog& rhs)
+	{
+		n_rows = rhs.n_rows;
+		start = NewStamp();
+		entries.clear();
+		return *this;
+	}
+	/// Record a modification of a row and return its stamp.
+	unsigned long Modify(int row)
+	{
+		unsigned long stamp = NewStamp();
+		if ((int) entries.size() >= n_rows) {
+			entries.clear();
+			start = stamp;
+		}
+		entries.push_back(std::make_pair(stamp, row));
+		return stamp;
+	}
+	bool getModifiedRows(unsigned long since, std::vector<int>& rows) const;
+	/// Generate a stamp later than any other previously given out.
+	static unsigned long NewStamp()
+	{
+		return last_stamp.fetch_add(1) + 1;
+	}
+	/// The most recent stamp given out to any table.
+	static unsigned long getLastStamp()
+	{
+		return last_stamp.load();
+	}
+};
+
+#endif
@@ -65,7 +65,8 @@ DiscreteSpaceRewardDistribution::DiscreteSpaceRewardDistribution(int n_states_,
     : n_states(n_states_),
       n_actions(n_actions_),
 	  R(n_states * n_actions),
-	  ER(n_states * n_actions) 
+	  ER(n_states * n_actions),
+	  modifications(n_states * n_actions)
 {
     // empty
 	for (uint i=0; i<R.size(); ++i) {
@@ -77,6 +78,7 @@ DiscreteSpaceRewardDistribution::DiscreteSpaceRewardDistribution(int n_states_,
 
 /// Copy constructor. Do not actually copy anything!
 DiscreteSpaceRewardDistribution::DiscreteSpaceRewardDistribution(const DiscreteSpaceRewardDistribution& rhs)
+	: modifications(rhs.modifications)
 {
 	n_states = rhs.n_states;
 	n_actions = rhs.n_actions;
@@ -90,6 +92,7 @@ DiscreteSpaceRewardDistribution& DiscreteSpaceRewardDistribution::operator= (con
 	n_states = rhs.n_states;
 	n_actions = rhs.n_actions;
 	ER = rhs.ER;
+	modifications = rhs.modifications;
 	return *this;
 }
 
@@ -152,6 +155,7 @@ void DiscreteSpaceRewardDistribution::setRewardDistribution(int s, int a, Distri
 	int ID = getID (s, a);
 	R[ID] = reward;
 	ER(ID) = reward->getMean();
+	modifications.Modify(ID);
 }
 
 // only use this function once per state-action pair
@@ -162,6 +166,7 @@ void DiscreteSpaceRewardDistribution::addRewardDistribution(int s, int a, Distri
 	distribution_vector.push_back(reward);
 	R[ID] = reward;
 	ER(ID) = reward->getMean();
+	modifications.Modify(ID);
 }
 // only use this function once per state-action pair
 void DiscreteSpaceRewardDistribution::addFixedReward(int s, int a, real reward)
@@ -183,7 +188,8 @@ void DiscreteSpaceRewardDistribution::setFixedReward(int s, int a, real reward)
 		addRewardDistribution(s, a, distribution);
 		ER[ID] = reward;
 	}
-	
+	modifications.Modify(ID);
+
 }
 
 void DiscreteSpaceRewardDistribution::Show()
@@ -13,6 +13,7 @@
 #define REWARD_DISTRIBUTION_H
 
 #include "Vector.h"
+#include "ModificationLog.h"
 #include "real.h"
 #include <vector>
 
@@ -59,6 +60,7 @@ protected:
     std::vector<Distribution*> R; ///< reward distribution
 	std::vector<Distribution*> distribution_vector; ///< for malloc
 	Vector ER; ///< expected reward
+	ModificationLog modifications; ///< rows whose reward was set recently
     inline int getID (int s, int a) const
     {
         assert(s>=0 && s<n_states);
@@ -83,6 +85,11 @@ public:
     {
         return ER;
     }
+    /// The state-action pairs whose reward was set recently
+    const ModificationLog& getModifications() const
+    {
+        return modifications;
+    }
 };
 
 
@@ -12,6 +12,31 @@
 #include "TransitionDistribution.h"
 #include "Random.h"
 
+/// Copy constructor. All rows are marked as modified.
+DiscreteTransitionDistribution::TransitionDistribution(const DiscreteTransitionDistribution& rhs)
+	: n_states(rhs.n_states),
+	  n_actions(rhs.n_actions),
+	  P(rhs.P),
+	  next_states(rhs.next_states),
+	  row_stamp(rhs.row_stamp.size(), NewStamp()),
+	  modifications(rhs.modifications)
+{
+}
+
+/// Assignment. All rows are marked as modified.
+DiscreteTransitionDistribution& DiscreteTransitionDistribution::operator= (const DiscreteTransitionDistribution& rhs)
+{
+	if (this != &rhs) {
+		n_states = rhs.n_states;
+		n_actions = rhs.n_actions;
+		P = rhs.P;
+		next_states = rhs.next_states;
+		row_stamp.assign(rhs.row_stamp.size(), NewStamp());
+		modifications = rhs.modifications;
+	}
+	return *this;
+}
+
 DiscreteTransitionDistribution::~TransitionDistribution()
 {
 	int n_pairs = 0;
@@ -36,6 +61,8 @@ void DiscreteTransitionDistribution::SetTransition(int state,
 													real probability)
 {	
 	assert(probability >= 0 && probability <= 1);
+	assert(action >= 0 && action < n_actions);
+	row_stamp[state * n_actions + action] = modifications.Modify(state * n_actions + action);
 	DiscreteTransition transition = DiscreteTransition(state, action, next_state);
 	if (probability > 0) {
 		P[transition] = probability;
@@ -48,8 +75,7 @@ void DiscreteTransitionDistribution::SetTransition(int state,
 		DiscreteStateAction SA(state, action);
 		auto got = next_states.find(SA);
 		if (got != next_states.end()) {
-			DiscreteStateSet states = got->second;
-			states.erase(next_state);
+			got->second.erase(next_state);
 		}
 	}
 }
@@ -16,10 +16,13 @@
 #include "DiscreteStateSet.h"
 #include "StateAction.h"
 #include "HashCombine.h"
+#include "ModificationLog.h"
 #include "debug.h"
+#include <cassert>
 #include <cstdio>
 #include <map>
 #include <unordered_map>
+#include <vector>
 
 template <typename StateType, typename ActionType>
 class TransitionDistribution
@@ -78,6 +81,12 @@ namespace std
 /** Discrete transition distribution.
 
 	In this model, we employ an unorder map of actual transitions, as well as a map of next states.
+
+	Every (state, action) row also carries a modification stamp, taken
+	from the counter shared by all modification logs, and the rows
+	modified recently are listed in a ModificationLog. Compiled views
+	of the distribution (see CompiledDiscreteMDP) use them to find out
+	which rows have changed since they were last built.
  */
 template<>
 class TransitionDistribution<int, int>
@@ -91,9 +100,13 @@ public:
 	std::unordered_map<DiscreteStateAction, DiscreteStateSet> next_states; ///< next states for quick access
 	TransitionDistribution(int n_states_, int n_actions_)
 		: n_states(n_states_),
-		  n_actions(n_actions_)
+		  n_actions(n_actions_),
+		  row_stamp(n_states_ * n_actions_, NewStamp()),
+		  modifications(n_states_ * n_actions_)
 	{
 	}
+	TransitionDistribution(const TransitionDistribution<int, int>& rhs);
+	TransitionDistribution<int, int>& operator= (const TransitionDistribution<int, int>& rhs);
 	
 	virtual ~TransitionDistribution();
 
@@ -130,6 +143,32 @@ public:
 		}
 	}
 
+	/// Stamp of the last modification of the (state, action) row.
+	unsigned long getRowStamp(int state, int action) const
+	{
+		assert(state >= 0 && state < n_states);
+		assert(action >= 0 && action < n_actions);
+		return row_stamp[state * n_actions + action];
+	}
+
+	/// The rows modified recently
+	const ModificationLog& getModifications() const
+	{
+		return modifications;
+	}
+	/// The most recent stamp given out to any discrete distribution.
+	static unsigned long getLastStamp()
+	{
+		return ModificationLog::getLastStamp();
+	}
+protected:
+	std::vector<unsigned long> row_stamp; ///< modification stamp of each row
+	ModificationLog modifications; ///< rows modified recently
+	/// Generate a stamp later than any other previously given out.
+	static unsigned long NewStamp()
+	{
+		return ModificationLog::NewStamp();
+	}
 };
 
 typedef TransitionDistribution<int, int> DiscreteTransitionDistribution;
@@ -0,0 +1,170 @@
+// -*- Mode: c++ -*-
+// copyright (c) 2013 by Christos Dimitrakakis <christos.dimitrakakis@gmail.com>
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifdef MAKE_MAIN
+
+#include "CompiledDiscreteMDP.h"
+#include "DiscreteMDP.h"
+#include "Random.h"
+#include "EasyClock.h"
+#include "real.h"
+#include <cmath>
+
+/// Set random transitions to at most n_next states for (s, a)
+void SetRandomRow(DiscreteMDP& mdp, int s, int a, int n_next)
+{
+	int n_states = mdp.getNStates();
+	for (int s2=0; s2<n_states; ++s2) {
+		mdp.setTransitionProbability(s, a, s2, 0.0);
+	}
+	Vector p(n_states);
+	for (int k=0; k<n_next; ++k) {
+		p(urandom(0, n_states)) += urandom();
+	}
+	p /= p.Sum();
+	for (int s2=0; s2<n_states; ++s2) {
+		if (p(s2) > 0) {
+			mdp.setTransitionProbability(s, a, s2, p(s2));
+		}
+	}
+}
+
+/// Check that the snapshot agrees with the MDP
+int CheckModel(const DiscreteMDP& mdp, const CompiledDiscreteMDP& model)
+{
+	int n_errors = 0;
+	int n_states = mdp.getNStates();
+	int n_actions = mdp.getNActions();
+	for (int s=0; s<n_states; ++s) {
+		for (int a=0; a<n_actions; ++a) {
+			Vector P(n_states);
+			for (int k=model.RowBegin(s, a); k<model.RowEnd(s, a); ++k) {
+				P(model.next_state[k]) = model.probability[k];
+			}
+			for (int s2=0; s2<n_states; ++s2) {
+				if (P(s2) != mdp.getTransitionProbability(s, a, s2)) {
+					n_errors++;
+				}
+			}
+			if (model.getExpectedReward(s, a) != mdp.getExpectedReward(s, a)) {
+				n_errors++;
+			}
+		}
+	}
+	return n_errors;
+}
+
+int main()
+{
+	int n_states = 50;
+	int n_actions = 4;
+	int n_errors = 0;
+	DiscreteMDP mdp(n_states, n_actions);
+	for (int s=0; s<n_states; ++s) {
+		for (int a=0; a<n_actions; ++a) {
+			SetRandomRow(mdp, s, a, 3);
+			mdp.setFixedReward(s, a, urandom());
+		}
+	}
+
+	CompiledDiscreteMDP model(&mdp);
+	printf("%d transitions compiled\n", model.getNTransitions());
+	n_errors += CheckModel(mdp, model);
+
+	int n_compiled = model.Update();
+	printf("%d rows recompiled without changes\n", n_compiled);
+	if (n_compiled) {
+		n_errors++;
+	}
+
+	// rows keeping the same support are overwritten in place
+	for (int a=0; a<n_actions; ++a) {
+		int s = urandom(0, n_states);
+		for (int k=model.RowBegin(s, a); k<model.RowEnd(s, a); ++k) {
+			int s2 = model.next_state[k];
+			mdp.setTransitionProbability(s, a, s2, model.probability[k]);
+		}
+	}
+	n_compiled = model.Update();
+	printf("%d rows recompiled after same-size change\n", n_compiled);
+	n_errors += CheckModel(mdp, model);
+
+	// rows changing size require splicing
+	for (int i=0; i<10; ++i) {
+		SetRandomRow(mdp, urandom(0, n_states), urandom(0, n_actions), 1 + i);
+	}
+	mdp.setFixedReward(0, 0, -1.0);
+	n_compiled = model.Update();
+	printf("%d rows recompiled after resizing change\n", n_compiled);
+	n_errors += CheckModel(mdp, model);
+
+	// a copy of the MDP must be compiled from scratch
+	DiscreteMDP mdp_copy(mdp);
+	model.setMDP(&mdp_copy);
+	n_compiled = model.Update();
+	printf("%d rows recompiled for a copy\n", n_compiled);
+	n_errors += CheckModel(mdp_copy, model);
+
+	// a reward change only touches its own row
+	model.setMDP(&mdp);
+	model.Update();
+	mdp.setFixedReward(3, 1, 5.0);
+	n_compiled = model.Update();
+	if (n_compiled || model.changed_rows.size() != 1
+		|| model.changed_rows[0] != model.getID(3, 1)) {
+		n_errors++;
+	}
+	n_errors += CheckModel(mdp, model);
+
+	// the cost of an update does not grow with the MDP
+	int n_large = 20000;
+	DiscreteMDP large(n_large, n_actions);
+	for (int s=0; s<n_large; ++s) {
+		for (int a=0; a<n_actions; ++a) {
+			large.setTransitionProbability(s, a, s, 0.5);
+			large.setTransitionProbability(s, a, (s + a + 1) % n_large, 0.5);
+		}
+	}
+	CompiledDiscreteMDP large_model(&large);
+	int n_updates = 1000;
+	int n_changed = 0;
+	double start_time = GetCPU();
+	for (int t=0; t<n_updates; ++t) {
+		int s = urandom(0, n_large);
+		int a = urandom(0, n_actions);
+		real p = urandom();
+		large.setTransitionProbability(s, a, s, p);
+		large.setTransitionProbability(s, a, (s + a + 1) % n_large, 1 - p);
+		large.setFixedReward(s, a, p);
+		large_model.Update();
+		n_changed += large_model.changed_rows.size();
+		int k = large_model.RowBegin(s, a);
+		real sum = large_model.probability[k] + large_model.probability[k + 1];
+		if (large_model.getExpectedReward(s, a) != p || fabs(sum - 1) > 1e-12) {
+			n_errors++;
+		}
+	}
+	double end_time = GetCPU();
+	printf("%d single-row updates of %d rows: %f s, %d rows changed\n",
+		   n_updates, n_large * n_actions, end_time - start_time, n_changed);
+	if (n_changed > n_updates) {
+		n_errors++;
+	}
+
+	if (n_errors) {
+		printf("%d errors\n", n_errors);
+		return -1;
+	}
+	printf("OK\n");
+	return 0;
+}
+
+#endif
@@ -0,0 +1,170 @@
+// -*- Mode: c++ -*-
+// copyright (c) 2013 by Christos Dimitrakakis <christos.dimitrakakis@gmail.com>
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifdef MAKE_MAIN
+
+#include "DirichletTransitions.h"
+#include "DiscreteMDPCounts.h"
+#include "DiscreteMDP.h"
+#include "Random.h"
+#include "EasyClock.h"
+#include "real.h"
+#include <cmath>
+
+typedef DirichletTransitions::SparseDistribution SparseDistribution;
+
+/// Each state-action pair goes to one of a few successors
+int Successor(int s, int a, int n_states)
+{
+	return (s * 7 + a * 13 + urandom(0, 3)) % n_states;
+}
+
+/// Check the sparse marginal against the dense one
+int CheckMarginal(const DirichletTransitions& transitions, int s, int a)
+{
+	int n_errors = 0;
+	Vector P = transitions.getMarginal(s, a);
+	SparseDistribution p;
+	transitions.getMarginal(s, a, p);
+	real sum = 0;
+	real lumped = 1;
+	for (uint k=0; k<p.size(); ++k) {
+		int s2 = p[k].first;
+		sum += p[k].second;
+		if (s2 != s && fabs(p[k].second - P(s2)) > 1e-12) {
+			n_errors++;
+		}
+		if (s2 != s) {
+			lumped -= P(s2);
+		}
+		if (fabs(transitions.marginal_pdf(s, a, s2) - P(s2)) > 1e-12) {
+			n_errors++;
+		}
+	}
+	if (fabs(sum - 1) > 1e-9) {
+		n_errors++;
+	}
+	// the current state holds all the remaining mass
+	for (uint k=0; k<p.size(); ++k) {
+		if (p[k].first == s && fabs(p[k].second - lumped) > 1e-9) {
+			n_errors++;
+		}
+	}
+	return n_errors;
+}
+
+int main()
+{
+	int n_errors = 0;
+	int n_states = 200;
+	int n_actions = 2;
+
+	DirichletTransitions transitions(n_states, n_actions, 0.5);
+	for (int t=0; t<5000; ++t) {
+		int s = urandom(0, n_states / 2);
+		int a = urandom(0, n_actions);
+		transitions.Observe(s, a, Successor(s, a, n_states));
+	}
+	for (int s=0; s<n_states; ++s) {
+		for (int a=0; a<n_actions; ++a) {
+			n_errors += CheckMarginal(transitions, s, a);
+		}
+	}
+	printf("Marginals: %d errors\n", n_errors);
+
+	// the mean of the sparse samples is the posterior mean
+	int s = 0;
+	int a = 1;
+	int n_samples = 20000;
+	Vector mean(n_states);
+	SparseDistribution p;
+	for (int k=0; k<n_samples; ++k) {
+		transitions.generate(s, a, p);
+		real sum = 0;
+		for (uint i=0; i<p.size(); ++i) {
+			mean(p[i].first) += p[i].second / (real) n_samples;
+			sum += p[i].second;
+		}
+		if (fabs(sum - 1) > 1e-9) {
+			n_errors++;
+		}
+	}
+	Vector P = transitions.getMarginal(s, a);
+	real error = 0;
+	real unobserved_mean = 0;
+	real unobserved_P = 0;
+	for (int s2=0; s2<n_states; ++s2) {
+		if (transitions.P[DiscreteStateAction(s, a)].find(s2) >= 0) {
+			error = std::max(error, fabs(mean(s2) - P(s2)));
+		} else {
+			unobserved_mean += mean(s2);
+			unobserved_P += P(s2);
+		}
+	}
+	printf("Samples: error %f, unobserved mass %f vs %f\n",
+		   error, unobserved_mean, unobserved_P);
+	if (error > 0.01 || fabs(unobserved_mean - unobserved_P) > 0.01) {
+		n_errors++;
+	}
+
+	// sampled and mean MDPs only hold the observed transitions
+	int n_large = 2000;
+	DiscreteMDPCounts model(n_large, n_actions);
+	for (int t=0; t<20000; ++t) {
+		int s = urandom(0, n_large);
+		int a = urandom(0, n_actions);
+		model.AddTransition(s, a, urandom(), Successor(s, a, n_large));
+	}
+	double start_time = GetCPU();
+	DiscreteMDP* sample = model.generate();
+	double end_time = GetCPU();
+	DiscreteMDP mean_mdp(n_large, n_actions, NULL);
+	for (int a=0; a<n_actions; ++a) {
+		// stale entries must be removed
+		mean_mdp.setTransitionProbability(1, a, 5, 0.5);
+	}
+	model.CopyMeanMDP(&mean_mdp);
+	int n_transitions = 0;
+	for (int s=0; s<n_large; ++s) {
+		for (int a=0; a<n_actions; ++a) {
+			int n_next = (int) mean_mdp.getNextStates(s, a).size();
+			n_transitions += n_next;
+			if (n_next > 4 || (int) sample->getNextStates(s, a).size() > 4) {
+				n_errors++;
+			}
+			// the internal mean MDP leaves unvisited pairs empty
+			if (model.getNVisits(s, a)
+				&& (int) model.getMeanMDP()->getNextStates(s, a).size() != n_next) {
+				n_errors++;
+			}
+			real sum = 0;
+			const DiscreteStateSet& next = mean_mdp.getNextStates(s, a);
+			for (DiscreteStateSet::const_iterator i = next.begin(); i != next.end(); ++i) {
+				sum += mean_mdp.getTransitionProbability(s, a, *i);
+			}
+			if (fabs(sum - 1) > 1e-9) {
+				n_errors++;
+			}
+		}
+	}
+	printf("%d states: sampled in %f s, %d mean transitions\n",
+		   n_large, end_time - start_time, n_transitions);
+	delete sample;
+
+	if (n_errors) {
+		printf("%d errors\n", n_errors);
+		return -1;
+	}
+	printf("OK\n");
+	return 0;
+}
+
+#endif
@@ -96,6 +96,15 @@ real BetaDistribution::generate() const
     return genbet(alpha, beta);
 }
 
+/// Generate as a ratio of gamma variates, using the given generator
+real BetaDistribution::generate(RandomNumberGenerator& rng) const
+{
+	assert(alpha > 0 && beta > 0);
+    real x = rng.gamma(alpha);
+    real y = rng.gamma(beta);
+    return x / (x + y);
+}
+
 /// Generate using ranlib
 real BetaDistribution::generateMarginal() 
 {
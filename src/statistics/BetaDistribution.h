@@ -58,6 +58,7 @@ public:
     virtual real getVariance(); 
     virtual real generate();
 	real generate() const;
+	real generate(RandomNumberGenerator& rng) const;
     virtual real generateMarginal();
     real Observe(real x);
     real setMaximumLikelihoodParameters(const std::vector<real>& x,
@@ -42,7 +42,7 @@ ConditionalKDContextTree::Node::Node(ConditionalKDContextTree& tree_,
 #endif
 
 
-	local_density = new ContextTreeKDTree(tree.n_branches, tree.max_depth_cond, tree.lower_bound_y, tree.upper_bound_y);
+	local_density = new ContextTreeKDTree(tree.n_branches, tree.max_depth_cond, tree.lower_bound_y, tree.upper_bound_y, tree.node_budget);
     int y_dim = tree.upper_bound_y.Size();
 	normal_density = new MultivariateNormalUnknownMeanPrecision((tree.upper_bound_y + tree.lower_bound_y)*0.5 , 1.0, 1.0, Matrix::Unity(y_dim, y_dim));
     prior_normal = DEFAULT_PRIOR_NORMAL;
@@ -84,21 +84,19 @@ ConditionalKDContextTree::Node::Node(ConditionalKDContextTree::Node* prev_,
 	local_density = new ContextTreeKDTree(tree.n_branches,
 										  tree.max_depth_cond,
 										  tree.lower_bound_y,
-										  tree.upper_bound_y);
+										  tree.upper_bound_y,
+										  tree.node_budget);
     int y_dim = tree.upper_bound_y.Size();
 	normal_density = new MultivariateNormalUnknownMeanPrecision((tree.upper_bound_y + tree.lower_bound_y)*0.5 , 1.0, 1.0, Matrix::Unity(y_dim, y_dim));
     prior_normal = DEFAULT_PRIOR_NORMAL;
     log_prior_normal = log(prior_normal);
 }
 
-/// make sure to kill all
+/// The children are owned by the tree's node pool
 ConditionalKDContextTree::Node::~Node()
 {
 	delete local_density;
     delete normal_density;
-    for (int i=0; i<tree.n_branches; ++i) {
-        delete next[i];
-    }
 }
 
 /** Observe new data, adapt parameters.
@@ -149,16 +147,17 @@ real ConditionalKDContextTree::Node::Observe(Vector& x, Vector& y, real probabil
               << std::endl;
 #endif
 	// Do a forward mixture if there is another node available.
-    if ((tree.max_depth==0 || depth < tree.max_depth) && S >  threshold) {
+    if ((tree.max_depth==0 || depth < tree.max_depth) && S >  threshold
+        && (next[k] || tree.CanSplit())) {
         if (!next[k]) {
             if (k == 0) {
 				Vector new_bound_x = upper_bound_x;
 				new_bound_x(splitting_dimension) = mid_point;
-                next[k] = new Node(this, lower_bound_x, new_bound_x);
+                next[k] = tree.nodes.New(this, lower_bound_x, new_bound_x);
             } else {
 				Vector new_bound_x = lower_bound_x;
 				new_bound_x(splitting_dimension) = mid_point;
-                next[k] = new Node(this, new_bound_x, upper_bound_x);
+                next[k] = tree.nodes.New(this, new_bound_x, upper_bound_x);
             }
         }
 		total_probability = next[k]->Observe(x, y, total_probability);
@@ -239,19 +238,21 @@ ConditionalKDContextTree::ConditionalKDContextTree(int n_branches_,
 												   Vector& lower_bound_x,
 												   Vector& upper_bound_x,
 												   Vector& lower_bound_y_,
-												   Vector& upper_bound_y_)
+												   Vector& upper_bound_y_,
+												   int node_budget_)
     : n_branches(n_branches_),
       max_depth(max_depth_),
       max_depth_cond(max_depth_cond_),
 	  lower_bound_y(lower_bound_y_),
-	  upper_bound_y(upper_bound_y_)
+	  upper_bound_y(upper_bound_y_),
+	  node_budget(node_budget_)
 {
-    root = new Node(*this, lower_bound_x, upper_bound_x);
+    root = nodes.New(*this, lower_bound_x, upper_bound_x);
 }
 
 ConditionalKDContextTree::~ConditionalKDContextTree()
 {
-    delete root;
+    nodes.Clear();
 }
 
 /** Obtain \f$\xi_t(y \mid x)\f$ and calculate \f$\xi_{t+1}(w) = \xi_t(w \mid x, y)\f$.
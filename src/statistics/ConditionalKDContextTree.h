@@ -19,6 +19,7 @@
 #include "ContextTreeKDTree.h"
 #include "MultivariateNormal.h"
 #include "MultivariateNormalUnknownMeanPrecision.h"
+#include "Arena.h"
 
 
 /** Context tree non-parametric conditional density estimation on \f$R^n \times R^m\f$.
@@ -43,6 +44,10 @@
 
 	The model can also be used for estimating conditional densities, directly.
 	However, this is perhaps not a good idea. 
+
+    Nodes are allocated from a pool owned by the tree. With a node
+    budget, the tree stops splitting once the budget is reached, and
+    the local density of each node is limited to as many nodes.
  */
 class ConditionalKDContextTree
 {
@@ -83,7 +88,8 @@ public:
                              int max_depth_,
                              int max_depth_cond_,
 							 Vector& lower_bound_x, Vector& upper_bound_x,
-							 Vector& lower_bound_y, Vector& upper_bound_y);
+							 Vector& lower_bound_y, Vector& upper_bound_y,
+                             int node_budget_ = 0);
     ~ConditionalKDContextTree();
     real Observe(Vector& x, Vector& y);
     real pdf(Vector& x, Vector& y);
@@ -95,7 +101,14 @@ protected:
     int max_depth_cond;
 	Vector lower_bound_y;
 	Vector upper_bound_y;
+    int node_budget; ///< maximum number of nodes, 0 for no limit
+    ObjectPool<Node> nodes; ///< storage for the nodes
     Node* root;
+    /// Whether another node may be created
+    bool CanSplit() const
+    {
+        return !node_budget || nodes.Size() < node_budget;
+    }
 };
 
 
@@ -14,245 +14,99 @@
 //#define DEFAULT_PRIOR (1.0 / sqrt((real) n_outcomes))
 #define DEFAULT_PRIOR (1.0 / (real) n_outcomes)
 
-ContextTree::Node::Node(int n_branches_,
-						int n_outcomes_)
-	: N_obs(0),
-      n_branches(n_branches_),
-	  n_outcomes(n_outcomes_),
-	  depth(0),
-	  prev(NULL),
-	  next(n_branches),
-	  P(n_outcomes), alpha(n_outcomes), prior_alpha(DEFAULT_PRIOR),
-      w(1), log_w(0), log_w_prior(0)
-{
-	for (int i=0; i<n_outcomes; ++i) {
-		P(i) = 1.0 / (real) n_outcomes;
-		alpha(i) = 0;
-	}
-}
-
-/// Make a node for K symbols at nominal depth d
-ContextTree::Node::Node(ContextTree::Node* prev_)
-	: N_obs(0),
-      n_branches(prev_->n_branches),
-	  n_outcomes(prev_->n_outcomes),
-	  depth(prev_->depth + 1),
-	  prev(prev_),
-	  next(n_branches),
-	  P(n_outcomes),
-	  alpha(n_outcomes),
-	  prior_alpha(DEFAULT_PRIOR),
-	  log_w(0),
-	  log_w_prior(prev_->log_w_prior - log(2))
-	  //log_w_prior( - log(10))
-{
-    w = exp(log_w_prior);
-	for (int i=0; i<n_branches; ++i) {
-		next[i] = NULL;
-	}
-	for (int i=0; i<n_outcomes; ++i) {
-		P(i) = 1.0 / (real) n_outcomes;
-		alpha(i) = 0;
-	}
-
-}
-
-/// make sure to kill all
-ContextTree::Node::~Node()
-{
-	for (int i=0; i<n_branches; ++i) {
-		delete next[i];
-	}
-}
-
-real ContextTree::Node::Observe(Ring<int>& history,
-								Ring<int>::iterator x,
-								int y,
-								real probability)
-{
-	real total_probability = 0;
-	// calculate probabilities
-
-    // Standard
-#if 0
-    real S = (real) N_obs; //xalpha.Sum();
-    real Z = 1.0 / (prior_alpha * (real) n_outcomes + S);
-    P = (alpha + prior_alpha) * Z;
-    
-    //printf("%f\n", P.Sum());//P.print(stdout);
-    //P /= P.Sum();
-    //P[y] = (alpha[y] + prior_alpha) * Z;
-#endif
-
-
-#if 0
-    // P-BVMM
-    // use a modified PPM -- best for many outcomes
-    real S = alpha.Sum(); // total number of observations
-    real Z = 0; // total prior mass for observed values
-    int zeros = 0; // number of unobserved values
-    for (int i=0; i<n_outcomes; ++i) {
-        if (alpha(i) > 0) {
-            Z += prior_alpha; 
-        } else {
-            zeros++;
-        }
-    }
-    if (zeros == n_outcomes) {
-        // case 1: observed nothing yet
-        for (int i=0; i<n_outcomes; ++i) {
-            if (alpha(i) == 0) {
-                P(i) = 1.0 / (real) n_outcomes;
-            }
-        }
-    } else {
-        // case 2: observed some things
-        real iSZ = 1.0 / (S + Z); // S + Z is the total alpha for observed values
-        P = (alpha) * iSZ; // Pr of seeing the i-th symbol if you know you are going to see a previsouly seen symbol
-        
-        real P_rest = 1.0 - P.Sum(); // Remaining mass
-        
-        if (zeros > 0) {
-            for (int i=0; i<n_outcomes; ++i) {
-                if (alpha(i) == 0) {
-                    P(i) = P_rest / (real) zeros;
-                }
-            }
-        }
-         P /= P.Sum();
-    }
-#endif
-
-
-#if 1
-    // aka: I-BVMM -- best for many outcomes
-    real S = alpha.Sum(); // = N_obs
-    real N = 0; // N is the number of symbols
-    for (int i=0; i<n_outcomes; ++i) {
-        if (alpha(i)) {
-            N += 1;
-        }
-    }
-    real Z = (1 + N) * prior_alpha + S; // total dirichlet mass
-    P = (alpha + prior_alpha) / Z;
-    real n_zero_outcomes = n_outcomes - N;
-    if (n_zero_outcomes > 0) {
-        real SA = 1.0 / n_zero_outcomes;
-        for (int i=0; i<n_outcomes; ++i) {
-            if (alpha(i)==0) {
-                P(i) *= SA;
-            }
-        }
-    }
-#endif
-	alpha[y]++;
-    // P(y | B_k) = P(y | B_k, h_k) P(h_k | B_k) + (1 - P(h_k | B_k)) P(y | B_{k-1})
-    w = exp(log_w_prior + log_w); 
-
-
-    total_probability = P[y] * w + (1 - w) * probability;
-#if 0
-    std::cout << depth << ": P(y|h_k)=" << P[y] 
-              << ", P(h_k|B_k)=" << w 
-              << ", P(y|B_{k-1})="<< probability
-              << ", P(y|B_k)=" << total_probability
-              << std::endl;
-#endif
-    //real posterior = w * P[y] / total_probability; // real posterior
-    //real posterior = w; // fake posterior
-    //real log_posterior = log(w) + log(P[y]) - log(total_probability);
-    //log_w = log(posterior) - log_w_prior;
-    log_w = log(w * P[y] /total_probability) - log_w_prior;
-
-    // This sometimes doesn't work
-    //log_w = log_w + log(P[y]) - log(total_probability);
-
-    // Make sure we have enough observations to justify adding a
-    // node. This means at least as many as total outcomes.
-    //real threshold = (real) n_outcomes; 
-
-    // Go deeper when there has been at least one observations
-    // node. 
-    real threshold = pow(3,(real) depth); 
-    //real threshold = sqrt((real) depth);//2;
-    //real threshold = log((real) depth);//2;
-    
-    // Always go deepr, no matter what
-    //real threshold = 0; 
-    
-    // Go deeper if the context is long enough and the number of
-    // observations justifies it.
-	if (x != history.end() && S >  threshold) {
-		int k = *x;
-		++x;
-		if (!next[k]) {
-			next[k] = new Node(this);
-		}
-		total_probability = next[k]->Observe(history, x, y, total_probability);
-	}
-
-    N_obs++;
-
-	return total_probability;
-}
-
-
-void ContextTree::Node::Show()
-{
-	
-    std::cout << w << " " << depth << "# weight depth\n";
-	for (int i=0; i<n_outcomes; ++i) {
-		std::cout << alpha[i] << " ";
-	}
-	for (int k=0; k<n_branches; ++k) {
-		if (next[k]) {
-			std::cout << "b: " << k << std::endl;
-			next[k]->Show();
-		}
-	}
-	std::cout << "<<<<\n";
-}
-
-int ContextTree::Node::NChildren()
-{
-	int my_children = 0;
-	for (int k=0; k<n_branches; ++k) {
-		if (next[k]) {
-			my_children++;
-			my_children += next[k]->NChildren();
-		}
-	}
-	return my_children;
-}
-
-ContextTree::ContextTree(int n_branches_, int n_symbols_, int max_depth_)
+ContextTree::ContextTree(int n_branches_, int n_symbols_, int max_depth_, int node_budget)
 	: n_branches(n_branches_),
 	  n_symbols(n_symbols_),
 	  max_depth(max_depth_),
+	  log_w_prior(max_depth + 1),
+	  store(n_branches, n_symbols, max_depth, node_budget),
 	  history(max_depth)
 {
-	root = new Node(n_branches, n_symbols);
+	int n_outcomes = n_symbols;
+	prior_alpha = DEFAULT_PRIOR;
+	log_w_prior[0] = 0;
+	for (int d=1; d<=max_depth; ++d) {
+		log_w_prior[d] = log_w_prior[d - 1] - log(2);
+	}
 }
 
 ContextTree::~ContextTree()
 {
     Show();
-	delete root;
 }
 
+/** Observe a new symbol.
+
+	Walks down the current context, from the root, mixing the
+	prediction of each node with that of its ancestors and updating
+	the node statistics. Nodes are created when their parent has been
+	visited often enough.
+
+	@param x the next context symbol
+	@param y the next outcome
+	@return the probability of y
+ */
 real ContextTree::Observe(int x, int y)
 {
     history.push_back(x);
-	return root->Observe(history, history.begin(), y, 0);
+	store.Advance();
+
+	real probability = 0;
+	Ring<int>::iterator h = history.begin();
+	int i = store.Root();
+	for (int depth = 0; ; ++depth) {
+		store.Touch(depth, i);
+		real* alpha = store.Counts(depth, i);
+
+		// aka: I-BVMM -- best for many outcomes
+		real S = 0; // = N_obs
+		real N = 0; // N is the number of symbols
+		for (int j=0; j<n_symbols; ++j) {
+			S += alpha[j];
+			if (alpha[j]) {
+				N += 1;
+			}
+		}
+		real Z = (1 + N) * prior_alpha + S; // total dirichlet mass
+		real P_y = (alpha[y] + prior_alpha) * (1.0 / Z);
+		real n_zero_outcomes = n_symbols - N;
+		if (n_zero_outcomes > 0 && alpha[y] == 0) {
+			P_y *= 1.0 / n_zero_outcomes;
+		}
+		alpha[y]++;
+
+		// P(y | B_k) = P(y | B_k, h_k) P(h_k | B_k) + (1 - P(h_k | B_k)) P(y | B_{k-1})
+		real& log_w = store.LogWeight(depth, i);
+		real w = exp(log_w_prior[depth] + log_w);
+		real total_probability = P_y * w + (1 - w) * probability;
+		log_w = log(w * P_y / total_probability) - log_w_prior[depth];
+		store.Observations(depth, i)++;
+		probability = total_probability;
+
+		// Go deeper if the context is long enough and the number of
+		// observations justifies it.
+		real threshold = pow(3, (real) depth);
+		if (h == history.end() || S <= threshold) {
+			break;
+		}
+		int k = *h;
+		++h;
+		int next = store.Child(depth, i, k);
+		if (next < 0) {
+			next = store.AddChild(depth, i, k);
+		}
+		i = next;
+	}
+	return probability;
 }
 
 void ContextTree::Show()
 {
-    //root->Show();
 	std::cout << "Total contexts: " << NChildren() << std::endl;
 }
 
+/// The number of contexts, other than the root
 int ContextTree::NChildren()
 {
-	return root->NChildren();
+	return store.Size() - 1;
 }
@@ -16,6 +16,7 @@
 #include "real.h"
 #include "Vector.h"
 #include "Ring.h"
+#include "ContextTreeStore.h"
 
 
 /** An Bayesian variable order Markov model implemented as a context tree.
@@ -23,48 +24,35 @@
     This is a dynamically-updated model, usable online. From the paper:
     "Bayesian Variable Order Markov Models",
     C. Dimitrakakis, AI-STATS 2010.
+
+    The nodes are kept in a ContextTreeStore. With a node budget,
+    memory stays bounded on arbitrarily long sequences.
 */
 class ContextTree
 {
 public:
-	// public classes
-	struct Node
-	{
-        int N_obs; ///< total number of observations
-        int n_branches; ///< The number of symbols we condition on
-        int n_outcomes; ///< The number of symbols to predict
-        int depth; ///< depth
-        Node* prev; ///< previous node
-        std::vector<Node*> next; ///< pointers to next nodes
-		Vector P; ///< probability of next symbols
-		Vector alpha; ///< parameters of next symbols
-        const real prior_alpha; ///< implicit prior value of alpha
-        real w; ///< backoff weight
-        real log_w; ///< log of w
-        real log_w_prior; ///< initial value
-		Node(int n_branches_,
-			 int n_outcomes_);
-		Node(Node* prev_);
-		~Node();
-		real Observe(Ring<int>& history,
-					 Ring<int>::iterator x,
-					 int y,
-					 real probability);
-		void Show();
-		int NChildren();	
-	};
-	
 	// public methods
-	ContextTree(int n_branches_, int n_symbols_, int max_depth_= 0);
+	ContextTree(int n_branches_, int n_symbols_, int max_depth_= 0, int node_budget = 0);
 	~ContextTree();
 	real Observe(int x, int y);
 	void Show();
 	int NChildren();
+	/// Limit the number of nodes, pruning the least recently used contexts
+	void setNodeBudget(int node_budget)
+	{
+		store.setBudget(node_budget);
+	}
+	int getNodeBudget() const
+	{
+		return store.getBudget();
+	}
 protected: 
 	int n_branches;
 	int n_symbols;
 	int max_depth;
-	Node* root;
+	real prior_alpha; ///< implicit prior value of alpha
+	std::vector<real> log_w_prior; ///< initial log-weight at each depth
+	ContextTreeStore<> store; ///< the nodes
     Ring<int> history;
 };
 
@@ -97,12 +97,9 @@ ContextTreeKDTree::Node::Node(ContextTreeKDTree::Node* prev_,
     
 }
 
-/// make sure to kill all
+/// The children are owned by the tree's node pool
 ContextTreeKDTree::Node::~Node()
 {
-    for (int i=0; i<tree.n_branches; ++i) {
-        delete next[i];
-    }
 }
 
 /** Observe new data, adapt parameters.
@@ -166,16 +163,17 @@ real ContextTreeKDTree::Node::Observe(const Vector& x,
 
     //real threshold = 1; //log(depth);
     real threshold = pow(1.1, (real) depth); 
-    if ((tree.max_depth==0 || depth < tree.max_depth) && S >  threshold) {
+    if ((tree.max_depth==0 || depth < tree.max_depth) && S >  threshold
+        && (next[k] || tree.CanSplit())) {
         if (!next[k]) {
             if (k == 0) {
 				Vector new_bound = upper_bound;
 				new_bound(splitting_dimension) = mid_point;
-                next[k] = new Node(this, lower_bound, new_bound);
+                next[k] = tree.nodes.New(this, lower_bound, new_bound);
             } else {
 				Vector new_bound = lower_bound;
 				new_bound(splitting_dimension) = mid_point;
-                next[k] = new Node(this, new_bound, upper_bound);
+                next[k] = tree.nodes.New(this, new_bound, upper_bound);
             }
         }
         P *= next[k]->Observe(x, P);
@@ -297,16 +295,18 @@ int ContextTreeKDTree::Node::NChildren()
 ContextTreeKDTree::ContextTreeKDTree(int n_branches_,
                                          int max_depth_,
 									 const Vector& lower_bound,
-									 const Vector& upper_bound)
+									 const Vector& upper_bound,
+									 int node_budget_)
     : n_branches(n_branches_),
-      max_depth(max_depth_)
+      max_depth(max_depth_),
+      node_budget(node_budget_)
 {
-    root = new Node(*this, lower_bound, upper_bound);
+    root = nodes.New(*this, lower_bound, upper_bound);
 }
 
 ContextTreeKDTree::~ContextTreeKDTree()
 {
-    delete root;
+    nodes.Clear();
 }
 
 real ContextTreeKDTree::Observe(const Vector& x)
@@ -19,6 +19,7 @@
 #include "MomentMatchingBetaEstimate.h"
 #include "NormalDistribution.h"
 #include "DeltaDistribution.h"
+#include "Arena.h"
 
 #undef RANDOM_SPLITS
 #undef USE_GAUSSIAN_MIX
@@ -39,6 +40,9 @@
     
 	The model can also be used for estimating conditional densities, directly.
 	However, this is perhaps not a good idea. 
+
+	Nodes are allocated from a pool owned by the tree. With a node
+	budget, the tree stops splitting once the budget is reached.
  */
 class ContextTreeKDTree
 {
@@ -88,16 +92,33 @@ public:
     // public methods
     ContextTreeKDTree(int n_branches_,
                       int max_depth_,
-                      const Vector& lower_bound, const Vector& upper_bound);
+                      const Vector& lower_bound, const Vector& upper_bound,
+                      int node_budget_ = 0);
     ~ContextTreeKDTree();
     real Observe(const Vector& x);
     real pdf(const Vector& x);
     void Show();
     int NChildren();
+    /// Limit the number of nodes; 0 for no limit
+    void setNodeBudget(int node_budget_)
+    {
+        node_budget = node_budget_;
+    }
+    int getNodeBudget() const
+    {
+        return node_budget;
+    }
 protected: 
     int n_branches;
     int max_depth;
+    int node_budget; ///< maximum number of nodes, 0 for no limit
+    ObjectPool<Node> nodes; ///< storage for the nodes
     Node* root;
+    /// Whether another node may be created
+    bool CanSplit() const
+    {
+        return !node_budget || nodes.Size() < node_budget;
+    }
 };
 
 
@@ -14,11 +14,13 @@
 #include <cmath>
 
 
-ContextTreeRealLine::Node::Node(real lower_bound_,
+ContextTreeRealLine::Node::Node(ContextTreeRealLine& tree_,
+                                real lower_bound_,
                                 real upper_bound_,
                                 int n_branches_,
                                 int max_depth_)
-    : lower_bound(lower_bound_),
+    : tree(tree_),
+      lower_bound(lower_bound_),
       upper_bound(upper_bound_),
       new_bound((lower_bound + upper_bound)/2),
       n_branches(n_branches_),
@@ -40,7 +42,8 @@ ContextTreeRealLine::Node::Node(real lower_bound_,
 ContextTreeRealLine::Node::Node(ContextTreeRealLine::Node* prev_,
                                 real lower_bound_,
                                 real upper_bound_)
-    : lower_bound(lower_bound_),
+    : tree(prev_->tree),
+      lower_bound(lower_bound_),
       upper_bound(upper_bound_),
       n_branches(prev_->n_branches),
       depth(prev_->depth + 1),
@@ -70,12 +73,9 @@ ContextTreeRealLine::Node::Node(ContextTreeRealLine::Node* prev_,
     
 }
 
-/// make sure to kill all
+/// The children are owned by the tree's node pool
 ContextTreeRealLine::Node::~Node()
 {
-    for (int i=0; i<n_branches; ++i) {
-        delete next[i];
-    }
 }
 
 /** Observe new data, adapt parameters.
@@ -138,12 +138,13 @@ real ContextTreeRealLine::Node::Observe(real x,
     S++;
 
     real threshold = 2;
-    if ((max_depth==0 || depth < max_depth) && S >  threshold) {
+    if ((max_depth==0 || depth < max_depth) && S >  threshold
+        && (next[k] || tree.CanSplit())) {
         if (!next[k]) {
             if (k == 0) {
-                next[k] = new Node(this, lower_bound, new_bound);
+                next[k] = tree.nodes.New(this, lower_bound, new_bound);
             } else {
-                next[k] = new Node(this, new_bound, upper_bound);
+                next[k] = tree.nodes.New(this, new_bound, upper_bound);
             }
         }
         P *= next[k]->Observe(x, P);
@@ -260,16 +261,18 @@ int ContextTreeRealLine::Node::NChildren()
 ContextTreeRealLine::ContextTreeRealLine(int n_branches_,
                                          int max_depth_,
                                          real lower_bound,
-                                         real upper_bound)
+                                         real upper_bound,
+                                         int node_budget_)
     : n_branches(n_branches_),
-      max_depth(max_depth_)
+      max_depth(max_depth_),
+      node_budget(node_budget_)
 {
-    root = new Node(lower_bound, upper_bound, n_branches, max_depth);
+    root = nodes.New(*this, lower_bound, upper_bound, n_branches, max_depth);
 }
 
 ContextTreeRealLine::~ContextTreeRealLine()
 {
-    delete root;
+    nodes.Clear();
 }
 
 real ContextTreeRealLine::Observe(real x)
@@ -16,6 +16,7 @@
 #include "real.h"
 #include "Vector.h"
 #include "Ring.h"
+#include "Arena.h"
 
 
 /** Context tree on the real line.
@@ -25,6 +26,9 @@
 
     The BVMM approach (implemented in ContextTree.[h|cc]) is not applicable
     here.
+
+    Nodes are allocated from a pool owned by the tree. With a node
+    budget, the tree stops splitting once the budget is reached.
 */
 class ContextTreeRealLine
 {
@@ -32,6 +36,7 @@ public:
     // public classes
     struct Node
     {
+        ContextTreeRealLine& tree; ///< the tree owning the node
         real lower_bound; ///< looks at x > lower_bound
         real upper_bound; ///< looks at x < upper_bound
         real new_bound; ///< how to split
@@ -46,7 +51,8 @@ public:
         real log_w; ///< log of w
         real log_w_prior; ///< initial value
         Vector w_local; ///< weight of local distributions
-        Node(real lower_bound_,
+        Node(ContextTreeRealLine& tree_,
+             real lower_bound_,
              real upper_bound_,
              int n_branches_,
              int max_depth_);
@@ -62,16 +68,32 @@ public:
     };
     
     // public methods
-    ContextTreeRealLine(int n_branches_ = 2, int max_depth_= 0, real lower_bound = 0, real upper_bound = 1);
+    ContextTreeRealLine(int n_branches_ = 2, int max_depth_= 0, real lower_bound = 0, real upper_bound = 1, int node_budget_ = 0);
     ~ContextTreeRealLine();
     real Observe(real x);
     real pdf(real x);
     void Show();
     int NChildren();
+    /// Limit the number of nodes; 0 for no limit
+    void setNodeBudget(int node_budget_)
+    {
+        node_budget = node_budget_;
+    }
+    int getNodeBudget() const
+    {
+        return node_budget;
+    }
 protected: 
     int n_branches;
     int max_depth;
+    int node_budget; ///< maximum number of nodes, 0 for no limit
+    ObjectPool<Node> nodes; ///< storage for the nodes
     Node* root;
+    /// Whether another node may be created
+    bool CanSplit() const
+    {
+        return !node_budget || nodes.Size() < node_budget;
+    }
 };
 
 
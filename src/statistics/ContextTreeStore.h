@@ -0,0 +1,259 @@
+/* -*- Mode: c++;  -*- */
+// copyright (c) 2013 by Christos Dimitrakakis <christos.dimitrakakis@gmail.com>
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef CONTEXT_TREE_STORE_H
+#define CONTEXT_TREE_STORE_H
+
+#include <vector>
+#include <algorithm>
+#include <cassert>
+#include "real.h"
+
+/// Per-node data for trees that need nothing beyond counts and weights
+struct ContextTreeNoData
+{
+};
+
+/** Pooled node storage for discrete context trees.
+
+    Nodes are kept level by level, and a node is referred to by its
+    depth and its index within the level. Each level holds contiguous
+    arrays for the outcome counts and the child indices of its nodes
+    (-1 for a missing child), together with the log-weight, number of
+    observations, parent and time of last visit of each node. Removed
+    nodes leave their slots on a free list, so a tree that has reached
+    its working size no longer allocates.
+
+    With a node budget, Advance() prunes the least recently visited
+    leaves once the budget is reached, breaking ties by the number of
+    observations. A pruned context is learned again from scratch if it
+    reappears. The root is never pruned.
+
+    The Extra parameter holds any other per-node data. New slots are
+    value-initialised, but recycled slots keep their old Extra, which
+    the caller must reinitialise.
+ */
+template <class Extra = ContextTreeNoData>
+class ContextTreeStore
+{
+public:
+    /// All the nodes at one depth
+    struct Level
+    {
+        std::vector<real> alpha; ///< outcome counts, n_outcomes per node
+        std::vector<int> next; ///< child indices, n_branches per node
+        std::vector<real> log_w; ///< log-weight
+        std::vector<int> N_obs; ///< number of observations
+        std::vector<int> parent; ///< parent index, -1 for a free slot
+        std::vector<int> branch; ///< branch taken from the parent
+        std::vector<int> n_children; ///< number of children
+        std::vector<long> last_used; ///< time of the last visit
+        std::vector<Extra> extra; ///< other data
+        std::vector<int> free_slots; ///< slots available for reuse
+    };
+protected:
+    /// A pruning candidate
+    struct Leaf
+    {
+        long last_used;
+        int N_obs;
+        int depth;
+        int index;
+        bool operator< (const Leaf& rhs) const
+        {
+            if (last_used != rhs.last_used) {
+                return last_used < rhs.last_used;
+            }
+            return N_obs < rhs.N_obs;
+        }
+    };
+    int n_branches; ///< number of branches per node
+    int n_outcomes; ///< number of outcomes per node
+    std::vector<Level> levels; ///< the nodes, by depth
+    int n_nodes; ///< number of nodes in the tree
+    int budget; ///< maximum number of nodes, 0 for no limit
+    long clock; ///< number of calls to Advance()
+    std::vector<Leaf> leaves; ///< workspace for Prune()
+
+    /// Get a free slot at some depth
+    int Allocate(int depth)
+    {
+        Level& L = levels[depth];
+        int i;
+        if (!L.free_slots.empty()) {
+            i = L.free_slots.back();
+            L.free_slots.pop_back();
+            std::fill(L.alpha.begin() + i * n_outcomes,
+                      L.alpha.begin() + (i + 1) * n_outcomes, 0.0);
+            std::fill(L.next.begin() + i * n_branches,
+                      L.next.begin() + (i + 1) * n_branches, -1);
+            L.log_w[i] = 0;
+            L.N_obs[i] = 0;
+            L.n_children[i] = 0;
+            L.last_used[i] = clock;
+        } else {
+            i = (int) L.log_w.size();
+            L.alpha.resize(L.alpha.size() + n_outcomes, 0.0);
+            L.next.resize(L.next.size() + n_branches, -1);
+            L.log_w.push_back(0);
+            L.N_obs.push_back(0);
+            L.parent.push_back(-1);
+            L.branch.push_back(-1);
+            L.n_children.push_back(0);
+            L.last_used.push_back(clock);
+            L.extra.push_back(Extra());
+        }
+        n_nodes++;
+        return i;
+    }
+public:
+    ContextTreeStore(int n_branches_, int n_outcomes_, int max_depth, int budget_ = 0)
+        : n_branches(n_branches_),
+          n_outcomes(n_outcomes_),
+          levels(max_depth + 1),
+          n_nodes(0),
+          budget(budget_),
+          clock(0)
+    {
+        assert(budget >= 0);
+        Allocate(0);
+    }
+    /// Remove everything but the root, and reset the root
+    void Clear()
+    {
+        for (size_t d=0; d<levels.size(); ++d) {
+            levels[d] = Level();
+        }
+        n_nodes = 0;
+        clock = 0;
+        Allocate(0);
+    }
+    /// The root of the tree
+    int Root() const
+    {
+        return 0;
+    }
+    /// Number of nodes, including the root
+    int Size() const
+    {
+        return n_nodes;
+    }
+    int getMaxDepth() const
+    {
+        return (int) levels.size() - 1;
+    }
+    int getBudget() const
+    {
+        return budget;
+    }
+    /// Set the node budget, pruning down to it if necessary
+    void setBudget(int budget_)
+    {
+        assert(budget_ >= 0);
+        budget = budget_;
+        while (budget && n_nodes > budget) {
+            if (!Prune(n_nodes - budget)) {
+                break;
+            }
+        }
+    }
+    /// The outcome counts of a node
+    real* Counts(int depth, int i)
+    {
+        return &levels[depth].alpha[i * n_outcomes];
+    }
+    /// The k-th child of a node, or -1
+    int Child(int depth, int i, int k) const
+    {
+        return levels[depth].next[i * n_branches + k];
+    }
+    /// Create the k-th child of a node
+    int AddChild(int depth, int i, int k)
+    {
+        assert(depth + 1 < (int) levels.size());
+        assert(Child(depth, i, k) < 0);
+        int j = Allocate(depth + 1);
+        Level& L = levels[depth + 1];
+        L.parent[j] = i;
+        L.branch[j] = k;
+        levels[depth].next[i * n_branches + k] = j;
+        levels[depth].n_children[i]++;
+        return j;
+    }
+    real& LogWeight(int depth, int i)
+    {
+        return levels[depth].log_w[i];
+    }
+    int& Observations(int depth, int i)
+    {
+        return levels[depth].N_obs[i];
+    }
+    Extra& Data(int depth, int i)
+    {
+        return levels[depth].extra[i];
+    }
+    /// Mark a node as visited now
+    void Touch(int depth, int i)
+    {
+        levels[depth].last_used[i] = clock;
+    }
+    /** Start a new observation.
+
+        If the budget is reached, a tenth of it is freed, so that the
+        cost of pruning is spread over many observations. Call this
+        before every observation: the budget is then exceeded by at
+        most the number of nodes one observation creates.
+    */
+    void Advance()
+    {
+        clock++;
+        if (budget && n_nodes >= budget) {
+            Prune(std::max(1, budget / 10));
+        }
+    }
+    /// Remove a leaf
+    void Remove(int depth, int i)
+    {
+        assert(depth > 0);
+        Level& L = levels[depth];
+        assert(L.parent[i] >= 0 && L.n_children[i] == 0);
+        int p = L.parent[i];
+        levels[depth - 1].next[p * n_branches + L.branch[i]] = -1;
+        levels[depth - 1].n_children[p]--;
+        L.parent[i] = -1;
+        L.free_slots.push_back(i);
+        n_nodes--;
+    }
+    /// Remove up to n of the least recently visited leaves
+    int Prune(int n)
+    {
+        leaves.clear();
+        for (int d=1; d<(int) levels.size(); ++d) {
+            Level& L = levels[d];
+            for (int i=0; i<(int) L.parent.size(); ++i) {
+                if (L.parent[i] >= 0 && L.n_children[i] == 0) {
+                    Leaf leaf = {L.last_used[i], L.N_obs[i], d, i};
+                    leaves.push_back(leaf);
+                }
+            }
+        }
+        n = std::min(n, (int) leaves.size());
+        if (n < (int) leaves.size()) {
+            std::nth_element(leaves.begin(), leaves.begin() + n, leaves.end());
+        }
+        for (int k=0; k<n; ++k) {
+            Remove(leaves[k].depth, leaves[k].index);
+        }
+        return n;
+    }
+};
+
+#endif
@@ -80,6 +80,17 @@ void DirichletDistribution::generate(Vector& y) const
      y *= invsum;
 }
 
+/// Generate a multinomial vector in-place, using the given generator
+void DirichletDistribution::generate(Vector& y, RandomNumberGenerator& rng) const
+{
+    real sum = 0.0;
+    for (int i=0; i<n; i++) {
+        y(i) = rng.gamma(alpha(i));
+        sum += y(i);
+    }
+    y *= 1.0 / sum;
+}
+
 /** Dirichlet distribution
     Gets the parameters of a multinomial distribution as input.
 */
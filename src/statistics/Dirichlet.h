@@ -34,6 +34,7 @@ public:
     virtual ~DirichletDistribution();
     virtual void generate(Vector& x) const;
     virtual Vector generate() const;
+    void generate(Vector& x, RandomNumberGenerator& rng) const;
     virtual real pdf(const Vector& x) const;
     virtual real log_pdf(const Vector& x) const;
     virtual void update(Vector* x);
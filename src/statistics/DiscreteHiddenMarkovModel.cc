@@ -11,6 +11,9 @@
 
 #include "DiscreteHiddenMarkovModel.h"
 #include "RandomNumberGenerator.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <functional>
 #include <cassert>
 #include <cmath>
 
@@ -22,6 +25,7 @@ DiscreteHiddenMarkovModel::DiscreteHiddenMarkovModel(int n_states_, int n_observ
         P_S[i].Resize(n_states);
         P_X[i].Resize(n_observations);
     }
+    CompileTables();
     Reset();
 }
 
@@ -40,6 +44,7 @@ DiscreteHiddenMarkovModel::DiscreteHiddenMarkovModel(Matrix& Pr_S, Matrix& Pr_X)
             P_X[i].Pr(k) = Pr_X(i, k);
         }
     }
+    CompileTables();
     Reset();
 }
 
@@ -88,117 +93,163 @@ void DiscreteHiddenMarkovModel::Show()
   }
 }
 
-real DiscreteHiddenMarkovModel::Expectation(std::vector<int>& observations, Matrix& forward_belief, Matrix& backward_belief)
+/// Copy the parameters into the contiguous tables used by the forward-backward pass
+void DiscreteHiddenMarkovModel::CompileTables()
 {
-    int T = observations.size();
-    assert (forward_belief.Rows() == T);
-    assert (forward_belief.Columns() == n_states);
-
-    for (int t=0; t<T; ++t) {
-        for (int i=0; i<n_states; ++i) {
-            forward_belief(t, i) = -1;
-            backward_belief(t, i) = -1;
+    transition_table.resize(n_states * n_states);
+    emission_table.resize(n_observations * n_states);
+    for (int i=0; i<n_states; ++i) {
+        for (int j=0; j<n_states; ++j) {
+            transition_table[i * n_states + j] = PrS(i, j);
+        }
+        for (int x=0; x<n_observations; ++x) {
+            emission_table[x * n_states + i] = PrX(i, x);
         }
     }
-    //Show();
-    
-    // initialise the first belief
-    Vector B_prev(n_states);
-    B_prev[0]= 1.0;
-    for (int src=1; src<n_states; ++src) {
-        B_prev(src) = 0.0;
+}
+
+/** Scaled forward-backward pass over one sequence.
+
+    The forward pass computes the filtered beliefs
+    \f$\alpha_t(s) = P(s_t = s | x^t)\f$ with one gemv per step, and
+    the scale factors \f$c_t = P(x_t | x^{t-1})\f$, whose logarithms
+    sum to the log-likelihood. The backward pass keeps a single
+    scaled message \f$\beta_t\f$, so that \f$\alpha_t \beta_t\f$ is the
+    posterior \f$P(s_t | x^T)\f$, and stores the vectors
+    \f$u_{t+1} = q(x_{t+1}) \beta_{t+1} / c_{t+1}\f$. The expected
+    transitions \f$\sum_t \alpha_t(i) P_{ij} u_{t+1}(j)\f$ are then
+    obtained with a single gemm.
+
+    Expected counts and the log-likelihood are added to statistics.
+    If given, forward_belief and posterior must be T x n_states.
+    The tables must have been compiled.
+*/
+real DiscreteHiddenMarkovModel::ForwardBackward(const std::vector<int>& observations,
+                                                Statistics& statistics,
+                                                Workspace& workspace,
+                                                Matrix* forward_belief,
+                                                Matrix* posterior) const
+{
+    int T = observations.size();
+    int n = n_states;
+    if (T == 0) {
+        return 0;
     }
-    // calculate forward pass
+    workspace.alpha.resize(T * n);
+    workspace.u.resize(T * n);
+    workspace.beta.resize(n);
+    workspace.xi.resize(n * n);
+    const real* P = &transition_table[0];
+    real* alpha = &workspace.alpha[0];
+    real* u = &workspace.u[0];
+    real* beta = &workspace.beta[0];
+
+    // forward pass: alpha_t = q(x_t) P' alpha_{t-1} / c_t
+    real log_likelihood = 0;
     for (int t=0; t<T; ++t) {
-        //b(s') = sum_i b(s',s=i) = sum_i p(s'|s=i) b(s=i)
-        Vector B_next(n_states);
-        if (t==0) {
-            for (int src=0; src<n_states; ++src) {
-                for (int dst=0; dst<n_states; ++dst) {
-                    B_next[dst] += PrS(src, dst) * B_prev[src];
-                }
-            }
-        } else {    
-            for (int src=0; src<n_states; ++src) {
-                for (int dst=0; dst<n_states; ++dst) {
-                    B_next[dst] += PrS(src, dst) * forward_belief(t - 1, src);
-                }
-            }
+        real* alpha_t = alpha + t * n;
+        if (t == 0) {
+            std::copy(P, P + n, alpha_t);
+        } else {
+            cblas_dgemv(CblasRowMajor, CblasTrans, n, n, 1.0, P, n,
+                        alpha_t - n, 1, 0.0, alpha_t, 1);
         }
-
-        //b(s'|x') = p(x'|s') b(s') / sum_i b(x',s'=i) 
+        const real* q = &emission_table[observations[t] * n];
         real sum = 0.0;
-        for (int s=0; s<n_states; ++s) {
-            forward_belief(t, s) = PrX(s, observations[t]) * B_next[s];
-            sum += forward_belief(t,s);
+        for (int s=0; s<n; ++s) {
+            alpha_t[s] *= q[s];
+            sum += alpha_t[s];
         }
         assert (!std::isnan(sum));
         assert (sum > 0);
         real invsum = 1.0 / sum;
-        for (int s=0; s<n_states; ++s) {
-            forward_belief(t, s) *= invsum;
+        for (int s=0; s<n; ++s) {
+            alpha_t[s] *= invsum;
         }
-        //B_next.print(stdout);
+        // u holds the scale factors until the backward pass
+        u[t * n] = sum;
+        log_likelihood += log(sum);
     }
-    
-    //printf ("Expectation forward pass\n");
-    //forward_belief.print(stdout);
-
-    for (int s=0; s<n_states; ++s) {
-        backward_belief(T - 1, s) = forward_belief(T - 1, s);
+    if (forward_belief) {
+        for (int t=0; t<T; ++t) {
+            for (int s=0; s<n; ++s) {
+                (*forward_belief)(t, s) = alpha[t * n + s];
+            }
+        }
     }
 
-    // calculate backward pass
-    Matrix MB(n_states, n_states);
-    for (int t=T-2; t>=0; --t) {
-
-        // P(s|x^T) = sum_j P(s,s'=j | x^T)
-        //          = sum_j P(s|s'=j,x^T) P(s'=j|x^T)
-        // so this first calculates
-        // P(s_t = k| s_{t+1} = j, x^T) 
-        // = P(s_t = k | s_{t+1} = j, x^t)
-        // = P_{kj} b_t(s_t = k) / \sum_i P_{ij} b_t(s_t = i)
-        for (int j=0; j<n_states; ++j) {
-            real sum = 0.0;
-            for (int k=0; k<n_states; ++k) {
-                MB(k, j) = PrS(k, j) * forward_belief(t, k);
-                sum += MB(k, j);
-            }
-            assert (!std::isnan(sum));
-            assert (sum > 0);
-            real invsum = 1.0 / sum;
-            for (int k=0; k<n_states; ++k) {
-                MB(k, j) *= invsum;
+    // backward pass: beta_t = P u_{t+1}
+    for (int s=0; s<n; ++s) {
+        beta[s] = 1.0;
+    }
+    for (int t=T-1; t>=0; --t) {
+        if (t < T - 1) {
+            cblas_dgemv(CblasRowMajor, CblasNoTrans, n, n, 1.0, P, n,
+                        u + (t + 1) * n, 1, 0.0, beta, 1);
+        }
+        const real* alpha_t = alpha + t * n;
+        real* N_x = &statistics.emissions[observations[t] * n];
+        for (int s=0; s<n; ++s) {
+            real gamma = alpha_t[s] * beta[s];
+            N_x[s] += gamma;
+            if (posterior) {
+                (*posterior)(t, s) = gamma;
             }
         }
-        
-        // P(s|x^T) = sum_j P(s|x_T) P(s'=j|x^T)
-        real sum = 0.0;
-        for (int k=0; k<n_states; ++k) {
-            backward_belief(t, k) = 0;
-            for (int j=0; j<n_states; ++j) {
-                backward_belief(t, k) += MB(k, j) * backward_belief(t + 1, j);
+        if (t > 0) {
+            const real* q = &emission_table[observations[t] * n];
+            real invsum = 1.0 / u[t * n];
+            real* u_t = u + t * n;
+            for (int s=0; s<n; ++s) {
+                u_t[s] = q[s] * beta[s] * invsum;
             }
-            sum += backward_belief(t, k);
         }
-        assert(fabs(sum - 1.0) < 1e-6);
     }
 
-    real log_likelihood = 0;
-    for (int t=0; t<T; ++t) {
-        real p = 0;
-        for (int s=0; s<n_states; ++s) {
-            p += backward_belief(t, s) * PrX(s, observations[t]);
+    // expected transitions
+    if (T > 1) {
+        real* xi = &workspace.xi[0];
+        cblas_dgemm(CblasRowMajor, CblasTrans, CblasNoTrans, n, n, T - 1,
+                    1.0, alpha, n, u + n, n, 0.0, xi, n);
+        for (int k=0; k<n * n; ++k) {
+            statistics.transitions[k] += P[k] * xi[k];
         }
-        log_likelihood += log(p);
     }
-
-    //printf("log likelihood: %f\n", log_likelihood);
-    //printf ("Expectation backward pass\n");
-    //belief.print(stdout);
+    statistics.log_likelihood += log_likelihood;
     return log_likelihood;
 }
 
+/** Calculate the filtered and smoothed state beliefs.
+
+    The forward_belief has rows \f$P(s_t | x^t)\f$ and the
+    backward_belief has rows \f$P(s_t | x^T)\f$. Both must be T x n_states.
+
+    \return the log-likelihood \f$\log P(x^T)\f$.
+ */
+real DiscreteHiddenMarkovModel::Expectation(std::vector<int>& observations, Matrix& forward_belief, Matrix& backward_belief)
+{
+    assert (forward_belief.Rows() == (int) observations.size());
+    assert (forward_belief.Columns() == n_states);
+    assert (backward_belief.Rows() == (int) observations.size());
+    assert (backward_belief.Columns() == n_states);
+    CompileTables();
+    Statistics statistics(n_states, n_observations);
+    Workspace workspace;
+    return ForwardBackward(observations, statistics, workspace,
+                           &forward_belief, &backward_belief);
+}
+
+/** Add the expected counts of a sequence to statistics.
+
+    \return the log-likelihood of the sequence.
+ */
+real DiscreteHiddenMarkovModel::Expectation(std::vector<int>& observations, Statistics& statistics)
+{
+    CompileTables();
+    Workspace workspace;
+    return ForwardBackward(observations, statistics, workspace);
+}
+
 void DiscreteHiddenMarkovModel::Maximisation(Matrix& forward_belief, Matrix& backward_belief)
 {
     // states first
@@ -254,6 +305,36 @@ void DiscreteHiddenMarkovModel::Maximisation(Matrix& forward_belief, Matrix& bac
     }
 }
 
+/** Set the parameters to the normalised expected counts.
+
+    States that were never visited keep their distributions.
+ */
+void DiscreteHiddenMarkovModel::Maximisation(const Statistics& statistics)
+{
+    for (int i=0; i<n_states; ++i) {
+        const real* N_i = &statistics.transitions[i * n_states];
+        real sum = 0.0;
+        for (int j=0; j<n_states; ++j) {
+            sum += N_i[j];
+        }
+        if (sum > 0) {
+            for (int j=0; j<n_states; ++j) {
+                PrS(i, j) = N_i[j] / sum;
+            }
+        }
+        sum = 0.0;
+        for (int x=0; x<n_observations; ++x) {
+            sum += statistics.emissions[x * n_states + i];
+        }
+        if (sum > 0) {
+            for (int x=0; x<n_observations; ++x) {
+                PrX(i, x) = statistics.emissions[x * n_states + i] / sum;
+            }
+        }
+    }
+    CompileTables();
+}
+
 
 /** Expectation maximisation for HMMs
  
@@ -262,25 +343,121 @@ void DiscreteHiddenMarkovModel::Maximisation(Matrix& forward_belief, Matrix& bac
     P(x^t|y^t) 
     \f]
     
+    The state posterior of the last E-step is kept in getBelief().
+
+    \return the log-likelihood before the last M-step.
  */
 real DiscreteHiddenMarkovModel::ExpectationMaximisation(std::vector<int>& observations, int n_iterations)
 {
 
     int T = observations.size();
     _belief.Resize(T, n_states);
-    Matrix forward_belief(T, n_states);
+    Statistics statistics(n_states, n_observations);
+    Workspace workspace;
     
     real log_likelihood = LOG_ZERO;
     for (int iter=0; iter<n_iterations; ++iter) {
         // Expectation step.
-        log_likelihood = Expectation(observations, forward_belief, _belief);
+        CompileTables();
+        statistics.Clear();
+        log_likelihood = ForwardBackward(observations, statistics, workspace,
+                                         NULL, &_belief);
 
         // maximisation step
-        Maximisation(forward_belief, _belief);
+        Maximisation(statistics);
+    }
+    return log_likelihood;
+}
+
+/** Expectation maximisation over many independent sequences.
+
+    Each sequence starts from state 0. The sequences are split into
+    one block per thread, with about the same number of observations
+    in each. Every block collects its own expected counts, which are
+    summed in a fixed order before the M-step, so the result does not
+    depend on the number of threads up to rounding.
+
+    \return the total log-likelihood before the last M-step.
+ */
+real DiscreteHiddenMarkovModel::ExpectationMaximisation(std::vector<std::vector<int> >& sequences,
+                                                        int n_iterations,
+                                                        ThreadPool* pool)
+{
+    int n_sequences = sequences.size();
+    int n_blocks = pool ? std::max(1, std::min(n_sequences, pool->getNThreads())) : 1;
+
+    // balance the blocks by length
+    long total_length = 0;
+    for (int k=0; k<n_sequences; ++k) {
+        total_length += sequences[k].size();
+    }
+    std::vector<int> block(n_blocks + 1, n_sequences);
+    block[0] = 0;
+    long length = 0;
+    int b = 1;
+    for (int k=0; k<n_sequences && b<n_blocks; ++k) {
+        length += sequences[k].size();
+        if (length * n_blocks >= total_length * b) {
+            block[b++] = k + 1;
+        }
+    }
+
+    std::vector<Statistics> statistics(n_blocks, Statistics(n_states, n_observations));
+    std::vector<Workspace> workspace(n_blocks);
+    std::function<void (int)> expectation = [&] (int k) {
+        statistics[k].Clear();
+        for (int i=block[k]; i<block[k + 1]; ++i) {
+            ForwardBackward(sequences[i], statistics[k], workspace[k]);
+        }
+    };
+
+    Statistics total(n_states, n_observations);
+    real log_likelihood = LOG_ZERO;
+    for (int iter=0; iter<n_iterations; ++iter) {
+        CompileTables();
+        if (pool) {
+            pool->Run(n_blocks, expectation);
+        } else {
+            expectation(0);
+        }
+        total.Clear();
+        for (int k=0; k<n_blocks; ++k) {
+            total += statistics[k];
+        }
+        log_likelihood = total.log_likelihood;
+        Maximisation(total);
     }
     return log_likelihood;
 }
 
+DiscreteHiddenMarkovModel::Statistics::Statistics(int n_states, int n_observations)
+    : transitions(n_states * n_states, 0.0),
+      emissions(n_observations * n_states, 0.0),
+      log_likelihood(0.0)
+{
+}
+
+void DiscreteHiddenMarkovModel::Statistics::Clear()
+{
+    std::fill(transitions.begin(), transitions.end(), 0.0);
+    std::fill(emissions.begin(), emissions.end(), 0.0);
+    log_likelihood = 0.0;
+}
+
+DiscreteHiddenMarkovModel::Statistics& DiscreteHiddenMarkovModel::Statistics::operator+= (const Statistics& rhs)
+{
+    assert(transitions.size() == rhs.transitions.size());
+    assert(emissions.size() == rhs.emissions.size());
+    for (uint i=0; i<transitions.size(); ++i) {
+        transitions[i] += rhs.transitions[i];
+    }
+    for (uint i=0; i<emissions.size(); ++i) {
+        emissions[i] += rhs.emissions[i];
+    }
+    log_likelihood += rhs.log_likelihood;
+    return *this;
+}
+
 
 //----------------------------------------------------------------------//
 
@@ -16,13 +16,43 @@
 #include "Matrix.h"
 #include <vector>
 
+class ThreadPool;
+
 /**
    \ingroup StatisticsGroup
  */
 /*@{*/
 
+/** A hidden Markov model with discrete states and observations.
+
+    The chain starts from state 0 before the first observation.
+
+    The forward-backward pass works on contiguous copies of the
+    transition and emission probabilities, refreshed from P_S and P_X
+    at the start of every E-step, so that the distributions can still
+    be edited in place through PrS() and PrX().
+ */
 class DiscreteHiddenMarkovModel
 {
+public:
+    /// Expected counts of a set of observation sequences
+    struct Statistics
+    {
+        std::vector<real> transitions; ///< expected transitions, n_states x n_states
+        std::vector<real> emissions; ///< expected emissions, n_observations x n_states
+        real log_likelihood; ///< log-likelihood of the sequences
+        Statistics(int n_states = 0, int n_observations = 0);
+        void Clear();
+        Statistics& operator+= (const Statistics& rhs);
+    };
+    /// Buffers for the forward-backward pass over one sequence
+    struct Workspace
+    {
+        std::vector<real> alpha; ///< scaled forward beliefs, T x n_states
+        std::vector<real> u; ///< scaled backward messages times emissions, T x n_states
+        std::vector<real> beta; ///< scaled backward message
+        std::vector<real> xi; ///< unweighted expected transitions
+    };
 protected:
     int n_states;
     int n_observations;
@@ -30,6 +60,14 @@ protected:
     std::vector<MultinomialDistribution> P_X; ///< Emission distribution
     int current_state;
     Matrix _belief; ///< state belief, for EM
+    std::vector<real> transition_table; ///< P_S, n_states x n_states
+    std::vector<real> emission_table; ///< P_X by observation, n_observations x n_states
+    void CompileTables();
+    real ForwardBackward(const std::vector<int>& observations,
+                         Statistics& statistics,
+                         Workspace& workspace,
+                         Matrix* forward_belief = NULL,
+                         Matrix* posterior = NULL) const;
 public:
     DiscreteHiddenMarkovModel(Matrix& Pr_S, Matrix& Pr_X);
     DiscreteHiddenMarkovModel(int n_states_, int n_observations_);
@@ -69,8 +107,13 @@ public:
     }
     void Show();
     real Expectation(std::vector<int>& observations, Matrix& forward_belief, Matrix& backward_belief);
+    real Expectation(std::vector<int>& observations, Statistics& statistics);
     void Maximisation(Matrix& forward_belief, Matrix& backward_belief);
+    void Maximisation(const Statistics& statistics);
     real ExpectationMaximisation(std::vector<int>& observations, int n_iterations);
+    real ExpectationMaximisation(std::vector<std::vector<int> >& sequences,
+                                 int n_iterations,
+                                 ThreadPool* pool = NULL);
     Matrix& getBelief()
     {
         return _belief;
@@ -12,13 +12,26 @@
 #include "DiscreteHiddenMarkovModelPF.h"
 #include "Dirichlet.h"
 #include "Matrix.h"
+#include "Random.h"
+#include "ThreadPool.h"
+#include "ranlib.h"
+#include <algorithm>
+#include <functional>
+#include <cassert>
 #include <cmath>
 
 #undef REPLACE_ALL_LOW
 
 DiscreteHiddenMarkovModelPF::DiscreteHiddenMarkovModelPF(real threshold, real stationarity, int n_states_, int n_observations_, int n_particles_)
     :  n_states(n_states_), n_observations(n_observations_), 
-       n_particles(n_particles_), hmm(n_particles), belief(n_particles),
+       n_particles(n_particles_),
+       transitions(n_particles * n_states * n_states),
+       emissions(n_particles * n_states * n_observations),
+       beliefs(n_particles * n_states),
+       predictions(n_particles * n_states),
+       track_statistics(false),
+       offspring(n_particles),
+       pool(NULL),
        P_x(n_particles), log_P_x(n_particles),
        w(n_particles), log_w(n_particles),
        state_prior(n_states),
@@ -47,25 +60,23 @@ DiscreteHiddenMarkovModelPF::DiscreteHiddenMarkovModelPF(real threshold, real st
     // initialise the particles
     for (int k=0; k<n_particles; ++k) {
         // initialise state transition matrix
-        Matrix P_S(n_states, n_states);
+        real* P_S = Transitions(k);
         for (int i=0; i<n_states; ++i) {
             Vector p = state_prior[i]->generate();
             for (int j=0; j<n_states; ++j) {
-                P_S(i,j) = p[j];
+                P_S[i * n_states + j] = p[j];
             }
         }
         // initialise observation matrix
-        Matrix P_X(n_states, n_observations);
+        real* P_X = Emissions(k);
         for (int i=0; i<n_states; ++i) {
             Vector p = observation_prior[i]->generate();
             for (int j=0; j<n_observations; ++j) {
-                P_X(i,j) = p[j];
+                P_X[i * n_observations + j] = p[j];
             }
         }
-        // create HMM
-        hmm[k] = new DiscreteHiddenMarkovModel(P_S, P_X);
-        belief[k] = new DiscreteHiddenMarkovModelStateBelief(hmm[k]);
     }
+    ResetBeliefs();
 }
 
 DiscreteHiddenMarkovModelPF::~DiscreteHiddenMarkovModelPF()
@@ -76,24 +87,276 @@ DiscreteHiddenMarkovModelPF::~DiscreteHiddenMarkovModelPF()
         delete state_prior[i];
         delete observation_prior[i];
     }
-    for (int k=0; k<n_particles; ++k) {
-        delete hmm[k];
-        delete belief[k];
+}
+
+/// Start keeping the expected counts of each particle
+void DiscreteHiddenMarkovModelPF::TrackStatistics()
+{
+    track_statistics = true;
+    transition_counts.assign(n_particles * n_states * n_states, 0.0);
+    emission_counts.assign(n_particles * n_states * n_observations, 0.0);
+}
+
+/// Set all state beliefs to uniform
+void DiscreteHiddenMarkovModelPF::ResetBeliefs()
+{
+    real p = 1.0 / (real) n_states;
+    for (uint i=0; i<beliefs.size(); ++i) {
+        beliefs[i] = p;
     }
 }
 
+/** Update the state belief of a particle from the next observation.
 
-real DiscreteHiddenMarkovModelPF::Observe(int x)
+    \f[
+    b_{t+1}(s_{t+1})
+    = \frac{p(x_{t+1}|s_{t+1}) \sum_s p(s_{t+1}|s) b_t(s)}{p(x_{t+1} | x^t)}.
+    \f]
+
+    If statistics are tracked, the expected transition counts grow by
+    \f$b_t(i) p(j|i) p(x_{t+1}|j) / p(x_{t+1}|x^t)\f$ and the expected
+    emission counts by \f$b_{t+1}(j)\f$.
+
+    \return \f$p(x_{t+1} | x^t)\f$ for this particle.
+ */
+real DiscreteHiddenMarkovModelPF::ObserveParticle(int k, int x)
 {
-    real log_sum = LOG_ZERO;
-    
+    const real* P_S = Transitions(k);
+    const real* P_X = Emissions(k);
+    real* B = Belief(k);
+    real* B_next = &predictions[k * n_states];
+
+    //b(s') = sum_i b(s',s=i) = sum_i p(s'|s=i) b(s=i)
+    for (int i=0; i<n_states; ++i) {
+        B_next[i] = 0.0;
+    }
+    for (int src=0; src<n_states; ++src) {
+        for (int dst=0; dst<n_states; ++dst) {
+            B_next[dst] += P_S[src * n_states + dst] * B[src];
+        }
+    }
+
+    //b'(s') = p(x'|s') b(s') / sum_i b(x',s'=i) 
+    real sum = 0.0;
+    for (int s=0; s<n_states; ++s) {
+        sum += P_X[s * n_observations + x] * B_next[s];
+    }
+    real invsum = 1.0 / sum;
+    if (track_statistics) {
+        real* N_S = &transition_counts[k * n_states * n_states];
+        for (int i=0; i<n_states; ++i) {
+            real b = B[i] * invsum;
+            for (int j=0; j<n_states; ++j) {
+                N_S[i * n_states + j] += b * P_S[i * n_states + j] * P_X[j * n_observations + x];
+            }
+        }
+    }
+    for (int s=0; s<n_states; ++s) {
+        B[s] = P_X[s * n_observations + x] * B_next[s] * invsum;
+    }
+    if (track_statistics) {
+        real* N_X = &emission_counts[k * n_states * n_observations];
+        for (int s=0; s<n_states; ++s) {
+            N_X[s * n_observations + x] += B[s];
+        }
+    }
+    return sum;
+}
+
+/** Update all particles from the next observation.
+
+    Sets P_x and log_P_x, with the latter including the current
+    weights. The particles are updated in parallel if there is a
+    thread pool.
+
+    \return \f$\log p(x)\f$, with \f$p(x) = \sum_k p(x|k) w_k\f$.
+ */
+real DiscreteHiddenMarkovModelPF::ObserveParticles(int x)
+{
+    if (pool && n_particles > 1) {
+        int n_blocks = std::min(n_particles, pool->getNThreads());
+        std::function<void (int)> observe = [this, x] (int b) {
+            int n_blocks = std::min(n_particles, pool->getNThreads());
+            int end = (b + 1) * n_particles / n_blocks;
+            for (int k=b * n_particles / n_blocks; k<end; ++k) {
+                P_x[k] = ObserveParticle(k, x);
+            }
+        };
+        pool->Run(n_blocks, observe);
+    } else {
+        for (int k=0; k<n_particles; ++k) {
+            P_x[k] = ObserveParticle(k, x);
+        }
+    }
+
     // calculate p(x|k) and p(x) = sum_k p(x,k)
-   
+    real log_sum = LOG_ZERO;
     for (int k=0; k<n_particles; ++k) {
-        P_x[k] = belief[k]->Observe(x);
         log_P_x[k] = log(P_x[k]) + log_w[k];
         log_sum = logAdd(log_sum, log_P_x[k]);
     }
+    return log_sum;
+}
+
+/// Copy the parameters, belief and counts of one particle to another
+void DiscreteHiddenMarkovModelPF::CopyParticle(int src, int dst)
+{
+    if (src == dst) {
+        return;
+    }
+    int n_S = n_states * n_states;
+    int n_X = n_states * n_observations;
+    std::copy(Transitions(src), Transitions(src) + n_S, Transitions(dst));
+    std::copy(Emissions(src), Emissions(src) + n_X, Emissions(dst));
+    std::copy(Belief(src), Belief(src) + n_states, Belief(dst));
+    if (track_statistics) {
+        std::copy(&transition_counts[src * n_S], &transition_counts[src * n_S] + n_S,
+                  &transition_counts[dst * n_S]);
+        std::copy(&emission_counts[src * n_X], &emission_counts[src * n_X] + n_X,
+                  &emission_counts[dst * n_X]);
+    }
+}
+
+/// Move the parameters of dst, and optionally its belief, towards those of src
+void DiscreteHiddenMarkovModelPF::MixParticle(int src, int dst, real alpha, bool mix_belief)
+{
+    const real* PS_k = Transitions(src);
+    const real* PX_k = Emissions(src);
+    real* PS_min = Transitions(dst);
+    real* PX_min = Emissions(dst);
+    for (int i=0; i<n_states * n_states; ++i) {
+        PS_min[i] = PS_k[i] * alpha + PS_min[i] * (1 - alpha);
+    }
+    for (int i=0; i<n_states * n_observations; ++i) {
+        PX_min[i] = PX_k[i] * alpha + PX_min[i] * (1 - alpha);
+    }
+    if (mix_belief) {
+        const real* B_k = Belief(src);
+        real* B_min = Belief(dst);
+        for (int i=0; i<n_states; ++i) {
+            B_min[i] = B_k[i] * alpha + B_min[i] * (1 - alpha);
+        }
+    }
+}
+
+/** Draw each row of a table from a Dirichlet.
+
+    The Dirichlet parameters of each row are prior plus scale times the
+    row of alpha. Every entry of alpha is read before the same entry
+    of P is written, so alpha may equal P.
+ */
+static void DrawDirichlet(real* P, const real* alpha, real scale,
+                          DirichletDistribution** prior, int n_rows, int n_columns)
+{
+    for (int i=0; i<n_rows; ++i) {
+        real* p = P + i * n_columns;
+        const real* a = alpha + i * n_columns;
+        real sum = 0.0;
+        for (int j=0; j<n_columns; ++j) {
+            real a_j = scale * a[j];
+            if (prior) {
+                a_j += prior[i]->Alpha(j);
+            }
+            p[j] = gengam(1.0, a_j);
+            sum += p[j];
+        }
+        real invsum = 1.0 / sum;
+        for (int j=0; j<n_columns; ++j) {
+            p[j] *= invsum;
+        }
+    }
+}
+
+/** Give dst new parameters around those of src.
+
+    Each row of the new parameters is drawn from a Dirichlet whose
+    parameters are the corresponding row of src, times scale.
+ */
+void DiscreteHiddenMarkovModelPF::SampleParticle(int src, int dst, real scale)
+{
+    for (int i=0; i<n_states; ++i) {
+        DrawDirichlet(Transitions(dst) + i * n_states, Transitions(src) + i * n_states,
+                      scale, NULL, 1, n_states);
+        DrawDirichlet(Emissions(dst) + i * n_observations, Emissions(src) + i * n_observations,
+                      scale, NULL, 1, n_observations);
+    }
+}
+
+/** Replace dst with a copy of src that has new parameters.
+
+    The parameters are drawn from the Dirichlet posterior given the
+    expected counts of src, while the state belief and the counts are
+    copied. This takes the place of replaying the history under the
+    new parameters.
+ */
+void DiscreteHiddenMarkovModelPF::SampleParticleFromStatistics(int src, int dst)
+{
+    assert(track_statistics);
+    CopyParticle(src, dst);
+    DrawDirichlet(Transitions(dst), &transition_counts[dst * n_states * n_states], 1.0,
+                  &state_prior[0], n_states, n_states);
+    DrawDirichlet(Emissions(dst), &emission_counts[dst * n_states * n_observations], 1.0,
+                  &observation_prior[0], n_states, n_observations);
+}
+
+/// The effective sample size \f$1 / \sum_k w_k^2\f$
+real DiscreteHiddenMarkovModelPF::EffectiveSampleSize() const
+{
+    real sum = 0.0;
+    for (int k=0; k<n_particles; ++k) {
+        sum += w[k] * w[k];
+    }
+    return 1.0 / sum;
+}
+
+/** Systematic resampling.
+
+    A single uniform offset places n_particles evenly spaced points on
+    the cumulative weights, and each particle gets one copy per point
+    in its interval. Particles keep their place: the extra copies of a
+    particle overwrite particles without any. If statistics are
+    tracked, every extra copy draws new parameters from its posterior.
+    The weights are then uniform.
+ */
+void DiscreteHiddenMarkovModelPF::Resample()
+{
+    real step = 1.0 / (real) n_particles;
+    real point = urandom() * step;
+    real cumulative = w[0];
+    int i = 0;
+    for (int k=0; k<n_particles; ++k) {
+        offspring[k] = 0;
+    }
+    for (int k=0; k<n_particles; ++k, point += step) {
+        while (point > cumulative && i < n_particles - 1) {
+            cumulative += w[++i];
+        }
+        offspring[i]++;
+    }
+    int slot = 0;
+    for (int k=0; k<n_particles; ++k) {
+        for (int c=1; c<offspring[k]; ++c) {
+            while (offspring[slot] != 0) {
+                slot++;
+            }
+            offspring[slot] = -1;
+            if (track_statistics) {
+                SampleParticleFromStatistics(k, slot);
+            } else {
+                CopyParticle(k, slot);
+            }
+        }
+    }
+    real log_prior = log(step);
+    for (int k=0; k<n_particles; ++k) {
+        w[k] = step;
+        log_w[k] = log_prior;
+    }
+}
+
+real DiscreteHiddenMarkovModelPF::Observe(int x)
+{
+    real log_sum = ObserveParticles(x);
     
     // p(k|x) = p(x|k) / p(x)
     log_w = log_P_x - log_sum;
@@ -110,7 +373,23 @@ Vector DiscreteHiddenMarkovModelPF::getPrediction()
     }
     // p(k|x) = p(x|k) / p(x)
     for (int k=0; k<n_particles; ++k) {
-        p_x += belief[k]->getPrediction() * w[k];
+        const real* P_S = Transitions(k);
+        const real* P_X = Emissions(k);
+        const real* B = Belief(k);
+        real* Ps = &predictions[k * n_states];
+        for (int s2=0; s2<n_states; ++s2) {
+            Ps[s2] = 0.0;
+            for (int s=0; s<n_states; ++s) {
+                Ps[s2] += B[s] * P_S[s * n_states + s2];
+            }
+        }
+        for (int x=0; x<n_observations; ++x) {
+            real Px = 0.0;
+            for (int s=0; s<n_states; ++s) {
+                Px += Ps[s] * P_X[s * n_observations + x];
+            }
+            p_x[x] += Px * w[k];
+        }
     }
 
     return p_x;
@@ -124,7 +403,20 @@ void DiscreteHiddenMarkovModelPF::Show()
 {
     for (int k=0; k<n_particles; ++k) {
         printf ("w[%d] = %f\n", k, w[k]);
-        hmm[k]->Show();
+        const real* P_S = Transitions(k);
+        const real* P_X = Emissions(k);
+        for (int i=0; i<n_states; ++i) {
+            for (int j=0; j<n_states; ++j) {
+                printf ("%f ", P_S[i * n_states + j]);
+            }
+            printf ("# hP_S\n");
+        }
+        for (int i=0; i<n_states; ++i) {
+            for (int j=0; j<n_observations; ++j) {
+                printf ("%f ", P_X[i * n_observations + j]);
+            }
+            printf ("# hP_X\n");
+        }
     }
 }
 
@@ -142,32 +434,15 @@ real DiscreteHiddenMarkovModelPF_ReplaceLowest::Observe(int x)
 #endif
         int k = DiscreteDistribution::generate(w);
         real alpha = 0.1;
-        std::vector<MultinomialDistribution>& PS_k = hmm[k]->getStateProbablities();
-        std::vector<MultinomialDistribution>& PX_k = hmm[k]->getObservationProbablities();
-        std::vector<MultinomialDistribution>& PS_min = hmm[min_k]->getStateProbablities();
-        std::vector<MultinomialDistribution>& PX_min = hmm[min_k]->getObservationProbablities();
-        for (int i=0; i<n_states; ++i) {
-            for (int j=0; j<n_states; ++j) {
-                PS_min[i].Pr(j) = PS_k[i].Pr(j) * alpha + PS_min[i].Pr(j) * (1 - alpha);
-            }
-            for (int j=0; j<n_observations; ++j) {
-                PX_min[i].Pr(j) = PX_k[i].Pr(j) * alpha + PX_min[i].Pr(j) * (1 - alpha);
-            }
-        }
+        MixParticle(k, min_k, alpha, false);
         log_w[min_k] = logAdd(log(alpha) + log_w[k], log(1 - alpha) + log_w[min_k]);
         min_k = ArgMin(log_w);
     }
     // normalise weights
     log_w -= log_w.logSum();
         
-    real log_sum = LOG_ZERO;
-
     // calculate p(x|k) and p(x) = sum_k p(x,k)
-    for (int k=0; k<n_particles; ++k) {
-        P_x[k] = belief[k]->Observe(x);
-        log_P_x[k] = log(P_x[k]) + log_w[k];
-        log_sum = logAdd(log_sum, log_P_x[k]);
-    }
+    real log_sum = ObserveParticles(x);
     
     // p(k|x) = p(x|k) / p(x)
     log_w = log_P_x - log_sum;
@@ -191,13 +466,8 @@ real DiscreteHiddenMarkovModelPF_ReplaceLowest::Observe(int x)
  */
 real DiscreteHiddenMarkovModelPF_ISReplaceLowest::Observe(int x)
 {
-    real log_sum = LOG_ZERO;
     // calculate p(x|k) and p(x) = sum_k p(x,k)
-    for (int k=0; k<n_particles; ++k) {
-        P_x[k] = belief[k]->Observe(x);
-        log_P_x[k] = log(P_x[k]) + log_w[k];
-        log_sum = logAdd(log_sum, log_P_x[k]);
-    }
+    real log_sum = ObserveParticles(x);
     
     // p(k|x) = p(x|k) / p(x)
     log_w = log_P_x - log_sum;
@@ -212,31 +482,15 @@ real DiscreteHiddenMarkovModelPF_ISReplaceLowest::Observe(int x)
             /// mix weight with k
         int k = DiscreteDistribution::generate(w);
         real alpha = 0.1;
-        std::vector<MultinomialDistribution>& PS_k = hmm[k]->getStateProbablities();
-        std::vector<MultinomialDistribution>& PX_k = hmm[k]->getObservationProbablities();
-        std::vector<MultinomialDistribution>& PS_min = hmm[min_k]->getStateProbablities();
-        std::vector<MultinomialDistribution>& PX_min = hmm[min_k]->getObservationProbablities();
-        for (int i=0; i<n_states; ++i) {
-            for (int j=0; j<n_states; ++j) {
-                PS_min[i].Pr(j) = PS_k[i].Pr(j) * alpha + PS_min[i].Pr(j) * (1 - alpha);
-            }
-            for (int j=0; j<n_observations; ++j) {
-                PX_min[i].Pr(j) = PX_k[i].Pr(j) * alpha + PX_min[i].Pr(j) * (1 - alpha);
-            }
-        }
+        MixParticle(k, min_k, alpha, false);
         log_w[min_k] = logAdd(log(alpha) + log_w[k], log(1 - alpha) + log_w[min_k]);
         min_k = ArgMin(log_w);
     }
     // normalise weights
     log_w -= log_w.logSum();
         
-    log_sum = LOG_ZERO;
     // calculate p(x|k) and p(x) = sum_k p(x,k)
-    for (int k=0; k<n_particles; ++k) {
-        P_x[k] = belief[k]->Observe(x);
-        log_P_x[k] = log(P_x[k]) + log_w[k];
-        log_sum = logAdd(log_sum, log_P_x[k]);
-    }
+    log_sum = ObserveParticles(x);
     
     // p(k|x) = p(x|k) / p(x)
     log_w = log_P_x - log_sum;
@@ -265,13 +519,8 @@ real DiscreteHiddenMarkovModelPF_ISReplaceLowestDirichlet::Observe(int x)
 {
     T++;
     real scale = (real) T;
-    real log_sum = LOG_ZERO;
     // calculate p(x|k) and p(x) = sum_k p(x,k)
-    for (int k=0; k<n_particles; ++k) {
-        P_x[k] = belief[k]->Observe(x);
-        log_P_x[k] = log(P_x[k]) + log_w[k];
-        log_sum = logAdd(log_sum, log_P_x[k]);
-    }
+    real log_sum = ObserveParticles(x);
     
     // p(k|x) = p(x|k) / p(x)
     log_w = log_P_x - log_sum;
@@ -285,47 +534,16 @@ real DiscreteHiddenMarkovModelPF_ISReplaceLowestDirichlet::Observe(int x)
 #endif
             /// mix weight with k
         int k = DiscreteDistribution::generate(w);
-        std::vector<MultinomialDistribution>& PS_k = hmm[k]->getStateProbablities();
-        std::vector<MultinomialDistribution>& PX_k = hmm[k]->getObservationProbablities();
-        std::vector<MultinomialDistribution>& PS_min = hmm[min_k]->getStateProbablities();
-        std::vector<MultinomialDistribution>& PX_min = hmm[min_k]->getObservationProbablities();
             // create Dirichlet and sample
-        for (int i=0; i<n_states; ++i) {
-                // state Dirichlet
-            Vector v_s(n_states);
-            for (int j=0; j<n_states; ++j) {
-                v_s[j] = scale * PS_k[i].Pr(j);
-            }
-            DirichletDistribution dir_s(v_s);
-            dir_s.generate(v_s);
-            for (int j=0; j<n_states; ++j) {
-                PS_min[i].Pr(j) = v_s[j];
-            }
-            
-                // observation Dirichlet
-            Vector v_x(n_observations);
-            for (int j=0; j<n_observations; ++j) {
-                v_x[j] = scale * PX_k[i].Pr(j);
-            }
-            DirichletDistribution dir_x(v_x);
-            dir_x.generate(v_x);
-            for (int j=0; j<n_observations; ++j) {
-                PX_min[i].Pr(j) = v_x[j];
-            }
-        }
+        SampleParticle(k, min_k, scale);
         log_w[min_k] = log_w[k] - (real) n_particles;
         min_k = ArgMin(log_w);
     }
     // normalise weights
     log_w -= log_w.logSum();
         
-    log_sum = LOG_ZERO;
     // calculate p(x|k) and p(x) = sum_k p(x,k)
-    for (int k=0; k<n_particles; ++k) {
-        P_x[k] = belief[k]->Observe(x);
-        log_P_x[k] = log(P_x[k]) + log_w[k];
-        log_sum = logAdd(log_sum, log_P_x[k]);
-    }
+    log_sum = ObserveParticles(x);
     
     // p(k|x) = p(x|k) / p(x)
     log_w = log_P_x - log_sum;
@@ -337,18 +555,21 @@ real DiscreteHiddenMarkovModelPF_ISReplaceLowestDirichlet::Observe(int x)
 
 
 //----- DiscreteHiddenMarkovModelPF_ISReplaceLowestDirichletExact -----------//
+
+/** Replace particles under threshold by sampling from their posterior.
+
+    A replacement particle copies the state belief and the expected
+    counts of a particle drawn according to the weights, and draws
+    its parameters from the Dirichlet posterior given these counts.
+    As the copied belief already includes x, the particles observe
+    x only once, and the cost per observation does not grow with the
+    length of the history.
+ */
 real DiscreteHiddenMarkovModelPF_ISReplaceLowestDirichletExact::Observe(int x)
 {
     T++;
-    history.push_back(x);
-    real scale = (real) T;
-    real log_sum = LOG_ZERO;
     // calculate p(x|k) and p(x) = sum_k p(x,k)
-    for (int k=0; k<n_particles; ++k) {
-        P_x[k] = belief[k]->Observe(x);
-        log_P_x[k] = log(P_x[k]) + log_w[k];
-        log_sum = logAdd(log_sum, log_P_x[k]);
-    }
+    real log_sum = ObserveParticles(x);
     
     // p(k|x) = p(x|k) / p(x)
     log_w = log_P_x - log_sum;
@@ -360,74 +581,42 @@ real DiscreteHiddenMarkovModelPF_ISReplaceLowestDirichletExact::Observe(int x)
 #else
     if (log_w[min_k] < replacement_threshold) {
 #endif
-            /// mix weight with k
         int k = DiscreteDistribution::generate(w);
-        std::vector<MultinomialDistribution>& PS_k = hmm[k]->getStateProbablities();
-        std::vector<MultinomialDistribution>& PX_k = hmm[k]->getObservationProbablities();
-        std::vector<MultinomialDistribution>& PS_min = hmm[min_k]->getStateProbablities();
-        std::vector<MultinomialDistribution>& PX_min = hmm[min_k]->getObservationProbablities();
-            // create Dirichlet and sample
-        for (int i=0; i<n_states; ++i) {
-                // state Dirichlet
-            Vector v_s(n_states);
-            for (int j=0; j<n_states; ++j) {
-                v_s[j] = scale * PS_k[i].Pr(j);
-            }
-            DirichletDistribution dir_s(v_s);
-            dir_s.generate(v_s);
-            for (int j=0; j<n_states; ++j) {
-                PS_min[i].Pr(j) = v_s[j];
-            }
-            
-                // observation Dirichlet
-            Vector v_x(n_observations);
-            for (int j=0; j<n_observations; ++j) {
-                v_x[j] = scale * PX_k[i].Pr(j);
-            }
-            DirichletDistribution dir_x(v_x);
-            dir_x.generate(v_x);
-            for (int j=0; j<n_observations; ++j) {
-                PX_min[i].Pr(j) = v_x[j];
-            }
-        }
+        SampleParticleFromStatistics(k, min_k);
+        P_x[min_k] = P_x[k];
         log_w[min_k] = log_w[k] - (real) n_particles;
-        belief[min_k]->Reset();
-        belief[min_k]->Observe(history);
         min_k = ArgMin(log_w);
     }
     // normalise weights
     log_w -= log_w.logSum();
-        
-    log_sum = LOG_ZERO;
-    // calculate p(x|k) and p(x) = sum_k p(x,k)
-    for (int k=0; k<n_particles; ++k) {
-        P_x[k] = belief[k]->Observe(x);
-        log_P_x[k] = log(P_x[k]) + log_w[k];
-        log_sum = logAdd(log_sum, log_P_x[k]);
-    }
-    
-    // p(k|x) = p(x|k) / p(x)
-    log_w = log_P_x - log_sum;
     w = exp(log_w);
 
-
     return exp(log_sum);
 }
 
 
-//----- DiscreteHiddenMarkovModelPF_ISReplaceLowestDirichletExact -----------//
+//----- DiscreteHiddenMarkovModelPF_BootstrapDirichletExact -----------//
+
+/** Reweight the particles and resample them when the weights degenerate.
+ */
 real DiscreteHiddenMarkovModelPF_BootstrapDirichletExact::Observe(int x)
 {
-    // TODO Fill in dirichlet bootstrap
-    Serror("Unimplemented\n");
-    return -1;
+    T++;
+    real log_sum = ObserveParticles(x);
+
+    // p(k|x) = p(x|k) / p(x)
+    log_w = log_P_x - log_sum;
+    w = exp(log_w);
+    if (EffectiveSampleSize() < resampling_threshold) {
+        Resample();
+    }
+    return exp(log_sum);
 }
 
 
 //------------- DiscreteHiddenMarkovModelPF_ReplaceLowestExact --------------//
 real DiscreteHiddenMarkovModelPF_ReplaceLowestExact::Observe(int x)
 {
-    history.push_back(x);
     int min_k = ArgMin(log_w);
 #ifdef REPLACE_ALL_LOW
     int reps = n_particles;
@@ -437,34 +626,15 @@ real DiscreteHiddenMarkovModelPF_ReplaceLowestExact::Observe(int x)
 #endif
         int k = DiscreteDistribution::generate(w);
         real alpha = 0.1;
-        std::vector<MultinomialDistribution>& PS_k = hmm[k]->getStateProbablities();
-        std::vector<MultinomialDistribution>& PX_k = hmm[k]->getObservationProbablities();
-        std::vector<MultinomialDistribution>& PS_min = hmm[min_k]->getStateProbablities();
-        std::vector<MultinomialDistribution>& PX_min = hmm[min_k]->getObservationProbablities();
-        for (int i=0; i<n_states; ++i) {
-            for (int j=0; j<n_states; ++j) {
-                PS_min[i].Pr(j) = PS_k[i].Pr(j) * alpha + PS_min[i].Pr(j) * (1 - alpha);
-            }
-            for (int j=0; j<n_observations; ++j) {
-                PX_min[i].Pr(j) = PX_k[i].Pr(j) * alpha + PX_min[i].Pr(j) * (1 - alpha);
-            }
-        }
+        MixParticle(k, min_k, alpha, true);
         log_w[min_k] = logAdd(log(alpha) + log_w[k], log(1 - alpha) + log_w[min_k]);
-        belief[min_k]->Reset();
-        belief[min_k]->Observe(history);
         min_k = ArgMin(log_w);
     }
     // normalise weights
     log_w -= log_w.logSum();
    
-    real log_sum = LOG_ZERO;
-
     // calculate p(x|k) and p(x) = sum_k p(x,k)
-    for (int k=0; k<n_particles; ++k) {
-        P_x[k] = belief[k]->Observe(x);
-        log_P_x[k] = log(P_x[k]) + log_w[k];
-        log_sum = logAdd(log_sum, log_P_x[k]);
-    }
+    real log_sum = ObserveParticles(x);
     
     // p(k|x) = p(x|k) / p(x)
     log_w = log_P_x - log_sum;
@@ -476,22 +646,16 @@ real DiscreteHiddenMarkovModelPF_ReplaceLowestExact::Observe(int x)
 //------------ DiscreteHiddenMarkovModelPF_ISReplaceLowestExact -------------//
 // Importance Sampling
 // Lowest replacement
-// Exact state belief update
+// Mixed state belief update
 real DiscreteHiddenMarkovModelPF_ISReplaceLowestExact::Observe(int x)
 {
 
-   real log_sum = LOG_ZERO;
     // calculate p(x|k) and p(x) = sum_k p(x,k)
-    for (int k=0; k<n_particles; ++k) {
-        P_x[k] = belief[k]->Observe(x);
-        log_P_x[k] = log(P_x[k]) + log_w[k];
-        log_sum = logAdd(log_sum, log_P_x[k]);
-    }
+    real log_sum = ObserveParticles(x);
     // p(k|x) = p(x|k) / p(x)
     log_w = log_P_x - log_sum;
 
 
-    history.push_back(x);
     int min_k = ArgMin(log_w);
 #ifdef REPLACE_ALL_LOW
     int reps = n_particles;
@@ -501,34 +665,15 @@ real DiscreteHiddenMarkovModelPF_ISReplaceLowestExact::Observe(int x)
 #endif
         int k = DiscreteDistribution::generate(w);
         real alpha = 0.1;
-        std::vector<MultinomialDistribution>& PS_k = hmm[k]->getStateProbablities();
-        std::vector<MultinomialDistribution>& PX_k = hmm[k]->getObservationProbablities();
-        std::vector<MultinomialDistribution>& PS_min = hmm[min_k]->getStateProbablities();
-        std::vector<MultinomialDistribution>& PX_min = hmm[min_k]->getObservationProbablities();
-        for (int i=0; i<n_states; ++i) {
-            for (int j=0; j<n_states; ++j) {
-                PS_min[i].Pr(j) = PS_k[i].Pr(j) * alpha + PS_min[i].Pr(j) * (1 - alpha);
-            }
-            for (int j=0; j<n_observations; ++j) {
-                PX_min[i].Pr(j) = PX_k[i].Pr(j) * alpha + PX_min[i].Pr(j) * (1 - alpha);
-            }
-        }
+        MixParticle(k, min_k, alpha, true);
         log_w[min_k] = logAdd(log(alpha) + log_w[k], log(1 - alpha) + log_w[min_k]);
-        belief[min_k]->Reset();
-        belief[min_k]->Observe(history);
         min_k = ArgMin(log_w);
     }
     // normalise weights
     log_w -= log_w.logSum();
    
-    log_sum = LOG_ZERO;
-
     // calculate p(x|k) and p(x) = sum_k p(x,k)
-    for (int k=0; k<n_particles; ++k) {
-        P_x[k] = belief[k]->Observe(x);
-        log_P_x[k] = log(P_x[k]) + log_w[k];
-        log_sum = logAdd(log_sum, log_P_x[k]);
-    }
+    log_sum = ObserveParticles(x);
     
     // p(k|x) = p(x|k) / p(x)
     log_w = log_P_x - log_sum;
@@ -544,38 +689,13 @@ real DiscreteHiddenMarkovModelPF_ISReplaceLowestExact::Observe(int x)
 
 
 
-/// Here we resample from the Dirichlet created by the PF.
+/// Only reweights the particles: the resampling step is not implemented.
 real DiscreteHiddenMarkovModelRBPF::Observe(int x)
 {
     t++; // increase number of observations
 
-    // set up distribution to sample from
-    std::vector<DirichletDistribution> dS(n_states);
-    std::vector<DirichletDistribution> dX(n_states);
-
-    // fill in sampling distribution values
-    for (int k=0; k<n_particles; ++k) {
-        //real alpha = sqrt(real (t));
-        std::vector<MultinomialDistribution>& PS_k = hmm[k]->getStateProbablities();
-        std::vector<MultinomialDistribution>& PX_k = hmm[k]->getObservationProbablities();
-        for (int i=0; i<n_states; ++i) {
-            for (int j=0; j<n_states; ++j) {
-                dS[i].Alpha(j) += PS_k[i].Pr(j);
-            }
-            for (int j=0; j<n_observations; ++j) {
-                dX[i].Alpha(j) += PX_k[i].Pr(j);
-            }
-        }
-    }
-        
-    real log_sum = LOG_ZERO;
-
     // calculate p(x|k) and p(x) = sum_k p(x,k)
-    for (int k=0; k<n_particles; ++k) {
-        P_x[k] = belief[k]->Observe(x);
-        log_P_x[k] = log(P_x[k]) + log_w[k];
-        log_sum = logAdd(log_sum, log_P_x[k]);
-    }
+    real log_sum = ObserveParticles(x);
     
     // p(k|x) = p(x|k) / p(x)
     log_w = log_P_x - log_sum;
@@ -22,15 +22,57 @@
  */
 /*@{*/
 
-/// This is a generic particle filter for estimating hidden Markov models
+class ThreadPool;
+
+/** This is a generic particle filter for estimating hidden Markov models
+
+    Each particle is a hidden Markov model together with a belief
+    about its current state. The particles are packed: the transition,
+    emission and belief tables of all particles lie in contiguous
+    arrays, so particles are updated and copied without allocation,
+    and the update for a new observation can be split over threads.
+
+    Filters that replace particles by sampling from a Dirichlet
+    posterior also keep the expected transition and emission counts of
+    each particle, updated incrementally with every observation.
+*/
 class DiscreteHiddenMarkovModelPF
 {
 protected:
     int n_states;
     int n_observations;
     int n_particles;
-    std::vector<DiscreteHiddenMarkovModel*> hmm; ///< Transition distribution
-    std::vector<DiscreteHiddenMarkovModelStateBelief*> belief; ///< Emission distribution
+    std::vector<real> transitions; ///< transition tables, n_states x n_states per particle
+    std::vector<real> emissions; ///< emission tables, n_states x n_observations per particle
+    std::vector<real> beliefs; ///< state beliefs, n_states per particle
+    std::vector<real> predictions; ///< workspace, n_states per particle
+    bool track_statistics; ///< whether to keep the expected counts
+    std::vector<real> transition_counts; ///< expected transitions, n_states x n_states per particle
+    std::vector<real> emission_counts; ///< expected emissions, n_states x n_observations per particle
+    std::vector<int> offspring; ///< workspace for Resample()
+    ThreadPool* pool; ///< threads for the particle update, NULL if serial
+    real* Transitions(int k)
+    {
+        return &transitions[k * n_states * n_states];
+    }
+    real* Emissions(int k)
+    {
+        return &emissions[k * n_states * n_observations];
+    }
+    real* Belief(int k)
+    {
+        return &beliefs[k * n_states];
+    }
+    void TrackStatistics();
+    real ObserveParticle(int k, int x);
+    real ObserveParticles(int x);
+    void ResetBeliefs();
+    void CopyParticle(int src, int dst);
+    void MixParticle(int src, int dst, real alpha, bool mix_belief);
+    void SampleParticle(int src, int dst, real scale);
+    void SampleParticleFromStatistics(int src, int dst);
+    real EffectiveSampleSize() const;
+    void Resample();
 public:
     Vector P_x;
     Vector log_P_x;
@@ -48,6 +90,11 @@ public:
     virtual real Observe(int x);
     virtual void Reset();
     void Show();
+    /// Use a thread pool for the particle update; NULL for serial updates
+    void setThreadPool(ThreadPool* pool_)
+    {
+        pool = pool_;
+    }
 };
 
 /// This particle filter only replaces particles with very small weight
@@ -93,13 +140,13 @@ class DiscreteHiddenMarkovModelPF_ISReplaceLowestDirichletExact : public Discret
 {
 public:
     real replacement_threshold;
-    std::vector<int> history; ///< observation history
     long T;
     DiscreteHiddenMarkovModelPF_ISReplaceLowestDirichletExact(real threshold, real stationarity, int n_states_, int n_observations_, int n_particles_) : 
         DiscreteHiddenMarkovModelPF(threshold, stationarity, n_states_, n_observations_,  n_particles_)
     {
         replacement_threshold = - 2 * log((real) n_particles);
         T = 0;
+        TrackStatistics();
     }  
     virtual ~DiscreteHiddenMarkovModelPF_ISReplaceLowestDirichletExact()
     {
@@ -111,18 +158,24 @@ public:
     }
 };
 
-/// This particle filter only replaces particles with very small weight
+/** This particle filter resamples all particles when the weights degenerate.
+
+    When the effective sample size drops below resampling_threshold,
+    the particles are resampled systematically, and every extra copy
+    of a particle draws new parameters from the Dirichlet posterior
+    given its expected counts.
+*/
 class DiscreteHiddenMarkovModelPF_BootstrapDirichletExact : public DiscreteHiddenMarkovModelPF
 {
 public:
-    real replacement_threshold;
-    std::vector<int> history; ///< observation history
+    real resampling_threshold;
     long T;
     DiscreteHiddenMarkovModelPF_BootstrapDirichletExact(real threshold, real stationarity, int n_states_, int n_observations_, int n_particles_) : 
         DiscreteHiddenMarkovModelPF(threshold, stationarity, n_states_, n_observations_,  n_particles_)
     {
-        replacement_threshold = - 2 * log((real) n_particles);
+        resampling_threshold = 0.5 * (real) n_particles;
         T = 0;
+        TrackStatistics();
     }  
     virtual ~DiscreteHiddenMarkovModelPF_BootstrapDirichletExact()
     {
@@ -152,12 +205,11 @@ public:
     virtual real Observe(int x);
 };
 
-/// This particle filter only replaces some particles but uses all history to 
+/// This particle filter only replaces some particles, and mixes their state beliefs too
 class DiscreteHiddenMarkovModelPF_ReplaceLowestExact: public DiscreteHiddenMarkovModelPF
 {
 public:
     real replacement_threshold;
-    std::vector<int> history; ///< observation history
     DiscreteHiddenMarkovModelPF_ReplaceLowestExact(real threshold, real stationarity, int n_states_, int n_observations_, int n_particles_) : 
         DiscreteHiddenMarkovModelPF(threshold, stationarity, n_states_, n_observations_,  n_particles_)
     {
@@ -169,12 +221,11 @@ public:
     virtual real Observe(int x);
 };
 
-/// This particle filter only replaces some particles but uses all history to keep state
+/// This particle filter only replaces some particles, and mixes their state beliefs too
 class DiscreteHiddenMarkovModelPF_ISReplaceLowestExact: public DiscreteHiddenMarkovModelPF
 {
 public:
     real replacement_threshold;
-    std::vector<int> history; ///< observation history
     DiscreteHiddenMarkovModelPF_ISReplaceLowestExact(real threshold, real stationarity, int n_states_, int n_observations_, int n_particles_) : 
         DiscreteHiddenMarkovModelPF(threshold, stationarity, n_states_, n_observations_,  n_particles_)
     {
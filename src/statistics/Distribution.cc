@@ -45,6 +45,11 @@ real UniformDistribution::generate() const
     return x;
 }
 
+real UniformDistribution::generate(RandomNumberGenerator& rng) const
+{
+    return min + rng.uniform()*range;
+}
+
 real UniformDistribution::pdf(real x) const
 {
     if ((x >= min)&&(x <= min + range))
@@ -69,6 +74,14 @@ real BernoulliDistribution::generate() const
     return 0.0f;
 }
 
+real BernoulliDistribution::generate(RandomNumberGenerator& rng) const
+{
+    if (rng.uniform()<p) {
+        return 1.0f;
+    }
+    return 0.0f;
+}
+
 real BernoulliDistribution::pdf(real x) const
 {
     if (x==0.0f) {
@@ -83,7 +96,13 @@ real BernoulliDistribution::pdf(real x) const
 
 real LaplacianDistribution::generate() const
 {
-    real x = urandom(-1.0, 1.0);
+    DefaultRandomNumberGenerator rng;
+    return generate(rng);
+}
+
+real LaplacianDistribution::generate(RandomNumberGenerator& rng) const
+{
+    real x = rng.uniform(-1.0, 1.0);
     real absx = fabs (x);
     real sgnx;
     if (x>0.0) {
@@ -165,7 +184,14 @@ int DiscreteDistribution::generate(const std::vector<real>& x)
 
 int DiscreteDistribution::generate(const Vector& x) 
 {
-    real d=urandom();
+    DefaultRandomNumberGenerator rng;
+    return generate(x, rng);
+}
+
+/// Generate an outcome using the given random number generator
+int DiscreteDistribution::generate(const Vector& x, RandomNumberGenerator& rng)
+{
+    real d=rng.uniform();
     real sum = 0.0;
     int n = x.Size();
     for (int i=0; i<n; i++) {
@@ -108,6 +108,7 @@ public:
     virtual void setMean(real mean) {p = mean;}
     virtual void setVariance(real var) {} ///< set variance in a magic way
     virtual real generate() const;
+    real generate(RandomNumberGenerator& rng) const;
     virtual real pdf(real x) const;
     virtual real getMean() const {return p;}
 };
@@ -127,6 +128,7 @@ public:
     virtual real getMean() const;
     static int generate(const std::vector<real>& x);
     static int generate(const Vector& x);
+    static int generate(const Vector& x, RandomNumberGenerator& rng);
 };
 
 
@@ -145,6 +147,7 @@ public:
     }
     virtual ~UniformDistribution() {}
     virtual real generate() const;
+    real generate(RandomNumberGenerator& rng) const;
     virtual real pdf(real x) const;
     virtual void setVariance (real var) 
     {
@@ -180,6 +183,7 @@ public:
     }
     virtual ~LaplacianDistribution() {}
     virtual real generate() const;
+    real generate(RandomNumberGenerator& rng) const;
     virtual real pdf(real x) const;
     virtual void setVariance (real var)
     {l = sqrt(0.5f / var);}
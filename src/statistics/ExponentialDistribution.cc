@@ -19,6 +19,11 @@ real ExponentialDistribution::generate() const
     real x = urandom();
     return - log (1.0 - x) / l;
 }
+
+real ExponentialDistribution::generate(RandomNumberGenerator& rng) const
+{
+    return rng.exponential() / l;
+}
  
 real ExponentialDistribution::pdf(real x) const
 {
@@ -38,6 +38,7 @@ public:
     }
     virtual ~ExponentialDistribution() {}
     virtual real generate() const;
+    real generate(RandomNumberGenerator& rng) const;
     virtual real pdf(real x) const;
     virtual real log_pdf(real x) const;
     virtual real log_pdf(const std::vector<real>& x) const;
@@ -65,6 +65,13 @@ real GammaDistribution::generate() const
     return gengam(alpha, beta);
 }
 
+/// Generate with shape \f$\alpha\f$ and inverse scale \f$\beta\f$,
+/// using the given generator.
+real GammaDistribution::generate(RandomNumberGenerator& rng) const
+{
+    return rng.gamma(alpha) / beta;
+}
+
 /// Set the maximum likelihood parameters. Return the likelihood at that point.
 ///
 /// Unfortunately this can only be done approximately. We generate
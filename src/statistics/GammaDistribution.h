@@ -34,6 +34,7 @@ public:
     virtual real log_pdf(real x) const;
     virtual real generate();
     virtual real generate() const;
+    real generate(RandomNumberGenerator& rng) const;
     real setMaximumLikelihoodParameters(const std::vector<real>& x, int n_iterations);
 };
 
@@ -10,6 +10,8 @@
  ***************************************************************************/
 
 #include "GaussianProcess.h"
+#include <stdexcept>
+#include <algorithm>
 
 /// Create a new GP with observations in R^d
 GaussianProcess::GaussianProcess(Matrix& Sigma_p_,
@@ -18,6 +20,8 @@ GaussianProcess::GaussianProcess(Matrix& Sigma_p_,
       noise_variance(noise_variance_),
       X2(Matrix::Null(Sigma_p.Rows(), Sigma_p.Columns()))
 {
+    N = 0;
+    updated_alpha = true;
     Accuracy = Sigma_p.Inverse();
     A = Accuracy;
 }
@@ -30,6 +34,7 @@ GaussianProcess::GaussianProcess(real noise_variance_,
 	  sig_var(sig_var_)
 {
 	N = 0;
+	updated_alpha = true;
 }
 
 GaussianProcess::GaussianProcess(Matrix& X_, 
@@ -40,9 +45,13 @@ GaussianProcess::GaussianProcess(Matrix& X_,
 	: X(X_),
 	  Y(Y_),
 	  noise_variance(noise_variance_),
-	  scale_length(scale_length_),
+	  scale_length(X_.Columns()),
 	  sig_var(sig_var_)
 {
+	// the same length scale in every dimension
+	for (int k=0; k<scale_length.Size(); ++k) {
+		scale_length(k) = scale_length_;
+	}
 	N = X.Rows();
 	UpdateGaussianProcess();
 }
@@ -124,19 +133,130 @@ void GaussianProcess::Observe(std::vector<Vector>& x, std::vector<real>& y)
 }
 
 
- void GaussianProcess::AddObservation(const Vector& x, const real& y)
- {
-	 Serror ("Not implemented\n");
-	 exit(-1);	 
- }
+/** Add a single observation.
+
+	The Cholesky factor gains one column, computed with a single
+	triangular solve, so this takes \f$O(N^2)\f$ time.
+*/
+void GaussianProcess::AddObservation(const Vector& x, const real& y)
+{
+	if(N == 0) {
+		X = Matrix(1, x.Size());
+		X.setRow(0, x);
+		Y = Vector(1);
+		Y(0) = y;
+		L.clear();
+		z = Vector();
+		ExtendCholesky(Vector(), sig_var*sig_var + noise_variance*noise_variance, y);
+	} else {
+		Vector k = Kernel(x);
+		X = X.AddRow(x);
+		Y.AddElement(y);
+		ExtendCholesky(k, sig_var*sig_var + noise_variance*noise_variance, y);
+	}
+	N++;
+}
 
+/** Append a point to the factor.
+
+	Given the kernel k between the new point and the previous ones and
+	the variance k_xx of the new point, the new column of L is
+	\f$u = L'^{-1} k\f$, with diagonal element \f$\sqrt{k_{xx} - u'u}\f$.
+	The same accuracy limit as in Matrix::Cholesky() is added to the
+	diagonal.
+*/
+void GaussianProcess::ExtendCholesky(const Vector& k, real k_xx, real y)
+{
+	int n = z.Size();
+	assert(k.Size() == n);
+	Vector u = SolveTransposed(k);
+	real d = k_xx + ACCURACY_LIMIT - Product(u, u);
+	if (d <= 0) {
+		throw std::runtime_error("Could not extend Cholesky factor, matrix not positive definite");
+	}
+	real l = sqrt(d);
+	for(int i=0; i<n; ++i) {
+		L.push_back(u(i));
+	}
+	L.push_back(l);
+	z.AddElement((y - Product(u, z)) / l);
+	updated_alpha = false;
+}
+
+/// Solve L'v = k by forward substitution; each column of L is contiguous.
+Vector GaussianProcess::SolveTransposed(const Vector& k) const
+{
+	int n = k.Size();
+	Vector v(n);
+	real* v_x = v.x;
+	for(int i=0; i<n; ++i) {
+		const real* L_i = &L[i*(i+1)/2];
+		real s = k(i);
+		for(int m=0; m<i; ++m) {
+			s -= L_i[m]*v_x[m];
+		}
+		v_x[i] = s / L_i[i];
+	}
+	return v;
+}
+
+/// Solve L a = v by back substitution, column by column.
+Vector GaussianProcess::Solve(const Vector& v) const
+{
+	int n = v.Size();
+	Vector a = v;
+	real* a_x = a.x;
+	for(int j=n-1; j>=0; --j) {
+		const real* L_j = &L[j*(j+1)/2];
+		a_x[j] /= L_j[j];
+		for(int i=0; i<j; ++i) {
+			a_x[i] -= L_j[i]*a_x[j];
+		}
+	}
+	return a;
+}
+
+/// Solve L alpha = z
+void GaussianProcess::UpdateAlpha()
+{
+	if(updated_alpha) {
+		return;
+	}
+	alpha = Solve(z);
+	updated_alpha = true;
+}
+
+/// The inverse of the covariance, column by column from the factor
+Matrix GaussianProcess::InverseCovariance() const
+{
+	int n = z.Size();
+	Matrix inv_K(n, n);
+	for(int i=0; i<n; ++i) {
+		Vector e(n);
+		e(i) = 1.0;
+		Vector c = Solve(SolveTransposed(e));
+		for(int j=0; j<n; ++j) {
+			inv_K(j,i) = c(j);
+		}
+	}
+	return inv_K;
+}
+
+/// Rebuild the factor from all observations
 void GaussianProcess::UpdateGaussianProcess()
 {
 	Covariance();
-	L = K.Cholesky();
-	inv_L = L.Inverse();
-	inv_K = inv_L*Transpose(inv_L);
-	alpha = inv_K*Y; 
+	L.clear();
+	z = Vector();
+	L.reserve(N*(N+1)/2);
+	for(int i=0; i<N; ++i) {
+		Vector k(i);
+		for(int j=0; j<i; ++j) {
+			k(j) = K(j,i);
+		}
+		ExtendCholesky(k, K(i,i), Y(i));
+	}
+	UpdateAlpha();
 }
 
 real GaussianProcess::GeneratePrediction(const Vector& x)
@@ -177,13 +297,14 @@ void GaussianProcess::Prediction(Vector& x, real& mean, real& var)
 
 real GaussianProcess::PredictiveMean(const Vector& k)
 {
+	UpdateAlpha();
 	real mean = Product(k, alpha); ///(mean = k'*alpha) 
 	return mean;
 }
 
 real GaussianProcess::PredictiveVariance(const Vector& k)
 {
-	Vector v = Transpose(inv_L)*k;
+	Vector v = SolveTransposed(k);
 	real var = sig_var*sig_var - Product(v,v);
 	return var;
 }
@@ -192,17 +313,62 @@ real GaussianProcess::PredictiveVariance(const Vector& k)
 void GaussianProcess::Covariance()
 {
 	/// The covariance matrix is symmetric
-	K = Matrix(N,N);
-	for(int i=0; i<N; ++i) { 
-		Vector S = X.getRow(i);
-		for(int j = i; j < N; ++j) {
-			real delta = ((S - X.getRow(j))/scale_length).SquareNorm();
-			delta = sig_var*sig_var*exp(-0.5*delta);
-			if(i == j) {
-				K(i,j) = delta + noise_variance*noise_variance;
-			}else {
-				K(i,j) = delta;
-				K(j,i) = delta;
+	KernelMatrix(X, X, K);
+	for(int i=0; i<N; ++i) {
+		K(i,i) += noise_variance*noise_variance;
+	}
+}
+
+/** Kernel between every row of A and every row of B.
+
+	The rows of B are scaled by the length scale and stored by
+	dimension, so that the squared distances from one row of A to a
+	block of rows of B are accumulated over contiguous memory, one
+	dimension at a time. Blocks of B are kept in cache while all rows
+	of A pass over them.
+*/
+void GaussianProcess::KernelMatrix(const Matrix& A, const Matrix& B, Matrix& K_AB) const
+{
+	int n_a = A.Rows();
+	int n_b = B.Rows();
+	int d = A.Columns();
+	real sig2 = sig_var*sig_var;
+	K_AB = Matrix(n_a, n_b);
+	if(n_a == 0 || n_b == 0) {
+		return;
+	}
+	assert(B.Columns() == d && scale_length.Size() == d);
+	std::vector<real> A_s(n_a*d);
+	for(int i=0; i<n_a; ++i) {
+		for(int k=0; k<d; ++k) {
+			A_s[i*d + k] = A(i,k) / scale_length(k);
+		}
+	}
+	std::vector<real> B_s(d*n_b);
+	for(int k=0; k<d; ++k) {
+		for(int j=0; j<n_b; ++j) {
+			B_s[k*n_b + j] = B(j,k) / scale_length(k);
+		}
+	}
+	const int block_size = 256;
+	std::vector<real> distance(block_size);
+	for(int j0=0; j0<n_b; j0+=block_size) {
+		int n_j = std::min(block_size, n_b - j0);
+		for(int i=0; i<n_a; ++i) {
+			real* dist = &distance[0];
+			for(int j=0; j<n_j; ++j) {
+				dist[j] = 0.0;
+			}
+			for(int k=0; k<d; ++k) {
+				real a_k = A_s[i*d + k];
+				const real* b_k = &B_s[k*n_b + j0];
+				for(int j=0; j<n_j; ++j) {
+					real delta = a_k - b_k[j];
+					dist[j] += delta*delta;
+				}
+			}
+			for(int j=0; j<n_j; ++j) {
+				K_AB(i, j0 + j) = sig2*exp(-0.5*dist[j]);
 			}
 		}
 	}
@@ -240,26 +406,147 @@ Matrix GaussianProcess::CovarianceDerivatives(int p)
 /// Kernel function
 Vector GaussianProcess::Kernel(const Vector& x)
 {
-	Vector k(N);
-	real sig_noise = sig_var*sig_var;
-	for(int i=0; i<N; ++i) { 
-		real delta = ((x - X.getRow(i))/scale_length).SquareNorm();
-		delta = sig_noise*exp(-0.5*delta);
-		k(i) = delta; 
+	if(N == 0) {
+		return Vector();
 	}
-	return k;
+	Matrix x_row(1, x.Size());
+	x_row.setRow(0, x);
+	Matrix k;
+	KernelMatrix(x_row, X, k);
+	return k.getRow(0);
 }
-												   
 
+/// Predict at every row of X_q
+void GaussianProcess::Predict(const Matrix& X_q, Vector& mean, Vector& var)
+{
+	int Q = X_q.Rows();
+	mean = Vector(Q);
+	var = Vector(Q);
+	real sig2 = sig_var*sig_var;
+	if(N == 0) {
+		for(int i=0; i<Q; ++i) {
+			var(i) = sig2;
+		}
+		return;
+	}
+	UpdateAlpha();
+	Matrix K_q;
+	KernelMatrix(X_q, X, K_q);
+	for(int i=0; i<Q; ++i) {
+		Vector k = K_q.getRow(i);
+		Vector v = SolveTransposed(k);
+		mean(i) = Product(k, alpha);
+		var(i) = sig2 - Product(v, v);
+	}
+}
 
 /// Log marginal likelihood computation
 real GaussianProcess::LogLikelihood()
 {
+	UpdateAlpha();
 	real slogL = 0.0;
 	for(int i=0; i<N; ++i) {
-		slogL += log(L(i,i));
+		slogL += log(Factor(i,i));
 	}
 	real LogLik = -0.5*Product(Y, alpha) - slogL - (0.5*N)*log(2*M_PI);
 	return LogLik;
 }
 
+/** Gradient of the log marginal likelihood.
+
+	With \f$W = \alpha\alpha' - K^{-1}\f$, the derivative with respect to
+	a hyperparameter \f$\theta\f$ is \f$\frac{1}{2} tr(W \partial K /
+	\partial \theta)\f$. The inverse is obtained once from the current
+	factor, and all derivatives are accumulated in one pass over the
+	pairs of points, without forming the matrices of
+	CovarianceDerivatives().
+
+	The gradient is with respect to the logarithms of the length
+	scales, the signal variance and the noise variance, in that order.
+*/
+Vector GaussianProcess::LogLikelihoodGradient()
+{
+	int d = scale_length.Size();
+	Vector gradient(d + 2);
+	if(N == 0) {
+		return gradient;
+	}
+	UpdateAlpha();
+	Matrix inv_K = InverseCovariance();
+	Matrix K_f;
+	KernelMatrix(X, X, K_f);
+	Vector delta(d);
+	for(int i=0; i<N; ++i) {
+		for(int j=0; j<=i; ++j) {
+			// W is symmetric: count pairs off the diagonal twice
+			real w = alpha(i)*alpha(j) - inv_K(i,j);
+			if(i == j) {
+				w *= 0.5;
+				gradient(d + 1) += w*2.0*noise_variance*noise_variance;
+			}
+			real wk = w*K_f(i,j);
+			gradient(d) += wk*2.0;
+			for(int k=0; k<d; ++k) {
+				real delta_k = (X(i,k) - X(j,k)) / scale_length(k);
+				gradient(k) += wk*delta_k*delta_k;
+			}
+		}
+	}
+	return gradient;
+}
+
+/** Fit the hyperparameters by gradient ascent on the log marginal likelihood.
+
+	Steps are taken in the logarithms of the hyperparameters. The step
+	size grows after every improvement, and is halved when a step does
+	not improve the likelihood, in which case the step is undone. Each
+	iteration needs one factorisation. Returns the final log
+	likelihood.
+*/
+real GaussianProcess::OptimiseHyperparameters(int n_iterations, real step_size)
+{
+	int d = scale_length.Size();
+	UpdateGaussianProcess();
+	real log_likelihood = LogLikelihood();
+	Vector gradient = LogLikelihoodGradient();
+	for(int iter=0; iter<n_iterations; ++iter) {
+		Vector old_scale_length = scale_length;
+		real old_sig_var = sig_var;
+		real old_noise_variance = noise_variance;
+		std::vector<real> old_L = L;
+		Vector old_z = z;
+		Matrix old_K = K;
+		
+		for(int k=0; k<d; ++k) {
+			scale_length(k) *= exp(step_size*gradient(k));
+		}
+		sig_var *= exp(step_size*gradient(d));
+		noise_variance *= exp(step_size*gradient(d + 1));
+		
+		bool improved = false;
+		try {
+			UpdateGaussianProcess();
+			real new_log_likelihood = LogLikelihood();
+			if(new_log_likelihood >= log_likelihood) {
+				log_likelihood = new_log_likelihood;
+				improved = true;
+			}
+		} catch (std::runtime_error& e) {
+			improved = false;
+		}
+		if(improved) {
+			gradient = LogLikelihoodGradient();
+			step_size *= 1.2;
+		} else {
+			scale_length = old_scale_length;
+			sig_var = old_sig_var;
+			noise_variance = old_noise_variance;
+			L = old_L;
+			z = old_z;
+			K = old_K;
+			updated_alpha = false;
+			step_size *= 0.5;
+		}
+	}
+	return log_likelihood;
+}
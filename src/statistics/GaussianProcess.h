@@ -23,6 +23,11 @@
 /** Gaussian process. 
     
     This is a {\em conditional} distribution.
+
+    The kernel matrix is kept as its Cholesky factor \f$K = L'L\f$,
+    with \f$L\f$ upper triangular. AddObservation() appends a column
+    to the factor in \f$O(N^2)\f$ time, and predictions use
+    triangular solves with it instead of explicit inverses.
  */
 class GaussianProcess
 {
@@ -34,10 +39,10 @@ protected:
     Matrix Sigma_p;
     Matrix Accuracy;
     Matrix A;
-	Matrix L;  ///< Cholesky Decomposition (L is an upper tringular matrix)
-	Matrix inv_L;
+	std::vector<real> L;  ///< Cholesky Decomposition (L is an upper tringular matrix), packed by columns
+	Vector z; ///< z = L'^{-1} Y
+	bool updated_alpha; ///< alpha = L^{-1} z is up to date
 	Matrix K;  ///< Kernel(Covariance) Matrix
-	Matrix inv_K; ///< Inverse Covariance Matrix (Precision)
 	/// Kernel hyperparameters.
     real noise_variance;	///< noise variance
 	Vector scale_length;	///< lenght scale
@@ -45,6 +50,20 @@ protected:
     Matrix X2; ///< observation co-variance
     Vector mean;
     Matrix covariance;
+	/// Element (i, j) of the factor, for i <= j
+	real& Factor(int i, int j)
+	{
+		return L[j*(j+1)/2 + i];
+	}
+	const real& Factor(int i, int j) const
+	{
+		return L[j*(j+1)/2 + i];
+	}
+	void ExtendCholesky(const Vector& k, real k_xx, real y);
+	Vector SolveTransposed(const Vector& k) const;
+	Vector Solve(const Vector& v) const;
+	void UpdateAlpha();
+	Matrix InverseCovariance() const;
 public:
     GaussianProcess(Matrix& Sigma_p_,
                     real noise_variance_);
@@ -74,6 +93,13 @@ public:
 	virtual Matrix CovarianceDerivatives(int p);
 	virtual Vector Kernel(const Vector& x);
 	virtual real LogLikelihood();
+	void KernelMatrix(const Matrix& A, const Matrix& B, Matrix& K_AB) const;
+	virtual void Predict(const Matrix& X_q, Vector& mean, Vector& var);
+	Vector LogLikelihoodGradient();
+	real OptimiseHyperparameters(int n_iterations = 100, real step_size = 0.01);
+	const Vector& getScaleLength() const { return scale_length; }
+	real getSignalVariance() const { return sig_var; }
+	real getNoiseVariance() const { return noise_variance; }
 };
 
 #endif
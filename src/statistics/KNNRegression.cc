@@ -36,14 +36,12 @@ void KNNRegression::Evaluate(Vector& x, Vector& y, int K)
         y[i] = 0;
     }
 
-    OrderedFixedList<KDNode> node_list = kd_tree.FindKNearestNeighbours(x, K);
-    
-    std::list<std::pair<real, KDNode*> >::iterator it;
+    std::vector<void_FlatKDTree::Neighbour> neighbours;
+    kd_tree.FindKNearestNeighbours(x, K, neighbours);
     
     real sum = 0;
-    for (it = node_list.S.begin(); it != node_list.S.end(); ++it) {
-        KDNode* node = it->second;
-        PointPair* point_pair = kd_tree.getObject(node);
+    for (uint k=0; k<neighbours.size(); ++k) {
+        PointPair* point_pair = kd_tree.getObject(neighbours[k].second);
         rbf.center = point_pair->x;
         real w = rbf.Evaluate(x);
         y += point_pair->y * w;
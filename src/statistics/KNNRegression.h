@@ -12,9 +12,10 @@
 #ifndef KNN_REGRESSION_H
 #define KNN_REGRESSION_H
 
-#include "KDTree.h"
+#include "FlatKDTree.h"
 //#include "CoverTree.h"
 #include "PointPair.h"
+#include <list>
 #include "BasisSet.h"
 
 /** K-Nearest-Neighbour regression */
@@ -23,7 +24,7 @@ class KNNRegression
 protected:
     int M; ///< Tree and conditioning variable dimension
     int N; ///< Dimension of the conditioned variable
-	KDTree<PointPair> kd_tree; ///< The tree
+	FlatKDTree<PointPair> kd_tree; ///< The tree
 	//CoverTree<PointPair> kd_tree;
     //RBFBasisSet basis;
     std::list<PointPair> pairs; ///< A list of pairs
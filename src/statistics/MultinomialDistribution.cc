@@ -75,7 +75,14 @@ void MultinomialDistribution::generate(Vector& x) const
 /// generate an integer
 int MultinomialDistribution::generateInt(const Vector& x)
 {
-    real d=urandom();
+    DefaultRandomNumberGenerator rng;
+    return generateInt(x, rng);
+}
+
+/// generate an integer using the given random number generator
+int MultinomialDistribution::generateInt(const Vector& x, RandomNumberGenerator& rng)
+{
+    real d=rng.uniform();
     real sum = 0.0;
 	int n = x.Size();
 
@@ -34,6 +34,10 @@ public:
     {
         return generateInt(p);
     }
+    int generateInt(RandomNumberGenerator& rng) const
+    {
+        return generateInt(p, rng);
+    }
     virtual Vector getMean()
     {
         return p;
@@ -50,6 +54,7 @@ public:
     virtual real pdf(const Vector& x) const;
     virtual void generate(Vector& x) const;
     static int generateInt(const Vector& x);
+    static int generateInt(const Vector& x, RandomNumberGenerator& rng);
 };
 
 Vector MultinomialDeviation(const Vector& p, const int j, const real c);
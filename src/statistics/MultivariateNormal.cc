@@ -23,54 +23,119 @@ MultivariateNormal::MultivariateNormal(const int n_dim_)
     for (int i=0; i<n_dim; ++i) {
         accuracy(i,i) = 1;
     }
-    determinant = 1;
+    Factorise();
 }
 
 MultivariateNormal::MultivariateNormal(const Vector& mean_, const Matrix& accuracy_)
     :  n_dim(mean_.Size()), mean(mean_), accuracy(accuracy_)
 {
-    accuracy.LUDecomposition(determinant);
+    Factorise();
+}
+
+/** Factorise the accuracy.
+
+    With \f$T = U^\top U\f$, a sample is \f$\mu + U^{-1} z\f$ for a
+    standard normal \f$z\f$, since \f$U^{-1} U^{-\top} = T^{-1}\f$.
+    Stores \f$U^{-\top}\f$, so that a row of samples is \f$z^\top U^{-\top}\f$.
+ */
+void MultivariateNormal::Factorise()
+{
+    assert(accuracy.Rows() == n_dim && accuracy.Columns() == n_dim);
+    chol_accuracy = accuracy.Cholesky();
+    const Matrix& U = chol_accuracy;
+    log_determinant = 0;
+    for (int i=0; i<n_dim; ++i) {
+        log_determinant += 2.0 * log(U(i,i));
+    }
+    sampling_factor = Matrix(n_dim, n_dim);
+    Matrix& L = sampling_factor;
+    // back-substitution for the columns of U^{-1}, stored transposed
+    for (int j=0; j<n_dim; ++j) {
+        L(j,j) = 1.0 / U(j,j);
+        for (int i=j-1; i>=0; --i) {
+            real sum = 0.0;
+            for (int k=i+1; k<=j; ++k) {
+                sum += U(i,k) * L(j,k);
+            }
+            L(j,i) = - sum / U(i,i);
+        }
+    }
 }
 
 /// In-place multivariate Gaussian generation
 void MultivariateNormal::generate(Vector& x) const
 {
-	x = generate();
+    NormalDistribution normal;
+	Vector v(n_dim);
+    for (int i=0; i<n_dim; ++i) {
+        v(i) = normal.generate();
+    }
+    x = mean;
+    const Matrix& L = sampling_factor;
+    for (int i=0; i<n_dim; ++i) {
+        real sum = 0.0;
+        for (int k=i; k<n_dim; ++k) {
+            sum += L(k,i) * v(k);
+        }
+        x(i) += sum;
+    }
 }
 
 /** Multivariate Gaussian generation.
-    Uses the Cholesky decomposition.
+    Uses the cached Cholesky factor of the accuracy.
  */
 Vector MultivariateNormal::generate() const
 {	
-    Matrix Sigma = accuracy;
-    Sigma = Sigma.Inverse();
-    Matrix A = Sigma.Cholesky();
+    Vector x(n_dim);
+    generate(x);
+    return x;
+}
+
+/** Generate n samples, one in each row of X.
+
+    The standard normal draws are transformed with a single
+    matrix product with the triangular factor.
+ */
+void MultivariateNormal::generate(int n, Matrix& X) const
+{
     NormalDistribution normal;
-	Vector v(n_dim);
-    for (int i=0; i<n_dim; ++i) {
-        v(i) = normal.generate();
+    Matrix Z(n, n_dim);
+    for (int t=0; t<n; ++t) {
+        for (int i=0; i<n_dim; ++i) {
+            Z(t,i) = normal.generate();
+        }
+    }
+    X = Z * sampling_factor;
+    for (int t=0; t<n; ++t) {
+        for (int i=0; i<n_dim; ++i) {
+            X(t,i) += mean(i);
+        }
     }
-
-    const Matrix Ar = Transpose(A);
-    return mean + Ar*v;
 }
 
 /** Multivariate Gaussian density.
 
     For a gaussian with mean and precision \f$\mu, T\f$, the pdf is given by
     \f[
-    f(x \mid \mu, T) = (2\pi)^{-k/2} |T|^{1/2} 
+    f(x \mid \mu, T) = (2\pi)^{-k/2} |T|^{1/2} \exp(-(x - \mu)^\top T (x - \mu) / 2),
     \f]
+    where the quadratic form is \f$\|U(x - \mu)\|^2\f$.
  */
 real MultivariateNormal::log_pdf(const Vector& x) const
 {
 	assert (x.Size()==mean.Size());
 	real n = (real) x.Size();
     Vector diff = x - mean;
-	real d = Mahalanobis2(diff, accuracy.Inverse(), diff);
-    assert(d >= 0);
-	real log_pdf = 0.5 * (log(determinant) - d - n * log(2*M_PI));
+    const Matrix& U = chol_accuracy;
+	real d = 0.0;
+    for (int i=0; i<n_dim; ++i) {
+        real u = 0.0;
+        for (int j=i; j<n_dim; ++j) {
+            u += U(i,j) * diff(j);
+        }
+        d += u * u;
+    }
+	real log_pdf = 0.5 * (log_determinant - d - n * log(2*M_PI));
     return log_pdf;
 }
 
@@ -14,14 +14,23 @@
 
 #include "NormalDistribution.h"
 
-/// Multivariate Gaussian probability distribution
+/** Multivariate Gaussian probability distribution.
+
+    The Cholesky factor \f$U\f$ of the accuracy \f$T = U^\top U\f$,
+    its inverse and the log-determinant are computed once, whenever
+    the accuracy is set, so that neither sampling nor the density
+    needs to invert a matrix.
+*/
 class MultivariateNormal : public VectorDistribution
 {
  private:
     int n_dim;
     Vector mean;
     Matrix accuracy;
-    real determinant;
+    Matrix chol_accuracy; ///< upper triangular U, with T = U'U
+    Matrix sampling_factor; ///< lower triangular inverse of U'
+    real log_determinant; ///< log-determinant of the accuracy
+    void Factorise();
  public:
     MultivariateNormal(const int n_dim_);
     MultivariateNormal(const Vector& mean_, const Matrix& accuracy_);
@@ -32,11 +41,16 @@ class MultivariateNormal : public VectorDistribution
     void setAccuracy(const Matrix& accuracy_)
     {
         accuracy = accuracy_;
-        accuracy.LUDecomposition(determinant);
+        Factorise();
+    }
+    real getLogDeterminant() const
+    {
+        return log_determinant;
     }
     virtual ~MultivariateNormal() {}
     virtual void generate(Vector& x) const;
     virtual Vector generate() const;
+    void generate(int n, Matrix& X) const;
     virtual real log_pdf(const Vector& x) const;
     virtual real pdf(const Vector& x) const
     {
@@ -50,6 +50,12 @@ real NormalDistribution::generate()
         return normal_rho * sin(2.0 * M_PI * normal_x) * s + m; 
     }
 }
+
+/// Generate using the given random number generator.
+real NormalDistribution::generate(RandomNumberGenerator& rng) const
+{
+    return rng.normal() * s + m;
+}
 /// Normal distribution log-pdf
 real NormalDistribution::log_pdf(real x) const
 {
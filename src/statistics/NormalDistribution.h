@@ -45,6 +45,7 @@ class NormalDistribution : public ParametricDistribution {
     virtual ~NormalDistribution() {}
     virtual real generate();
     virtual real generate() const;
+    real generate(RandomNumberGenerator& rng) const;
     virtual real log_pdf(real x) const;
     virtual real pdf(real x) const;
     void setSTD(real std)
@@ -11,7 +11,15 @@
  ***************************************************************************/
 
 #include "ParticleFilter.h"
+#include "debug.h"
+#include <algorithm>
+#include <cmath>
+
 ParticleFilter::ParticleFilter(int N, Distribution* prior, Distribution* T, Distribution* O)
+	: resampling(SYSTEMATIC_RESAMPLING),
+	  resampling_threshold(1.0),
+	  use_log_weights(false),
+	  cumulative_valid(false)
 {
 	this->transitions = T;
 	this->observations = O;
@@ -28,6 +36,10 @@ void ParticleFilter::Init(int N, Distribution* prior, Distribution* T, Distribut
 }
 
 ParticleFilter::ParticleFilter()
+	: resampling(SYSTEMATIC_RESAMPLING),
+	  resampling_threshold(1.0),
+	  use_log_weights(false),
+	  cumulative_valid(false)
 {
 	transitions = NULL;
 	observations = NULL;
@@ -42,6 +54,10 @@ void ParticleFilter::SetNumberOfEstimates(int n_estimates)
 	y2.resize(N);
 	w.resize(N);
 	w2.resize(N);
+	if (use_log_weights) {
+		log_w.resize(N);
+	}
+	cumulative_valid = false;
 	if (prior) {
 		Reset();
 	}
@@ -58,44 +74,226 @@ void ParticleFilter::Reset()
 		//printf ("(%f, %f)", w[i], y[i]);
 	}
 	//printf ("\n");
+	if (use_log_weights) {
+		real log_a = log(a);
+		for (int i=0; i<N; i++) {
+			log_w[i] = log_a;
+		}
+	}
+	cumulative_valid = false;
+}
+
+/** Choose how and when to resample.
+
+	\param method the resampling scheme
+	\param threshold resample when the effective sample size is below
+	threshold times the number of particles; 0 never resamples.
+*/
+void ParticleFilter::setResampling(ResamplingMethod method, real threshold)
+{
+	resampling = method;
+	resampling_threshold = threshold;
+}
+
+/// Keep log-weights, so that the weights never underflow
+void ParticleFilter::setLogWeights(bool use_log_weights_)
+{
+	if (use_log_weights_ && !use_log_weights) {
+		log_w.resize(N);
+		for (int i=0; i<N; i++) {
+			log_w[i] = log(w[i]);
+		}
+	}
+	use_log_weights = use_log_weights_;
+}
+
+/// Sum with independent partial sums, which the compiler can vectorise
+static real PartialSums(const real* x, int n)
+{
+	real s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+	int i = 0;
+	for (; i + 4 <= n; i += 4) {
+		s0 += x[i];
+		s1 += x[i + 1];
+		s2 += x[i + 2];
+		s3 += x[i + 3];
+	}
+	for (; i < n; i++) {
+		s0 += x[i];
+	}
+	return (s0 + s1) + (s2 + s3);
+}
+
+/** Resample if the effective sample size is too small.
+
+	The resampled particles replace y and get uniform weights.
+
+	\return whether the particles were resampled.
+*/
+bool ParticleFilter::MaybeResample()
+{
+	if (EffectiveSampleSize(w) >= resampling_threshold * (real) N) {
+		return false;
+	}
+	ancestors.resize(N);
+	Resample(resampling, w, ancestors);
+	for (int n=0; n<N; n++) {
+		y2[n] = y[ancestors[n]];
+	}
+	y.swap(y2);
+	UniformWeights();
+	return true;
+}
+
+/// Give all particles the same weight
+void ParticleFilter::UniformWeights()
+{
+	real a = 1.0 / (real) N;
+	std::fill(w.begin(), w.end(), a);
+	if (use_log_weights) {
+		std::fill(log_w.begin(), log_w.end(), log(a));
+	}
+	cumulative_valid = false;
+}
+
+/// Multiply the weights by the likelihood of each particle and normalise
+void ParticleFilter::Reweight(const real* likelihood)
+{
+	cumulative_valid = false;
+	if (use_log_weights) {
+		real* lw = &log_w[0];
+		for (int i=0; i<N; i++) {
+			lw[i] += log(likelihood[i]);
+		}
+		Normalise();
+		return;
+	}
+	real* p = &w2[0];
+	const real* q = &w[0];
+	for (int i=0; i<N; i++) {
+		p[i] = likelihood[i] * q[i];
+	}
+	real sum = PartialSums(p, N);
+	if (sum==0.0f) {
+		fprintf (stderr, "ERROR: 0 mass on prior!!\n");
+		exit(-1);
+	}
+
+	// Normalise to create a new filtering distribution
+	real isum = 1.0f / sum;
+	real* r = &w[0];
+	for (int i=0; i<N; i++) {
+		r[i] = p[i] * isum;
+	}
+}
+
+/** Multiply the weights by the exponential of log_likelihood and normalise.
+
+	With log-weights the update stays in log space. Otherwise the
+	likelihoods are scaled by their maximum before exponentiation. The
+	log_likelihood may be stored in w2.
+*/
+void ParticleFilter::ReweightLog(const real* log_likelihood)
+{
+	if (use_log_weights) {
+		cumulative_valid = false;
+		real* lw = &log_w[0];
+		for (int i=0; i<N; i++) {
+			lw[i] += log_likelihood[i];
+		}
+		Normalise();
+		return;
+	}
+	real max_ll = *std::max_element(log_likelihood, log_likelihood + N);
+	if (max_ll == LOG_ZERO || std::isnan(max_ll)) {
+		fprintf (stderr, "ERROR: 0 mass on prior!!\n");
+		exit(-1);
+	}
+	real* likelihood = &w2[0];
+	for (int i=0; i<N; i++) {
+		likelihood[i] = exp(log_likelihood[i] - max_ll);
+	}
+	Reweight(likelihood);
+}
+
+/// Set the weights from the log-weights, and normalise both
+void ParticleFilter::Normalise()
+{
+	real* lw = &log_w[0];
+	real* r = &w[0];
+	real max_lw = *std::max_element(log_w.begin(), log_w.end());
+	if (max_lw == LOG_ZERO || std::isnan(max_lw)) {
+		fprintf (stderr, "ERROR: 0 mass on prior!!\n");
+		exit(-1);
+	}
+	for (int i=0; i<N; i++) {
+		r[i] = exp(lw[i] - max_lw);
+	}
+	real sum = PartialSums(r, N);
+	real isum = 1.0 / sum;
+	real log_sum = max_lw + log(sum);
+	for (int i=0; i<N; i++) {
+		r[i] *= isum;
+		lw[i] -= log_sum;
+	}
 }
 
 ParticleFilter::~ParticleFilter()
 {
 }
 
+/// Draw a particle and move it. The first draw after an update costs O(N), later ones O(log N).
 real ParticleFilter::Sample()
 {
-	int Yn = PropSample (w);
+	if (!cumulative_valid) {
+		cumulative.resize(N);
+		real sum = 0.0;
+		for (int i=0; i<N; i++) {
+			sum += w[i];
+			cumulative[i] = sum;
+		}
+		cumulative_valid = true;
+	}
+	real X = UniformSample() * cumulative[N - 1];
+	int Yn = std::upper_bound(cumulative.begin(), cumulative.end(), X) - cumulative.begin();
+	Yn = std::min(Yn, N - 1);
 	return y[Yn] + transitions->generate(); 
 }
 
+/** Move the particles and weight them by the likelihood of x.
+
+	This is a marginal particle filter. The particles are resampled if
+	their weights have degenerated, and each one is moved by the
+	transition distribution. The new weight of a particle is its
+	likelihood times the predictive density under the current weights,
+	divided by its proposal density. As the old weights enter through
+	the predictive density, the update starts from uniform weights.
+	Evaluating both densities takes O(N) time per particle.
+*/
 void ParticleFilter::Observe(real x)
 {
-	// Generate a set of samples from our current belief
+	MaybeResample();
 	for (int n=0; n<N; n++) {
-		y2[n] = Sample();
+		y2[n] = y[n] + transitions->generate();
 	}
 
-	// Evaluate the new posterior up to a normalising constant
-	real sum = 0.0f;
+	// Evaluate the log of the new weights, up to a constant
+	real* log_likelihood = &w2[0];
+	const real* q = &w[0];
 	for (int i=0; i<N; i++) {
-		real likelihood = observations->pdf(x - y2[i]);
-		real prior = 0.0f;
+		real predictive = 0.0;
+		real proposal = 0.0;
 		for (int j=0; j<N; j++) {
-			prior += w[j]*transitions->pdf(y[j] - y2[i]);
+			real p = transitions->pdf(y2[i] - y[j]);
+			predictive += q[j] * p;
+			proposal += p;
 		}
-		w2[i] = likelihood*prior;
-		sum += w2[i];
-	}
-
-	// Normalise to create a new filtering distribution
-	real isum = 1.0f / sum;
-	for (int i=0; i<N; i++) {
-		w[i] = w2[i] * isum;
-		y[i] = y2[i];
-		//printf ("%f %f\n", w[i], y[i]);
+		log_likelihood[i] = observations->log_pdf(x - y2[i])
+			+ log(predictive) - log(proposal / (real) N);
 	}
+	y.swap(y2);
+	UniformWeights();
+	ReweightLog(log_likelihood);
 }
 
 /// Get the current mean;
@@ -130,37 +328,25 @@ BernoulliParticleFilter::~BernoulliParticleFilter()
 {
 }
 
+/** Move the particles and weight them by the likelihood of x.
+
+	The particles are first resampled if their weights have
+	degenerated, then moved by the transition distribution.
+*/
 void BernoulliParticleFilter::Observe(real x)
 {
-	// Generate a set of samples from our current belief
+	MaybeResample();
 	for (int n=0; n<N; n++) {
-		int Yn = PropSample (w);
-		y2[n] = y[Yn] + transitions->generate();
-		w[n] = w[Yn];
-		//printf ("y2:%f ", y2[n]);
-	}
-	
-	// Evaluate the new posterior up to a normalising constant
-	real sum = 0.0f;
-	for (int i=0; i<N; i++) {
-		real q = y2[i];
-		real likelihood = q*x + (1-q)*(1-x);
-		real prior = w[i];
-		w2[i] = likelihood*prior;
-		sum += w2[i];
-	}
-	if (sum==0.0f) {
-		fprintf (stderr, "ERROR: 0 mass on prior!!\n");
-		exit(-1);
+		y[n] += transitions->generate();
 	}
 
-	// Normalise to create a new filtering distribution
-	real isum = 1.0f / sum;
+	// Evaluate the likelihood of each particle
+	const real* q = &y[0];
+	real* likelihood = &y2[0];
 	for (int i=0; i<N; i++) {
-		w[i] = w2[i] * isum;
-		y[i] = y2[i];
-		//printf ("%f %f\n", w[i], y[i]);
+		likelihood[i] = q[i]*x + (1-q[i])*(1-x);
 	}
+	Reweight(likelihood);
 }
 
 /// Get the current mean;
@@ -197,27 +383,15 @@ BernoulliGridParticleFilter::~BernoulliGridParticleFilter()
 {
 }
 
+/// Weight the particles by the likelihood of x. The grid never moves.
 void BernoulliGridParticleFilter::Observe(real x)
 {
-	// Evaluate the new posterior up to a normalising constant
-	real sum = 0.0f;
-	for (int i=0; i<N; i++) {
-		real q = y[i];
-		real likelihood = q*x + (1-q)*(1-x);
-		real prior = w[i];
-		w2[i] = likelihood*prior;
-		sum += w2[i];
-	}
-	if (sum==0.0f) {
-		fprintf (stderr, "ERROR: 0 mass on prior!!\n");
-		exit(-1);
-	}
-
-	// Normalise to create a new filtering distribution
-	real isum = 1.0f / sum;
+	const real* q = &y[0];
+	real* likelihood = &y2[0];
 	for (int i=0; i<N; i++) {
-		w[i] = w2[i] * isum;
+		likelihood[i] = q[i]*x + (1-q[i])*(1-x);
 	}
+	Reweight(likelihood);
 }
 
 /// Get the current mean;
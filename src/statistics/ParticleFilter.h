@@ -18,8 +18,34 @@
 #include "Distribution.h"
 #include <vector>
 
+/** A particle filter for a scalar hidden variable.
+
+    The particle values y and normalised weights w are kept in separate
+    arrays. Before moving the particles, the filters resample them
+    with one of the linear-time schemes of Resample(), but only when
+    the effective sample size falls below resampling_threshold times
+    the number of particles. The default threshold of 1 resamples at
+    every step unless the weights are uniform.
+
+    With log-weights, the filters also keep the unnormalised
+    log-weights and normalise them after every observation, so that
+    the weights never underflow over long runs.
+ */
 class ParticleFilter
 {
+ protected:
+    ResamplingMethod resampling; ///< resampling scheme
+    real resampling_threshold; ///< resample when ESS / N falls below this
+    bool use_log_weights; ///< whether to keep log-weights
+    std::vector<real> log_w; ///< log-weights, if used
+    std::vector<int> ancestors; ///< workspace for resampling
+    std::vector<real> cumulative; ///< cumulative weights, for Sample()
+    bool cumulative_valid; ///< whether cumulative matches w
+    bool MaybeResample();
+    void UniformWeights();
+    void Reweight(const real* likelihood);
+    void ReweightLog(const real* log_likelihood);
+    void Normalise();
  public:
     int N;
     std::vector<real> y;
@@ -40,6 +66,12 @@ class ParticleFilter
     virtual void Observe(real x);
     virtual real GetMean();
     virtual real GetVar();
+    void setResampling(ResamplingMethod method, real threshold = 1.0);
+    void setLogWeights(bool use_log_weights_);
+    real getEffectiveSampleSize() const
+    {
+        return EffectiveSampleSize(w);
+    }
 };
 
 
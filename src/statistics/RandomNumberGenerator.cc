@@ -0,0 +1,63 @@
+/* -*- Mode: C++; -*- */
+// copyright (c) 2013 by Christos Dimitrakakis <christos.dimitrakakis@gmail.com>
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "RandomNumberGenerator.h"
+#include <cassert>
+
+/** Generate a standard normal variate.
+
+	Uses the Box-Muller transform. No state is kept between calls, so
+	that the output only depends on the generator.
+*/
+real RandomNumberGenerator::normal()
+{
+    real x = uniform();
+    real y = uniform();
+    return sqrt(-2.0 * log(1.0 - y)) * cos(2.0 * M_PI * x);
+}
+
+/// Generate a standard exponential variate.
+real RandomNumberGenerator::exponential()
+{
+    return - log(1.0 - uniform());
+}
+
+/** Generate a gamma variate with the given shape and unit scale.
+
+	Uses the method of Marsaglia and Tsang (2000). Shapes below 1
+	are boosted by one and corrected with a uniform variate.
+*/
+real RandomNumberGenerator::gamma(real shape)
+{
+    assert(shape > 0);
+    if (shape < 1.0) {
+        real u = uniform();
+        return gamma(1.0 + shape) * pow(1.0 - u, 1.0 / shape);
+    }
+    real d = shape - 1.0 / 3.0;
+    real c = 1.0 / sqrt(9.0 * d);
+    while (true) {
+        real x, v;
+        do {
+            x = normal();
+            v = 1.0 + c * x;
+        } while (v <= 0.0);
+        v = v * v * v;
+        real u = 1.0 - uniform();
+        real x2 = x * x;
+        if (u < 1.0 - 0.0331 * x2 * x2) {
+            return d * v;
+        }
+        if (log(u) < 0.5 * x2 + d * (1.0 - v + log(v))) {
+            return d * v;
+        }
+    }
+}
@@ -48,6 +48,15 @@ public:
     {
         return lower_bound + (upper_bound - lower_bound) * uniform();
     }
+
+    /// Generates a standard normal variate.
+    real normal();
+
+    /// Generates an exponential variate with unit rate.
+    real exponential();
+
+    /// Generates a gamma variate with the given shape and unit scale.
+    real gamma(real shape);
 };
 
 class DefaultRandomNumberGenerator : public RandomNumberGenerator
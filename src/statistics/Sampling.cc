@@ -10,7 +10,11 @@
  *                                                                         *
  ***************************************************************************/
 #include "Sampling.h"
+#include "debug.h"
+#include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <cstdio>
 
 int PropSample (std::vector<real>& w)
 {
@@ -26,3 +30,111 @@ int PropSample (std::vector<real>& w)
     }
     return rand()%n;
 }
+
+/** Place evenly spaced or stratified points on the cumulative weights.
+
+    Point k is (k + u_k) / n. With a single offset, u_k = u_0 for all
+    k, this is systematic resampling; with independent u_k it is
+    stratified resampling. The points are increasing, so a single
+    sweep over the weights finds all of them.
+
+    \param w the weights, summing to total
+    \param index the n ancestors, written from position start
+ */
+static void SweepResample (const std::vector<real>& w, real total, int n,
+                           bool stratified, std::vector<int>& index, int start)
+{
+    int N = w.size();
+    real step = total / (real) n;
+    real u = UniformSample();
+    real cumulative = w[0];
+    int i = 0;
+    for (int k=0; k<n; ++k) {
+        if (stratified && k > 0) {
+            u = UniformSample();
+        }
+        real point = ((real) k + u) * step;
+        while (point >= cumulative && i < N - 1) {
+            cumulative += w[++i];
+        }
+        index[start + k] = i;
+    }
+}
+
+/** Draw index.size() ancestors from the weights w.
+
+    All methods are linear in the number of particles, apart from
+    multinomial resampling, which needs a binary search for each draw.
+    Systematic, stratified and residual resampling have lower variance
+    than multinomial resampling. The ancestors are sorted, except for
+    multinomial resampling.
+*/
+void Resample (ResamplingMethod method, const std::vector<real>& w, std::vector<int>& index)
+{
+    int N = w.size();
+    int n = index.size();
+    assert(N > 0);
+    real total = 0.0;
+    for (int i=0; i<N; ++i) {
+        total += w[i];
+    }
+    assert(total > 0);
+    switch (method) {
+    case MULTINOMIAL_RESAMPLING: {
+        std::vector<real> cumulative(N);
+        real sum = 0.0;
+        for (int i=0; i<N; ++i) {
+            sum += w[i];
+            cumulative[i] = sum;
+        }
+        for (int k=0; k<n; ++k) {
+            real X = UniformSample() * total;
+            int i = std::upper_bound(cumulative.begin(), cumulative.end(), X) - cumulative.begin();
+            index[k] = std::min(i, N - 1);
+        }
+        break;
+    }
+    case SYSTEMATIC_RESAMPLING:
+        SweepResample(w, total, n, false, index, 0);
+        break;
+    case STRATIFIED_RESAMPLING:
+        SweepResample(w, total, n, true, index, 0);
+        break;
+    case RESIDUAL_RESAMPLING: {
+        // deterministic copies first
+        int k = 0;
+        std::vector<real> residual(N);
+        real residual_total = 0.0;
+        for (int i=0; i<N; ++i) {
+            real expected = (real) n * w[i] / total;
+            int copies = (int) floor(expected);
+            for (int c=0; c<copies && k<n; ++c) {
+                index[k++] = i;
+            }
+            residual[i] = expected - (real) copies;
+            residual_total += residual[i];
+        }
+        // the rest from the residual weights
+        if (k < n) {
+            SweepResample(residual, residual_total, n - k, false, index, k);
+            std::sort(index.begin(), index.end());
+        }
+        break;
+    }
+    default:
+        Serror("Unknown resampling method %d\n", method);
+        exit(-1);
+    }
+}
+
+/// The effective sample size \f$(\sum_i w_i)^2 / \sum_i w_i^2\f$
+real EffectiveSampleSize (const std::vector<real>& w)
+{
+    real sum = 0.0;
+    real sum2 = 0.0;
+    for (uint i=0; i<w.size(); ++i) {
+        sum += w[i];
+        sum2 += w[i] * w[i];
+    }
+    return sum * sum / sum2;
+}
@@ -25,4 +25,15 @@ inline real UniformSample()
 
 int PropSample (std::vector<real>& w);
 
+/// Ways to draw a new particle population from normalised weights
+enum ResamplingMethod {
+    MULTINOMIAL_RESAMPLING, ///< independent draws, O(N log N)
+    SYSTEMATIC_RESAMPLING, ///< one uniform offset for evenly spaced points
+    STRATIFIED_RESAMPLING, ///< one uniform point in each of N strata
+    RESIDUAL_RESAMPLING ///< floor(N w) copies, then systematic for the rest
+};
+
+void Resample (ResamplingMethod method, const std::vector<real>& w, std::vector<int>& index);
+real EffectiveSampleSize (const std::vector<real>& w);
+
 #endif
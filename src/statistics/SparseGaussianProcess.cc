@@ -24,6 +24,7 @@ SparseGaussianProcess::SparseGaussianProcess(real noise_variance_,
 	scale_length_dic(scale_length_dic_)
 {
 	N = 0;
+	budget = 0;
 }
 
 SparseGaussianProcess::SparseGaussianProcess(Matrix& X_, 
@@ -41,6 +42,7 @@ SparseGaussianProcess::SparseGaussianProcess(Matrix& X_,
 	v(threshold_),
 	scale_length_dic(scale_length_dic_)
 {
+	budget = 0;
 	Observe(X_, Y_);
 }
 
@@ -82,6 +84,10 @@ void SparseGaussianProcess::Observe(const std::vector<Vector>& x, const std::vec
 
 void SparseGaussianProcess::AddObservation(const Vector& x, const real& y)
 {
+	if(budget > 0) {
+		AddBudgetedObservation(x, y);
+		return;
+	}
 	Vector k;
 	Vector iKk;
 	real mu;
@@ -122,8 +128,80 @@ void SparseGaussianProcess::AddObservation(const std::vector<Vector>& x, const s
 	UpdateSparseGaussianProcess();
 }
 
+/** Add an observation to the budgeted process.
+
+	The observation is projected onto the dictionary: with \f$a =
+	K^{-1} k(x)\f$, it is treated as a noisy observation of \f$a'f\f$,
+	where \f$f\f$ are the function values at the dictionary points.
+	If the residual variance \f$\delta = k(x,x) - a'k(x)\f$ exceeds the
+	threshold (relative to the signal variance) and there is room in
+	the budget, x is first added to the dictionary, conditioning its
+	prior on the current points, and observed directly.
+
+	The dictionary uses the kernel of the process itself, so that the
+	projection and the predictions agree.
+*/
+void SparseGaussianProcess::AddBudgetedObservation(const Vector& x, const real& y)
+{
+	real sig2 = sig_var*sig_var;
+	if(N == 0) {
+		X = Matrix(1, x.Size());
+		X.setRow(0, x);
+		inv_K = Matrix(1,1);
+		inv_K(0,0) = 1.0/sig2;
+		mu_D = Vector(1);
+		Sigma_D = Matrix(1,1);
+		Sigma_D(0,0) = sig2;
+		N = 1;
+		ConditionOn(Vector(1.0), y);
+	} else {
+		Vector k = Kernel(x);
+		Vector a = inv_K*k;
+		real delta = sig2 - Product(a, k);
+		if(delta > v*sig2 && N < budget) {
+			// f(x) given the dictionary has mean a'f and variance delta
+			Vector Sa = Sigma_D*a;
+			Vector column = Sa;
+			column.AddElement(Product(a, Sa) + delta);
+			Sigma_D = Sigma_D.AddRow(Sa);
+			Sigma_D = Sigma_D.AddColumn(column);
+			mu_D.AddElement(Product(a, mu_D));
+			
+			Vector b = a*(-1.0/delta);
+			Matrix inv_K_new = inv_K;
+			inv_K_new.AddOuterProduct(1.0/delta, a, a);
+			inv_K_new = inv_K_new.AddRow(b);
+			b.AddElement(1.0/delta);
+			inv_K = inv_K_new.AddColumn(b);
+			
+			X = X.AddRow(x);
+			N++;
+			Vector e(N);
+			e(N-1) = 1.0;
+			ConditionOn(e, y);
+		} else {
+			ConditionOn(a, y);
+		}
+	}
+	alpha = inv_K*mu_D;
+}
+
+/// Kalman update of the dictionary posterior with an observation y of a'f
+void SparseGaussianProcess::ConditionOn(const Vector& a, const real& y)
+{
+	Vector s = Sigma_D*a;
+	real gamma = noise_variance*noise_variance + Product(a, s);
+	real residual = y - Product(a, mu_D);
+	mu_D += s*(residual/gamma);
+	Sigma_D.AddOuterProduct(-1.0/gamma, s, s);
+}
+
 void SparseGaussianProcess::UpdateSparseGaussianProcess()
 {
+	if(budget > 0) {
+		// the posterior is updated with every observation
+		return;
+	}
 	Covariance();
 	L = K.Cholesky();
 	inv_L = L.Inverse();
@@ -175,11 +253,77 @@ real SparseGaussianProcess::PredictiveMean(const Vector& k)
 
 real SparseGaussianProcess::PredictiveVariance(const Vector& k)
 {
+	if(budget > 0) {
+		if(N == 0) {
+			return sig_var*sig_var;
+		}
+		Vector a = inv_K*k;
+		return sig_var*sig_var - Product(a, k) + Product(a, Sigma_D*a);
+	}
 	Vector iLk = Transpose(inv_L)*k;
 	real var = sig_var*sig_var - Product(iLk,iLk);
 	return var;
 }
 
+/// Predict at many points at once
+void SparseGaussianProcess::Predict(const std::vector<Vector>& x, Vector& mean, Vector& var)
+{
+	int Q = x.size();
+	Matrix K_q(Q, N);
+	for(int i=0; i<Q; ++i) {
+		K_q.setRow(i, Kernel(x[i]));
+	}
+	Predict(K_q, mean, var);
+}
+
+/** Predict at many points at once, from their kernel rows.
+
+	Row i of K_q holds the kernel between the i-th query point and the
+	dictionary, as returned by Kernel(). Callers that query the same
+	points repeatedly can keep these rows; they only change when the
+	dictionary grows.
+*/
+void SparseGaussianProcess::Predict(const Matrix& K_q, Vector& mean, Vector& var)
+{
+	int Q = K_q.Rows();
+	real sig2 = sig_var*sig_var;
+	mean = Vector(Q);
+	var = Vector(Q);
+	if(N == 0) {
+		for(int i=0; i<Q; ++i) {
+			var(i) = sig2;
+		}
+		return;
+	}
+	assert(K_q.Columns() == N);
+	if(budget > 0) {
+		Matrix A = K_q*inv_K;
+		Matrix B = A*Sigma_D;
+		for(int i=0; i<Q; ++i) {
+			real m = 0.0;
+			real r = 0.0;
+			for(int j=0; j<N; ++j) {
+				m += A(i,j)*mu_D(j);
+				r += A(i,j)*(K_q(i,j) - B(i,j));
+			}
+			mean(i) = m;
+			var(i) = sig2 - r;
+		}
+	} else {
+		Matrix V = K_q*inv_L;
+		for(int i=0; i<Q; ++i) {
+			real m = 0.0;
+			real r = 0.0;
+			for(int j=0; j<N; ++j) {
+				m += K_q(i,j)*alpha(j);
+				r += V(i,j)*V(i,j);
+			}
+			mean(i) = m;
+			var(i) = sig2 - r;
+		}
+	}
+}
+
 /// Covariance function estimation
 void SparseGaussianProcess::Covariance()
 {
@@ -228,4 +372,5 @@ Vector SparseGaussianProcess::Kernel(const Vector& x, const Vector& scale)
 void SparseGaussianProcess::Clear()
 {
 	N = 0;
+	alpha = Vector();
 }
@@ -19,7 +19,21 @@
 
 #include <vector>
 
-/** Sparse Gaussian process. */
+/** Sparse Gaussian process.
+
+	The dictionary of basis points is chosen online by approximate
+	linear dependence (ALD): a point is added when its kernel cannot be
+	approximated by those of the dictionary to within the threshold.
+
+	By default all dictionary points are kept, and the process is
+	refitted over the whole dictionary by UpdateSparseGaussianProcess().
+
+	With a budget set by setBudget(), the dictionary holds at most that
+	many points, and the posterior over the function values at the
+	dictionary points is updated in \f$O(M^2)\f$ time per observation.
+	Every observation is projected onto the dictionary, so memory and
+	time per step stay constant over an unbounded stream.
+*/
 class SparseGaussianProcess
 	{
 	protected:
@@ -39,6 +53,11 @@ class SparseGaussianProcess
 		real v; ///<Dictionary threshold
 		Vector scale_length_dic; ///< scale length for dictionary
 		Vector alpha;
+		int budget;		///< maximum dictionary size, or 0 for no budget
+		Vector mu_D;	///< posterior mean of the function at the dictionary points
+		Matrix Sigma_D;	///< posterior covariance of the function at the dictionary points
+		void AddBudgetedObservation(const Vector& x, const real& y);
+		void ConditionOn(const Vector& a, const real& y);
 	public:
 		SparseGaussianProcess(real noise_variance_,
 							  Vector scale_length_,
@@ -66,10 +85,22 @@ class SparseGaussianProcess
 		virtual void Prediction(Vector& x, real& mean, real& var);
 		virtual real PredictiveMean(const Vector& x);
 		virtual real PredictiveVariance(const Vector& x);
+		virtual void Predict(const std::vector<Vector>& x, Vector& mean, Vector& var);
+		virtual void Predict(const Matrix& K_q, Vector& mean, Vector& var);
 		virtual void Covariance();
 		virtual Vector Kernel(const Vector& x);
 		virtual Vector Kernel(const Vector& x, const Vector& scale);
 		virtual void Clear();
+		/// Keep at most budget_ dictionary points; 0 removes the budget. This clears the process.
+		void setBudget(int budget_)
+		{
+			budget = budget_;
+			Clear();
+		}
+		int getBudget() const
+		{
+			return budget;
+		}
 	};
 
 #endif
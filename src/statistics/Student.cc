@@ -20,6 +20,7 @@
 /// Initialises location to zero and precision to identity.
 Student::Student(const int dimension) 
     : sampler(new MultivariateNormal(dimension)),
+      sampler_ready(true),
       n(1),
       k(dimension),
       mu(k),
@@ -32,6 +33,7 @@ Student::Student(const int dimension)
 /// Constructor
 Student::Student(const int degrees, const Vector& location, const Matrix& precision)
     : sampler(new MultivariateNormal(location.Size())),
+      sampler_ready(false),
       n(degrees),
       k(location.Size()),
       mu(location),
@@ -56,11 +58,14 @@ void Student::setLocation(const Vector& location)
 {
     mu = location;
 }
-/// Set the precision matrix and calculate its determinant
+/// Set the precision matrix and calculate its determinant.
+///
+/// The sampler is only refactorised on the next call to generate().
 void Student::setPrecision(const Matrix& precision)
 {
     T = precision;
     T.LUDecomposition(det);
+    sampler_ready = false;
 	//det = T.det();
     //printf("New Precision det:%f\n", det);
     //T.print(stdout);
@@ -106,10 +111,14 @@ void Student::Show() const
 /** Generate a sample.
 
     Simply draw use a normal and a chi^2 variate dude!
+    The factorisation of the precision is reused between draws.
 */
 Vector Student::generate() const
 {
-    sampler->setAccuracy(T);
+    if (!sampler_ready) {
+        sampler->setAccuracy(T);
+        sampler_ready = true;
+    }
     Vector v = sampler->generate();
     real z = genchi((real) n);
     //v.print(stdout);
@@ -40,7 +40,8 @@ class MultivariateNormal;
 class Student
 {
 private:
-    MultivariateNormal* sampler;
+    MultivariateNormal* sampler; ///< normal with precision T
+    mutable bool sampler_ready; ///< whether the sampler has the current T
 public:
     int n; ///< Degrees of freedom
     const int k; ///< Dimensionality
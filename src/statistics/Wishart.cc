@@ -20,7 +20,7 @@ Wishart::Wishart()
       k(1),
       n(1)
 {
-    
+    Factorise();
 }
 
 /// We initialise k to the number of rows, otherwise the prior is improper
@@ -44,6 +44,16 @@ Wishart::~Wishart()
     
 }
 
+/// Factorise the covariance once, for sampling and the density
+void Wishart::Factorise()
+{
+    chol_covariance = Covariance.Cholesky();
+    log_det_precision = 0.0;
+    for (int i=0; i<chol_covariance.Rows(); ++i) {
+        log_det_precision -= 2.0 * log(chol_covariance(i,i));
+    }
+}
+
 void Wishart::generate(Matrix& X) const
 {
     Serror("Not implemented\n");
@@ -54,7 +64,7 @@ void Wishart::generate(Matrix& X) const
 Matrix Wishart::generate() const
 {
 	NormalDistribution norm;
-	Matrix T = Covariance.Cholesky();
+	const Matrix& T = chol_covariance;
 	Matrix B(k,k);
 	
 	for(int i = 0; i < k; ++i){
@@ -95,11 +105,10 @@ real Wishart::log_pdf(const Matrix& X) const
         }
     }
 
-    real det_V = Precision.det();
     real det_X = X.det();
 
     real log_p = log_c 
-        + 0.5 * n * log(det_V)
+        + 0.5 * n * log_det_precision
         + 0.5 * (n - rk - 1.0) * log(det_X)
         - 0.5 * trace_VX;
 
@@ -20,6 +20,9 @@ class Wishart : public AbstractDistribution<Matrix>
 protected:
     Matrix Precision; ///< precision matrix
     Matrix Covariance; ///< covariance matrix
+    Matrix chol_covariance; ///< upper Cholesky factor of the covariance
+    real log_det_precision; ///< log-determinant of the precision
+    void Factorise();
 public:
     int k; ///< dimensionality
     real n; ///< degrees of freedom
@@ -37,11 +40,13 @@ public:
     {
         Covariance = V;
         Precision = V.Inverse();
+        Factorise();
     }
     void setPrecision(const Matrix& V)
     {
         Covariance = V.Inverse();
         Precision = V;
+        Factorise();
     }
     void Show()
     {
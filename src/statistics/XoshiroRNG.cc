@@ -0,0 +1,83 @@
+/* -*- Mode: C++; -*- */
+// copyright (c) 2013 by Christos Dimitrakakis <christos.dimitrakakis@gmail.com>
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "XoshiroRNG.h"
+#include <cassert>
+
+/// Polynomials for jumping ahead.
+static const uint64_t JUMP[] = {
+    0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL,
+    0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL
+};
+static const uint64_t LONG_JUMP[] = {
+    0x76e15d3efefdcbbfULL, 0xc5004e441c522fb3ULL,
+    0x77710069854ee241ULL, 0x39109bb02acbe635ULL
+};
+
+XoshiroRNG::XoshiroRNG(unsigned long seed, int stream)
+{
+    setStream(seed, stream);
+}
+
+/** Seed the generator.
+
+	The state is filled by splitmix64, so that similar seeds still
+	give unrelated states, and the state is never all zero.
+*/
+void XoshiroRNG::manualSeed(unsigned long seed)
+{
+    initial_seed = seed;
+    uint64_t x = seed;
+    for (int i=0; i<4; ++i) {
+        x += 0x9e3779b97f4a7c15ULL;
+        uint64_t z = x;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        state[i] = z ^ (z >> 31);
+    }
+}
+
+void XoshiroRNG::setStream(unsigned long seed, int stream)
+{
+    assert(stream >= 0);
+    manualSeed(seed);
+    for (int k=0; k<stream; ++k) {
+        Jump();
+    }
+}
+
+void XoshiroRNG::Jump()
+{
+    Jump(JUMP);
+}
+
+void XoshiroRNG::LongJump()
+{
+    Jump(LONG_JUMP);
+}
+
+void XoshiroRNG::Jump(const uint64_t* jump)
+{
+    uint64_t s[4] = {0, 0, 0, 0};
+    for (int i=0; i<4; ++i) {
+        for (int b=0; b<64; ++b) {
+            if (jump[i] & (1ULL << b)) {
+                for (int j=0; j<4; ++j) {
+                    s[j] ^= state[j];
+                }
+            }
+            next();
+        }
+    }
+    for (int j=0; j<4; ++j) {
+        state[j] = s[j];
+    }
+}
@@ -0,0 +1,89 @@
+/* -*- Mode: C++; -*- */
+// copyright (c) 2013 by Christos Dimitrakakis <christos.dimitrakakis@gmail.com>
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef XOSHIRO_RNG_H
+#define XOSHIRO_RNG_H
+
+#include "RandomNumberGenerator.h"
+#include <stdint.h>
+
+/** The xoshiro256** generator of Blackman and Vigna.
+
+	The state is only 32 bytes, so that each thread can cheaply own a
+	generator. Independent streams are obtained from a single seed by
+	jumping ahead: stream k starts \f$k 2^{128}\f$ steps after the
+	seed. Since the stream of a task depends only on the seed and the
+	task number, results do not depend on how many threads are used or
+	how tasks are scheduled on them.
+ */
+class XoshiroRNG : public RandomNumberGenerator
+{
+protected:
+    unsigned long initial_seed;
+    uint64_t state[4];
+    void Jump(const uint64_t* jump);
+public:
+    XoshiroRNG(unsigned long seed = 0, int stream = 0);
+    virtual ~XoshiroRNG() {}
+
+    /// Initializes the random number generator with the given long "the_seed_".
+    virtual void manualSeed(unsigned long seed);
+
+    /// Seed, and then move to the start of the given stream.
+    void setStream(unsigned long seed, int stream);
+
+    /// Returns the starting seed used.
+    virtual unsigned long getInitialSeed()
+    {
+        return initial_seed;
+    }
+
+    /// Generates a uniform 64 bits integer.
+    inline uint64_t next()
+    {
+        uint64_t result = rotl(state[1] * 5, 7) * 9;
+        uint64_t t = state[1] << 17;
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= t;
+        state[3] = rotl(state[3], 45);
+        return result;
+    }
+
+    /// Generates a uniform 32 bits integer.
+    virtual unsigned long random()
+    {
+        return (unsigned long) (next() >> 32);
+    }
+
+    /// Generates a uniform random number in [0,1[.
+    virtual real uniform()
+    {
+        return (real) (next() >> 11) * (1.0 / 9007199254740992.0);
+    }
+    using RandomNumberGenerator::uniform;
+
+    /// Advance by \f$2^{128}\f$ steps.
+    void Jump();
+
+    /// Advance by \f$2^{192}\f$ steps.
+    void LongJump();
+
+protected:
+    static inline uint64_t rotl(uint64_t x, int k)
+    {
+        return (x << k) | (x >> (64 - k));
+    }
+};
+
+#endif
@@ -20,7 +20,7 @@ iWishart::iWishart()
 	  k(1),
 	  n(1)
 {
-    
+    Factorise();
 }
 
 iWishart::iWishart(real n_, const Matrix& V, bool is_covariance)
@@ -42,6 +42,16 @@ iWishart::~iWishart()
     
 }
 
+/// Factorise the covariance once, for sampling and the density
+void iWishart::Factorise()
+{
+	chol_covariance = Covariance.Cholesky();
+	log_det_covariance = 0.0;
+	for (int i=0; i<chol_covariance.Rows(); ++i) {
+		log_det_covariance += 2.0 * log(chol_covariance(i,i));
+	}
+}
+
 void iWishart::generate(Matrix& X) const
 {
     Serror("Not implemented\n");
@@ -52,7 +62,7 @@ Matrix iWishart::generate() const
 {
 	NormalDistribution norm;
 	std::vector<Matrix> QR;
-	Matrix T = Covariance.Cholesky();
+	const Matrix& T = chol_covariance;
 	Matrix B(k,k);
 	
 	for(int i = 0; i < k; ++i){
@@ -94,11 +104,10 @@ real iWishart::log_pdf(const Matrix& X) const
 		}
 	}
 	
-	real det_V = Covariance.det();
 	real det_X = X.det();
 	
 	real log_p = log_c
-		+ 0.5 * n * log(det_V)
+		+ 0.5 * n * log_det_covariance
 		- 0.5 * (n + rk + 1.0) * log(det_X)
 		- 0.5 * (trace_VX);
 	
@@ -22,6 +22,9 @@ class iWishart : public AbstractDistribution<Matrix>
 protected:
     Matrix Precision; ///< precision matrix
     Matrix Covariance; ///< covariance matrix
+    Matrix chol_covariance; ///< upper Cholesky factor of the covariance
+    real log_det_covariance; ///< log-determinant of the covariance
+    void Factorise();
 public:
 	int k;		///< dimensionality
 	real n;		///< degrees of freedom
@@ -39,11 +42,13 @@ public:
     {
         Covariance = V;
         Precision = V.Inverse_LU();
+        Factorise();
     }
     void setPrecision(const Matrix& V)
     {
         Covariance = V.Inverse_LU();
         Precision = V;
+        Factorise();
     }
     void Show()
     {
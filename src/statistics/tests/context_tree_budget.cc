@@ -0,0 +1,123 @@
+/* -*- Mode: C++; -*- */
+// copyright (c) 2013 by Christos Dimitrakakis <christos.dimitrakakis@gmail.com>
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifdef MAKE_MAIN
+
+#include "ContextTree.h"
+#include "ContextTreeKDTree.h"
+#include "ContextTreeRealLine.h"
+#include "Random.h"
+#include "EasyClock.h"
+#include <vector>
+
+/// A noisy order-3 Markov source
+int NextSymbol(const std::vector<int>& data, int t, int n_symbols)
+{
+    if (t < 3 || urandom() < 0.2) {
+        return (int) floor(urandom() * n_symbols);
+    }
+    return (data[t - 1] + data[t - 3]) % n_symbols;
+}
+
+int main()
+{
+    int n_errors = 0;
+    int n_symbols = 4;
+    int depth = 8;
+    int T = 100000;
+    std::vector<int> data(T);
+    for (int t=0; t<T; ++t) {
+        data[t] = NextSymbol(data, t, n_symbols);
+    }
+
+    // a budget the tree never reaches changes nothing
+    real log_loss = 0;
+    int n_contexts;
+    {
+        ContextTree tree(n_symbols, n_symbols, depth);
+        ContextTree budgeted(n_symbols, n_symbols, depth, 1000000);
+        for (int t=1; t<T; ++t) {
+            real p = tree.Observe(data[t - 1], data[t]);
+            if (p != budgeted.Observe(data[t - 1], data[t])) {
+                n_errors++;
+            }
+            log_loss -= log(p);
+        }
+        n_contexts = tree.NChildren();
+    }
+    printf("Unbounded: %d contexts, log loss %f, %d errors\n",
+           n_contexts, log_loss / T, n_errors);
+
+    // a small budget bounds the tree, at some cost in prediction
+    int budget = n_contexts / 4;
+    real budget_log_loss = 0;
+    {
+        ContextTree tree(n_symbols, n_symbols, depth, budget);
+        double start_time = GetCPU();
+        for (int t=1; t<T; ++t) {
+            budget_log_loss -= log(tree.Observe(data[t - 1], data[t]));
+            if (tree.NChildren() + 1 > budget) {
+                n_errors++;
+            }
+        }
+        double end_time = GetCPU();
+        printf("Budget %d: %d contexts, log loss %f, %f s\n",
+               budget, tree.NChildren(), budget_log_loss / T, end_time - start_time);
+        if (budget_log_loss > log_loss + 0.1 * T) {
+            n_errors++;
+        }
+
+        // shrinking the budget prunes at once
+        tree.setNodeBudget(budget / 2);
+        if (tree.NChildren() + 1 > budget / 2) {
+            n_errors++;
+        }
+        for (int t=1; t<T; ++t) {
+            tree.Observe(data[t - 1], data[t]);
+        }
+        if (tree.NChildren() + 1 > budget / 2) {
+            n_errors++;
+        }
+    }
+
+    // the continuous trees stop splitting at the budget
+    {
+        int n_dim = 2;
+        Vector lower_bound(n_dim);
+        Vector upper_bound(n_dim);
+        for (int j=0; j<n_dim; ++j) {
+            upper_bound(j) = 1;
+        }
+        ContextTreeKDTree kd_tree(2, 0, lower_bound, upper_bound, 500);
+        ContextTreeRealLine real_line(2, 0, 0, 1, 500);
+        for (int t=0; t<20000; ++t) {
+            Vector x(n_dim);
+            x(0) = urandom();
+            x(1) = urandom() * x(0);
+            kd_tree.Observe(x);
+            real_line.Observe(x(1));
+        }
+        printf("KD tree: %d contexts, real line: %d contexts\n",
+               kd_tree.NChildren(), real_line.NChildren());
+        if (kd_tree.NChildren() + 1 > 500 || real_line.NChildren() + 1 > 500) {
+            n_errors++;
+        }
+    }
+
+    if (n_errors) {
+        printf("%d errors\n", n_errors);
+        return -1;
+    }
+    printf("OK\n");
+    return 0;
+}
+
+#endif
@@ -0,0 +1,127 @@
+/* -*- Mode: C++; -*- */
+// copyright (c) 2013 by Christos Dimitrakakis <christos.dimitrakakis@gmail.com>
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifdef MAKE_MAIN
+
+#include "GaussianProcess.h"
+#include "Random.h"
+#include "EasyClock.h"
+#include <vector>
+
+/// Log likelihood of a process with the given hyperparameters
+real LogLikelihood(Matrix& X, Vector& Y, real noise_variance, const Vector& scale_length, real sig_var)
+{
+    GaussianProcess gp(noise_variance, scale_length, sig_var);
+    gp.Observe(X, Y);
+    return gp.LogLikelihood();
+}
+
+int main()
+{
+    int n_errors = 0;
+    int n_dim = 2;
+    int T = 150;
+    real noise_variance = 0.3;
+    real sig_var = 0.7;
+    Vector scale_length(n_dim);
+    scale_length(0) = 1.0;
+    scale_length(1) = 0.5;
+
+    Matrix X(T, n_dim);
+    Vector Y(T);
+    for (int t=0; t<T; ++t) {
+        for (int j=0; j<n_dim; ++j) {
+            X(t, j) = urandom(-2.0, 2.0);
+        }
+        Y(t) = sin(2 * X(t, 0)) + 0.1 * X(t, 1) + 0.1 * urandom(-1.0, 1.0);
+    }
+    GaussianProcess gp(noise_variance, scale_length, sig_var);
+    gp.Observe(X, Y);
+
+    // the blocked kernel matrix against single rows
+    int Q = 300;
+    Matrix X_q(Q, n_dim);
+    for (int i=0; i<Q; ++i) {
+        for (int j=0; j<n_dim; ++j) {
+            X_q(i, j) = urandom(-2.0, 2.0);
+        }
+    }
+    Matrix K_q;
+    gp.KernelMatrix(X_q, X, K_q);
+    for (int i=0; i<Q; ++i) {
+        Vector x = X_q.getRow(i);
+        for (int t=0; t<T; ++t) {
+            real delta = ((x - X.getRow(t)) / scale_length).SquareNorm();
+            if (fabs(K_q(i, t) - sig_var * sig_var * exp(-0.5 * delta)) > 1e-12) {
+                n_errors++;
+            }
+        }
+    }
+    printf("Kernel matrix: %d errors\n", n_errors);
+
+    // batch against single predictions
+    Vector mean, var;
+    gp.Predict(X_q, mean, var);
+    for (int i=0; i<Q; ++i) {
+        Vector x = X_q.getRow(i);
+        real mean_i, var_i;
+        gp.Prediction(x, mean_i, var_i);
+        if (fabs(mean(i) - mean_i) > 1e-9 || fabs(var(i) - var_i) > 1e-9) {
+            n_errors++;
+        }
+    }
+    printf("Predict: %d errors\n", n_errors);
+
+    // the gradient against finite differences in the log hyperparameters
+    Vector gradient = gp.LogLikelihoodGradient();
+    real h = 1e-5;
+    Vector numerical(n_dim + 2);
+    for (int k=0; k<n_dim; ++k) {
+        Vector up = scale_length;
+        Vector down = scale_length;
+        up(k) *= exp(h);
+        down(k) *= exp(-h);
+        numerical(k) = (LogLikelihood(X, Y, noise_variance, up, sig_var)
+                        - LogLikelihood(X, Y, noise_variance, down, sig_var)) / (2 * h);
+    }
+    numerical(n_dim) = (LogLikelihood(X, Y, noise_variance, scale_length, sig_var * exp(h))
+                        - LogLikelihood(X, Y, noise_variance, scale_length, sig_var * exp(-h))) / (2 * h);
+    numerical(n_dim + 1) = (LogLikelihood(X, Y, noise_variance * exp(h), scale_length, sig_var)
+                            - LogLikelihood(X, Y, noise_variance * exp(-h), scale_length, sig_var)) / (2 * h);
+    for (int k=0; k<n_dim + 2; ++k) {
+        printf("gradient %d: %f, numerical %f\n", k, gradient(k), numerical(k));
+        if (fabs(gradient(k) - numerical(k)) > 1e-4 * (1 + fabs(numerical(k)))) {
+            n_errors++;
+        }
+    }
+
+    // fit the hyperparameters
+    real initial = gp.LogLikelihood();
+    double start_time = GetCPU();
+    real final = gp.OptimiseHyperparameters(100, 0.01);
+    double end_time = GetCPU();
+    printf("Log likelihood %f -> %f in %f s; scale (%f %f), signal %f, noise %f\n",
+           initial, final, end_time - start_time,
+           gp.getScaleLength()(0), gp.getScaleLength()(1),
+           gp.getSignalVariance(), gp.getNoiseVariance());
+    if (final < initial || fabs(final - gp.LogLikelihood()) > 1e-9) {
+        n_errors++;
+    }
+
+    if (n_errors) {
+        printf("%d errors\n", n_errors);
+        return -1;
+    }
+    printf("OK\n");
+    return 0;
+}
+
+#endif
@@ -0,0 +1,140 @@
+/* -*- Mode: C++; -*- */
+// copyright (c) 2013 by Christos Dimitrakakis <christos.dimitrakakis@gmail.com>
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifdef MAKE_MAIN
+
+#include "GaussianProcess.h"
+#include "Random.h"
+#include "EasyClock.h"
+#include <vector>
+
+int main()
+{
+    int n_errors = 0;
+    int n_dim = 2;
+    int T = 200;
+    real noise_variance = 0.1;
+    real sig_var = 1.0;
+    Vector scale_length(n_dim);
+    for (int j=0; j<n_dim; ++j) {
+        scale_length(j) = 0.5;
+    }
+
+    std::vector<Vector> x(T);
+    std::vector<real> y(T);
+    for (int t=0; t<T; ++t) {
+        x[t] = Vector(n_dim);
+        for (int j=0; j<n_dim; ++j) {
+            x[t](j) = urandom(-1.0, 1.0);
+        }
+        y[t] = sin(3 * x[t](0)) + x[t](1) + noise_variance * urandom(-1.0, 1.0);
+    }
+
+    // online and batch processes must agree
+    GaussianProcess online(noise_variance, scale_length, sig_var);
+    GaussianProcess batch(noise_variance, scale_length, sig_var);
+    for (int t=0; t<T; ++t) {
+        online.AddObservation(x[t], y[t]);
+    }
+    batch.Observe(x, y);
+
+    // and agree with the explicit inverse
+    Matrix K(T, T);
+    for (int i=0; i<T; ++i) {
+        for (int j=0; j<T; ++j) {
+            real delta = ((x[i] - x[j]) / scale_length).SquareNorm();
+            K(i, j) = sig_var * sig_var * exp(-0.5 * delta);
+        }
+        K(i, i) += noise_variance * noise_variance;
+    }
+    Matrix inv_K = K.Inverse();
+    Vector Y(T);
+    for (int t=0; t<T; ++t) {
+        Y(t) = y[t];
+    }
+    Vector alpha = inv_K * Y;
+
+    for (int i=0; i<100; ++i) {
+        Vector z(n_dim);
+        for (int j=0; j<n_dim; ++j) {
+            z(j) = urandom(-1.0, 1.0);
+        }
+        real mean, var, batch_mean, batch_var;
+        online.Prediction(z, mean, var);
+        batch.Prediction(z, batch_mean, batch_var);
+        Vector k = online.Kernel(z);
+        real direct_mean = Product(k, alpha);
+        real direct_var = sig_var * sig_var - Product(k, inv_K * k);
+        if (fabs(mean - batch_mean) > 1e-9 || fabs(var - batch_var) > 1e-9) {
+            n_errors++;
+        }
+        if (fabs(mean - direct_mean) > 1e-6 || fabs(var - direct_var) > 1e-6) {
+            printf("mean %f %f, var %f %f\n", mean, direct_mean, var, direct_var);
+            n_errors++;
+        }
+    }
+    if (fabs(online.LogLikelihood() - batch.LogLikelihood()) > 1e-9) {
+        n_errors++;
+    }
+
+    // a scalar length scale applies to every dimension
+    Matrix X(T, n_dim);
+    for (int t=0; t<T; ++t) {
+        X.setRow(t, x[t]);
+    }
+    GaussianProcess scalar(X, Y, noise_variance, scale_length(0), sig_var);
+    if (scalar.getScaleLength().Size() != n_dim) {
+        n_errors++;
+    }
+    for (int i=0; i<10; ++i) {
+        Vector z(n_dim);
+        for (int j=0; j<n_dim; ++j) {
+            z(j) = urandom(-1.0, 1.0);
+        }
+        real mean, var, scalar_mean, scalar_var;
+        batch.Prediction(z, mean, var);
+        scalar.Prediction(z, scalar_mean, scalar_var);
+        if (fabs(mean - scalar_mean) > 1e-9 || fabs(var - scalar_var) > 1e-9) {
+            n_errors++;
+        }
+    }
+    printf("%d points, log likelihood %f, %d errors\n",
+           online.getNSamples(), online.LogLikelihood(), n_errors);
+
+    // thousands of online observations, with a prediction after each
+    int T_long = 2000;
+    GaussianProcess gp(noise_variance, scale_length, sig_var);
+    double start_time = GetCPU();
+    real error = 0;
+    for (int t=0; t<T_long; ++t) {
+        Vector z(n_dim);
+        for (int j=0; j<n_dim; ++j) {
+            z(j) = urandom(-1.0, 1.0);
+        }
+        real target = sin(3 * z(0)) + z(1);
+        if (t) {
+            error += fabs(gp.PredictiveMean(gp.Kernel(z)) - target);
+        }
+        gp.AddObservation(z, target + noise_variance * urandom(-1.0, 1.0));
+    }
+    double end_time = GetCPU();
+    printf("%d online observations: %f s, mean error %f\n",
+           T_long, end_time - start_time, error / T_long);
+
+    if (n_errors) {
+        printf("%d errors\n", n_errors);
+        return -1;
+    }
+    printf("OK\n");
+    return 0;
+}
+
+#endif
@@ -0,0 +1,179 @@
+/* -*- Mode: C++; -*- */
+// copyright (c) 2013 by Christos Dimitrakakis <christos.dimitrakakis@gmail.com>
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifdef MAKE_MAIN
+
+#include "DiscreteHiddenMarkovModel.h"
+#include "RandomDevice.h"
+#include "ThreadPool.h"
+#include "EasyClock.h"
+#include <vector>
+
+/// Unscaled forward and backward messages, for short sequences
+real ReferencePosterior(DiscreteHiddenMarkovModel& hmm,
+                        const std::vector<int>& x,
+                        Matrix& posterior,
+                        Matrix& transitions)
+{
+    int T = x.size();
+    int n = hmm.getNStates();
+    Matrix alpha(T, n);
+    Matrix beta(T, n);
+    for (int t=0; t<T; ++t) {
+        for (int j=0; j<n; ++j) {
+            real p = 0;
+            for (int i=0; i<n; ++i) {
+                real prev = (t == 0) ? (i == 0) : alpha(t - 1, i);
+                p += prev * hmm.PrS(i, j);
+            }
+            alpha(t, j) = p * hmm.PrX(j, x[t]);
+        }
+    }
+    for (int i=0; i<n; ++i) {
+        beta(T - 1, i) = 1;
+    }
+    for (int t=T-2; t>=0; --t) {
+        for (int i=0; i<n; ++i) {
+            beta(t, i) = 0;
+            for (int j=0; j<n; ++j) {
+                beta(t, i) += hmm.PrS(i, j) * hmm.PrX(j, x[t + 1]) * beta(t + 1, j);
+            }
+        }
+    }
+    real likelihood = 0;
+    for (int i=0; i<n; ++i) {
+        likelihood += alpha(T - 1, i);
+    }
+    for (int t=0; t<T; ++t) {
+        for (int i=0; i<n; ++i) {
+            posterior(t, i) = alpha(t, i) * beta(t, i) / likelihood;
+        }
+    }
+    for (int t=0; t<T-1; ++t) {
+        for (int i=0; i<n; ++i) {
+            for (int j=0; j<n; ++j) {
+                transitions(i, j) += alpha(t, i) * hmm.PrS(i, j) * hmm.PrX(j, x[t + 1])
+                    * beta(t + 1, j) / likelihood;
+            }
+        }
+    }
+    return log(likelihood);
+}
+
+std::vector<int> Generate(DiscreteHiddenMarkovModel& hmm, int T)
+{
+    std::vector<int> x(T);
+    hmm.Reset();
+    for (int t=0; t<T; ++t) {
+        x[t] = hmm.generate();
+    }
+    return x;
+}
+
+int main()
+{
+    int n_errors = 0;
+    int n_states = 4;
+    int n_observations = 6;
+    RandomDevice rng(false);
+    DiscreteHiddenMarkovModel* hmm = MakeRandomDiscreteHMM(n_states, n_observations, 0.7, &rng);
+
+    // scaled against unscaled messages
+    int T = 20;
+    std::vector<int> x = Generate(*hmm, T);
+    Matrix forward_belief(T, n_states);
+    Matrix posterior(T, n_states);
+    Matrix reference(T, n_states);
+    Matrix reference_transitions(n_states, n_states);
+    real log_likelihood = hmm->Expectation(x, forward_belief, posterior);
+    real reference_log_likelihood = ReferencePosterior(*hmm, x, reference, reference_transitions);
+    if (fabs(log_likelihood - reference_log_likelihood) > 1e-9) {
+        n_errors++;
+    }
+    for (int t=0; t<T; ++t) {
+        for (int s=0; s<n_states; ++s) {
+            if (fabs(posterior(t, s) - reference(t, s)) > 1e-9) {
+                n_errors++;
+            }
+        }
+    }
+    DiscreteHiddenMarkovModel::Statistics statistics(n_states, n_observations);
+    hmm->Expectation(x, statistics);
+    for (int i=0; i<n_states; ++i) {
+        for (int j=0; j<n_states; ++j) {
+            if (fabs(statistics.transitions[i * n_states + j] - reference_transitions(i, j)) > 1e-9) {
+                n_errors++;
+            }
+        }
+    }
+    printf("Forward-backward: %d errors\n", n_errors);
+
+    // EM never decreases the likelihood
+    std::vector<std::vector<int> > sequences(64);
+    for (uint k=0; k<sequences.size(); ++k) {
+        sequences[k] = Generate(*hmm, 500 + 100 * (k % 7));
+    }
+    DiscreteHiddenMarkovModel* serial = MakeRandomDiscreteHMM(n_states, n_observations, 0.5, &rng);
+    DiscreteHiddenMarkovModel parallel(*serial);
+    real previous = LOG_ZERO;
+    for (int iter=0; iter<10; ++iter) {
+        real log_p = serial->ExpectationMaximisation(sequences, 1);
+        if (log_p < previous - 1e-6) {
+            n_errors++;
+        }
+        previous = log_p;
+    }
+    printf("EM: log likelihood %f\n", previous);
+
+    // threads only change the rounding
+    ThreadPool pool(4);
+    double start_time = GetCPU();
+    real parallel_log_p = parallel.ExpectationMaximisation(sequences, 10, &pool);
+    double end_time = GetCPU();
+    if (fabs(parallel_log_p - previous) > 1e-6) {
+        n_errors++;
+    }
+    for (int i=0; i<n_states; ++i) {
+        for (int j=0; j<n_states; ++j) {
+            if (fabs(parallel.PrS(i, j) - serial->PrS(i, j)) > 1e-9) {
+                n_errors++;
+            }
+        }
+        for (int k=0; k<n_observations; ++k) {
+            if (fabs(parallel.PrX(i, k) - serial->PrX(i, k)) > 1e-9) {
+                n_errors++;
+            }
+        }
+    }
+    printf("Parallel EM: log likelihood %f, %f s\n", parallel_log_p, end_time - start_time);
+
+    // a long sequence does not underflow
+    x = Generate(*hmm, 1000000);
+    start_time = GetCPU();
+    log_likelihood = hmm->ExpectationMaximisation(x, 1);
+    end_time = GetCPU();
+    printf("%d observations: log likelihood %f, %f s\n",
+           (int) x.size(), log_likelihood, end_time - start_time);
+    if (std::isnan(log_likelihood) || log_likelihood >= 0) {
+        n_errors++;
+    }
+
+    delete serial;
+    delete hmm;
+    if (n_errors) {
+        printf("%d errors\n", n_errors);
+        return -1;
+    }
+    printf("OK\n");
+    return 0;
+}
+
+#endif
@@ -0,0 +1,152 @@
+/* -*- Mode: C++; -*- */
+// copyright (c) 2013 by Christos Dimitrakakis <christos.dimitrakakis@gmail.com>
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifdef MAKE_MAIN
+
+#include "DiscreteHiddenMarkovModelPF.h"
+#include "Random.h"
+#include "RandomDevice.h"
+#include "ThreadPool.h"
+#include "EasyClock.h"
+#include "ranlib.h"
+#include <vector>
+
+/// Access to the packed particles
+class InspectedPF : public DiscreteHiddenMarkovModelPF_BootstrapDirichletExact
+{
+public:
+    InspectedPF(int n_states, int n_observations, int n_particles)
+        : DiscreteHiddenMarkovModelPF_BootstrapDirichletExact(0.5, 0.8, n_states, n_observations, n_particles)
+    {
+    }
+    /// The largest deviation of the counts of a particle from T
+    real CountError(long T)
+    {
+        real error = 0;
+        for (int k=0; k<n_particles; ++k) {
+            real N_S = 0;
+            for (int i=0; i<n_states * n_states; ++i) {
+                N_S += transition_counts[k * n_states * n_states + i];
+            }
+            real N_X = 0;
+            for (int i=0; i<n_states * n_observations; ++i) {
+                N_X += emission_counts[k * n_states * n_observations + i];
+            }
+            error = std::max(error, std::max(fabs(N_S - T), fabs(N_X - T)));
+        }
+        return error;
+    }
+    /// Resample the given weights and check the number of copies
+    int CheckResample(const Vector& weights)
+    {
+        int n_errors = 0;
+        w = weights;
+        Resample();
+        int n_copies = 0;
+        for (int k=0; k<n_particles; ++k) {
+            real expected = weights[k] * n_particles;
+            int copies = (offspring[k] < 0) ? 0 : offspring[k];
+            if (fabs(copies - expected) >= 1.0) {
+                n_errors++;
+            }
+            n_copies += copies;
+        }
+        if (n_copies != n_particles || fabs(w.Sum() - 1) > 1e-9) {
+            n_errors++;
+        }
+        return n_errors;
+    }
+};
+
+int main()
+{
+    int n_errors = 0;
+    int n_states = 3;
+    int n_observations = 4;
+    int n_particles = 256;
+    int T = 5000;
+    RandomDevice rng(false);
+    DiscreteHiddenMarkovModel* hmm = MakeRandomDiscreteHMM(n_states, n_observations, 0.8, &rng);
+    std::vector<int> x(T);
+    for (int t=0; t<T; ++t) {
+        x[t] = hmm->generate();
+    }
+
+    // threads do not change the filter
+    ThreadPool pool(4);
+    real serial_log_loss = 0;
+    real parallel_log_loss = 0;
+    double serial_time, parallel_time;
+    {
+        setRandomSeed(1234);
+        setall(1234, 5678);
+        DiscreteHiddenMarkovModelPF_ISReplaceLowestDirichletExact pf(0.5, 0.8, n_states, n_observations, n_particles);
+        double start_time = GetCPU();
+        for (int t=0; t<T; ++t) {
+            serial_log_loss -= log(pf.Observe(x[t]));
+        }
+        serial_time = GetCPU() - start_time;
+    }
+    {
+        setRandomSeed(1234);
+        setall(1234, 5678);
+        DiscreteHiddenMarkovModelPF_ISReplaceLowestDirichletExact pf(0.5, 0.8, n_states, n_observations, n_particles);
+        pf.setThreadPool(&pool);
+        double start_time = GetCPU();
+        for (int t=0; t<T; ++t) {
+            parallel_log_loss -= log(pf.Observe(x[t]));
+        }
+        parallel_time = GetCPU() - start_time;
+    }
+    printf("Replacement filter: log loss %f (serial, %f s), %f (parallel, %f s)\n",
+           serial_log_loss / T, serial_time, parallel_log_loss / T, parallel_time);
+    if (serial_log_loss != parallel_log_loss) {
+        n_errors++;
+    }
+
+    // the bootstrap filter keeps its counts and learns the source
+    InspectedPF pf(n_states, n_observations, n_particles);
+    real log_loss = 0;
+    for (int t=0; t<T; ++t) {
+        Vector p = pf.getPrediction();
+        if (fabs(p.Sum() - 1) > 1e-9) {
+            n_errors++;
+        }
+        log_loss -= log(pf.Observe(x[t]));
+    }
+    real count_error = pf.CountError(T);
+    printf("Bootstrap filter: log loss %f, uniform %f, count error %g\n",
+           log_loss / T, log((real) n_observations), count_error);
+    if (log_loss / T > log((real) n_observations) || count_error > 1e-6 * T) {
+        n_errors++;
+    }
+
+    // systematic resampling gives each particle its expected number of copies
+    for (int iter=0; iter<100; ++iter) {
+        Vector weights(n_particles);
+        for (int k=0; k<n_particles; ++k) {
+            weights[k] = pow(urandom(), 4.0);
+        }
+        weights /= weights.Sum();
+        n_errors += pf.CheckResample(weights);
+    }
+    printf("Resampling: %d errors\n", n_errors);
+
+    delete hmm;
+    if (n_errors) {
+        printf("%d errors\n", n_errors);
+        return -1;
+    }
+    printf("OK\n");
+    return 0;
+}
+
+#endif
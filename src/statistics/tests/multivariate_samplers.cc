@@ -0,0 +1,198 @@
+/* -*- Mode: C++; -*- */
+// copyright (c) 2013 by Christos Dimitrakakis <christos.dimitrakakis@gmail.com>
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifdef MAKE_MAIN
+
+#include "MultivariateNormal.h"
+#include "Student.h"
+#include "Wishart.h"
+#include "iWishart.h"
+#include "Random.h"
+#include "SpecialFunctions.h"
+#include "EasyClock.h"
+
+/// A random symmetric positive definite matrix
+Matrix RandomPrecision(int n_dim)
+{
+    Matrix A(n_dim, n_dim);
+    for (int i=0; i<n_dim; ++i) {
+        for (int j=0; j<n_dim; ++j) {
+            A(i,j) = urandom(-1.0, 1.0);
+        }
+    }
+    Matrix T = Transpose(A) * A;
+    for (int i=0; i<n_dim; ++i) {
+        T(i,i) += 1.0;
+    }
+    return T;
+}
+
+/// The largest absolute difference between two matrices
+real MaxDifference(const Matrix& A, const Matrix& B)
+{
+    real d = 0;
+    for (int i=0; i<A.Rows(); ++i) {
+        for (int j=0; j<A.Columns(); ++j) {
+            d = std::max(d, fabs(A(i,j) - B(i,j)));
+        }
+    }
+    return d;
+}
+
+/// Sample covariance of the rows of X
+Matrix SampleCovariance(const Matrix& X, Vector& mean)
+{
+    int n = X.Rows();
+    int n_dim = X.Columns();
+    mean = Vector(n_dim);
+    for (int t=0; t<n; ++t) {
+        mean += X.getRow(t) / (real) n;
+    }
+    Matrix S(n_dim, n_dim);
+    for (int t=0; t<n; ++t) {
+        Vector d = X.getRow(t) - mean;
+        S.AddOuterProduct(1.0 / (real) n, d, d);
+    }
+    return S;
+}
+
+int main()
+{
+    int n_errors = 0;
+    int n_dim = 4;
+    int n_samples = 50000;
+    Matrix T = RandomPrecision(n_dim);
+    Matrix Sigma = T.Inverse();
+    Vector mu(n_dim);
+    for (int i=0; i<n_dim; ++i) {
+        mu(i) = urandom(-1.0, 1.0);
+    }
+
+    // the density against the explicit formula
+    MultivariateNormal normal(mu, T);
+    real log_det = log(T.det());
+    for (int k=0; k<100; ++k) {
+        Vector x(n_dim);
+        for (int i=0; i<n_dim; ++i) {
+            x(i) = urandom(-2.0, 2.0);
+        }
+        Vector d = x - mu;
+        real log_p = 0.5 * (log_det - Mahalanobis2(d, T, d) - n_dim * log(2 * M_PI));
+        if (fabs(normal.log_pdf(x) - log_p) > 1e-9) {
+            n_errors++;
+        }
+    }
+    printf("Density: %d errors\n", n_errors);
+
+    // single and batch samples have the right moments
+    Matrix X(n_samples, n_dim);
+    double start_time = GetCPU();
+    for (int t=0; t<n_samples; ++t) {
+        X.setRow(t, normal.generate());
+    }
+    double end_time = GetCPU();
+    Vector mean;
+    real single_error = MaxDifference(SampleCovariance(X, mean), Sigma);
+    real single_mean_error = (mean - mu).L1Norm();
+    double single_time = end_time - start_time;
+    start_time = GetCPU();
+    normal.generate(n_samples, X);
+    end_time = GetCPU();
+    real batch_error = MaxDifference(SampleCovariance(X, mean), Sigma);
+    real batch_mean_error = (mean - mu).L1Norm();
+    printf("Covariance error: single %f, batch %f; mean error: single %f, batch %f\n",
+           single_error, batch_error, single_mean_error, batch_mean_error);
+    printf("%d samples: single %f s, batch %f s\n",
+           n_samples, single_time, end_time - start_time);
+    if (single_error > 0.05 || batch_error > 0.05
+        || single_mean_error > 0.05 || batch_mean_error > 0.05) {
+        n_errors++;
+    }
+
+    // repeated Student draws reuse the factorisation until the precision
+    // changes. The normal draw is divided by a chi-square draw z, so the
+    // covariance is the inverse precision times E[1/z^2] = 1/((nu-2)(nu-4)).
+    real nu = 10;
+    real scale = 1.0 / ((nu - 2.0) * (nu - 4.0));
+    Student student(nu, mu, T);
+    real student_error = 0;
+    real student_mean_error = 0;
+    for (int k=0; k<2; ++k) {
+        if (k == 1) {
+            student.setPrecision(T * 4.0);
+        }
+        for (int t=0; t<n_samples; ++t) {
+            X.setRow(t, student.generate());
+        }
+        Matrix S = SampleCovariance(X, mean);
+        Matrix expected = Sigma * (scale / (k == 1 ? 4.0 : 1.0));
+        student_error = std::max(student_error,
+                                 MaxDifference(S, expected) / MaxDifference(expected, Matrix(n_dim, n_dim)));
+        student_mean_error = std::max(student_mean_error, (mean - mu).L1Norm());
+    }
+    printf("Student: mean error %f, relative covariance error %f\n",
+           student_mean_error, student_error);
+    if (student_mean_error > 0.05 || student_error > 0.1) {
+        n_errors++;
+    }
+
+    // the Wishart mean is n times the covariance
+    real n = 8;
+    Wishart wishart(n, Sigma, true);
+    Matrix W_mean(n_dim, n_dim);
+    int n_wishart = 20000;
+    for (int t=0; t<n_wishart; ++t) {
+        W_mean += wishart.generate() * (1.0 / (real) n_wishart);
+    }
+    real wishart_error = MaxDifference(W_mean, Sigma * n);
+    printf("Wishart: mean error %f\n", wishart_error);
+    if (wishart_error > 0.1 * n) {
+        n_errors++;
+    }
+
+    // the Wishart densities against the explicit formulas
+    Matrix W = wishart.generate();
+    real log_c = - (0.5 * n_dim * n * log(2.0) + 0.25 * n_dim * (n_dim - 1.0) * log(M_PI));
+    for (int j=0; j<n_dim; ++j) {
+        log_c -= logGamma(0.5 * (n - j));
+    }
+    real trace = 0;
+    Matrix inv_W = W.Inverse();
+    real inv_trace = 0;
+    for (int i=0; i<n_dim; ++i) {
+        for (int j=0; j<n_dim; ++j) {
+            trace += T(i,j) * W(j,i);
+            inv_trace += Sigma(i,j) * inv_W(j,i);
+        }
+    }
+    real log_p = log_c + 0.5 * n * log(T.det()) + 0.5 * (n - n_dim - 1.0) * log(W.det()) - 0.5 * trace;
+    if (fabs(wishart.log_pdf(W) - log_p) > 1e-6) {
+        n_errors++;
+    }
+    iWishart inverse_wishart(n, Sigma, true);
+    log_p = log_c + 0.5 * n * log(Sigma.det()) - 0.5 * (n + n_dim + 1.0) * log(W.det()) - 0.5 * inv_trace;
+    if (fabs(inverse_wishart.log_pdf(W) - log_p) > 1e-6) {
+        n_errors++;
+    }
+    Matrix V = inverse_wishart.generate();
+    if (!V.isSymmetric()) {
+        n_errors++;
+    }
+
+    if (n_errors) {
+        printf("%d errors\n", n_errors);
+        return -1;
+    }
+    printf("OK\n");
+    return 0;
+}
+
+#endif
@@ -0,0 +1,171 @@
+/* -*- Mode: C++; -*- */
+// copyright (c) 2013 by Christos Dimitrakakis <christos.dimitrakakis@gmail.com>
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifdef MAKE_MAIN
+
+#include "XoshiroRNG.h"
+#include "NormalDistribution.h"
+#include "GammaDistribution.h"
+#include "BetaDistribution.h"
+#include "Dirichlet.h"
+#include "ThreadPool.h"
+#include <chrono>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+/// Draw a fixed number of normal samples from every stream
+std::vector<real> SampleStreams(int n_streams, int n_samples, int n_threads,
+                                unsigned long seed)
+{
+    std::vector<real> sums(n_streams);
+    ThreadPool pool(n_threads);
+    pool.Run(n_streams, [&](int k) {
+            XoshiroRNG rng(seed, k);
+            NormalDistribution normal(1.0, 2.0);
+            real sum = 0.0;
+            for (int t=0; t<n_samples; ++t) {
+                sum += normal.generate(rng);
+            }
+            sums[k] = sum;
+        });
+    return sums;
+}
+
+/// Wall-clock time in seconds
+double WallTime()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int main()
+{
+    int n_errors = 0;
+    unsigned long seed = 12345;
+
+    // the same seed and stream give the same sequence
+    {
+        XoshiroRNG a(seed, 3);
+        XoshiroRNG b(seed);
+        for (int k=0; k<3; ++k) {
+            b.Jump();
+        }
+        for (int t=0; t<1000; ++t) {
+            if (a.random() != b.random()) {
+                n_errors++;
+            }
+        }
+        XoshiroRNG c(seed, 4);
+        int n_equal = 0;
+        for (int t=0; t<1000; ++t) {
+            if (a.uniform() == c.uniform()) {
+                n_equal++;
+            }
+        }
+        if (n_equal > 1) {
+            printf("Streams 3 and 4 overlap\n");
+            n_errors++;
+        }
+    }
+
+    // results do not depend on the number of threads
+    int n_streams = 64;
+    int n_samples = 100000;
+    double start_time = WallTime();
+    std::vector<real> serial = SampleStreams(n_streams, n_samples, 1, seed);
+    double serial_time = WallTime() - start_time;
+    int n_threads = std::max(4, ThreadPool::HardwareThreads());
+    start_time = WallTime();
+    std::vector<real> parallel = SampleStreams(n_streams, n_samples, n_threads, seed);
+    double parallel_time = WallTime() - start_time;
+    printf("1 thread: %f s, %d threads: %f s\n",
+           serial_time, n_threads, parallel_time);
+    real total = 0.0;
+    for (int k=0; k<n_streams; ++k) {
+        if (serial[k] != parallel[k]) {
+            n_errors++;
+        }
+        total += serial[k];
+    }
+    real mean = total / (real) (n_streams * n_samples);
+    printf("Normal mean: %f\n", mean);
+    if (fabs(mean - 1.0) > 0.01) {
+        n_errors++;
+    }
+
+    // moments of the other samplers
+    int T = 100000;
+    XoshiroRNG rng(seed);
+    real shapes[] = {0.3, 1.0, 4.5};
+    for (int i=0; i<3; ++i) {
+        GammaDistribution gamma(shapes[i], 2.0);
+        real sum = 0.0;
+        real sum2 = 0.0;
+        for (int t=0; t<T; ++t) {
+            real x = gamma.generate(rng);
+            sum += x;
+            sum2 += x * x;
+        }
+        real m = sum / (real) T;
+        real v = sum2 / (real) T - m * m;
+        real true_m = shapes[i] / 2.0;
+        real true_v = shapes[i] / 4.0;
+        printf("Gamma(%f, 2): mean %f (%f), variance %f (%f)\n",
+               shapes[i], m, true_m, v, true_v);
+        if (fabs(m - true_m) > 0.05 * true_m || fabs(v - true_v) > 0.1 * true_v) {
+            n_errors++;
+        }
+    }
+
+    {
+        BetaDistribution beta(2.0, 5.0);
+        real sum = 0.0;
+        for (int t=0; t<T; ++t) {
+            sum += beta.generate(rng);
+        }
+        real m = sum / (real) T;
+        printf("Beta(2, 5): mean %f (%f)\n", m, 2.0 / 7.0);
+        if (fabs(m - 2.0 / 7.0) > 0.01) {
+            n_errors++;
+        }
+    }
+
+    {
+        Vector alpha(4);
+        alpha(0) = 0.1;
+        alpha(1) = 1.0;
+        alpha(2) = 2.0;
+        alpha(3) = 5.0;
+        DirichletDistribution dirichlet(alpha);
+        Vector x(4);
+        Vector sum(4);
+        for (int t=0; t<T; ++t) {
+            dirichlet.generate(x, rng);
+            sum += x;
+        }
+        sum /= (real) T;
+        Vector true_mean = alpha / alpha.Sum();
+        printf("Dirichlet mean:");
+        sum.print(stdout);
+        if ((sum - true_mean).L1Norm() > 0.01) {
+            n_errors++;
+        }
+    }
+
+    if (n_errors) {
+        printf("%d errors\n", n_errors);
+        return -1;
+    }
+    printf("OK\n");
+    return 0;
+}
+
+#endif
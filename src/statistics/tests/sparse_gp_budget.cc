@@ -0,0 +1,132 @@
+/* -*- Mode: C++; -*- */
+// copyright (c) 2013 by Christos Dimitrakakis <christos.dimitrakakis@gmail.com>
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifdef MAKE_MAIN
+
+#include "SparseGaussianProcess.h"
+#include "GaussianProcess.h"
+#include "Random.h"
+#include "EasyClock.h"
+#include <vector>
+
+Vector RandomPoint(int n_dim)
+{
+    Vector x(n_dim);
+    for (int j=0; j<n_dim; ++j) {
+        x(j) = urandom(-1.0, 1.0);
+    }
+    return x;
+}
+
+real Target(const Vector& x)
+{
+    return sin(3 * x(0)) + x(1);
+}
+
+/// Check batch predictions against single ones
+int CheckBatch(SparseGaussianProcess& gp, const std::vector<Vector>& Z)
+{
+    int n_errors = 0;
+    Vector mean, var;
+    gp.Predict(Z, mean, var);
+    for (uint i=0; i<Z.size(); ++i) {
+        Vector k = gp.Kernel(Z[i]);
+        if (fabs(mean(i) - gp.PredictiveMean(k)) > 1e-9
+            || fabs(var(i) - gp.PredictiveVariance(k)) > 1e-9) {
+            n_errors++;
+        }
+    }
+    return n_errors;
+}
+
+int main()
+{
+    int n_errors = 0;
+    int n_dim = 2;
+    real noise_variance = 0.1;
+    real sig_var = 1.0;
+    Vector scale_length(n_dim);
+    for (int j=0; j<n_dim; ++j) {
+        scale_length(j) = 0.3;
+    }
+    std::vector<Vector> Z(100);
+    for (uint i=0; i<Z.size(); ++i) {
+        Z[i] = RandomPoint(n_dim);
+    }
+
+    // with every point in the dictionary, the budgeted process is exact
+    int T = 60;
+    SparseGaussianProcess exact(noise_variance, scale_length, sig_var, 0.0, scale_length);
+    exact.setBudget(T);
+    GaussianProcess full(noise_variance, scale_length, sig_var);
+    for (int t=0; t<T; ++t) {
+        Vector x = RandomPoint(n_dim);
+        real y = Target(x) + noise_variance * urandom(-1.0, 1.0);
+        exact.AddObservation(x, y);
+        full.AddObservation(x, y);
+    }
+    for (uint i=0; i<Z.size(); ++i) {
+        real mean, var, full_mean, full_var;
+        exact.Prediction(Z[i], mean, var);
+        full.Prediction(Z[i], full_mean, full_var);
+        if (fabs(mean - full_mean) > 1e-6 || fabs(var - full_var) > 1e-6) {
+            printf("mean %f %f, var %f %f\n", mean, full_mean, var, full_var);
+            n_errors++;
+        }
+    }
+    n_errors += CheckBatch(exact, Z);
+    printf("Exact: %d points, %d errors\n", exact.getNSamples(), n_errors);
+
+    // a long stream with a small budget
+    int budget = 50;
+    int T_long = 20000;
+    int block = 2000;
+    SparseGaussianProcess gp(noise_variance, scale_length, sig_var, 0.01, scale_length);
+    gp.setBudget(budget);
+    for (int t=0; t<T_long; t+=block) {
+        double start_time = GetCPU();
+        real error = 0.0;
+        for (int i=0; i<block; ++i) {
+            Vector x = RandomPoint(n_dim);
+            real mean, var;
+            gp.Prediction(x, mean, var);
+            error += fabs(mean - Target(x));
+            gp.AddObservation(x, Target(x) + noise_variance * urandom(-1.0, 1.0));
+        }
+        double end_time = GetCPU();
+        printf("%d observations, %d points, error %f, %f s\n",
+               t + block, gp.getNSamples(), error / block, end_time - start_time);
+    }
+    if (gp.getNSamples() > budget) {
+        n_errors++;
+    }
+    n_errors += CheckBatch(gp, Z);
+
+    // the unbudgeted process
+    SparseGaussianProcess dictionary(noise_variance, scale_length, sig_var, 0.01, scale_length);
+    std::vector<Vector> X(T);
+    std::vector<real> Y(T);
+    for (int t=0; t<T; ++t) {
+        X[t] = RandomPoint(n_dim);
+        Y[t] = Target(X[t]);
+    }
+    dictionary.Observe(X, Y);
+    n_errors += CheckBatch(dictionary, Z);
+
+    if (n_errors) {
+        printf("%d errors\n", n_errors);
+        return -1;
+    }
+    printf("OK\n");
+    return 0;
+}
+
+#endif
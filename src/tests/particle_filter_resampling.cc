@@ -0,0 +1,198 @@
+/* -*- Mode: C++; -*- */
+// copyright (c) 2013 by Christos Dimitrakakis <christos.dimitrakakis@gmail.com>
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifdef MAKE_MAIN
+
+#include "ParticleFilter.h"
+#include "NormalDistribution.h"
+#include "Sampling.h"
+#include "PFActionValueEstimate.h"
+#include "DiscreteBanditPolicy.h"
+#include "Random.h"
+#include "EasyClock.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+
+/// Check the number of copies of each particle against its expected number
+int CheckResampling(ResamplingMethod method, const char* name, real max_deviation)
+{
+    int n_errors = 0;
+    int N = 1000;
+    int n_repetitions = 2000;
+    std::vector<real> w(N);
+    real sum = 0;
+    for (int i=0; i<N; i++) {
+        w[i] = pow(drand48(), 4.0);
+        sum += w[i];
+    }
+    for (int i=0; i<N; i++) {
+        w[i] /= sum;
+    }
+    std::vector<int> index(N);
+    std::vector<real> mean_copies(N);
+    real worst = 0;
+    for (int r=0; r<n_repetitions; r++) {
+        Resample(method, w, index);
+        std::vector<int> copies(N);
+        for (int k=0; k<N; k++) {
+            if (index[k] < 0 || index[k] >= N) {
+                n_errors++;
+                continue;
+            }
+            copies[index[k]]++;
+        }
+        for (int i=0; i<N; i++) {
+            worst = std::max(worst, fabs(copies[i] - N * w[i]));
+            mean_copies[i] += copies[i] / (real) n_repetitions;
+        }
+    }
+    real bias = 0;
+    for (int i=0; i<N; i++) {
+        bias = std::max(bias, fabs(mean_copies[i] - N * w[i]));
+    }
+    printf("%s: largest deviation %f, bias %f\n", name, worst, bias);
+    if (worst >= max_deviation || bias > 0.25) {
+        n_errors++;
+    }
+    return n_errors;
+}
+
+int main (void)
+{
+    int n_errors = 0;
+    srand48(12345);
+
+    n_errors += CheckResampling(MULTINOMIAL_RESAMPLING, "multinomial", 1e9);
+    n_errors += CheckResampling(SYSTEMATIC_RESAMPLING, "systematic", 1.0);
+    n_errors += CheckResampling(STRATIFIED_RESAMPLING, "stratified", 2.0);
+    n_errors += CheckResampling(RESIDUAL_RESAMPLING, "residual", 1e9);
+
+    std::vector<real> w(100, 0.01);
+    if (fabs(EffectiveSampleSize(w) - 100) > 1e-9) {
+        n_errors++;
+    }
+    std::fill(w.begin(), w.end(), 0.0);
+    w[3] = 1.0;
+    if (fabs(EffectiveSampleSize(w) - 1) > 1e-9) {
+        n_errors++;
+    }
+
+    // log-weights give the same posterior on the same grid
+    real p = 0.7;
+    UniformDistribution transitions(-0.01f, 0.01f);
+    BernoulliDistribution observations;
+    UniformDistribution prior(0.0f, 1.0f);
+    int N = 1000;
+    int T = 2000;
+    setRandomSeed(1);
+    BernoulliGridParticleFilter grid(N, &prior, &transitions, &observations);
+    setRandomSeed(1);
+    BernoulliGridParticleFilter log_grid(N, &prior, &transitions, &observations);
+    log_grid.setLogWeights(true);
+    BernoulliParticleFilter adaptive(N, &prior, &transitions, &observations);
+    adaptive.setResampling(STRATIFIED_RESAMPLING, 0.5);
+    adaptive.setLogWeights(true);
+    real grid_difference = 0;
+    for (int t=0; t<T; t++) {
+        real x = (drand48() < p) ? 1.0 : 0.0;
+        grid.Observe(x);
+        log_grid.Observe(x);
+        adaptive.Observe(x);
+        grid_difference = std::max(grid_difference, fabs(grid.GetMean() - log_grid.GetMean()));
+    }
+    printf("Grid: mean %f, log-weight difference %g; adaptive: mean %f, ESS %f\n",
+           grid.GetMean(), grid_difference, adaptive.GetMean(), adaptive.getEffectiveSampleSize());
+    if (grid_difference > 1e-9 || fabs(grid.GetMean() - p) > 0.05
+        || fabs(adaptive.GetMean() - p) > 0.1) {
+        n_errors++;
+    }
+
+    // the generic filter tracks a random walk as well as the Kalman filter
+    NormalDistribution walk(0.0, 0.3);
+    NormalDistribution noise(0.0, 0.5);
+    NormalDistribution start(0.0, 1.0);
+    ParticleFilter generic(500, &start, &walk, &noise);
+    ParticleFilter generic_adaptive(500, &start, &walk, &noise);
+    generic_adaptive.setResampling(SYSTEMATIC_RESAMPLING, 0.5);
+    generic_adaptive.setLogWeights(true);
+    real z = start.generate();
+    real kalman_mean = 0.0;
+    real kalman_var = 1.0;
+    real generic_error = 0;
+    for (int t=0; t<50; t++) {
+        z += walk.generate();
+        real x = z + noise.generate();
+        kalman_var += walk.s * walk.s;
+        real gain = kalman_var / (kalman_var + noise.s * noise.s);
+        kalman_mean += gain * (x - kalman_mean);
+        kalman_var *= 1.0 - gain;
+        generic.Observe(x);
+        generic_adaptive.Observe(x);
+        generic_error = std::max(generic_error, fabs(generic.GetMean() - kalman_mean));
+        generic_error = std::max(generic_error, fabs(generic_adaptive.GetMean() - kalman_mean));
+    }
+    printf("Generic filter: largest error %f, posterior std %f\n",
+           generic_error, sqrt(kalman_var));
+    if (generic_error > 0.5 * sqrt(kalman_var)) {
+        n_errors++;
+    }
+
+    // the quick pairwise probability against all pairs
+    PFActionValueEstimate small(2, 200);
+    for (int t=0; t<20; t++) {
+        small.Observe(t % 2, (drand48() < 0.3 + 0.4 * (t % 2)) ? 1.0 : 0.0);
+    }
+    for (int k=0; k<5; k++) {
+        real delta = 0.1 * (k - 2);
+        real P = 0, S = 0;
+        for (int n=0; n<small.q[1].N; n++) {
+            for (int m=0; m<small.q[0].N; m++) {
+                real density = small.q[1].w[n] * small.q[0].w[m];
+                S += density;
+                if (small.q[1].y[n] - small.q[0].y[m] > delta) {
+                    P += density;
+                }
+            }
+        }
+        if (fabs(small.GetProbability(1, 0, delta) - P / S) > 1e-9) {
+            n_errors++;
+        }
+    }
+
+    // a million particles per arm
+    int n_actions = 3;
+    PFActionValueEstimate estimate(n_actions, 1000000);
+    PFVPIPolicy policy(n_actions, &estimate, 0.99, 1);
+    double start_time = GetCPU();
+    int T_bandit = 200;
+    int n_best = 0;
+    for (int t=0; t<T_bandit; t++) {
+        int a = policy.SelectAction();
+        real r = (drand48() < 0.2 + 0.3 * a) ? 1.0 : 0.0;
+        policy.Observe(a, r);
+        if (a == n_actions - 1) {
+            n_best++;
+        }
+    }
+    double end_time = GetCPU();
+    printf("Bandit: %d steps with 10^6 particles per arm in %f s, best arm %d times\n",
+           T_bandit, end_time - start_time, n_best);
+
+    if (n_errors) {
+        printf("%d errors\n", n_errors);
+        return -1;
+    }
+    printf("OK\n");
+    return 0;
+}
+
+#endif